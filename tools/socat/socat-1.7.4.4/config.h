@@ -127,6 +127,18 @@
 /* Define if you have the inet_aton function. */
 #define HAVE_INET_ATON 1
 
+/* Define if you have the splice function. */
+#define HAVE_SPLICE 1
+
+/* Define if you have the recvmmsg function. */
+#define HAVE_RECVMMSG 1
+
+/* Define if you have the sendmmsg function. */
+#define HAVE_SENDMMSG 1
+
+/* Define if you have the posix_spawnp function. */
+#define HAVE_POSIX_SPAWNP 1
+
 /* Define if you have the strndup function. */
 #define HAVE_PROTOTYPE_LIB_strndup 1
 
@@ -301,6 +313,19 @@
 /* Define if you have the <sys/file.h> header file. (AIX) */
 #define HAVE_SYS_FILE_H 1
 
+/* Define if you have the <sys/epoll.h> header file. */
+#define HAVE_SYS_EPOLL_H 1
+
+/* Define if you have the <linux/io_uring.h> header file. */
+#define HAVE_LINUX_IO_URING_H 1
+
+/* Define if <linux/io_uring.h> has the constants of Linux 6.1 that the io_uring
+   transfer loop (option -I) uses */
+#define WITH_IOURING 1
+
+/* Define if you have the <spawn.h> header file. */
+#define HAVE_SPAWN_H 1
+
 /* Define if you have the <util.h> header file. (NetBSD, OpenBSD: openpty()) */
 /* #undef HAVE_UTIL_H */
 
@@ -700,6 +725,7 @@
 /* #undef HAVE_LIBWRAP */
 
 #define WITH_SYCLS 1
+/* #undef WITH_FAST_SYCLS */
 #define WITH_FILAN 1
 #define WITH_RETRY 1
 
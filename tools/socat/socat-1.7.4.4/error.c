@@ -28,7 +28,6 @@ int syslevel[] = {
 
 struct diag_opts {
    const char *progname;
-   int msglevel;
    int exitlevel;
    int syslog;
    FILE *logfile;
@@ -44,8 +43,10 @@ struct diag_opts {
 static void _diag_exit(int status);
 
 
+int diag_msglevel = E_ERROR;	/* lowest level that is printed */
+
 struct diag_opts diagopts =
-  { NULL, E_ERROR, E_ERROR, 0, NULL, LOG_DAEMON, false, 0, false, NULL, true } ;
+  { NULL, E_ERROR, 0, NULL, LOG_DAEMON, false, 0, false, NULL, true } ;
 
 static void msg2(
 #if HAVE_CLOCK_GETTIME
@@ -108,7 +109,7 @@ struct sermsg {
 static int diaginitialized;
 static int diag_sock_send = -1;
 static int diag_sock_recv = -1;
-static int diag_msg_avail = 0;	/* !=0: messages from within signal handler may be waiting */
+static volatile sig_atomic_t diag_msg_avail = 0;	/* !=0: messages from within signal handler may be waiting */
 
 
 static int diag_sock_pair(void) {
@@ -192,7 +193,7 @@ void diag_set(char what, const char *arg) {
    case 'p': diagopts.progname = arg;
       openlog(diagopts.progname, LOG_PID, diagopts.logfacility);
       break;
-   case 'd': --diagopts.msglevel; break;
+   case 'd': --diag_msglevel; break;
    case 'u': diagopts.micros = true; break;
    default: msg(E_ERROR, "unknown diagnostic option %c", what);
    }
@@ -201,7 +202,7 @@ void diag_set(char what, const char *arg) {
 void diag_set_int(char what, int arg) {
    DIAG_INIT;
    switch (what) {
-   case 'D': diagopts.msglevel = arg; break;
+   case 'D': diag_msglevel = arg; break;
    case 'e': diagopts.exitlevel = arg; break;
    case 'x': diagopts.exitstatus = arg; break;
    case 'h': diagopts.withhostname = arg;
@@ -220,7 +221,7 @@ int diag_get_int(char what) {
    switch (what) {
    case 'y': return diagopts.syslog;
    case 's': return diagopts.logfile == stderr;
-   case 'd': case 'D': return diagopts.msglevel;
+   case 'd': case 'D': return diag_msglevel;
    case 'e': return diagopts.exitlevel;
    }
    return -1;
@@ -276,11 +277,10 @@ void msg(int level, const char *format, ...) {
    /* in normal program flow (not in signal handler) */
    /* first flush the queue of datagrams from the socket */
    if (diag_msg_avail && !diag_in_handler) {
-      diag_msg_avail = 0;	/* _before_ flush to prevent inconsistent state when signal occurs inbetween */
       diag_flush();
    }
 
-   if (level < diagopts.msglevel)  { return; }
+   if (level < diag_msglevel)  { return; }
    va_start(ap, format);
 
    /* we do only a minimum in the outer parts which may run in a signal handler
@@ -389,7 +389,7 @@ void msg2(
    strcpy(bufp, "\n");
    _msg(level, buff, syslp);
    if (level >= diagopts.exitlevel) {
-      if (E_NOTICE >= diagopts.msglevel) {
+      if (E_NOTICE >= diag_msglevel) {
 	 if ((syslp - buff) + 16 > MSGLEN+1)
 	    syslp = buff + MSGLEN - 15;
 	 snprintf_r(syslp, 16, "N exit(%d)\n", exitcode?exitcode:(diagopts.exitstatus?diagopts.exitstatus:1));
@@ -416,9 +416,10 @@ void diag_flush(void) {
    struct diag_dgram recv_dgram;
    char exitmsg[20];
 
-   if (!diagopts.signalsafe) {
-      return;
+   if (!diagopts.signalsafe || !diag_msg_avail) {
+      return;	/* nothing queued, avoid the system call */
    }
+   diag_msg_avail = 0;	/* _before_ flush to prevent inconsistent state when signal occurs inbetween */
 
    while (recv(diag_sock_recv, &recv_dgram, sizeof(recv_dgram)-1,
 	       0 	/* for canonical reasons */
@@ -437,7 +438,7 @@ void diag_flush(void) {
 #else
 	 recv_dgram.now = time(NULL);
 #endif
-	 if (E_NOTICE >= diagopts.msglevel) {
+	 if (E_NOTICE >= diag_msglevel) {
 	    snprintf_r(exitmsg, sizeof(exitmsg), "exit(%d)", recv_dgram.exitcode?recv_dgram.exitcode:1);
 	    msg2(&recv_dgram.now, E_NOTICE, recv_dgram.exitcode?recv_dgram.exitcode:1, 1, exitmsg);
 	 }
@@ -497,6 +498,7 @@ void diag_exit(int status) {
 	   |MSG_NOSIGNAL
 #endif
 	   );
+      diag_msg_avail = 1;
       return;
    }
    _diag_exit(status);
@@ -527,6 +529,7 @@ int diag_select(int nfds, fd_set *readfds, fd_set *writefds,
 	 /* select terminated not due to diag_sock_recv, normalt continuation */
 	 break;
       }
+      diag_msg_avail = 1;	/* the socket is readable */
       diag_flush();
       if (readfds)   { memcpy(readfds,   &save_readfds,   sizeof(*readfds)); }
       if (writefds)  { memcpy(writefds,  &save_writefds,  sizeof(*writefds)); }
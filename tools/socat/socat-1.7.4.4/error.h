@@ -21,6 +21,11 @@
 #  define WITH_MSGLEVEL E_NOTICE
 #endif
 
+/* checks the level before the arguments of the message are evaluated, so a
+   message that is not printed costs only one comparison */
+extern int diag_msglevel;
+#define DIAG_IF(l,call) ((l) < diag_msglevel ? (void)0 : (call))
+
 #if WITH_MSGLEVEL <= E_FATAL
 #define Fatal(m) msg(E_FATAL,"%s",m)
 #define Fatal1(m,a1) msg(E_FATAL,m,a1)
@@ -42,18 +47,18 @@
 #endif /* !(WITH_MSGLEVEL <= E_FATAL) */
 
 #if WITH_MSGLEVEL <= E_ERROR
-#define Error(m) msg(E_ERROR,"%s",m)
-#define Error1(m,a1) msg(E_ERROR,m,a1)
-#define Error2(m,a1,a2) msg(E_ERROR,m,a1,a2)
-#define Error3(m,a1,a2,a3) msg(E_ERROR,m,a1,a2,a3)
-#define Error4(m,a1,a2,a3,a4) msg(E_ERROR,m,a1,a2,a3,a4)
-#define Error5(m,a1,a2,a3,a4,a5) msg(E_ERROR,m,a1,a2,a3,a4,a5)
-#define Error6(m,a1,a2,a3,a4,a5,a6) msg(E_ERROR,m,a1,a2,a3,a4,a5,a6)
-#define Error7(m,a1,a2,a3,a4,a5,a6,a7) msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7)
-#define Error8(m,a1,a2,a3,a4,a5,a6,a7,a8) msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8)
-#define Error9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8,a9)
-#define Error10(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10) msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10)
-#define Error11(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11) msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11)
+#define Error(m) DIAG_IF(E_ERROR, msg(E_ERROR,"%s",m))
+#define Error1(m,a1) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1))
+#define Error2(m,a1,a2) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2))
+#define Error3(m,a1,a2,a3) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3))
+#define Error4(m,a1,a2,a3,a4) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4))
+#define Error5(m,a1,a2,a3,a4,a5) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5))
+#define Error6(m,a1,a2,a3,a4,a5,a6) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5,a6))
+#define Error7(m,a1,a2,a3,a4,a5,a6,a7) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7))
+#define Error8(m,a1,a2,a3,a4,a5,a6,a7,a8) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8))
+#define Error9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8,a9))
+#define Error10(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10))
+#define Error11(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11) DIAG_IF(E_ERROR, msg(E_ERROR,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11))
 #else /* !(WITH_MSGLEVEL >= E_ERROR) */
 #define Error(m)
 #define Error1(m,a1)
@@ -70,14 +75,14 @@
 #endif /* !(WITH_MSGLEVEL <= E_ERROR) */
 
 #if WITH_MSGLEVEL <= E_WARN
-#define Warn(m) msg(E_WARN,"%s",m)
-#define Warn1(m,a1) msg(E_WARN,m,a1)
-#define Warn2(m,a1,a2) msg(E_WARN,m,a1,a2)
-#define Warn3(m,a1,a2,a3) msg(E_WARN,m,a1,a2,a3)
-#define Warn4(m,a1,a2,a3,a4) msg(E_WARN,m,a1,a2,a3,a4)
-#define Warn5(m,a1,a2,a3,a4,a5) msg(E_WARN,m,a1,a2,a3,a4,a5)
-#define Warn6(m,a1,a2,a3,a4,a5,a6) msg(E_WARN,m,a1,a2,a3,a4,a5,a6)
-#define Warn7(m,a1,a2,a3,a4,a5,a6,a7) msg(E_WARN,m,a1,a2,a3,a4,a5,a6,a7)
+#define Warn(m) DIAG_IF(E_WARN, msg(E_WARN,"%s",m))
+#define Warn1(m,a1) DIAG_IF(E_WARN, msg(E_WARN,m,a1))
+#define Warn2(m,a1,a2) DIAG_IF(E_WARN, msg(E_WARN,m,a1,a2))
+#define Warn3(m,a1,a2,a3) DIAG_IF(E_WARN, msg(E_WARN,m,a1,a2,a3))
+#define Warn4(m,a1,a2,a3,a4) DIAG_IF(E_WARN, msg(E_WARN,m,a1,a2,a3,a4))
+#define Warn5(m,a1,a2,a3,a4,a5) DIAG_IF(E_WARN, msg(E_WARN,m,a1,a2,a3,a4,a5))
+#define Warn6(m,a1,a2,a3,a4,a5,a6) DIAG_IF(E_WARN, msg(E_WARN,m,a1,a2,a3,a4,a5,a6))
+#define Warn7(m,a1,a2,a3,a4,a5,a6,a7) DIAG_IF(E_WARN, msg(E_WARN,m,a1,a2,a3,a4,a5,a6,a7))
 #else /* !(WITH_MSGLEVEL <= E_WARN) */
 #define Warn(m)
 #define Warn1(m,a1)
@@ -90,16 +95,16 @@
 #endif /* !(WITH_MSGLEVEL <= E_WARN) */
 
 #if WITH_MSGLEVEL <= E_NOTICE
-#define Notice(m) msg(E_NOTICE,"%s",m)
-#define Notice1(m,a1) msg(E_NOTICE,m,a1)
-#define Notice2(m,a1,a2) msg(E_NOTICE,m,a1,a2)
-#define Notice3(m,a1,a2,a3) msg(E_NOTICE,m,a1,a2,a3)
-#define Notice4(m,a1,a2,a3,a4) msg(E_NOTICE,m,a1,a2,a3,a4)
-#define Notice5(m,a1,a2,a3,a4,a5) msg(E_NOTICE,m,a1,a2,a3,a4,a5)
-#define Notice6(m,a1,a2,a3,a4,a5,a6) msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6)
-#define Notice7(m,a1,a2,a3,a4,a5,a6,a7) msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6,a7)
-#define Notice8(m,a1,a2,a3,a4,a5,a6,a7,a8) msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6,a7,a8)
-#define Notice9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6,a7,a8,a9)
+#define Notice(m) DIAG_IF(E_NOTICE, msg(E_NOTICE,"%s",m))
+#define Notice1(m,a1) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1))
+#define Notice2(m,a1,a2) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2))
+#define Notice3(m,a1,a2,a3) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3))
+#define Notice4(m,a1,a2,a3,a4) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3,a4))
+#define Notice5(m,a1,a2,a3,a4,a5) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3,a4,a5))
+#define Notice6(m,a1,a2,a3,a4,a5,a6) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6))
+#define Notice7(m,a1,a2,a3,a4,a5,a6,a7) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6,a7))
+#define Notice8(m,a1,a2,a3,a4,a5,a6,a7,a8) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6,a7,a8))
+#define Notice9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) DIAG_IF(E_NOTICE, msg(E_NOTICE,m,a1,a2,a3,a4,a5,a6,a7,a8,a9))
 #else /* !(WITH_MSGLEVEL <= E_NOTICE) */
 #define Notice(m)
 #define Notice1(m,a1)
@@ -114,18 +119,18 @@
 #endif /* !(WITH_MSGLEVEL <= E_NOTICE) */
 
 #if WITH_MSGLEVEL <= E_INFO
-#define Info(m) msg(E_INFO,"%s",m)
-#define Info1(m,a1) msg(E_INFO,m,a1)
-#define Info2(m,a1,a2) msg(E_INFO,m,a1,a2)
-#define Info3(m,a1,a2,a3) msg(E_INFO,m,a1,a2,a3)
-#define Info4(m,a1,a2,a3,a4) msg(E_INFO,m,a1,a2,a3,a4)
-#define Info5(m,a1,a2,a3,a4,a5) msg(E_INFO,m,a1,a2,a3,a4,a5)
-#define Info6(m,a1,a2,a3,a4,a5,a6) msg(E_INFO,m,a1,a2,a3,a4,a5,a6)
-#define Info7(m,a1,a2,a3,a4,a5,a6,a7) msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7)
-#define Info8(m,a1,a2,a3,a4,a5,a6,a7,a8) msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8)
-#define Info9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8,a9)
-#define Info10(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10) msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10)
-#define Info11(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11) msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11)
+#define Info(m) DIAG_IF(E_INFO, msg(E_INFO,"%s",m))
+#define Info1(m,a1) DIAG_IF(E_INFO, msg(E_INFO,m,a1))
+#define Info2(m,a1,a2) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2))
+#define Info3(m,a1,a2,a3) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3))
+#define Info4(m,a1,a2,a3,a4) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4))
+#define Info5(m,a1,a2,a3,a4,a5) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5))
+#define Info6(m,a1,a2,a3,a4,a5,a6) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5,a6))
+#define Info7(m,a1,a2,a3,a4,a5,a6,a7) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7))
+#define Info8(m,a1,a2,a3,a4,a5,a6,a7,a8) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8))
+#define Info9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8,a9))
+#define Info10(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10))
+#define Info11(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11) DIAG_IF(E_INFO, msg(E_INFO,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11))
 #else /* !(WITH_MSGLEVEL <= E_INFO) */
 #define Info(m)
 #define Info1(m,a1)
@@ -142,25 +147,25 @@
 #endif /* !(WITH_MSGLEVEL <= E_INFO) */
 
 #if WITH_MSGLEVEL <= E_DEBUG
-#define Debug(m) msg(E_DEBUG,"%s",m)
-#define Debug1(m,a1) msg(E_DEBUG,m,a1)
-#define Debug2(m,a1,a2) msg(E_DEBUG,m,a1,a2)
-#define Debug3(m,a1,a2,a3) msg(E_DEBUG,m,a1,a2,a3)
-#define Debug4(m,a1,a2,a3,a4) msg(E_DEBUG,m,a1,a2,a3,a4)
-#define Debug5(m,a1,a2,a3,a4,a5) msg(E_DEBUG,m,a1,a2,a3,a4,a5)
-#define Debug6(m,a1,a2,a3,a4,a5,a6) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6)
-#define Debug7(m,a1,a2,a3,a4,a5,a6,a7) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7)
-#define Debug8(m,a1,a2,a3,a4,a5,a6,a7,a8) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8)
-#define Debug9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9)
-#define Debug10(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10)
-#define Debug11(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11)
-#define Debug12(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12)
-#define Debug13(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13)
-#define Debug14(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14)
-#define Debug15(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15)
-#define Debug16(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16)
-#define Debug17(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17)
-#define Debug18(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17,a18) msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17,a18)
+#define Debug(m) DIAG_IF(E_DEBUG, msg(E_DEBUG,"%s",m))
+#define Debug1(m,a1) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1))
+#define Debug2(m,a1,a2) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2))
+#define Debug3(m,a1,a2,a3) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3))
+#define Debug4(m,a1,a2,a3,a4) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4))
+#define Debug5(m,a1,a2,a3,a4,a5) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5))
+#define Debug6(m,a1,a2,a3,a4,a5,a6) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6))
+#define Debug7(m,a1,a2,a3,a4,a5,a6,a7) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7))
+#define Debug8(m,a1,a2,a3,a4,a5,a6,a7,a8) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8))
+#define Debug9(m,a1,a2,a3,a4,a5,a6,a7,a8,a9) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9))
+#define Debug10(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10))
+#define Debug11(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11))
+#define Debug12(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12))
+#define Debug13(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13))
+#define Debug14(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14))
+#define Debug15(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15))
+#define Debug16(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16))
+#define Debug17(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17))
+#define Debug18(m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17,a18) DIAG_IF(E_DEBUG, msg(E_DEBUG,m,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,a16,a17,a18))
 #else /* !(WITH_MSGLEVEL <= E_DEBUG) */
 #define Debug(m)
 #define Debug1(m,a1)
@@ -0,0 +1,69 @@
+#! /usr/bin/env bash
+# source: ktls-bench.sh
+# Copyright Gerhard Rieger and contributors (see file CHANGES)
+# Published under the GNU General Public License V.2, see file COPYING
+
+# measures the CPU time socat needs per GB of TLS data: a local openssl
+# s_server sends the data, socat receives it as OPENSSL client and passes it
+# to a TCP sink, once with records decrypted by OpenSSL in user space and
+# once with option openssl-ktls. with kernel TLS the data moves from the TLS
+# socket to the TCP socket with splice(). it requires the openssl command;
+# kernel TLS requires Linux with the tls module and an OpenSSL library built
+# with it, otherwise both runs use user space.
+# usage: ./ktls-bench.sh [megabytes [port]]
+
+if [ -x ./socat ]; then
+    SOCAT=./socat
+else
+    SOCAT=socat
+fi
+
+MB=${1:-1024}
+PORT=${2:-47301}
+
+TD=$(mktemp -d /tmp/socat-bench.XXXXXX) || exit 1
+trap 'rm -rf "$TD"' EXIT
+
+if ! openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost \
+	-keyout $TD/key.pem -out $TD/cert.crt >/dev/null 2>&1; then
+    echo "failed to generate a certificate with openssl" >&2
+    exit 1
+fi
+cat $TD/key.pem $TD/cert.crt >$TD/cert.pem
+
+# prints user+system CPU ticks of process $1 and its waited-for children
+cputicks () {
+    awk '{ print $14+$15+$16+$17 }' /proc/$1/stat
+}
+
+# transfers $MB MiB; $1: client address options, $2: description
+bench () {
+    local t0 t1 ms c0 c1 spid kpid
+    # s_server sends its stdin; zero bytes do not trigger its commands
+    head -c ${MB}M /dev/zero |
+	openssl s_server -accept $PORT -naccept 1 -cert $TD/cert.pem \
+	    >/dev/null 2>&1 &
+    spid=$!
+    $SOCAT -u TCP-LISTEN:$((PORT+1)),reuseaddr OPEN:/dev/null &
+    kpid=$!
+    sleep 0.5
+    c0=$(cputicks $$)
+    t0=$(date +%s%N)
+    $SOCAT -d -d -u OPENSSL:localhost:$PORT,verify=0$1 TCP:localhost:$((PORT+1)) \
+	2>$TD/socat.log
+    t1=$(date +%s%N)
+    c1=$(cputicks $$)
+    kill $spid $kpid 2>/dev/null; wait $spid $kpid 2>/dev/null
+    if [ "$1" ] && ! grep -q "kernel TLS used" $TD/socat.log; then
+	echo "kernel TLS not available, OpenSSL used user space"
+    fi
+    ms=$(( (t1-t0)/1000000 ))
+    # ticks: 1/100 s on Linux
+    printf "%-24s %6d ms  %6d MB/s  CPU %6d ms/GB\n" "$2" $ms \
+	$(( ms>0 ? MB*1000/ms : 0 )) $(( (c1-c0)*10*1024/MB ))
+    PORT=$((PORT+2))
+}
+
+echo "$MB MiB from openssl s_server over localhost"
+bench "" "user space TLS"
+bench ",ktls" "kernel TLS (ktls)"
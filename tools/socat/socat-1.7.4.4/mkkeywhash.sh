@@ -0,0 +1,106 @@
+#! /bin/sh
+# source: mkkeywhash.sh
+# Copyright Gerhard Rieger and contributors (see file CHANGES)
+# Published under the GNU General Public License V.2, see file COPYING
+
+# generates a perfect hash table for a keyword table (struct wordent layout),
+# so keyw_hash() finds a keyword with one hash computation and one string
+# compare instead of a binary search. reads the preprocessed C source that
+# defines the table, so the result matches the configured features exactly.
+# the hash is computed like wordhash() in utils.c: h = h*33 + lower(c) mod
+# 2^32, starting with a seed; a keyword lands in bucket h%buckets and in slot
+# (h/buckets + disp[bucket]) % size, disp being chosen per bucket here
+# ("hash and displace").
+# usage: $(CC) -E ... xioopts.c |./mkkeywhash.sh optionnames xioopt_hash >xioopthash.h
+
+if [ $# -ne 2 ]; then
+    echo "usage: $0 table prefix" >&2
+    exit 1
+fi
+
+${AWK:-awk} -v table="$1" -v prefix="$2" '
+BEGIN {
+    for (i = 32; i < 127; ++i)  ord[sprintf("%c", i)] = i
+    n = 0;  intable = 0
+}
+/^#/ { next }		# line markers of the preprocessor
+intable == 0 && index($0, table "[] =") {
+    intable = 1;  next
+}
+intable == 1 {
+    if (match($0, /"[^"]*"/)) {
+	key[++n] = tolower(substr($0, RSTART+1, RLENGTH-2))
+    } else if ($0 ~ /NULL|^[ \t]*}[ \t]*;/) {
+	intable = 2
+    }
+}
+function hash(s, seed,   h, i) {
+    h = seed
+    for (i = 1; i <= length(s); ++i) {
+	h = (h*33 + ord[substr(s, i, 1)]) % 4294967296
+    }
+    return h
+}
+# tries to place all keys with the given seed; returns 1 on success
+function place(seed,   i, j, b, d, s, ok, sz, maxsz, cnt, mem) {
+    for (b = 0; b < buckets; ++b)  { cnt[b] = 0;  disp[b] = 0 }
+    for (s = 0; s < size; ++s)  slot[s] = 0
+    for (i = 1; i <= n; ++i) {
+	h = hash(key[i], seed)
+	b = h % buckets;  h2[i] = int(h / buckets)
+	mem[b, cnt[b]++] = i
+    }
+    maxsz = 0
+    for (b = 0; b < buckets; ++b)  if (cnt[b] > maxsz)  maxsz = cnt[b]
+    # the big buckets first, while there are many free slots
+    for (sz = maxsz; sz > 0; --sz) {
+	for (b = 0; b < buckets; ++b) {
+	    if (cnt[b] != sz)  continue
+	    for (d = 0; d < size; ++d) {
+		ok = 1
+		for (j = 0; j < sz; ++j) {
+		    s = (h2[mem[b, j]] + d) % size
+		    if (slot[s]) { ok = 0;  break }
+		    slot[s] = mem[b, j]
+		}
+		if (ok)  break
+		for (--j; j >= 0; --j) {	# undo
+		    slot[(h2[mem[b, j]] + d) % size] = 0
+		}
+	    }
+	    if (d == size)  return 0
+	    disp[b] = d
+	}
+    }
+    return 1
+}
+END {
+    if (n == 0) {
+	print "mkkeywhash.sh: table " table " not found" >"/dev/stderr"
+	exit 1
+    }
+    size = 1;  while (size < 2*n)  size *= 2
+    buckets = int((n+3)/4)
+    for (seed = 5381; seed < 5381+64; ++seed) {
+	if (place(seed))  break
+    }
+    if (seed == 5381+64) {
+	print "mkkeywhash.sh: no perfect hash found for " table >"/dev/stderr"
+	exit 1
+    }
+    print "/* generated by mkkeywhash.sh from " table "[], do not edit */"
+    print ""
+    printf "static const unsigned short %s_disp[%d] = {", prefix, buckets
+    for (b = 0; b < buckets; ++b)
+	printf "%s%s%d", (b ? "," : ""), (b%16 ? " " : "\n   "), disp[b]
+    print "\n} ;"
+    printf "static const unsigned short %s_slot[%d] = {", prefix, size
+    for (s = 0; s < size; ++s)
+	printf "%s%s%d", (s ? "," : ""), (s%16 ? " " : "\n   "), slot[s]
+    print "\n} ;"
+    printf "static const struct wordhash %s = {\n", prefix
+    printf "   %d, %d, %d, %d, %s_disp, %s_slot\n", n, seed, buckets, size, \
+	prefix, prefix
+    print "} ;"
+}
+'
@@ -0,0 +1,176 @@
+/* source: newline-bench.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* microbenchmark of the line terminator conversions (options cr, crnl):
+   converts 1MiB of text with each implementation of newline.c and with the
+   byte loops of socat 1.7.4.4, checks that the results are equal, and prints
+   the throughput.
+   build with "make newline-bench"; usage: ./newline-bench [rounds] */
+
+#include "config.h"
+
+#include "sysincludes.h"
+
+#include "mytypes.h"
+#include "error.h"
+#include "newline.h"
+
+#define CR '\r'
+#define LF '\n'
+#define BENCH_SIZE (1024*1024)
+
+/* the loops of cv_newline() of socat 1.7.4.4 */
+static size_t old_replace(unsigned char *buff, size_t len,
+			  unsigned char from, unsigned char to) {
+   unsigned char *p = buff, *z = buff + len;
+   while (p < z) {
+      if (*p == from)  *p = to;
+      ++p;
+   }
+   return len;
+}
+
+static size_t old_contract(unsigned char *buff, size_t len, unsigned char to) {
+   unsigned char *s, *t, *z;
+   z = buff + len;
+   s = t = buff;
+   while (s < z) {
+      if (*s == '\r') {
+	 ++s;
+	 continue;
+      }
+      if (*s == '\n') {
+	 *t++ = to; ++s;
+      } else {
+	 *t++ = *s++;
+      }
+   }
+   return t - buff;
+}
+
+static size_t old_expand(unsigned char *buff, unsigned char *buf2,
+			 size_t len, unsigned char from) {
+   unsigned char *s, *t, *z;
+   memcpy(buf2, buff, len);
+   s = buf2;  t = buff;  z = buf2 + len;
+   while (s < z) {
+      if (*s == from) {
+	 *t++ = '\r'; *t++ = '\n';
+	 ++s;
+	 continue;
+      } else {
+	 *t++ = *s++;
+      }
+   }
+   return t - buff;
+}
+
+/* text with lines of 1 to 100 printable characters */
+static void mktext(unsigned char *buff, size_t len, bool crlf) {
+   size_t i = 0, n;
+   srand(1);
+   while (i < len) {
+      n = rand() % 100 + 1;
+      while (n-- > 0 && i < len)  buff[i++] = ' ' + rand() % 95;
+      if (crlf && i < len)  buff[i++] = CR;
+      if (i < len)  buff[i++] = LF;
+   }
+}
+
+static double now(void) {
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+enum { REPLACE, CONTRACT, EXPAND };
+static const char *opnames[] = { "LF->CR", "CRLF->LF", "LF->CRLF" };
+
+/* runs operation op rounds times with implementation impl (NULL: the old
+   loops); returns MB/s and the last result in res, reslen */
+static double bench(int op, const char *impl, const unsigned char *text,
+		    unsigned char *work, unsigned char *work2, int rounds,
+		    unsigned char *res, size_t *reslen) {
+   double t0, t1;
+   size_t len = 0;
+   int r;
+
+   t0 = now();
+   for (r = 0; r < rounds; ++r) {
+      memcpy(work, text, BENCH_SIZE);
+      switch (op) {
+      case REPLACE:
+	 if (impl) {
+	    newline_replace(work, BENCH_SIZE, LF, CR);
+	    len = BENCH_SIZE;
+	 } else {
+	    len = old_replace(work, BENCH_SIZE, LF, CR);
+	 }
+	 break;
+      case CONTRACT:
+	 if (impl)  len = newline_contract(work, work, BENCH_SIZE, LF);
+	 else  len = old_contract(work, BENCH_SIZE, LF);
+	 break;
+      case EXPAND:
+	 if (impl) {
+	    memcpy(work2, work, BENCH_SIZE);	/* as in cv_newline() */
+	    len = newline_expand(work, work2, BENCH_SIZE, LF);
+	 } else {
+	    len = old_expand(work, work2, BENCH_SIZE, LF);
+	 }
+	 break;
+      }
+   }
+   t1 = now();
+   memcpy(res, work, len);
+   *reslen = len;
+   /* the memcpy of the input is part of both measurements */
+   return (double)BENCH_SIZE * rounds / (1024*1024) / (t1 - t0);
+}
+
+int main(int argc, const char *argv[]) {
+   static const char *impls[] = { "scalar", "sse2", "avx2", NULL };
+   unsigned char *lftext, *crlftext, *work, *work2, *ref, *res;
+   size_t reflen, reslen;
+   int rounds = 256;
+   int op, i, rc = 0;
+
+   if (argc > 1)  rounds = atoi(argv[1]);
+   if (rounds <= 0)  rounds = 1;
+   lftext   = malloc(BENCH_SIZE);
+   crlftext = malloc(BENCH_SIZE);
+   work  = malloc(2*BENCH_SIZE);
+   work2 = malloc(2*BENCH_SIZE);
+   ref   = malloc(2*BENCH_SIZE);
+   res   = malloc(2*BENCH_SIZE);
+   if (!lftext || !crlftext || !work || !work2 || !ref || !res) {
+      fputs("out of memory\n", stderr);
+      return 1;
+   }
+   mktext(lftext, BENCH_SIZE, false);
+   mktext(crlftext, BENCH_SIZE, true);
+
+   printf("%d x 1MiB text\n", rounds);
+   for (op = REPLACE; op <= EXPAND; ++op) {
+      const unsigned char *text = op == CONTRACT ? crlftext : lftext;
+      double mbs;
+
+      mbs = bench(op, NULL, text, work, work2, rounds, ref, &reflen);
+      printf("%-9s %-8s %8.0f MB/s\n", opnames[op], "1.7.4.4", mbs);
+      for (i = 0; impls[i] != NULL; ++i) {
+	 if (newline_select(impls[i]) == NULL) {
+	    printf("%-9s %-8s      n/a\n", opnames[op], impls[i]);
+	    continue;
+	 }
+	 mbs = bench(op, impls[i], text, work, work2, rounds, res, &reslen);
+	 printf("%-9s %-8s %8.0f MB/s", opnames[op], impls[i], mbs);
+	 if (reslen != reflen || memcmp(res, ref, reflen)) {
+	    printf(" RESULT DIFFERS");
+	    rc = 1;
+	 }
+	 putchar('\n');
+      }
+   }
+   return rc;
+}
@@ -0,0 +1,361 @@
+/* source: newline.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the kernels for converting line terminators (options
+   cr, crnl). On x86 they search 16 (SSE2) or 32 (AVX2) bytes at a time for
+   CR and LF, the implementation is selected at runtime */
+
+#include "config.h"
+
+#include "sysincludes.h"
+
+#include "mytypes.h"
+#include "error.h"
+#include "newline.h"
+
+#if defined(__GNUC__) && \
+   (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#  define NEWLINE_SSE2 1
+#  include <emmintrin.h>
+#  if __GNUC__ >= 5 || defined(__clang__)
+#     define NEWLINE_AVX2 1
+#     include <immintrin.h>
+#  endif
+#endif
+
+#define CR '\r'
+#define LF '\n'
+
+
+static void newline_replace_scalar(unsigned char *buff, size_t len,
+				   unsigned char from, unsigned char to) {
+   unsigned char *p = buff, *z = buff + len;
+
+   while (p < z) {
+      if (*p == from)  *p = to;
+      ++p;
+   }
+}
+
+static size_t newline_contract_scalar(unsigned char *out,
+				      const unsigned char *in, size_t len,
+				      unsigned char to) {
+   const unsigned char *s = in, *z = in + len;
+   unsigned char *t = out;
+
+   while (s < z) {
+      if (*s == CR) {
+	 ++s;
+	 continue;
+      }
+      if (*s == LF) {
+	 *t++ = to; ++s;
+      } else {
+	 *t++ = *s++;
+      }
+   }
+   return t - out;
+}
+
+static size_t newline_expand_scalar(unsigned char *out,
+				    const unsigned char *in, size_t len,
+				    unsigned char from) {
+   const unsigned char *s = in, *z = in + len;
+   unsigned char *t = out;
+
+   while (s < z) {
+      if (*s == from) {
+	 *t++ = CR; *t++ = LF;
+	 ++s;
+      } else {
+	 *t++ = *s++;
+      }
+   }
+   return t - out;
+}
+
+
+#if NEWLINE_SSE2
+
+static void newline_replace_sse2(unsigned char *buff, size_t len,
+				 unsigned char from, unsigned char to) {
+   const __m128i vfrom = _mm_set1_epi8((char)from);
+   const __m128i vto   = _mm_set1_epi8((char)to);
+   size_t i;
+
+   for (i = 0; i + 16 <= len; i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(buff+i));
+      __m128i m = _mm_cmpeq_epi8(x, vfrom);
+      if (_mm_movemask_epi8(m) != 0) {
+	 x = _mm_or_si128(_mm_andnot_si128(m, x), _mm_and_si128(m, vto));
+	 _mm_storeu_si128((__m128i *)(buff+i), x);
+      }
+   }
+   newline_replace_scalar(buff+i, len-i, from, to);
+}
+
+/* the parts between CRs are moved with 16 byte stores that may overshoot;
+   later stores overwrite the excess. The next block is loaded before the
+   stores, so with out == in they never reach data not yet read */
+static size_t newline_contract_sse2(unsigned char *out,
+				    const unsigned char *in, size_t len,
+				    unsigned char to) {
+   const __m128i vcr = _mm_set1_epi8(CR);
+   const __m128i vlf = _mm_set1_epi8(LF);
+   const __m128i vto = _mm_set1_epi8((char)to);
+   unsigned char blk[32] = { 0 };
+   size_t i = 0, o = 0;
+   __m128i x, next;
+
+   if (len < 32) {
+      return newline_contract_scalar(out, in, len, to);
+   }
+   x = _mm_loadu_si128((const __m128i *)in);
+   for (; i + 32 <= len; i += 16) {
+      unsigned int mcr = _mm_movemask_epi8(_mm_cmpeq_epi8(x, vcr));
+      unsigned int start = 0, b;
+
+      next = _mm_loadu_si128((const __m128i *)(in+i+16));
+      if (to != LF) {
+	 __m128i m = _mm_cmpeq_epi8(x, vlf);
+	 x = _mm_or_si128(_mm_andnot_si128(m, x), _mm_and_si128(m, vto));
+      }
+      if (mcr == 0) {
+	 _mm_storeu_si128((__m128i *)(out+o), x);
+	 o += 16;
+      } else {
+	 _mm_storeu_si128((__m128i *)blk, x);
+	 do {
+	    b = __builtin_ctz(mcr);
+	    _mm_storeu_si128((__m128i *)(out+o),
+			     _mm_loadu_si128((const __m128i *)(blk+start)));
+	    o += b-start;
+	    start = b+1;
+	    mcr &= mcr-1;
+	 } while (mcr);
+	 _mm_storeu_si128((__m128i *)(out+o),
+			  _mm_loadu_si128((const __m128i *)(blk+start)));
+	 o += 16-start;
+      }
+      x = next;
+   }
+   /* the stores may have overwritten the input of x already */
+   _mm_storeu_si128((__m128i *)blk, x);
+   o += newline_contract_scalar(out+o, blk, 16, to);
+   i += 16;
+   return o + newline_contract_scalar(out+o, in+i, len-i, to);
+}
+
+/* as in newline_contract_sse2() the stores may overshoot by up to 15 bytes;
+   leaving the last 16 to 31 bytes to the scalar loop keeps them within
+   2*len */
+static size_t newline_expand_sse2(unsigned char *out,
+				  const unsigned char *in, size_t len,
+				  unsigned char from) {
+   const __m128i vfrom = _mm_set1_epi8((char)from);
+   size_t i, o = 0;
+
+   for (i = 0; i + 32 <= len; i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(in+i));
+      unsigned int m = _mm_movemask_epi8(_mm_cmpeq_epi8(x, vfrom));
+      unsigned int start = 0, b;
+
+      if (m == 0) {
+	 _mm_storeu_si128((__m128i *)(out+o), x);
+	 o += 16;
+	 continue;
+      }
+      do {
+	 b = __builtin_ctz(m);
+	 _mm_storeu_si128((__m128i *)(out+o),
+			  _mm_loadu_si128((const __m128i *)(in+i+start)));
+	 o += b-start;
+	 out[o++] = CR;  out[o++] = LF;
+	 start = b+1;
+	 m &= m-1;
+      } while (m);
+      _mm_storeu_si128((__m128i *)(out+o),
+		       _mm_loadu_si128((const __m128i *)(in+i+start)));
+      o += 16-start;
+   }
+   return o + newline_expand_scalar(out+o, in+i, len-i, from);
+}
+
+#endif /* NEWLINE_SSE2 */
+
+
+#if NEWLINE_AVX2
+
+#define NEWLINE_TARGET_AVX2 __attribute__((target("avx2")))
+
+NEWLINE_TARGET_AVX2
+static void newline_replace_avx2(unsigned char *buff, size_t len,
+				 unsigned char from, unsigned char to) {
+   const __m256i vfrom = _mm256_set1_epi8((char)from);
+   const __m256i vto   = _mm256_set1_epi8((char)to);
+   size_t i;
+
+   for (i = 0; i + 32 <= len; i += 32) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(buff+i));
+      __m256i m = _mm256_cmpeq_epi8(x, vfrom);
+      if (_mm256_movemask_epi8(m) != 0) {
+	 x = _mm256_blendv_epi8(x, vto, m);
+	 _mm256_storeu_si256((__m256i *)(buff+i), x);
+      }
+   }
+   newline_replace_scalar(buff+i, len-i, from, to);
+}
+
+NEWLINE_TARGET_AVX2
+static size_t newline_contract_avx2(unsigned char *out,
+				    const unsigned char *in, size_t len,
+				    unsigned char to) {
+   const __m256i vcr = _mm256_set1_epi8(CR);
+   const __m256i vlf = _mm256_set1_epi8(LF);
+   const __m256i vto = _mm256_set1_epi8((char)to);
+   unsigned char blk[64] = { 0 };
+   size_t i = 0, o = 0;
+   __m256i x, next;
+
+   if (len < 64) {
+      return newline_contract_scalar(out, in, len, to);
+   }
+   x = _mm256_loadu_si256((const __m256i *)in);
+   for (; i + 64 <= len; i += 32) {
+      unsigned int mcr = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vcr));
+      unsigned int start = 0, b;
+
+      next = _mm256_loadu_si256((const __m256i *)(in+i+32));
+      if (to != LF) {
+	 x = _mm256_blendv_epi8(x, vto, _mm256_cmpeq_epi8(x, vlf));
+      }
+      if (mcr == 0) {
+	 _mm256_storeu_si256((__m256i *)(out+o), x);
+	 o += 32;
+      } else {
+	 _mm256_storeu_si256((__m256i *)blk, x);
+	 do {
+	    b = __builtin_ctz(mcr);
+	    _mm256_storeu_si256((__m256i *)(out+o),
+			     _mm256_loadu_si256((const __m256i *)(blk+start)));
+	    o += b-start;
+	    start = b+1;
+	    mcr &= mcr-1;
+	 } while (mcr);
+	 _mm256_storeu_si256((__m256i *)(out+o),
+			     _mm256_loadu_si256((const __m256i *)(blk+start)));
+	 o += 32-start;
+      }
+      x = next;
+   }
+   /* the stores may have overwritten the input of x already */
+   _mm256_storeu_si256((__m256i *)blk, x);
+   o += newline_contract_scalar(out+o, blk, 32, to);
+   i += 32;
+   return o + newline_contract_scalar(out+o, in+i, len-i, to);
+}
+
+NEWLINE_TARGET_AVX2
+static size_t newline_expand_avx2(unsigned char *out,
+				  const unsigned char *in, size_t len,
+				  unsigned char from) {
+   const __m256i vfrom = _mm256_set1_epi8((char)from);
+   size_t i, o = 0;
+
+   for (i = 0; i + 64 <= len; i += 32) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(in+i));
+      unsigned int m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vfrom));
+      unsigned int start = 0, b;
+
+      if (m == 0) {
+	 _mm256_storeu_si256((__m256i *)(out+o), x);
+	 o += 32;
+	 continue;
+      }
+      do {
+	 b = __builtin_ctz(m);
+	 _mm256_storeu_si256((__m256i *)(out+o),
+			     _mm256_loadu_si256((const __m256i *)(in+i+start)));
+	 o += b-start;
+	 out[o++] = CR;  out[o++] = LF;
+	 start = b+1;
+	 m &= m-1;
+      } while (m);
+      _mm256_storeu_si256((__m256i *)(out+o),
+			  _mm256_loadu_si256((const __m256i *)(in+i+start)));
+      o += 32-start;
+   }
+   return o + newline_expand_scalar(out+o, in+i, len-i, from);
+}
+
+static int newline_have_avx2(void) {
+   return __builtin_cpu_supports("avx2");
+}
+
+#endif /* NEWLINE_AVX2 */
+
+
+struct newline_impl {
+   const char *name;
+   int (*usable)(void);		/* NULL: always */
+   void (*replace)(unsigned char *, size_t, unsigned char, unsigned char);
+   size_t (*contract)(unsigned char *, const unsigned char *, size_t,
+		      unsigned char);
+   size_t (*expand)(unsigned char *, const unsigned char *, size_t,
+		    unsigned char);
+} ;
+
+/* ordered from slowest to fastest */
+static const struct newline_impl newline_impls[] = {
+   { "scalar", NULL, newline_replace_scalar, newline_contract_scalar,
+     newline_expand_scalar },
+#if NEWLINE_SSE2
+   { "sse2", NULL, newline_replace_sse2, newline_contract_sse2,
+     newline_expand_sse2 },
+#endif
+#if NEWLINE_AVX2
+   { "avx2", newline_have_avx2, newline_replace_avx2, newline_contract_avx2,
+     newline_expand_avx2 },
+#endif
+   { NULL }
+} ;
+
+static const struct newline_impl *newline_impl;	/* NULL: not yet selected */
+
+const char *newline_select(const char *name) {
+   const struct newline_impl *impl, *found = NULL;
+
+   for (impl = newline_impls; impl->name != NULL; ++impl) {
+      if (name != NULL && strcmp(impl->name, name)) {
+	 continue;
+      }
+      if (impl->usable == NULL || impl->usable()) {
+	 found = impl;
+      }
+   }
+   if (found == NULL) {
+      return NULL;
+   }
+   newline_impl = found;
+   Debug1("using %s newline conversion", found->name);
+   return found->name;
+}
+
+void newline_replace(unsigned char *buff, size_t len,
+		     unsigned char from, unsigned char to) {
+   if (newline_impl == NULL)  newline_select(NULL);
+   newline_impl->replace(buff, len, from, to);
+}
+
+size_t newline_contract(unsigned char *out, const unsigned char *in,
+			size_t len, unsigned char to) {
+   if (newline_impl == NULL)  newline_select(NULL);
+   return newline_impl->contract(out, in, len, to);
+}
+
+size_t newline_expand(unsigned char *out, const unsigned char *in,
+		      size_t len, unsigned char from) {
+   if (newline_impl == NULL)  newline_select(NULL);
+   return newline_impl->expand(out, in, len, from);
+}
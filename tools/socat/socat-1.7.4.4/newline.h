@@ -0,0 +1,26 @@
+/* source: newline.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __newline_h_included
+#define __newline_h_included 1
+
+/* replaces each byte from in buff with to */
+extern void newline_replace(unsigned char *buff, size_t len,
+			    unsigned char from, unsigned char to);
+/* copies len bytes from in to out, drops each CR and replaces each LF with
+   to. out may be equal to in. returns the number of bytes written to out */
+extern size_t newline_contract(unsigned char *out, const unsigned char *in,
+			       size_t len, unsigned char to);
+/* copies len bytes from in to out and replaces each from with CR LF. out must
+   provide 2*len bytes and must not overlap in. returns the number of bytes
+   written to out */
+extern size_t newline_expand(unsigned char *out, const unsigned char *in,
+			     size_t len, unsigned char from);
+
+/* selects the implementation: "scalar", "sse2", "avx2", or NULL for the best
+   one that the CPU supports. returns the name of the selected implementation,
+   or NULL when it is not available */
+extern const char *newline_select(const char *name);
+
+#endif /* !defined(__newline_h_included) */
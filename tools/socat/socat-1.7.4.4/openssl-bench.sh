@@ -0,0 +1,70 @@
+#! /usr/bin/env bash
+# source: openssl-bench.sh
+# Copyright Gerhard Rieger and contributors (see file CHANGES)
+# Published under the GNU General Public License V.2, see file COPYING
+
+# measures TLS handshake latency and CPU time of socat: a forking
+# OPENSSL-LISTEN server answers a number of short OPENSSL client connections,
+# with full handshakes and with sessions resumed by option
+# openssl-session-cache. it requires the openssl command for a test
+# certificate.
+# usage: ./openssl-bench.sh [connections [port]]
+
+if [ -x ./socat ]; then
+    SOCAT=./socat
+else
+    SOCAT=socat
+fi
+
+N=${1:-200}
+PORT=${2:-47201}
+
+TD=$(mktemp -d /tmp/socat-bench.XXXXXX) || exit 1
+trap 'rm -rf "$TD"' EXIT
+
+if ! openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost \
+	-keyout $TD/key.pem -out $TD/cert.crt >/dev/null 2>&1; then
+    echo "failed to generate a certificate with openssl" >&2
+    exit 1
+fi
+cat $TD/key.pem $TD/cert.crt >$TD/cert.pem
+
+# prints user+system CPU ticks of process $1 and its waited-for children
+cputicks () {
+    awk '{ print $14+$15+$16+$17 }' /proc/$1/stat
+}
+
+# runs $N connections; $1: client address options, $2: server address options
+bench () {
+    local t0 t1 ms c0 c1 s1 i pid
+    $SOCAT OPENSSL-LISTEN:$PORT,reuseaddr,fork,cert=$TD/cert.pem,cafile=$TD/cert.crt$2 EXEC:echo &
+    pid=$!
+    sleep 0.5
+    c0=$(cputicks $$)
+    t0=$(date +%s%N)
+    for ((i=0; i<N; ++i)); do
+	if ! $SOCAT - OPENSSL:localhost:$PORT,cafile=$TD/cert.crt,cert=$TD/cert.pem$1 \
+	    </dev/null >/dev/null; then
+	    kill $pid 2>/dev/null; wait $pid 2>/dev/null
+	    echo "connection failed" >&2
+	    exit 1
+	fi
+    done
+    t1=$(date +%s%N)
+    c1=$(cputicks $$)
+    sleep 0.2
+    s1=$(cputicks $pid)
+    kill $pid 2>/dev/null; wait $pid 2>/dev/null
+    ms=$(( (t1-t0)/1000000 ))
+    # ticks: 1/100 s on Linux
+    printf "%-36s %6d us/conn  client %5d us/conn  server %5d us/conn\n" \
+	"$3" $(( ms*1000/N )) $(( (c1-c0)*10000/N )) $(( s1*10000/N ))
+    PORT=$((PORT+1))
+}
+
+echo "$N TLS connections over localhost"
+bench "" "" "full handshake"
+bench ",session-cache=$TD/client.sess" ",session-cache=$TD/ticket.keys" \
+      "resumed (session-cache)"
+bench ",session-cache=$TD/client12.sess,max-version=TLS1.2" \
+      ",session-cache=$TD/ticket.keys" "resumed, TLS 1.2"
@@ -21,6 +21,8 @@
 #include "xio.h"
 #include "xioopts.h"
 #include "xiolockfile.h"
+#include "newline.h"
+#include "uring.h"
 
 
 /* command line options */
@@ -39,6 +41,10 @@ struct {
    int sniffleft;	/* -1 or an FD for teeing data arriving on xfd1 */
    int sniffright;	/* -1 or an FD for teeing data arriving on xfd2 */
    xiolock_t lock;	/* a lock file */
+   bool bufsizauto;	/* no -b: adapt bufsiz to the addresses */
+   bool statistics;	/* print statistics at exit and on SIGUSR1 */
+   const char *statspath;	/* serve statistics on this UNIX socket */
+   bool uring;		/* transfer with io_uring when possible */
 } socat_opts = {
    8192,	/* bufsiz */
    false,	/* verbose */
@@ -54,6 +60,10 @@ struct {
    -1,		/* sniffleft */
    -1,		/* sniffright */
    { NULL, 0 },	/* lock */
+   true,	/* bufsizauto */
+   false,	/* statistics */
+   NULL,	/* statspath */
+   false,	/* uring */
 };
 
 void socat_usage(FILE *fd);
@@ -71,6 +81,18 @@ void crlftolf(char **in, ssize_t *len, size_t bufsiz);
 static int socat_lock(void);
 static void socat_unlock(void);
 static int socat_newchild(void);
+static void socat_stats_signal(int signum);
+static void socat_stats_exit(void);
+static void socat_stats_open(void);
+static void socat_stats_serve(void);
+static void socat_stats_dump(void);
+static void socat_dump_init(void);
+#if HAVE_SYS_EPOLL_H
+static int socat_eventloop(const xiofile_t *tmpl2);
+#endif
+#if WITH_VSOCK && defined(SO_VM_SOCKETS_BUFFER_SIZE)
+static void socat_vsockbufsiz(xiofile_t *xfd1, xiofile_t *xfd2);
+#endif
 
 static const char socatversion[] =
 #include "./VERSION"
@@ -239,9 +261,15 @@ int main(int argc, const char *argv[]) {
 	    }
 	 }
 	 socat_opts.bufsiz = Strtoul(a, (char **)&a, 0, "-b");
+	 socat_opts.bufsizauto = false;
 	 break;
       case 's':  if (arg1[0][2])  { socat_opt_hint(stderr, arg1[0][1], arg1[0][2]); Exit(1); }
 	 diag_set_int('e', E_FATAL); break;
+      case 'S':  socat_opts.statistics = true;
+	 if (arg1[0][2]) {
+	    socat_opts.statspath = *arg1+2;
+	 }
+	 break;
       case 't': if (arg1[0][2]) {
 	    a = *arg1+2;
 	 } else {
@@ -274,6 +302,10 @@ int main(int argc, const char *argv[]) {
 	 socat_opts.lefttoright = true; break;
       case 'U':  if (arg1[0][2])  { socat_opt_hint(stderr, arg1[0][1], arg1[0][2]); Exit(1); }
 	 socat_opts.righttoleft = true; break;
+#if WITH_IOURING
+      case 'I':  if (arg1[0][2])  { socat_opt_hint(stderr, arg1[0][1], arg1[0][2]); Exit(1); }
+	 socat_opts.uring = true; break;
+#endif
       case 'g':  if (arg1[0][2])  { socat_opt_hint(stderr, arg1[0][1], arg1[0][2]); Exit(1); }
 	 xioopts_ignoregroups = true; break;
       case 'L': if (socat_opts.lock.lockfile)
@@ -391,6 +423,16 @@ int main(int argc, const char *argv[]) {
 
    Atexit(socat_unlock);
 
+   if (socat_opts.statistics) {
+      struct sigaction act;
+      sigfillset(&act.sa_mask);
+      act.sa_flags = 0;
+      act.sa_handler = socat_stats_signal;
+      Sigaction(SIGUSR1, &act, NULL);
+      Atexit(socat_stats_exit);
+   }
+   socat_dump_init();
+
    result = socat(arg1[0], arg1[1]);
    Notice1("exiting with status %d", result);
    Exit(result);
@@ -424,12 +466,16 @@ void socat_usage(FILE *fd) {
    fputs("      -x     verbose hexadecimal dump of data traffic\n", fd);
    fputs("      -r <file>      raw dump of data flowing from left to right\n", fd);
    fputs("      -R <file>      raw dump of data flowing from right to left\n", fd);
-   fputs("      -b<size_t>     set data buffer size (8192)\n", fd);
+   fputs("      -b<size_t>     set data buffer size (8192; more with VSOCK)\n", fd);
    fputs("      -s     sloppy (continue on error)\n", fd);
+   fputs("      -S[<path>]     print statistics at exit and on SIGUSR1; serve them on UNIX socket <path>\n", fd);
    fputs("      -t<timeout>    wait seconds before closing second channel\n", fd);
    fputs("      -T<timeout>    total inactivity timeout in seconds\n", fd);
    fputs("      -u     unidirectional mode (left to right)\n", fd);
    fputs("      -U     unidirectional mode (right to left)\n", fd);
+#if WITH_IOURING
+   fputs("      -I     transfer data with io_uring where possible\n", fd);
+#endif
    fputs("      -g     do not check option groups\n", fd);
    fputs("      -L <lockfile>  try to obtain lock, or fail\n", fd);
    fputs("      -W <lockfile>  try to obtain lock, or wait\n", fd);
@@ -621,6 +667,11 @@ void socat_version(FILE *fd) {
 #else
    fputs("  #undef WITH_RETRY\n", fd);
 #endif
+#ifdef WITH_IOURING
+   fprintf(fd, "  #define WITH_IOURING %d\n", WITH_IOURING);
+#else
+   fputs("  #undef WITH_IOURING\n", fd);
+#endif
 #ifdef WITH_MSGLEVEL
    fprintf(fd, "  #define WITH_MSGLEVEL %d /*%s*/\n", WITH_MSGLEVEL,
 	   &"debug\0\0\0info\0\0\0\0notice\0\0warn\0\0\0\0error\0\0\0fatal\0\0\0"[WITH_MSGLEVEL<<3]);
@@ -637,43 +688,66 @@ int closing = 0;	/* 0..no eof yet, 1..first eof just occurred,
 /* call this function when the common command line options are parsed, and the
    addresses are extracted (but not resolved). */
 int socat(const char *address1, const char *address2) {
+   xiofile_t *tmpl2;
    int mayexec;
 
+   /* the second address is parsed only once: the children of a forking first
+      address inherit it, and the event loop opens copies of it */
+   if ((tmpl2 = xioparse(address2)) == NULL) {
+      return -1;
+   }
+#if _WITH_SOCKET
+   /* the pool of option preconnect must not inherit the first address */
+   if (xiopreconnect(tmpl2, socat_opts.lefttoright ? XIO_WRONLY :
+		     socat_opts.righttoleft ? XIO_RDONLY : XIO_RDWR) < 0) {
+      return -1;
+   }
+#endif /* _WITH_SOCKET */
+#if WITH_IP4 && (WITH_TCP || WITH_UDP)
+   /* children of a forking first address take it from the cache */
+   if (xioresolve_prefetch(tmpl2) < 0) {
+      return -1;
+   }
+#endif /* WITH_IP4 && (WITH_TCP || WITH_UDP) */
+
    if (socat_opts.lefttoright) {
-      if ((sock1 = xioopen(address1, XIO_RDONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT)) == NULL) {
+      if ((sock1 = xioopen(address1, XIO_RDONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYEVENTLOOP)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock1, socat_sigchild);
    } else if (socat_opts.righttoleft) {
-      if ((sock1 = xioopen(address1, XIO_WRONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT)) == NULL) {
+      if ((sock1 = xioopen(address1, XIO_WRONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYEVENTLOOP)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock1, socat_sigchild);
    } else {
-      if ((sock1 = xioopen(address1, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT)) == NULL) {
+      if ((sock1 = xioopen(address1, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYEVENTLOOP)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock1, socat_sigchild);
    }
+#if HAVE_SYS_EPOLL_H
+   if (sock1->common.flags & XIO_DOESEVENTLOOP) {
+      /* listener of option event-loop; the connections are handled there */
+      return socat_eventloop(tmpl2);
+   }
+#endif /* HAVE_SYS_EPOLL_H */
 #if 1	/*! */
    if (XIO_READABLE(sock1) &&
        (XIO_RDSTREAM(sock1)->howtoend == END_KILL ||
 	XIO_RDSTREAM(sock1)->howtoend == END_CLOSE_KILL ||
 	XIO_RDSTREAM(sock1)->howtoend == END_SHUTDOWN_KILL)) {
-      int i;
-      for (i = 0; i < NUMUNKNOWN; ++i) {
-	 if (XIO_RDSTREAM(sock1)->para.exec.pid == diedunknown[i]) {
-	    /* child has alread died... but it might have put regular data into
-	       the communication channel, so continue */
-	    Info2("child "F_pid" has already died with status %d",
-		  XIO_RDSTREAM(sock1)->para.exec.pid, statunknown[i]);
-	    if (statunknown[i] != 0) {
-	       return 1;
-	    }
-	    diedunknown[i] = 0;
-	    XIO_RDSTREAM(sock1)->para.exec.pid = 0;
-	    /* return STAT_RETRYLATER; */
+      int status;
+      if (xiochildunknown(XIO_RDSTREAM(sock1)->para.exec.pid, &status)) {
+	 /* child has alread died... but it might have put regular data into
+	    the communication channel, so continue */
+	 Info2("child "F_pid" has already died with status %d",
+	       XIO_RDSTREAM(sock1)->para.exec.pid, status);
+	 if (status != 0) {
+	    return 1;
 	 }
+	 XIO_RDSTREAM(sock1)->para.exec.pid = 0;
+	 /* return STAT_RETRYLATER; */
       }
    }
 #endif
@@ -681,18 +755,18 @@ int socat(const char *address1, const char *address2) {
    mayexec = (sock1->common.flags&XIO_DOESCONVERT ? 0 : XIO_MAYEXEC);
    if (XIO_WRITABLE(sock1)) {
       if (XIO_READABLE(sock1)) {
-	 if ((sock2 = xioopen(address2, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
+	 if ((sock2 = xioopen_parsed(tmpl2, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
 	    return -1;
 	 }
 	 xiosetsigchild(sock2, socat_sigchild);
       } else {
-	 if ((sock2 = xioopen(address2, XIO_RDONLY|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
+	 if ((sock2 = xioopen_parsed(tmpl2, XIO_RDONLY|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
 	    return -1;
 	 }
 	 xiosetsigchild(sock2, socat_sigchild);
       }
    } else {	/* assuming sock1 is readable */
-      if ((sock2 = xioopen(address2, XIO_WRONLY|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
+      if ((sock2 = xioopen_parsed(tmpl2, XIO_WRONLY|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock2, socat_sigchild);
@@ -702,20 +776,17 @@ int socat(const char *address1, const char *address2) {
        (XIO_RDSTREAM(sock2)->howtoend == END_KILL ||
 	XIO_RDSTREAM(sock2)->howtoend == END_CLOSE_KILL ||
 	XIO_RDSTREAM(sock2)->howtoend == END_SHUTDOWN_KILL)) {
-      int i;
-      for (i = 0; i < NUMUNKNOWN; ++i) {
-	 if (XIO_RDSTREAM(sock2)->para.exec.pid == diedunknown[i]) {
-	    /* child has alread died... but it might have put regular data into
-	       the communication channel, so continue */
-	    Info2("child "F_pid" has already died with status %d",
-		  XIO_RDSTREAM(sock2)->para.exec.pid, statunknown[i]);
-	    if (statunknown[i] != 0) {
-	       return 1;
-	    }
-	    diedunknown[i] = 0;
-	    XIO_RDSTREAM(sock2)->para.exec.pid = 0;
-	    /* return STAT_RETRYLATER; */
+      int status;
+      if (xiochildunknown(XIO_RDSTREAM(sock2)->para.exec.pid, &status)) {
+	 /* child has alread died... but it might have put regular data into
+	    the communication channel, so continue */
+	 Info2("child "F_pid" has already died with status %d",
+	       XIO_RDSTREAM(sock2)->para.exec.pid, status);
+	 if (status != 0) {
+	    return 1;
 	 }
+	 XIO_RDSTREAM(sock2)->para.exec.pid = 0;
+	 /* return STAT_RETRYLATER; */
       }
    }
 #endif
@@ -771,22 +842,297 @@ int childleftdata(xiofile_t *xfd) {
 }
 
 int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
-		unsigned char *buff, size_t bufsiz, bool righttoleft);
+		unsigned char *buff, size_t bufsiz, bool righttoleft,
+		bool maywrite);
+static size_t xiotransfer_room(xiofile_t *inpipe, xiofile_t *outpipe);
+static size_t socat_wrbufsiz(xiofile_t *inpipe, xiofile_t *outpipe);
+
+#if HAVE_SPLICE
+/* state of the splice() based transfer of one direction */
+struct xiosplice {
+   bool active;		/* this direction transfers data with splice() */
+   int  pipefd[2];	/* intermediate pipe that holds the data */
+   bool ktls;		/* input is a kernel TLS socket (option openssl-ktls) */
+   bool ktlsrecord;	/* kernel refused the last record, OpenSSL read it */
+   size_t pending;	/* bytes in the pipe not yet taken by the output */
+} ;
+
+static int xiosplice_init(struct xiosplice *sp, xiofile_t *inpipe,
+			  xiofile_t *outpipe, size_t bufsiz, bool righttoleft);
+static void xiosplice_close(struct xiosplice *sp);
+static ssize_t xiosplice_write(struct xiosplice *sp, xiofile_t *outpipe,
+			       unsigned char *buff, bool righttoleft);
+static int xiotransfer_splice(struct xiosplice *sp,
+			      xiofile_t *inpipe, xiofile_t *outpipe,
+			      unsigned char *buff, size_t bufsiz,
+			      bool righttoleft);
+
+static struct xiosplice splice1 = { false, { -1, -1 }, false, false, 0 };	/* sock1 to sock2 */
+static struct xiosplice splice2 = { false, { -1, -1 }, false, false, 0 };	/* sock2 to sock1 */
+#endif /* HAVE_SPLICE */
+
+static size_t socat_wrpending(xiofile_t *sock);
+static ssize_t socat_flush(xiofile_t *sock, unsigned char *buff);
+
+#if _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG
+static bool xiobatch_init(xiofile_t *inpipe, xiofile_t *outpipe);
+static ssize_t xiotransfer_batch(xiofile_t *inpipe, xiofile_t *outpipe,
+				 size_t bufsiz, bool righttoleft);
+
+static bool batch1 = false;	/* sock1 to sock2 with sendmmsg() */
+static bool batch2 = false;	/* sock2 to sock1 with sendmmsg() */
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG */
+
+#if WITH_IOURING
+static int socat_uring(void);
+#endif /* WITH_IOURING */
 
 bool mayrd1;		/* sock1 has read data or eof, according to poll() */
 bool mayrd2;		/* sock2 has read data or eof, according to poll() */
 bool maywr1;		/* sock1 can be written to, according to poll() */
 bool maywr2;		/* sock2 can be written to, according to poll() */
 
+/* transfer statistics (option -S). The counters are always kept; they cost a
+   few increments per block. Only the latency needs the time, so it is taken
+   with -S only */
+#define SOCAT_STATS_BUCKETS 24	/* log2 histograms: 0..1, 2..3, 4..7, ... */
+
+struct socat_statsdir {
+   unsigned long long bytesread;
+   unsigned long long byteswritten;	/* or buffered */
+   unsigned long long reads;
+   unsigned long long writes;
+   unsigned long long eagain;		/* reads that found no data */
+   unsigned long long sizes[SOCAT_STATS_BUCKETS];	/* bytes per read */
+   unsigned long long latency[SOCAT_STATS_BUCKETS];	/* usecs poll to write */
+} ;
+
+static struct {
+   struct timeval start;	/* begin of transfer; 0 when none */
+   struct timeval polled;	/* when poll() returned last, with -S */
+   unsigned long long wakeups;	/* returns from poll() or epoll_wait() */
+   struct socat_statsdir dir[2];	/* [0] left to right, [1] right to left */
+} socat_stats;
+
+static volatile sig_atomic_t socat_statsreq;	/* SIGUSR1 arrived */
+static int socat_statsfd = -1;	/* listening socket of -S<path> */
+
+static unsigned int socat_stats_bucket(unsigned long long val) {
+   unsigned int b = 0;
+#if defined(__GNUC__)
+   if (val > 1)  b = 63 - __builtin_clzll(val);
+#else
+   while (val >>= 1)  ++b;
+#endif
+   return b < SOCAT_STATS_BUCKETS ? b : SOCAT_STATS_BUCKETS-1;
+}
+
+/* the transfer process returned from poll() */
+static void socat_stats_wakeup(void) {
+   ++socat_stats.wakeups;
+   if (socat_opts.statistics) {
+      gettimeofday(&socat_stats.polled, NULL);	/* not traced, too frequent */
+   }
+}
+
+/* counts a read of direction d; call it right after the read, with errno */
+static void socat_stats_read(int d, ssize_t bytes) {
+   struct socat_statsdir *st = &socat_stats.dir[d];
+
+   if (bytes < 0) {
+      if (errno == EAGAIN)  ++st->eagain;
+      return;
+   }
+   ++st->reads;
+   st->bytesread += bytes;
+   ++st->sizes[socat_stats_bucket(bytes)];
+}
+
+/* counts a write of direction d */
+static void socat_stats_write(int d, ssize_t writt) {
+   struct socat_statsdir *st = &socat_stats.dir[d];
+
+   ++st->writes;
+   st->byteswritten += writt;
+   if (socat_opts.statistics && socat_stats.polled.tv_sec != 0) {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      ++st->latency[socat_stats_bucket(
+	    (now.tv_sec-socat_stats.polled.tv_sec)*1000000LL +
+	    now.tv_usec-socat_stats.polled.tv_usec)];
+   }
+}
+
+/* sniff data (-r, -R) and the -v/-x dump are written with one write() per
+   block. When an output would block, the rest of the block waits in a queue
+   that is flushed when poll() reports the FD writable, so the transfer never
+   waits for a slow reader of these outputs */
+#define SOCAT_DUMPQ_MAX (4*1024*1024)	/* max bytes waiting per output */
+#define SOCAT_DUMPQ_RETRY 10	/* ms, event loop retries queued output */
+#define SOCAT_DUMPQ_EXITWAIT 5000	/* ms without progress on exit */
+
+struct socat_dumpq {
+   int fd;		/* -1 when not used */
+   int sendflags;	/* socket: use send() with these flags */
+   const char *name;	/* for messages */
+   char *buff;
+   size_t size;		/* allocated bytes of buff */
+   size_t off;		/* begin of queued data in buff */
+   size_t len;		/* queued bytes */
+   unsigned long long dropped;	/* bytes dropped because queue was full */
+} ;
+
+/* [0] sniff left to right, [1] sniff right to left, [2] -v/-x on stderr */
+static struct socat_dumpq socat_dumpq[3] = {
+   { -1, 0, "-r" }, { -1, 0, "-R" }, { -1, 0, "-v/-x" } };
+
+/* writes as much of data as the output takes without blocking.
+   returns the number of bytes written, or -1 on error (data lost) */
+static ssize_t socat_dump_write(struct socat_dumpq *q,
+				const char *data, size_t len) {
+   ssize_t writt;
+
+   do {
+      if (q->sendflags) {
+	 writt = Send(q->fd, data, len, q->sendflags);
+      } else {
+	 writt = Write(q->fd, data, len);
+      }
+   } while (writt < 0 && errno == EINTR);
+   if (writt < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	 return 0;
+      }
+      Warn5("%s: write(%d, %p, "F_Zu"): %s",
+	    q->name, q->fd, data, len, strerror(errno));
+   }
+   return writt;
+}
+
+/* writes queued data of q as far as possible without blocking */
+static void socat_dump_flush(struct socat_dumpq *q) {
+   ssize_t writt;
+
+   if (q->len == 0) {
+      return;
+   }
+   if ((writt = socat_dump_write(q, q->buff+q->off, q->len)) < 0) {
+      writt = q->len;		/* already reported */
+   }
+   q->off += writt;
+   q->len -= writt;
+   if (q->len == 0) {
+      q->off = 0;
+      if (q->dropped) {
+	 Warn2("%s: output did not keep up, dropped %llu bytes",
+	       q->name, q->dropped);
+	 q->dropped = 0;
+      }
+   }
+}
+
+/* writes data to the output of q, or queues it when the output would block */
+static void socat_dump_put(struct socat_dumpq *q,
+			   const void *data, size_t len) {
+   ssize_t writt;
+
+   if (q->fd < 0) {
+      return;
+   }
+   if (q->len == 0) {
+      if ((writt = socat_dump_write(q, data, len)) < 0) {
+	 return;
+      }
+      data = (const char *)data + writt;
+      len -= writt;
+      if (len == 0) {
+	 return;
+      }
+   }
+   if (q->len + len > SOCAT_DUMPQ_MAX) {
+      q->dropped += len;
+      return;
+   }
+   if (q->off + q->len + len > q->size) {
+      memmove(q->buff, q->buff+q->off, q->len);
+      q->off = 0;
+      if (q->len + len > q->size) {
+	 size_t size = Max(2*q->size, q->len+len);
+	 char *buff;
+	 if ((buff = Realloc(q->buff, size)) == NULL) {
+	    q->dropped += len;
+	    return;
+	 }
+	 q->buff = buff;
+	 q->size = size;
+      }
+   }
+   memcpy(q->buff+q->off+q->len, data, len);
+   q->len += len;
+}
+
+/* fills pollfds for all outputs with queued data.
+   fds must provide space for 3 entries; returns the number of entries */
+static int socat_dump_pollfds(struct pollfd *fds) {
+   int i, n = 0;
+
+   for (i = 0; i < 3; ++i) {
+      if (socat_dumpq[i].len > 0) {
+	 fds[n].fd = socat_dumpq[i].fd;
+	 fds[n].events = POLLOUT;
+	 fds[n].revents = 0;
+	 ++n;
+      }
+   }
+   return n;
+}
+
+static bool socat_dump_pending(void) {
+   return
+      socat_dumpq[0].len > 0 || socat_dumpq[1].len > 0 ||
+      socat_dumpq[2].len > 0;
+}
+
+static void socat_dump_flushall(void) {
+   socat_dump_flush(&socat_dumpq[0]);
+   socat_dump_flush(&socat_dumpq[1]);
+   socat_dump_flush(&socat_dumpq[2]);
+}
+
+/* waits until queued output is written, but gives up on an output that does
+   not take data for SOCAT_DUMPQ_EXITWAIT ms */
+static void socat_dump_exit(void) {
+   struct pollfd pfd;
+   int i, rc;
+
+   for (i = 0; i < 3; ++i) {
+      struct socat_dumpq *q = &socat_dumpq[i];
+      while (q->len > 0) {
+	 pfd.fd = q->fd;  pfd.events = POLLOUT;  pfd.revents = 0;
+	 rc = Poll(&pfd, 1, SOCAT_DUMPQ_EXITWAIT);
+	 if (rc == 0 || (rc < 0 && errno != EINTR)) {
+	    Warn2("%s: output blocked, dropping "F_Zu" bytes on exit",
+		  q->name, q->len);
+	    q->len = 0;
+	    break;
+	 }
+	 socat_dump_flush(q);
+      }
+   }
+}
+
 /* here we come when the sockets are opened (in the meaning of C language),
    and their options are set/applied
    returns -1 on error or 0 on success */
 int _socat(void) {
-   struct pollfd fds[4],
+   struct pollfd fds[9],
        *fd1in  = &fds[0],
        *fd1out = &fds[1],
        *fd2in  = &fds[2],
-       *fd2out = &fds[3];
+       *fd2out = &fds[3],
+       *fdstats = &fds[4],	/* only with -S<path> */
+       *fdchild = &fds[5],	/* a child terminated, see xiochildfd() */
+       *fddump  = &fds[6];	/* queued sniff and -v/-x output */
    int retval;
    unsigned char *buff;
    ssize_t bytes1, bytes2;
@@ -823,6 +1169,12 @@ int _socat(void) {
    }
 #endif /* WITH_FILAN */
 
+#if WITH_VSOCK && defined(SO_VM_SOCKETS_BUFFER_SIZE)
+   if (socat_opts.bufsizauto) {
+      socat_vsockbufsiz(sock1, sock2);
+   }
+#endif
+
    /* when converting nl to crnl, size might double */
    if (socat_opts.bufsiz > (SIZE_MAX-1)/2) {
       Error2("buffer size option (-b) to big - "F_Zu" (max is "F_Zu")", socat_opts.bufsiz, (SIZE_MAX-1)/2);
@@ -850,12 +1202,62 @@ int _socat(void) {
       xiosetopt('l', "\0");
    }
    total_timeout = socat_opts.total_timeout;
+   socat_stats_open();
+
+#if WITH_IOURING
+   if (socat_opts.uring && (retval = socat_uring()) <= 0) {
+      if (retval == 0) {
+	 xioclose(sock1);
+	 xioclose(sock2);
+      }
+      free(buff);
+      return retval;
+   }
+   /* else io_uring cannot be used, continue with poll() */
+#endif /* WITH_IOURING */
+
+#if HAVE_SPLICE
+   if (XIO_READABLE(sock1) && XIO_WRITABLE(sock2) && !socat_opts.righttoleft) {
+      xiosplice_init(&splice1, sock1, sock2, socat_opts.bufsiz, false);
+   }
+   if (XIO_READABLE(sock2) && XIO_WRITABLE(sock1) && !socat_opts.lefttoright) {
+      xiosplice_init(&splice2, sock2, sock1, socat_opts.bufsiz, true);
+   }
+#endif /* HAVE_SPLICE */
+#if _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG
+   if (XIO_READABLE(sock1) && XIO_WRITABLE(sock2) && !socat_opts.righttoleft) {
+      batch1 = xiobatch_init(sock1, sock2);
+   }
+   if (XIO_READABLE(sock2) && XIO_WRITABLE(sock1) && !socat_opts.lefttoright) {
+      batch2 = xiobatch_init(sock2, sock1);
+   }
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG */
+
+   /* give each direction that does not splice() a write buffer of bufsiz
+      bytes (twice that when converting to CRNL, see xiotransfer_room()), so
+      it can keep reading while the peer does not take data.
+      Datagrams are not read in pieces, so they are written directly */
+   if (XIO_READABLE(sock1) && XIO_WRITABLE(sock2) && !socat_opts.righttoleft &&
+#if HAVE_SPLICE
+       !splice1.active &&
+#endif
+       (XIO_RDSTREAM(sock1)->dtype & XIODATA_READMASK) != XIOREAD_RECV) {
+      xiowrbuf_init(sock2, socat_wrbufsiz(sock1, sock2));
+   }
+   if (XIO_READABLE(sock2) && XIO_WRITABLE(sock1) && !socat_opts.lefttoright &&
+#if HAVE_SPLICE
+       !splice2.active &&
+#endif
+       (XIO_RDSTREAM(sock2)->dtype & XIODATA_READMASK) != XIOREAD_RECV) {
+      xiowrbuf_init(sock1, socat_wrbufsiz(sock2, sock1));
+   }
 
    Notice4("starting data transfer loop with FDs [%d,%d] and [%d,%d]",
 	   XIO_GETRDFD(sock1), XIO_GETWRFD(sock1),
 	   XIO_GETRDFD(sock2), XIO_GETWRFD(sock2));
    while (XIO_RDSTREAM(sock1)->eof <= 1 ||
-	  XIO_RDSTREAM(sock2)->eof <= 1) {
+	  XIO_RDSTREAM(sock2)->eof <= 1 ||
+	  socat_wrpending(sock1) > 0 || socat_wrpending(sock2) > 0) {
       struct timeval timeout, *to = NULL;
 
       Debug6("data loop: sock1->eof=%d, sock2->eof=%d, closing=%d, wasaction=%d, total_to={"F_tv_sec"."F_tv_usec"}",
@@ -935,7 +1337,10 @@ int _socat(void) {
 	 if (XIO_READABLE(sock1) &&
 	     !(XIO_RDSTREAM(sock1)->eof > 1 && !XIO_RDSTREAM(sock1)->ignoreeof) &&
 	     !socat_opts.righttoleft) {
-	    if (!mayrd1 && !(XIO_RDSTREAM(sock1)->eof > 1)) {
+	    if (!mayrd1 && !(XIO_RDSTREAM(sock1)->eof > 1) &&
+		(xiotransfer_room(sock1, sock2) > 0 ||
+		 (XIO_WRSTREAM(sock2)->wrbuf.size == 0 &&
+		  socat_wrpending(sock2) == 0))) {
 		fd1in->fd = XIO_GETRDFD(sock1);
 		fd1in->events = POLLIN;
 	    } else {
@@ -954,7 +1359,10 @@ int _socat(void) {
 	 if (XIO_READABLE(sock2) &&
 	     !(XIO_RDSTREAM(sock2)->eof > 1 && !XIO_RDSTREAM(sock2)->ignoreeof) &&
 	     !socat_opts.lefttoright) {
-	    if (!mayrd2 && !(XIO_RDSTREAM(sock2)->eof > 1)) {
+	    if (!mayrd2 && !(XIO_RDSTREAM(sock2)->eof > 1) &&
+		(xiotransfer_room(sock2, sock1) > 0 ||
+		 (XIO_WRSTREAM(sock1)->wrbuf.size == 0 &&
+		  socat_wrpending(sock1) == 0))) {
 		fd2in->fd = XIO_GETRDFD(sock2);
 		fd2in->events = POLLIN;
 	    } else {
@@ -970,8 +1378,34 @@ int _socat(void) {
 	     fd1out->fd = -1;
 	     fd2in->fd = -1;
 	 }
+	 /* buffered data is written even after EOF on its reading side */
+	 if (socat_wrpending(sock1) > 0 && !maywr1) {
+	    fd1out->fd = XIO_GETWRFD(sock1);
+	    fd1out->events = POLLOUT;
+	 }
+	 if (socat_wrpending(sock2) > 0 && !maywr2) {
+	    fd2out->fd = XIO_GETWRFD(sock2);
+	    fd2out->events = POLLOUT;
+	 }
+	 fdstats->fd = socat_statsfd;
+	 fdstats->events = POLLIN;
+	 fdchild->fd = xiochildfd();
+	 fdchild->events = POLLIN;
 	 /* frame 0: innermost part of the transfer loop: check FD status */
-	 retval = xiopoll(fds, 4, to);
+	 retval = xiopoll(fds, 6+socat_dump_pollfds(fddump), to);
+	 _errno = errno; diag_flush(); errno = _errno;	/* messages from signal handlers, also with --enable-fast-sycls */
+	 if (socat_statsreq) {
+	    socat_stats_dump();
+	 }
+	 /* terminated children call back socat_sigchild() from here */
+	 xiochildreap();
+	 errno = _errno;
+	 if (retval > 0 && fdchild->fd >= 0 && fdchild->revents) {
+	    fdchild->revents = 0;
+	    if (--retval == 0) {
+	       continue;	/* recompute the timeout, closing might be set */
+	    }
+	 }
 	 if (retval >= 0 || errno != EINTR) {
 	    break;
 	 }
@@ -979,6 +1413,11 @@ int _socat(void) {
 	 Info1("poll(): %s", strerror(errno));
 	 errno = _errno;
       } while (true);
+      socat_stats_wakeup();
+      socat_dump_flushall();
+      if (retval > 0 && socat_statsfd >= 0 && fdstats->revents) {
+	 socat_stats_serve();
+      }
 
       /* attention:
 	 when an exec'd process sends data and terminates, it is unpredictable
@@ -1017,6 +1456,8 @@ int _socat(void) {
 	 }
 
 	 if (closing) {
+	    /* -t bounds the shutdown, even when an output does not take the
+	       data that still waits for it; xioclose() discards that */
 	    break;
 	 }
 	 /* one possibility to come here is ignoreeof on some fd, but no EOF 
@@ -1062,10 +1503,40 @@ int _socat(void) {
 	 maywr2 = true;
       }
 
-      if (mayrd1 && maywr2) {
+      if (maywr2 && socat_wrpending(sock2) > 0) {
+	 /* first write the data that waits in the buffer */
+	 if (socat_flush(sock2, buff) < 0) {
+	    if (errno != EAGAIN) {
+	       closing = MAX(closing, 1);
+	       Notice("socket 1 to socket 2 is in error");
+	       if (socat_opts.lefttoright) {
+		  break;
+	       }
+	    }
+	 } else {
+	    total_timeout = socat_opts.total_timeout;
+	    wasaction = 1;
+	 }
+	 /* the FD stays writable only when it took all the data */
+	 maywr2 = (socat_wrpending(sock2) == 0);
+      }
+
+      if (mayrd1 && (maywr2 || xiotransfer_room(sock1, sock2) > 0)) {
 	 mayrd1 = false;
-	 if ((bytes1 = xiotransfer(sock1, sock2, buff, socat_opts.bufsiz, false))
-	     < 0) {
+#if HAVE_SPLICE
+	 if (splice1.active) {
+	    bytes1 = xiotransfer_splice(&splice1, sock1, sock2,
+					buff, socat_opts.bufsiz, false);
+	 } else
+#endif /* HAVE_SPLICE */
+#if _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG
+	 if (batch1 && maywr2 && socat_wrpending(sock2) == 0) {
+	    bytes1 = xiotransfer_batch(sock1, sock2, socat_opts.bufsiz, false);
+	 } else
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG */
+	    bytes1 = xiotransfer(sock1, sock2, buff, socat_opts.bufsiz,
+				 false, maywr2);
+	 if (bytes1 < 0) {
 	    if (errno != EAGAIN) {
 	       closing = MAX(closing, 1);
 	       Notice("socket 1 to socket 2 is in error");
@@ -1094,10 +1565,40 @@ int _socat(void) {
 	 bytes1 = -1;
       }
 
-      if (mayrd2 && maywr1) {
+      if (maywr1 && socat_wrpending(sock1) > 0) {
+	 /* first write the data that waits in the buffer */
+	 if (socat_flush(sock1, buff) < 0) {
+	    if (errno != EAGAIN) {
+	       closing = MAX(closing, 1);
+	       Notice("socket 2 to socket 1 is in error");
+	       if (socat_opts.righttoleft) {
+		  break;
+	       }
+	    }
+	 } else {
+	    total_timeout = socat_opts.total_timeout;
+	    wasaction = 1;
+	 }
+	 /* the FD stays writable only when it took all the data */
+	 maywr1 = (socat_wrpending(sock1) == 0);
+      }
+
+      if (mayrd2 && (maywr1 || xiotransfer_room(sock2, sock1) > 0)) {
 	 mayrd2 = false;
-	 if ((bytes2 = xiotransfer(sock2, sock1, buff, socat_opts.bufsiz, true))
-	     < 0) {
+#if HAVE_SPLICE
+	 if (splice2.active) {
+	    bytes2 = xiotransfer_splice(&splice2, sock2, sock1,
+					buff, socat_opts.bufsiz, true);
+	 } else
+#endif /* HAVE_SPLICE */
+#if _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG
+	 if (batch2 && maywr1 && socat_wrpending(sock1) == 0) {
+	    bytes2 = xiotransfer_batch(sock2, sock1, socat_opts.bufsiz, true);
+	 } else
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG */
+	    bytes2 = xiotransfer(sock2, sock1, buff, socat_opts.bufsiz,
+				 true, maywr1);
+	 if (bytes2 < 0) {
 	    if (errno != EAGAIN) {
 	       closing = MAX(closing, 1);
 	       Notice("socket 2 to socket 1 is in error");
@@ -1138,6 +1639,8 @@ int _socat(void) {
 		   XIO_RDSTREAM(sock1)->fd);	/*! */
 	    mayrd1 = true;
 	    polling = 1;	/* do not hook this eof fd to poll for pollintv*/
+	 } else if (socat_wrpending(sock2) > 0) {
+	    ;	/* shut down after the buffered data has been written */
 	 } else if (XIO_RDSTREAM(sock1)->eof <= 2) {
 	    Notice1("socket 1 (fd %d) is at EOF", XIO_GETRDFD(sock1));
 	    xioshutdown(sock2, SHUT_WR);
@@ -1147,7 +1650,7 @@ int _socat(void) {
       } else if (polling && XIO_RDSTREAM(sock1)->ignoreeof) {
 	 polling = 0;
       }
-      if (XIO_RDSTREAM(sock1)->eof >= 2) {
+      if (XIO_RDSTREAM(sock1)->eof >= 2 && socat_wrpending(sock2) == 0) {
 	 if (socat_opts.lefttoright) {
 	    break;
 	 }
@@ -1161,6 +1664,8 @@ int _socat(void) {
 		   XIO_RDSTREAM(sock2)->fd);
 	    mayrd2 = true;
 	    polling = 1;	/* do not hook this eof fd to poll for pollintv*/
+	 } else if (socat_wrpending(sock1) > 0) {
+	    ;	/* shut down after the buffered data has been written */
 	 } else if (XIO_RDSTREAM(sock2)->eof <= 2) {
 	    Notice1("socket 2 (fd %d) is at EOF", XIO_GETRDFD(sock2));
 	    xioshutdown(sock1, SHUT_WR);
@@ -1170,7 +1675,7 @@ int _socat(void) {
       } else if (polling && XIO_RDSTREAM(sock2)->ignoreeof) {
 	 polling = 0;
       }
-      if (XIO_RDSTREAM(sock2)->eof >= 2) {
+      if (XIO_RDSTREAM(sock2)->eof >= 2 && socat_wrpending(sock1) == 0) {
 	 if (socat_opts.righttoleft) {
 	    break;
 	 }
@@ -1181,6 +1686,10 @@ int _socat(void) {
    /* close everything that's still open */
    xioclose(sock1);
    xioclose(sock2);
+#if HAVE_SPLICE
+   xiosplice_close(&splice1);
+   xiosplice_close(&splice2);
+#endif /* HAVE_SPLICE */
 
    free(buff);
    return 0;
@@ -1239,34 +1748,248 @@ static const char *prefixltor = "> ";
 static const char *prefixrtol = "< ";
 static unsigned long numltor;
 static unsigned long numrtol;
-/* print block header (during verbose or hex dump)
-   returns 0 on success or -1 if an error occurred */
-static int
-   xioprintblockheader(FILE *file, size_t bytes, bool righttoleft) {
+/* prints the block header (during verbose or hex dump) to buff, which must
+   provide space for SOCAT_DUMPHDRLEN bytes.
+   returns the length of the header, or 0 if an error occurred */
+#define SOCAT_DUMPHDRLEN (128+MAXTIMESTAMPLEN)
+static size_t
+   xioprintblockheader(char *buff, size_t bytes, bool righttoleft) {
    char timestamp[MAXTIMESTAMPLEN];
-   char buff[128+MAXTIMESTAMPLEN];
+   int len;
    if (gettimestamp(timestamp) < 0) {
-      return -1;
+      return 0;
    }
    if (righttoleft) {
-      sprintf(buff, "%s%s length="F_Zu" from=%lu to=%lu\n",
-	      prefixrtol, timestamp, bytes, numrtol, numrtol+bytes-1);
+      len = sprintf(buff, "%s%s length="F_Zu" from=%lu to=%lu\n",
+		    prefixrtol, timestamp, bytes, numrtol, numrtol+bytes-1);
       numrtol+=bytes;
    } else {
-      sprintf(buff, "%s%s length="F_Zu" from=%lu to=%lu\n",
-	      prefixltor, timestamp, bytes, numltor, numltor+bytes-1);
+      len = sprintf(buff, "%s%s length="F_Zu" from=%lu to=%lu\n",
+		    prefixltor, timestamp, bytes, numltor, numltor+bytes-1);
       numltor+=bytes;
    }
-   fputs(buff, file);
-   return 0;
+   return len;
+}
+
+/* the -v and -x representations of each byte value, filled by
+   socat_dump_init() */
+static char socat_hextab[256][3];	/* " 00" .. " ff" */
+static char socat_asctab[256];		/* char or '.' (-v -x) */
+static char socat_vistab[256][3];	/* [0]: length, [1..2]: text (-v) */
+
+static void socat_dump_tables(void) {
+   static const char hexdigit[] = "0123456789abcdef";
+   int c;
+
+   for (c = 0; c < 256; ++c) {
+      socat_hextab[c][0] = ' ';
+      socat_hextab[c][1] = hexdigit[c>>4];
+      socat_hextab[c][2] = hexdigit[c&0x0f];
+      socat_asctab[c] = isprint(c) ? c : '.';
+      socat_vistab[c][0] = 1;
+      socat_vistab[c][1] = socat_asctab[c];
+   }
+   socat_vistab['\t'][1] = '\t';
+   socat_vistab['\n'][1] = '\n';
+   socat_vistab['\a'][0] = 2;  socat_vistab['\a'][1] = '\\';  socat_vistab['\a'][2] = 'a';
+   socat_vistab['\b'][0] = 2;  socat_vistab['\b'][1] = '\\';  socat_vistab['\b'][2] = 'b';
+   socat_vistab['\v'][0] = 2;  socat_vistab['\v'][1] = '\\';  socat_vistab['\v'][2] = 'v';
+   socat_vistab['\f'][0] = 2;  socat_vistab['\f'][1] = '\\';  socat_vistab['\f'][2] = 'f';
+   socat_vistab['\r'][0] = 2;  socat_vistab['\r'][1] = '\\';  socat_vistab['\r'][2] = 'r';
+   socat_vistab['\\'][0] = 2; socat_vistab['\\'][1] = '\\'; socat_vistab['\\'][2] = '\\';
+}
+
+/* sets up the outputs of the sniff files and of -v/-x */
+static void socat_dump_init(void) {
+   struct stat buf;
+   int fd;
+
+   socat_dumpq[0].fd = socat_opts.sniffleft;
+   socat_dumpq[1].fd = socat_opts.sniffright;
+   if (socat_opts.verbose || socat_opts.verbhex) {
+      socat_dump_tables();
+      socat_dumpq[2].fd = 2;
+      /* other processes share the open file of stderr, so do not change it
+	 to nonblocking mode: use MSG_DONTWAIT on a socket, and open a pipe or
+	 terminal once more */
+      if (Fstat(2, &buf) < 0) {
+	 ;
+      } else if (S_ISSOCK(buf.st_mode)) {
+	 socat_dumpq[2].sendflags = MSG_DONTWAIT;
+      } else if (S_ISFIFO(buf.st_mode) || S_ISCHR(buf.st_mode)) {
+	 if ((fd = Open("/dev/fd/2", O_WRONLY|O_NONBLOCK|O_NOCTTY, 0)) < 0) {
+	    Info1("open(\"/dev/fd/2\", ...): %s; -v/-x output might block",
+		  strerror(errno));
+	 } else {
+	    Fcntl_l(fd, F_SETFD, FD_CLOEXEC);
+	    socat_dumpq[2].fd = fd;
+	 }
+      }
+   }
+   if (socat_dumpq[0].fd >= 0 || socat_dumpq[1].fd >= 0 ||
+       socat_dumpq[2].fd >= 0) {
+      Atexit(socat_dump_exit);
+   }
+}
+
+/* formats the data in -v and/or -x format into a staging buffer and passes
+   it to the -v/-x output with one write */
+static void socat_dump_format(const unsigned char *buff, size_t bytes,
+			      bool righttoleft) {
+   static char *stage;
+   static size_t stagesiz;
+   size_t need;
+   char *p;
+   size_t i;
+
+   if (socat_opts.verbose && socat_opts.verbhex) {
+      need = 52*bytes + 3;	/* worst case: newlines only, 52 per line */
+   } else if (socat_opts.verbose) {
+      need = 2*bytes;
+   } else {
+      need = 3*bytes + 1;
+   }
+   need += SOCAT_DUMPHDRLEN;
+   if (need > stagesiz) {
+      free(stage);
+      if ((stage = Malloc(need)) == NULL) {
+	 stagesiz = 0;
+	 return;
+      }
+      stagesiz = need;
+   }
+   p = stage;
+   p += xioprintblockheader(p, bytes, righttoleft);
+
+   if (socat_opts.verbose && socat_opts.verbhex) {
+      /* lines of up to 16 bytes, a newline in the data ends a line */
+      const unsigned char *s = buff, *end = buff+bytes;
+      while (s < end) {
+	 size_t j = Min(16, (size_t)(end-s));
+	 size_t n = 0;
+
+	 while (n < j) {
+	    memcpy(p, socat_hextab[s[n]], 3);  p += 3;
+	    if (s[n++] == '\n')  break;
+	 }
+	 /* fill hex column */
+	 memset(p, ' ', 3*(16-n)+2);  p += 3*(16-n)+2;
+	 for (i = 0; i < n; ++i) {
+	    *p++ = socat_asctab[s[i]];
+	 }
+	 *p++ = '\n';
+	 s += n;
+      }
+      memcpy(p, "--\n", 3);  p += 3;
+   } else if (socat_opts.verbose) {
+      for (i = 0; i < bytes; ++i) {
+	 const char *v = socat_vistab[buff[i]];
+	 p[0] = v[1];  p[1] = v[2];
+	 p += v[0];
+      }
+   } else {
+      for (i = 0; i < bytes; ++i) {
+	 memcpy(p, socat_hextab[buff[i]], 3);  p += 3;
+      }
+      *p++ = '\n';
+   }
+   socat_dump_put(&socat_dumpq[2], stage, p-stage);
+}
+
+/* returns true when a feature needs to see the data from inpipe to outpipe:
+   escape char, line terminator conversion, sniff file, or -v/-x dump. Without
+   them xiotransfer_inspect() can be skipped */
+static bool xiotransfer_inspecting(xiofile_t *inpipe, xiofile_t *outpipe,
+				   bool righttoleft) {
+   return
+      XIO_RDSTREAM(inpipe)->escape != -1 ||
+      XIO_RDSTREAM(inpipe)->lineterm != XIO_WRSTREAM(outpipe)->lineterm ||
+      (righttoleft ? socat_opts.sniffright : socat_opts.sniffleft) >= 0 ||
+      socat_opts.verbose || socat_opts.verbhex;
+}
+
+/* inspects and converts the bytes that have been read from inpipe before they
+   are written to outpipe: checks for the escape char, converts line
+   terminators, and writes the data to the sniff files and in -v/-x format to
+   stderr.
+   buff must provide space for 2*bytes+1 bytes.
+   Returns the resulting number of bytes; 0 when the escape char was found at
+   the beginning of the data, or <0 with EAGAIN when the conversions left no
+   data */
+static ssize_t xiotransfer_inspect(xiofile_t *inpipe, xiofile_t *outpipe,
+			    unsigned char *buff, ssize_t bytes,
+			    bool righttoleft) {
+   /* handle escape char */
+   if (XIO_RDSTREAM(inpipe)->escape != -1) {
+      /* check input data for escape char */
+      unsigned char *ptr;
+      if ((ptr = memchr(buff, XIO_RDSTREAM(inpipe)->escape, bytes)) != NULL) {
+	 /* found: set flag, truncate input data */
+	 XIO_RDSTREAM(inpipe)->actescape = true;
+	 XIO_RDSTREAM(inpipe)->eof = 2;	/* read no more from this direction */
+	 bytes = ptr - buff;
+	 Info("escape char found in input");
+      }
+   }
+   if (bytes == 0) {
+      return 0;
+   }
+
+   if (XIO_RDSTREAM(inpipe)->lineterm !=
+       XIO_WRSTREAM(outpipe)->lineterm) {
+      cv_newline(buff, &bytes,
+		 XIO_RDSTREAM(inpipe)->lineterm,
+		 XIO_WRSTREAM(outpipe)->lineterm);
+   }
+   if (bytes == 0) {
+      errno = EAGAIN;  return -1;
+   }
+
+   if (!righttoleft && socat_opts.sniffleft >= 0) {
+      socat_dump_put(&socat_dumpq[0], buff, bytes);
+   } else if (righttoleft && socat_opts.sniffright >= 0) {
+      socat_dump_put(&socat_dumpq[1], buff, bytes);
+   }
+
+   if (socat_opts.verbose || socat_opts.verbhex) {
+      socat_dump_format(buff, bytes, righttoleft);
+   }
+   return bytes;
+}
+
+
+/* returns how many bytes xiotransfer() may read from inpipe so that the
+   converted data fits into the write buffer of outpipe; 0 when outpipe has no
+   write buffer or it is full. Conversion to CRNL might double the data, so
+   then a single free byte is not enough */
+static size_t xiotransfer_room(xiofile_t *inpipe, xiofile_t *outpipe) {
+   size_t room = XIO_WRROOM(outpipe);
+
+   if (XIO_WRSTREAM(outpipe)->lineterm == LINETERM_CRNL &&
+       XIO_RDSTREAM(inpipe)->lineterm != LINETERM_CRNL) {
+      room /= 2;
+   }
+   return room;
 }
 
+/* returns the size of the write buffer of outpipe for the data from inpipe:
+   a block of -b bytes must fit after conversion */
+static size_t socat_wrbufsiz(xiofile_t *inpipe, xiofile_t *outpipe) {
+   if (XIO_WRSTREAM(outpipe)->lineterm == LINETERM_CRNL &&
+       XIO_RDSTREAM(inpipe)->lineterm != LINETERM_CRNL) {
+      return 2*socat_opts.bufsiz;
+   }
+   return socat_opts.bufsiz;
+}
 
 /* inpipe is suspected to have read data available; read at most bufsiz bytes
    and transfer them to outpipe. Perform required data conversions.
    buff must be a malloc()'ed storage and might be realloc()'ed in this
    function if more space is required after conversions. 
-   Returns the number of bytes written, or 0 on EOF or <0 if an
+   When outpipe has a write buffer (see xiowrbuf_init()), it reads at most
+   what fits into the buffer; data that cannot be written immediately, or all
+   data when maywrite is false, is kept there for xioflush().
+   Returns the number of bytes written or buffered, or 0 on EOF or <0 if an
    error occurred or when data was read but none written due to conversions
    (with EAGAIN). EAGAIN also occurs when reading from a nonblocking FD where
    the file has a mandatory lock.
@@ -1275,10 +1998,19 @@ static int
    */
 /* inpipe, outpipe must be single descriptors (not dual!) */
 int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
-		unsigned char *buff, size_t bufsiz, bool righttoleft) {
+		unsigned char *buff, size_t bufsiz, bool righttoleft,
+		bool maywrite) {
    ssize_t bytes, writt = 0;
 
+	 if (XIO_WRSTREAM(outpipe)->wrbuf.size > 0) {
+	    size_t room = xiotransfer_room(inpipe, outpipe);
+	    if (room == 0) {
+	       errno = EAGAIN;  return -1;
+	    }
+	    bufsiz = Min(bufsiz, room);
+	 }
 	 bytes = xioread(inpipe, buff, bufsiz);
+	 socat_stats_read(righttoleft, bytes);
 	 if (bytes < 0) {
 	    if (errno != EAGAIN)
 	       XIO_RDSTREAM(inpipe)->eof = 2;
@@ -1292,135 +2024,20 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	    closing = MAX(closing, 1);
 	 }
 
-	 if (bytes > 0) {
-	    /* handle escape char */
-	    if (XIO_RDSTREAM(inpipe)->escape != -1) {
-	       /* check input data for escape char */
-	       unsigned char *ptr = buff;
-	       size_t ctr = 0;
-	       while (ctr < bytes) {
-		  if (*ptr == XIO_RDSTREAM(inpipe)->escape) {
-		     /* found: set flag, truncate input data */
-		     XIO_RDSTREAM(inpipe)->actescape = true;
-		     bytes = ctr;
-		     Info("escape char found in input");
-		     break;
-		  }
-		  ++ptr; ++ctr;
-	       }
-	       if (ctr != bytes) {
-		  XIO_RDSTREAM(inpipe)->eof = 2;
-	       }
+	 if (bytes > 0 &&
+	     xiotransfer_inspecting(inpipe, outpipe, righttoleft)) {
+	    bytes = xiotransfer_inspect(inpipe, outpipe, buff, bytes,
+					righttoleft);
+	    if (bytes < 0) {
+	       return -1;
 	    }
 	 }
 
 	    if (bytes > 0) {
-
-	    if (XIO_RDSTREAM(inpipe)->lineterm !=
-		XIO_WRSTREAM(outpipe)->lineterm) {
-	       cv_newline(buff, &bytes,
-			  XIO_RDSTREAM(inpipe)->lineterm,
-			  XIO_WRSTREAM(outpipe)->lineterm);
-	    }
-	    if (bytes == 0) {
-	       errno = EAGAIN;  return -1;
-	    }
-
-	    if (!righttoleft && socat_opts.sniffleft >= 0) {
-	       Write(socat_opts.sniffleft, buff, bytes);
-	    } else if (righttoleft && socat_opts.sniffright >= 0) {
-	       Write(socat_opts.sniffright, buff, bytes);
-	    }
-
-	    if (socat_opts.verbose && socat_opts.verbhex) {
-	       /* Hack-o-rama */
-	       size_t i = 0;
-	       size_t j;
-	       size_t N = 16;
-	       const unsigned char *end, *s, *t;
-	       s = buff;
-	       end = buff+bytes;
-	       xioprintblockheader(stderr, bytes, righttoleft);
-	       while (s < end) {
-		  /*! prefix? */
-		  j = Min(N, (size_t)(end-s));
-
-		  /* print hex */
-		  t = s;
-		  i = 0;
-		  while (i < j) {
-		     int c = *t++;
-		     fprintf(stderr, " %02x", c);
-		     ++i;
-		     if (c == '\n')  break;
-		  }
-
-		  /* fill hex column */
-		  while (i < N) {
-		     fputs("   ", stderr);
-		     ++i;
-		  }
-		  fputs("  ", stderr);
-
-		  /* print acsii */
-		  t = s;
-		  i = 0;
-		  while (i < j) {
-		     int c = *t++;
-		     if (c == '\n') {
-			fputc('.', stderr);
-			break;
-		     }
-		     if (!isprint(c))
-			c = '.';
-		     fputc(c, stderr);
-		     ++i;
-		  }
-
-		  fputc('\n', stderr);
-		  s = t;
-	       }
-	       fputs("--\n", stderr);
-	    } else if (socat_opts.verbose) {
-	       size_t i = 0;
-	       xioprintblockheader(stderr, bytes, righttoleft);
-	       while (i < (size_t)bytes) {
-		  int c = buff[i];
-		  if (i > 0 && buff[i-1] == '\n')
-		     /*! prefix? */;
-		  switch (c) {
-		  case '\a' : fputs("\\a", stderr); break;
-		  case '\b' : fputs("\\b", stderr); break;
-		  case '\t' : fputs("\t", stderr); break;
-		  case '\n' : fputs("\n", stderr); break;
-		  case '\v' : fputs("\\v", stderr); break;
-		  case '\f' : fputs("\\f", stderr); break;
-		  case '\r' : fputs("\\r", stderr); break;
-		  case '\\' : fputs("\\\\", stderr); break;
-		  default:
-		     if (!isprint(c))
-			c = '.';
-		     fputc(c, stderr);
-		     break;
-		  }
-		  ++i;
-	       }
-	    } else if (socat_opts.verbhex) {
-	       int i;
-	       /* print prefix */
-	       xioprintblockheader(stderr, bytes, righttoleft);
-	       for (i = 0; i < bytes; ++i) {
-		  fprintf(stderr, " %02x", buff[i]);
-	       }
-	       fputc('\n', stderr);
-	    }
-
-	    writt = xiowrite(outpipe, buff, bytes);
+	    writt = xiowritebuffered(outpipe, buff, bytes, maywrite);
 	    if (writt < 0) {
-	       /* EAGAIN when nonblocking but a mandatory lock is on file.
-		  the problem with EAGAIN is that the read cannot be repeated,
-		  so we need to buffer the data and try to write it later
-		  again. not yet implemented, sorry. */
+	       /* data that the FD does not take now (e.g. EAGAIN) stays in
+		  the write buffer; here we only see real errors */
 #if 0
 	       if (errno == EPIPE) {
 		  return 0;	/* can no longer write; handle like EOF */
@@ -1428,6 +2045,7 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 #endif
 	       return -1;
 	    } else {
+	       socat_stats_write(righttoleft, writt);
 	       Info3("transferred "F_Zu" bytes from %d to %d",
 		     writt, XIO_GETRDFD(inpipe), XIO_GETWRFD(outpipe));
 	    }
@@ -1435,81 +2053,2146 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
    return writt;
 }
 
-#define CR '\r'
-#define LF '\n'
+#if HAVE_SPLICE || WITH_IOURING
+/* checks if fd is of a type where splice() or io_uring move the data
+   unchanged: regular files, pipes, and stream sockets. TTYs and other
+   devices, and datagram sockets (that would lose packet boundaries) are
+   excluded.
+   returns true if so */
+static bool xiotransfer_fdok(int fd) {
+   struct stat st;
 
-
-/* converts the newline characters (or character sequences) from the one
-   specified in lineterm1 to that of lineterm2. Possible values are
-   LINETERM_CR, LINETERM_CRNL, LINETERM_RAW.
-   bytes specifies the number of bytes input and output */
-int cv_newline(unsigned char *buff, ssize_t *bytes,
-	       int lineterm1, int lineterm2) {
-   /* must perform newline changes */
-   if (lineterm1 <= LINETERM_CR && lineterm2 <= LINETERM_CR) {
-      /* no change in data length */
-      unsigned char from, to,  *p, *z;
-      if (lineterm1 == LINETERM_RAW) {
-	 from = '\n'; to = '\r';
-      } else {
-	 from = '\r'; to = '\n';
-      }
-      z = buff + *bytes;
-      p = buff;
-      while (p < z) {
-	 if (*p == from)  *p = to;
-	 ++p;
+   if (Fstat(fd, &st) < 0) {
+      Info2("fstat(%d, ...): %s", fd, strerror(errno));
+      return false;
+   }
+   if (S_ISSOCK(st.st_mode)) {
+      int socktype;
+      socklen_t optlen = sizeof(socktype);
+      if (Getsockopt(fd, SOL_SOCKET, SO_TYPE, &socktype, &optlen) < 0) {
+	 Info2("getsockopt(%d, SOL_SOCKET, SO_TYPE, ...): %s",
+	       fd, strerror(errno));
+	 return false;
       }
+      return socktype == SOCK_STREAM;
+   }
+   return S_ISREG(st.st_mode) || S_ISFIFO(st.st_mode);
+}
+#endif /* HAVE_SPLICE || WITH_IOURING */
 
-   } else if (lineterm1 == LINETERM_CRNL) {
-      /* buffer might become shorter */
-      unsigned char to,  *s, *t, *z;
-      if (lineterm2 == LINETERM_RAW) {
-	 to = '\n';
-      } else {
-	 to = '\r';
-      }
-      z = buff + *bytes;
-      s = t = buff;
-      while (s < z) {
-	 if (*s == '\r') {
-	    ++s;
-	    continue;
-	 }
-	 if (*s == '\n') {
-	    *t++ = to; ++s;
-	 } else {
-	    *t++ = *s++;
-	 }
+#if HAVE_SPLICE
+/* checks if splice() can read the data of sfd (write: write the data to it):
+   plain stream FDs, and OpenSSL connections where the kernel handles the
+   TLS records of this direction (option openssl-ktls).
+   returns true if so */
+static bool xiosplice_kernelfd(struct single *sfd, bool write) {
+   if (write) {
+      if ((sfd->dtype & XIODATA_WRITEMASK) == XIOWRITE_STREAM) {
+	 /* xiowrite() scans data to readline addresses for the prompt */
+	 return (sfd->dtype & XIODATA_READMASK) != XIOREAD_READLINE;
       }
-      *bytes = t - buff;
+#if WITH_OPENSSL
+      return (sfd->dtype & XIODATA_WRITEMASK) == XIOWRITE_OPENSSL &&
+	 sfd->para.openssl.ktls_send;
+#endif /* WITH_OPENSSL */
    } else {
-      /* buffer becomes longer (up to double length), must alloc another space */
-      static unsigned char *buf2;	/*! not threadsafe */
-      unsigned char from;  unsigned char *s, *t, *z;
-
-      if (lineterm1 == LINETERM_RAW) {
-	 from = '\n';
-      } else {
-	 from = '\r';
+      if ((sfd->dtype & XIODATA_READMASK) == XIOREAD_STREAM) {
+	 return true;
       }
-      if (buf2 == NULL) {
-	 if ((buf2 = Malloc(socat_opts.bufsiz)) == NULL) {
-	    return -1;
-	 }
-      }
-      memcpy(buf2, buff, *bytes);
-      s = buf2;  t = buff;  z = buf2 + *bytes;
-      while (s < z) {
-	 if (*s == from) {
-	    *t++ = '\r'; *t++ = '\n';
-	    ++s;
-	    continue;
-	 } else {
-	    *t++ = *s++;
+#if WITH_OPENSSL
+      return (sfd->dtype & XIODATA_READMASK) == XIOREAD_OPENSSL &&
+	 sfd->para.openssl.ktls_recv;
+#endif /* WITH_OPENSSL */
+   }
+   return false;
+}
+
+/* checks if the data flowing from inpipe to outpipe can be transferred with
+   splice(), i.e. both ends are plain stream FDs or kernel TLS connections and
+   no feature needs to look at or modify the data; if so, creates the
+   intermediate pipe and activates splice() mode for this direction.
+   returns 0 on success (even when splice() is not used), or -1 if an error
+   occurred */
+static int xiosplice_init(struct xiosplice *sp, xiofile_t *inpipe,
+			  xiofile_t *outpipe, size_t bufsiz, bool righttoleft) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+
+   sp->active = false;
+   if (!xiosplice_kernelfd(in, false) || !xiosplice_kernelfd(out, true)) {
+      return 0;
+   }
+   if (xiotransfer_inspecting(inpipe, outpipe, righttoleft)) {
+      return 0;
+   }
+   if (!xiotransfer_fdok(in->fd) || !xiotransfer_fdok(out->fd)) {
+      return 0;
+   }
+
+   if (Pipe(sp->pipefd) < 0) {
+      Warn1("pipe(): %s, not using splice()", strerror(errno));
+      return -1;
+   }
+   Fcntl_l(sp->pipefd[0], F_SETFD, FD_CLOEXEC);
+   Fcntl_l(sp->pipefd[1], F_SETFD, FD_CLOEXEC);
+#ifdef F_SETPIPE_SZ
+   /* default pipe capacity is 64KiB on Linux; it limits the size of a chunk */
+   if (bufsiz > 65536 &&
+       Fcntl_l(sp->pipefd[1], F_SETPIPE_SZ, bufsiz) < 0) {
+      Info3("fcntl(%d, F_SETPIPE_SZ, "F_Zu"): %s",
+	    sp->pipefd[1], bufsiz, strerror(errno));
+   }
+#endif /* defined(F_SETPIPE_SZ) */
+   sp->active = true;
+   sp->ktls = ((in->dtype & XIODATA_READMASK) != XIOREAD_STREAM);
+   sp->ktlsrecord = false;
+   Info2("using splice() for transfer from %d to %d", in->fd, out->fd);
+   return 0;
+}
+
+static void xiosplice_close(struct xiosplice *sp) {
+   if (sp->pipefd[0] >= 0) {
+      Close(sp->pipefd[0]);
+      Close(sp->pipefd[1]);
+      sp->pipefd[0] = sp->pipefd[1] = -1;
+   }
+   sp->active = false;
+   sp->pending = 0;
+}
+
+/* the output FD refused splice(): read the data that is still held in the
+   intermediate pipe into buff and write it with xiowrite(); afterwards this
+   direction continues with xiotransfer().
+   returns the number of bytes written, or -1 if an error occurred */
+static ssize_t xiosplice_flush(struct xiosplice *sp, xiofile_t *outpipe,
+			       unsigned char *buff, size_t bytes) {
+   size_t have = 0;
+   ssize_t chk;
+
+   while (have < bytes) {
+      do {
+	 chk = Read(sp->pipefd[0], buff+have, bytes-have);
+      } while (chk < 0 && errno == EINTR);
+      if (chk <= 0) {
+	 Error4("read(%d, %p, "F_Zu"): %s", sp->pipefd[0], buff+have,
+		bytes-have, chk<0?strerror(errno):"unexpected EOF");
+	 xiosplice_close(sp);
+	 return -1;
+      }
+      have += chk;
+   }
+   xiosplice_close(sp);
+   return xiowrite(outpipe, buff, have);
+}
+
+/* does the same as xiotransfer() but moves the data from inpipe through an
+   intermediate pipe to outpipe using splice(), so it is never copied to user
+   space. This requires that xiosplice_init() activated sp. Data that the
+   output does not take immediately waits in the pipe, and this direction
+   reads no more until socat_flush() emptied it.
+   When the kernel refuses splice() for the FDs, this direction transparently
+   falls back to xiotransfer().
+   Returns the number of bytes written or left in the pipe, or 0 on EOF or <0
+   if an error occurred */
+static int xiotransfer_splice(struct xiosplice *sp,
+			      xiofile_t *inpipe, xiofile_t *outpipe,
+			      unsigned char *buff, size_t bufsiz,
+			      bool righttoleft) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   ssize_t bytes;
+   int _errno;
+
+   if (in->readbytes) {
+      if (in->actbytes == 0) {
+	 Info("xioread(): readbytes consumed, inserting EOF");
+	 bytes = 0;
+	 goto eof;
+      }
+      if (in->actbytes < bufsiz) {
+	 bufsiz = in->actbytes;
+      }
+   }
+   if (sp->ktls && xiopending(inpipe) > 0) {
+      /* OpenSSL still holds decrypted data of a record it read */
+      return xiotransfer(inpipe, outpipe, buff, bufsiz, righttoleft, true);
+   }
+
+   do {
+      bytes = Splice(in->fd, NULL, sp->pipefd[1], NULL, bufsiz, SPLICE_F_MOVE);
+   } while (bytes < 0 && errno == EINTR);
+   socat_stats_read(righttoleft, bytes);
+   if (bytes < 0) {
+      _errno = errno;
+      switch (_errno) {
+      case EINVAL:
+	 if (sp->ktls && !sp->ktlsrecord) {
+	    /* kernel TLS passes only application data to splice(); OpenSSL
+	       handles other records like alerts or session tickets */
+	    Info1("splice(%d, ...): TLS control record, reading it with OpenSSL",
+		  in->fd);
+	    sp->ktlsrecord = true;
+	    return xiotransfer(inpipe, outpipe, buff, bufsiz, righttoleft, true);
+	 }
+	 /* input FD does not support splice() */
+	 Info2("splice(%d, ...): %s; falling back to read()",
+	       in->fd, strerror(_errno));
+	 xiosplice_close(sp);
+	 return xiotransfer(inpipe, outpipe, buff, bufsiz, righttoleft, true);
+      case EAGAIN:
+	 break;
+      case EPIPE: case ECONNRESET:
+	 Warn4("splice(%d, NULL, %d, NULL, "F_Zu", ...): %s",
+	       in->fd, sp->pipefd[1], bufsiz, strerror(_errno));
+	 in->eof = 2;
+	 break;
+      default:
+	 Error4("splice(%d, NULL, %d, NULL, "F_Zu", ...): %s",
+		in->fd, sp->pipefd[1], bufsiz, strerror(_errno));
+	 in->eof = 2;
+      }
+      errno = _errno;
+      return -1;
+   }
+   in->actbytes -= bytes;
+   sp->ktlsrecord = false;
+
+ eof:
+   if (bytes == 0) {
+      if (!(in->ignoreeof && !closing)) {
+	 in->eof = 2;
+	 closing = MAX(closing, 1);
+      }
+      return 0;
+   }
+
+   sp->pending = bytes;
+   if (xiosplice_write(sp, outpipe, buff, righttoleft) < 0 &&
+       errno != EAGAIN) {
+      return -1;
+   }
+   /* what the output did not take waits in the pipe for socat_flush() */
+   return bytes;
+}
+
+/* moves the data that waits in the intermediate pipe of sp to outpipe, until
+   the pipe is empty or the output FD does not take more data.
+   returns the number of bytes written; -1 with errno EAGAIN when the FD did
+   not take any data; -1 with other errno on error, the waiting data is then
+   discarded */
+static ssize_t xiosplice_write(struct xiosplice *sp, xiofile_t *outpipe,
+			       unsigned char *buff, bool righttoleft) {
+   struct single *out = XIO_WRSTREAM(outpipe);
+   ssize_t writt = 0, chk;
+   int _errno;
+
+   while (sp->pending > 0) {
+      chk = Splice(sp->pipefd[0], NULL, out->fd, NULL, sp->pending,
+		   SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+      if (chk >= 0) {
+	 sp->pending -= chk;
+	 writt += chk;
+	 continue;
+      }
+      _errno = errno;
+      switch (_errno) {
+      case EINTR:
+	 continue;
+      case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+      case EWOULDBLOCK:
+#endif
+	 /* output FD is full; the main loop waits for POLLOUT */
+	 if (writt > 0)  goto done;
+	 Debug2("splice(): "F_Zu" bytes wait in pipe for fd %d",
+		sp->pending, out->fd);
+	 errno = EAGAIN;
+	 return -1;
+      case EINVAL:
+	 /* output FD does not support splice() */
+	 Info2("splice(..., %d, ...): %s; falling back to write()",
+	       out->fd, strerror(_errno));
+	 if ((chk = xiosplice_flush(sp, outpipe, buff, sp->pending)) < 0) {
+	    return -1;
+	 }
+	 writt += chk;
+	 goto done;
+      case EPIPE:
+      case ECONNRESET:
+	 if (out->cool_write) {
+	    Notice4("splice(%d, NULL, %d, NULL, "F_Zu", ...): %s",
+		    sp->pipefd[0], out->fd, sp->pending, strerror(_errno));
+	    break;
+	 }
+	 /*PASSTHROUGH*/
+      default:
+	 Error4("splice(%d, NULL, %d, NULL, "F_Zu", ...): %s",
+		sp->pipefd[0], out->fd, sp->pending, strerror(_errno));
+      }
+      /* data that is left in the pipe is lost with this direction */
+      sp->pending = 0;
+      errno = _errno;
+      return -1;
+   }
+ done:
+   socat_stats_write(righttoleft, writt);
+   Info3("transferred "F_Zu" bytes from pipe %d to %d",
+	 writt, sp->pipefd[0], out->fd);
+   return writt;
+}
+#endif /* HAVE_SPLICE */
+
+/* returns the number of bytes that wait to be written to sock: in its write
+   buffer, or in the pipe of the splice() direction that writes to it */
+static size_t socat_wrpending(xiofile_t *sock) {
+   size_t pending = XIO_WRPENDING(sock);
+
+#if HAVE_SPLICE
+   pending += (sock == sock2 ? splice1.pending : splice2.pending);
+#endif /* HAVE_SPLICE */
+   return pending;
+}
+
+/* writes the data that waits for sock, see socat_wrpending(); buff is
+   scratch space for the fallback from splice() to write().
+   returns like xioflush() */
+static ssize_t socat_flush(xiofile_t *sock, unsigned char *buff) {
+#if HAVE_SPLICE
+   struct xiosplice *sp = (sock == sock2 ? &splice1 : &splice2);
+
+   if (sp->pending > 0) {
+      return xiosplice_write(sp, sock, buff, sock == sock1);
+   }
+#endif /* HAVE_SPLICE */
+   return xioflush(sock);
+}
+
+#if _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG
+/* checks if the datagrams that inpipe receives with recvmmsg() (option batch)
+   can be passed on to outpipe with one sendmmsg() call, i.e. outpipe is a
+   datagram socket and no conversion changes the size of the data.
+   returns true if so */
+static bool xiobatch_init(xiofile_t *inpipe, xiofile_t *outpipe) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+   int socktype;
+   socklen_t optlen = sizeof(socktype);
+
+   if ((in->dtype & XIODATA_READMASK) != XIOREAD_RECV ||
+       (in->dtype & XIOREAD_RECV_ONESHOT) ||
+       in->batch.num == 0 || in->readbytes != 0 ||
+       in->lineterm != out->lineterm) {
+      return false;
+   }
+   if ((out->dtype & XIODATA_WRITEMASK) == XIOWRITE_STREAM) {
+      /* a connected datagram socket */
+      if (Getsockopt(out->fd, SOL_SOCKET, SO_TYPE, &socktype, &optlen) < 0 ||
+	  socktype != SOCK_DGRAM) {
+	 return false;
+      }
+   } else if ((out->dtype & XIODATA_WRITEMASK) != XIOWRITE_SENDTO) {
+      return false;
+   }
+   Info2("using sendmmsg() for transfer from %d to %d", in->fd, out->fd);
+   return true;
+}
+
+/* like xiotransfer(), but takes all the datagrams that inpipe has received
+   with one recvmmsg() call and writes them to outpipe with one sendmmsg()
+   call.
+   returns the number of bytes written, 0 on EOF, or <0 if an error occurred
+   or no data is left after the conversions (with EAGAIN) */
+static ssize_t xiotransfer_batch(xiofile_t *inpipe, xiofile_t *outpipe,
+				 size_t bufsiz, bool righttoleft) {
+   static unsigned char *stage = NULL;
+   static size_t stagesiz = 0;
+   static struct iovec iov[XIO_BATCHMAX];
+   struct single *in = XIO_RDSTREAM(inpipe);
+   unsigned int num = Min(in->batch.num, XIO_BATCHMAX);
+   unsigned int n = 0;
+   bool inspect = xiotransfer_inspecting(inpipe, outpipe, righttoleft);
+   bool eof = false;
+   ssize_t bytes, writt;
+
+   if (stagesiz < num*(bufsiz+1)) {
+      free(stage);
+      stagesiz = 0;
+      if ((stage = Malloc(num*(bufsiz+1))) == NULL) {
+	 return -1;
+      }
+      stagesiz = num*(bufsiz+1);
+   }
+
+   /* the first xioread() calls recvmmsg(), the others take the datagrams
+      that it has queued */
+   while (n < num && (n == 0 || xiopending(inpipe) > 0)) {
+      unsigned char *ptr = stage + n*(bufsiz+1);
+
+      bytes = xioread(inpipe, ptr, bufsiz);
+      socat_stats_read(righttoleft, bytes);
+      if (bytes < 0) {
+	 if (errno != EAGAIN) {
+	    in->eof = 2;
+	 }
+	 if (n == 0)  return -1;
+	 break;
+      }
+      if (bytes == 0) {
+	 if (!in->ignoreeof || closing) {
+	    in->eof = 2;
+	    closing = MAX(closing, 1);
+	 }
+	 eof = true;
+	 break;
+      }
+      if (inspect) {
+	 bytes = xiotransfer_inspect(inpipe, outpipe, ptr, bytes, righttoleft);
+      }
+      if (bytes < 0) {
+	 continue;	/* nothing left of this datagram */
+      }
+      if (bytes > 0) {
+	 iov[n].iov_base = ptr;
+	 iov[n].iov_len  = bytes;
+	 ++n;
+      }
+      if (in->actescape) {
+	 break;
+      }
+   }
+   if (n == 0) {
+      if (eof || in->actescape)  return 0;
+      errno = EAGAIN;  return -1;
+   }
+
+   if ((writt = xiowritebatch(outpipe, iov, n)) < 0) {
+      return -1;
+   }
+   socat_stats_write(righttoleft, writt);
+   Info4("transferred "F_Zd" bytes in %u datagrams from %d to %d",
+	 writt, n, in->fd, XIO_GETWRFD(outpipe));
+   return writt;
+}
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG && HAVE_SENDMMSG */
+
+#if WITH_IOURING
+/* option -I: transfer loop on io_uring. Each direction has a ring of
+   provided buffers; a multishot recv (stream sockets) or a read (other FDs)
+   stays queued and fills them, and one writev per direction writes the
+   received chunks in order. Short writes are continued from where they
+   stopped, so writes are not linked in the kernel */
+#define SOCAT_URING_BUFS 32	/* buffers per direction, power of 2 */
+#define SOCAT_URING_BUFMEM (4*1024*1024)	/* limits the buffers per direction */
+#define SOCAT_URING_ENTRIES 16
+
+enum { SOCAT_URING_READ, SOCAT_URING_WRITE, SOCAT_URING_RDPOLL,
+       SOCAT_URING_WRPOLL, SOCAT_URING_STATS, SOCAT_URING_CANCEL } ;
+#define SOCAT_URING_DATA(d,op) ((unsigned long long)(d)<<8|(op))
+
+struct socat_uringdir {
+   xiofile_t *inpipe, *outpipe;
+   bool active;		/* this direction transfers data */
+   bool recv;		/* input is a stream socket, use multishot recv */
+   bool reading;	/* a read or recv request is queued */
+   bool writing;	/* a writev request is queued */
+   bool rdpoll, wrpoll;	/* waiting for the FD after EAGAIN */
+   bool waiting;	/* at EOF with ignoreeof, read again after pollintv */
+   struct timeval rearm;	/* when waiting ends */
+   bool failed;		/* read or write error, stop this direction */
+   struct uring_bufring bufs;
+   struct {		/* received chunks, not yet written, in order */
+      unsigned short bid;
+      unsigned int off, len;
+   } q[SOCAT_URING_BUFS];
+   unsigned int qhead, qlen;
+   struct iovec iov[SOCAT_URING_BUFS];
+} ;
+
+static struct uring socat_ur;
+static struct socat_uringdir socat_urdir[2];	/* [0] sock1 to sock2 */
+static unsigned int socat_urinflight;	/* requests that will complete */
+
+/* checks if the data from inpipe to outpipe can be transferred with
+   io_uring: plain stream FDs where no feature needs to see the data */
+static bool socat_uring_ok(xiofile_t *inpipe, xiofile_t *outpipe,
+			   bool righttoleft) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+   int wrtype = out->dtype & XIODATA_WRITEMASK;
+
+   if ((in->dtype & XIODATA_READMASK) != XIOREAD_STREAM ||
+       (wrtype != XIOWRITE_STREAM && wrtype != XIOWRITE_PIPE &&
+	wrtype != XIOWRITE_2PIPE) ||
+       (out->dtype & XIODATA_READMASK) == XIOREAD_READLINE ||
+       in->readbytes != 0) {
+      return false;
+   }
+   if (xiotransfer_inspecting(inpipe, outpipe, righttoleft)) {
+      return false;
+   }
+#ifdef O_DIRECT
+   /* reads at the file position do not advance it reliably with O_DIRECT */
+   if (Fcntl(XIO_GETRDFD(inpipe), F_GETFL) & O_DIRECT) {
+      return false;
+   }
+#endif
+   return xiotransfer_fdok(XIO_GETRDFD(inpipe)) &&
+      xiotransfer_fdok(XIO_GETWRFD(outpipe));
+}
+
+static struct io_uring_sqe *socat_uring_sqe(int d, int op) {
+   struct io_uring_sqe *sqe;
+
+   if ((sqe = uring_getsqe(&socat_ur)) == NULL) {
+      /* cannot happen with the few requests per direction */
+      Warn("io_uring submission queue is full");
+      return NULL;
+   }
+   sqe->user_data = SOCAT_URING_DATA(d, op);
+   ++socat_urinflight;
+   return sqe;
+}
+
+static void socat_uring_poll(int d, int op, int fd, short events) {
+   struct io_uring_sqe *sqe;
+
+   if ((sqe = socat_uring_sqe(d, op)) != NULL) {
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = fd;
+      sqe->poll32_events = events;
+   }
+}
+
+/* queues the read or writev requests that direction d can do now */
+static void socat_uring_arm(int d) {
+   struct socat_uringdir *ud = &socat_urdir[d];
+   struct io_uring_sqe *sqe;
+   unsigned int i, n;
+
+   if (!ud->active || ud->failed)  return;
+
+   if (!ud->reading && !ud->rdpoll && !ud->waiting &&
+       XIO_RDSTREAM(ud->inpipe)->eof < 2 &&
+       ud->qlen < ud->bufs.entries &&
+       (sqe = socat_uring_sqe(d, SOCAT_URING_READ)) != NULL) {
+      sqe->fd = XIO_GETRDFD(ud->inpipe);
+      sqe->flags = IOSQE_BUFFER_SELECT;
+      sqe->buf_group = ud->bufs.bgid;
+      if (ud->recv) {
+	 sqe->opcode = IORING_OP_RECV;
+	 sqe->ioprio = IORING_RECV_MULTISHOT;
+      } else {
+	 sqe->opcode = IORING_OP_READ;
+	 sqe->len = ud->bufs.bufsiz;
+	 sqe->off = (unsigned long long)-1;	/* at the file position */
+      }
+      ud->reading = true;
+   }
+
+   if (!ud->writing && !ud->wrpoll && ud->qlen > 0 &&
+       (sqe = socat_uring_sqe(d, SOCAT_URING_WRITE)) != NULL) {
+      for (n = 0; n < ud->qlen; ++n) {
+	 i = (ud->qhead + n) & (ud->bufs.entries-1);
+	 ud->iov[n].iov_base = uring_bufaddr(&ud->bufs, ud->q[i].bid) +
+	    ud->q[i].off;
+	 ud->iov[n].iov_len = ud->q[i].len;
+      }
+      sqe->opcode = IORING_OP_WRITEV;
+      sqe->fd = XIO_GETWRFD(ud->outpipe);
+      sqe->addr = (unsigned long)ud->iov;
+      sqe->len = n;
+      sqe->off = (unsigned long long)-1;
+      ud->writing = true;
+   }
+}
+
+/* drops the unwritten chunks of direction d */
+static void socat_uring_drop(struct socat_uringdir *ud) {
+   while (ud->qlen > 0) {
+      uring_bufring_put(&ud->bufs, ud->q[ud->qhead].bid);
+      ud->qhead = (ud->qhead + 1) & (ud->bufs.entries-1);
+      --ud->qlen;
+   }
+}
+
+/* a read or recv request of direction d completed */
+static void socat_uring_read(int d, struct io_uring_cqe *cqe) {
+   struct socat_uringdir *ud = &socat_urdir[d];
+   struct single *in = XIO_RDSTREAM(ud->inpipe);
+   int res = cqe->res;
+   unsigned int i;
+
+   if (!(cqe->flags & IORING_CQE_F_MORE)) {
+      ud->reading = false;
+   }
+   if (res > 0) {
+      unsigned short bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+      socat_stats_read(d, res);
+      if (in->eof >= 3 || ud->failed) {
+	 /* this direction was already shut down */
+	 uring_bufring_put(&ud->bufs, bid);
+	 return;
+      }
+      i = (ud->qhead + ud->qlen) & (ud->bufs.entries-1);
+      ud->q[i].bid = bid;
+      ud->q[i].off = 0;
+      ud->q[i].len = res;
+      ++ud->qlen;
+      return;
+   }
+   if (cqe->flags & IORING_CQE_F_BUFFER) {
+      /* a read at EOF consumes a buffer too */
+      uring_bufring_put(&ud->bufs, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+   }
+   switch (res) {
+   case 0:
+      if (in->ignoreeof && !closing) {
+	 Debug2("socket %d (fd %d) is at EOF, ignoring",
+		d+1, XIO_GETRDFD(ud->inpipe));
+	 ud->waiting = true;
+	 gettimeofday(&ud->rearm, NULL);
+	 ud->rearm.tv_sec  += socat_opts.pollintv.tv_sec;
+	 ud->rearm.tv_usec += socat_opts.pollintv.tv_usec;
+	 if (ud->rearm.tv_usec >= 1000000) {
+	    ud->rearm.tv_usec -= 1000000;
+	    ++ud->rearm.tv_sec;
+	 }
+      } else {
+	 in->eof = 2;
+	 closing = MAX(closing, 1);
+      }
+      break;
+   case -ENOBUFS:	/* all buffers wait for the writer; rearmed later */
+   case -ECANCELED:
+   case -EINTR:
+      break;
+   case -EAGAIN:	/* FD is nonblocking */
+      errno = EAGAIN;
+      socat_stats_read(d, -1);
+      ud->rdpoll = true;
+      socat_uring_poll(d, SOCAT_URING_RDPOLL, XIO_GETRDFD(ud->inpipe), POLLIN);
+      break;
+   default:
+      if (res == -EPIPE || res == -ECONNRESET) {
+	 Warn3("%s(%d, ...): %s", ud->recv?"recv":"read",
+	       XIO_GETRDFD(ud->inpipe), strerror(-res));
+      } else {
+	 Error3("%s(%d, ...): %s", ud->recv?"recv":"read",
+		XIO_GETRDFD(ud->inpipe), strerror(-res));
+      }
+      in->eof = 2;
+      ud->failed = true;
+      socat_uring_drop(ud);
+      closing = MAX(closing, 1);
+      Notice2("socket %d to socket %d is in error", d+1, 2-d);
+   }
+}
+
+/* a writev request of direction d completed */
+static void socat_uring_write(int d, struct io_uring_cqe *cqe) {
+   struct socat_uringdir *ud = &socat_urdir[d];
+   struct single *out = XIO_WRSTREAM(ud->outpipe);
+   int res = cqe->res;
+   size_t writt;
+   unsigned int i;
+
+   ud->writing = false;
+   if (res >= 0) {
+      writt = res;
+      socat_stats_write(d, res);
+      Info3("transferred %d bytes from %d to %d",
+	    res, XIO_GETRDFD(ud->inpipe), XIO_GETWRFD(ud->outpipe));
+      while (writt > 0) {
+	 i = ud->qhead;
+	 if (writt < ud->q[i].len) {
+	    ud->q[i].off += writt;
+	    ud->q[i].len -= writt;
+	    break;
+	 }
+	 writt -= ud->q[i].len;
+	 uring_bufring_put(&ud->bufs, ud->q[i].bid);
+	 ud->qhead = (ud->qhead + 1) & (ud->bufs.entries-1);
+	 --ud->qlen;
+      }
+      return;
+   }
+   switch (res) {
+   case -ECANCELED:
+   case -EINTR:
+      break;
+   case -EAGAIN:
+      ud->wrpoll = true;
+      socat_uring_poll(d, SOCAT_URING_WRPOLL, XIO_GETWRFD(ud->outpipe),
+		       POLLOUT);
+      break;
+   default:
+      if ((res == -EPIPE || res == -ECONNRESET) && out->cool_write) {
+	 Notice2("writev(%d, ...): %s",
+		 XIO_GETWRFD(ud->outpipe), strerror(-res));
+      } else {
+	 Error2("writev(%d, ...): %s",
+		XIO_GETWRFD(ud->outpipe), strerror(-res));
+      }
+      ud->failed = true;
+      socat_uring_drop(ud);
+      closing = MAX(closing, 1);
+      Notice2("socket %d to socket %d is in error", d+1, 2-d);
+   }
+}
+
+/* cancels all requests and waits until they completed */
+static void socat_uring_cancel(void) {
+   struct io_uring_sqe *sqe;
+   struct io_uring_cqe *cqe;
+   struct timeval timeout = { 1, 0 };
+
+   if (socat_urinflight > 0 &&
+       (sqe = socat_uring_sqe(0, SOCAT_URING_CANCEL)) != NULL) {
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+   }
+   while (socat_urinflight > 0) {
+      if (uring_enter(&socat_ur, 1, &timeout) < 0 &&
+	  errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+	 break;
+      }
+      if ((cqe = uring_peekcqe(&socat_ur)) == NULL) {
+	 break;
+      }
+      do {
+	 if (!(cqe->flags & IORING_CQE_F_MORE))  --socat_urinflight;
+	 uring_cqeseen(&socat_ur);
+      } while ((cqe = uring_peekcqe(&socat_ur)) != NULL);
+   }
+}
+
+static void socat_uring_close(void) {
+   int d;
+
+   socat_uring_cancel();
+   for (d = 0; d < 2; ++d) {
+      if (socat_urinflight > 0) {
+	 /* the kernel might still use the buffers */
+	 Warn1("%u io_uring requests did not terminate", socat_urinflight);
+	 break;
+      }
+      uring_bufring_exit(&socat_ur, &socat_urdir[d].bufs);
+   }
+   uring_exit(&socat_ur);
+}
+
+/* the transfer loop of _socat() with io_uring instead of poll(), read(), and
+   write(). It has the same handling of EOF, ignoreeof, closing, -t, -T, -u,
+   and -U.
+   returns 0 when the transfer is done, 1 when io_uring cannot be used for
+   the addresses (nothing happened, use the poll() loop), or -1 on error */
+static int socat_uring(void) {
+   struct socat_uringdir *ud;
+   struct io_uring_cqe *cqe;
+   struct timeval total_timeout;	/* the actual total timeout timer */
+   struct timeval timeout, *to, before, now;
+   bool statspoll = false;
+   bool polling, done = false;
+   size_t bufsiz = socat_opts.bufsiz;
+   unsigned short nbufs;
+   int d, retval, _errno;
+
+   memset(socat_urdir, 0, sizeof(socat_urdir));
+   socat_urdir[0].inpipe = sock1;  socat_urdir[0].outpipe = sock2;
+   socat_urdir[1].inpipe = sock2;  socat_urdir[1].outpipe = sock1;
+   socat_urdir[0].active = XIO_READABLE(sock1) && XIO_WRITABLE(sock2) &&
+      !socat_opts.righttoleft;
+   socat_urdir[1].active = XIO_READABLE(sock2) && XIO_WRITABLE(sock1) &&
+      !socat_opts.lefttoright;
+   if (!socat_urdir[0].active && !socat_urdir[1].active) {
+      return 1;
+   }
+   for (d = 0; d < 2; ++d) {
+      ud = &socat_urdir[d];
+      if (ud->active && !socat_uring_ok(ud->inpipe, ud->outpipe, d)) {
+	 Info2("io_uring transfer not possible from %d to %d, using poll()",
+	       XIO_GETRDFD(ud->inpipe), XIO_GETWRFD(ud->outpipe));
+	 return 1;
+      }
+   }
+   if (bufsiz > 0x40000000) {
+      Info("buffer size too large for io_uring, using poll()");
+      return 1;
+   }
+   for (nbufs = SOCAT_URING_BUFS;
+	nbufs > 2 && nbufs * bufsiz > SOCAT_URING_BUFMEM; nbufs /= 2) ;
+
+   if (uring_init(&socat_ur, SOCAT_URING_ENTRIES) < 0) {
+      Warn1("io_uring: %s, using poll()", strerror(errno));
+      return 1;
+   }
+   for (d = 0; d < 2; ++d) {
+      struct stat st;
+      ud = &socat_urdir[d];
+      if (!ud->active)  continue;
+      if (uring_bufring_init(&socat_ur, &ud->bufs, d, nbufs, bufsiz) < 0) {
+	 Warn1("io_uring buffers: %s, using poll()", strerror(errno));
+	 if (d == 1)  uring_bufring_exit(&socat_ur, &socat_urdir[0].bufs);
+	 uring_exit(&socat_ur);
+	 return 1;
+      }
+      ud->recv = (Fstat(XIO_GETRDFD(ud->inpipe), &st) >= 0 &&
+		  S_ISSOCK(st.st_mode));
+   }
+   socat_urinflight = 0;
+
+   Notice4("starting io_uring transfer loop with FDs [%d,%d] and [%d,%d]",
+	   XIO_GETRDFD(sock1), XIO_GETWRFD(sock1),
+	   XIO_GETRDFD(sock2), XIO_GETWRFD(sock2));
+   total_timeout = socat_opts.total_timeout;
+   while (XIO_RDSTREAM(sock1)->eof <= 1 ||
+	  XIO_RDSTREAM(sock2)->eof <= 1 ||
+	  socat_urdir[0].qlen > 0 || socat_urdir[1].qlen > 0) {
+
+      childleftdata(sock1);
+      childleftdata(sock2);
+      if (socat_urdir[0].waiting || socat_urdir[1].waiting) {
+	 gettimeofday(&now, NULL);
+	 for (d = 0; d < 2; ++d) {
+	    ud = &socat_urdir[d];
+	    /* when closing, read the rest as soon as the other direction
+	       wrote its data */
+	    if (ud->waiting &&
+		(closing && socat_urdir[1-d].qlen == 0 ||
+		 now.tv_sec > ud->rearm.tv_sec ||
+		 (now.tv_sec == ud->rearm.tv_sec &&
+		  now.tv_usec >= ud->rearm.tv_usec))) {
+	       ud->waiting = false;	/* read again */
+	    }
+	 }
+      }
+      for (d = 0; d < 2; ++d) {
+	 socat_uring_arm(d);
+      }
+      if (socat_statsfd >= 0 && !statspoll) {
+	 socat_uring_poll(0, SOCAT_URING_STATS, socat_statsfd, POLLIN);
+	 statspoll = true;
+      }
+
+      polling = socat_urdir[0].waiting || socat_urdir[1].waiting;
+      if (polling) {
+	 /* reread the input at EOF with ignoreeof */
+	 timeout = socat_opts.pollintv;
+	 to = &timeout;
+      } else if (socat_opts.total_timeout.tv_sec != 0 ||
+		 socat_opts.total_timeout.tv_usec != 0) {
+	 /* there might occur a total inactivity timeout */
+	 timeout = socat_opts.total_timeout;
+	 to = &timeout;
+      } else {
+	 to = NULL;
+      }
+      if (closing >= 1) {
+	 /* first eof already occurred, start end timer */
+	 if (!polling ||
+	     socat_opts.closwait.tv_sec < timeout.tv_sec ||
+	     (socat_opts.closwait.tv_sec == timeout.tv_sec &&
+	      socat_opts.closwait.tv_usec < timeout.tv_usec)) {
+	    timeout = socat_opts.closwait;
+	 }
+	 to = &timeout;
+	 closing = 2;
+      }
+
+      if (to != NULL)  gettimeofday(&before, NULL);
+      retval = uring_enter(&socat_ur, 1, to);
+      _errno = errno; diag_flush(); errno = _errno;
+      if (socat_statsreq) {
+	 socat_stats_dump();
+      }
+      socat_stats_wakeup();
+      if (retval < 0 && errno != EINTR && errno != ETIME &&
+	  errno != EAGAIN && errno != EBUSY) {
+	 Error1("io_uring_enter(): %s", strerror(errno));
+	 socat_uring_close();
+	 return -1;
+      }
+
+      if ((cqe = uring_peekcqe(&socat_ur)) == NULL) {
+	 /* the wait was interrupted or timed out */
+	 if (to == NULL)  continue;
+	 if (retval >= 0 || errno != ETIME) {
+	    gettimeofday(&now, NULL);
+	    if ((now.tv_sec - before.tv_sec) * 1000000 +
+		now.tv_usec - before.tv_usec <
+		timeout.tv_sec * 1000000 + timeout.tv_usec) {
+	       continue;
+	    }
+	 }
+	 Info2("io_uring wait timed out (no data within %ld.%06ld seconds)",
+	       (long)timeout.tv_sec, (long)timeout.tv_usec);
+	 if (polling) {
+	    /* the ignoreeof interval passed without data */
+	    if (socat_opts.total_timeout.tv_sec != 0 ||
+		socat_opts.total_timeout.tv_usec != 0) {
+	       if (total_timeout.tv_usec < socat_opts.pollintv.tv_usec) {
+		  total_timeout.tv_usec += 1000000;
+		  total_timeout.tv_sec  -= 1;
+	       }
+	       total_timeout.tv_sec  -= socat_opts.pollintv.tv_sec;
+	       total_timeout.tv_usec -= socat_opts.pollintv.tv_usec;
+	       if (total_timeout.tv_sec < 0 ||
+		   (total_timeout.tv_sec == 0 && total_timeout.tv_usec <= 0)) {
+		  Notice("inactivity timeout triggered");
+		  break;
+	       }
+	    }
+	 } else if (socat_opts.total_timeout.tv_sec != 0 ||
+		    socat_opts.total_timeout.tv_usec != 0) {
+	    Notice("inactivity timeout triggered");
+	    break;
+	 }
+	 if (closing) {
+	    /* -t bounds the shutdown like in the poll() loop, even when an
+	       output does not take its queued data */
+	    break;
+	 }
+	 continue;
+      }
+
+      do {
+	 d = (cqe->user_data >> 8) & 1;
+	 if (!(cqe->flags & IORING_CQE_F_MORE))  --socat_urinflight;
+	 switch (cqe->user_data & 0xff) {
+	 case SOCAT_URING_READ:
+	    socat_uring_read(d, cqe);
+	    if (cqe->res > 0) {
+	       total_timeout = socat_opts.total_timeout;
+	    }
+	    break;
+	 case SOCAT_URING_WRITE:
+	    socat_uring_write(d, cqe);
+	    if (cqe->res > 0) {
+	       total_timeout = socat_opts.total_timeout;
+	    }
+	    break;
+	 case SOCAT_URING_RDPOLL:
+	    socat_urdir[d].rdpoll = false;
+	    break;
+	 case SOCAT_URING_WRPOLL:
+	    socat_urdir[d].wrpoll = false;
+	    break;
+	 case SOCAT_URING_STATS:
+	    statspoll = false;
+	    socat_stats_serve();
+	    break;
+	 }
+	 uring_cqeseen(&socat_ur);
+      } while ((cqe = uring_peekcqe(&socat_ur)) != NULL);
+
+      /* NOW handle EOFs */
+      for (d = 0; d < 2; ++d) {
+	 bool onlythis = (d == 0 ? socat_opts.lefttoright :
+			  socat_opts.righttoleft);
+	 struct single *in;
+
+	 ud = &socat_urdir[d];
+	 in = XIO_RDSTREAM(ud->inpipe);
+	 if (!ud->active)  continue;
+	 if (ud->failed && onlythis) {
+	    done = true;
+	 }
+	 if (in->eof < 2 || ud->qlen > 0) {
+	    /* shut down after the received data has been written */
+	    continue;
+	 }
+	 if (in->eof == 2) {
+	    Notice2("socket %d (fd %d) is at EOF",
+		    d+1, XIO_GETRDFD(ud->inpipe));
+	    xioshutdown(ud->outpipe, SHUT_WR);
+	    in->eof = 3;
+	    in->ignoreeof = false;
+	 }
+	 if (onlythis) {
+	    done = true;
+	 }
+	 closing = 1;
+      }
+      if (done) {
+	 break;	/* the unidirectional transfer is over */
+      }
+   }
+
+   socat_uring_close();
+   return 0;
+}
+#endif /* WITH_IOURING */
+
+/* the statistics socket of a child process of a forking listener gets the
+   pid appended to its path */
+static bool socat_forked = false;
+static char *socat_statsname;	/* actual path of the statistics socket */
+static pid_t socat_statspid;	/* the process that created it */
+
+/* appends to the string in buff of size buflen that has n characters.
+   returns the new length, which is >= buflen when the text was truncated */
+static size_t socat_stats_append(char *buff, size_t buflen, size_t n,
+				 const char *format, ...) {
+   va_list ap;
+   int rc;
+
+   if (n >= buflen)  return n;
+   va_start(ap, format);
+   rc = vsnprintf(buff+n, buflen-n, format, ap);
+   va_end(ap);
+   return rc < 0 ? n : n+rc;
+}
+
+/* formats the statistics of this process as one line of JSON.
+   returns the length of the text */
+static size_t socat_stats_json(char *buff, size_t buflen) {
+   static const char *dirnames[2] = { "left_to_right", "right_to_left" };
+   struct timeval now;
+   double secs = 0.0;
+   size_t n;
+   int d, i;
+
+   gettimeofday(&now, NULL);
+   if (socat_stats.start.tv_sec != 0) {
+      secs = (now.tv_sec - socat_stats.start.tv_sec) +
+	 (now.tv_usec - socat_stats.start.tv_usec)/1000000.0;
+   }
+   n = socat_stats_append(buff, buflen, 0,
+			  "{\"pid\":"F_pid",\"seconds\":%.3f,\"wakeups\":%llu",
+			  Getpid(), secs, socat_stats.wakeups);
+   for (d = 0; d < 2; ++d) {
+      struct socat_statsdir *st = &socat_stats.dir[d];
+
+      n = socat_stats_append(buff, buflen, n,
+			     ",\"%s\":{\"bytes_read\":%llu,\"bytes_written\":%llu,"
+			     "\"reads\":%llu,\"writes\":%llu,\"eagain\":%llu,"
+			     "\"read_sizes_log2\":[",
+			     dirnames[d], st->bytesread, st->byteswritten,
+			     st->reads, st->writes, st->eagain);
+      for (i = 0; i < SOCAT_STATS_BUCKETS; ++i) {
+	 n = socat_stats_append(buff, buflen, n, "%s%llu",
+				i?",":"", st->sizes[i]);
+      }
+      n = socat_stats_append(buff, buflen, n,
+			     "],\"write_latency_usec_log2\":[");
+      for (i = 0; i < SOCAT_STATS_BUCKETS; ++i) {
+	 n = socat_stats_append(buff, buflen, n, "%s%llu",
+				i?",":"", st->latency[i]);
+      }
+      n = socat_stats_append(buff, buflen, n, "]}");
+   }
+   n = socat_stats_append(buff, buflen, n, "}\n");
+   return n < buflen ? n : buflen-1;
+}
+
+/* handler for SIGUSR1; the transfer loop prints the statistics */
+static void socat_stats_signal(int signum) {
+   socat_statsreq = 1;
+}
+
+/* prints the statistics to stderr */
+static void socat_stats_dump(void) {
+   char buff[4096];
+
+   socat_statsreq = 0;
+   socat_stats_json(buff, sizeof(buff));
+   fputs(buff, stderr);
+   fflush(stderr);
+}
+
+/* called when the transfer starts: takes the start time and, with -S<path>,
+   creates the listening statistics socket */
+static void socat_stats_open(void) {
+   struct sockaddr_un sa;
+   const char *path = socat_opts.statspath;
+   char *name;
+   int fd;
+
+   if (socat_stats.start.tv_sec != 0)  return;
+   gettimeofday(&socat_stats.start, NULL);
+   if (path == NULL)  return;
+
+   if ((name = Malloc(strlen(path)+24)) == NULL)  return;
+   if (socat_forked) {
+      sprintf(name, "%s."F_pid, path, Getpid());
+   } else {
+      strcpy(name, path);
+   }
+   if (strlen(name) >= sizeof(sa.sun_path)) {
+      Warn1("statistics socket path \"%s\" is too long", name);
+      free(name);
+      return;
+   }
+   memset(&sa, 0, sizeof(sa));
+   sa.sun_family = AF_UNIX;
+   strcpy(sa.sun_path, name);
+   if ((fd = Socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
+      Warn1("socket(PF_UNIX, SOCK_STREAM, 0): %s", strerror(errno));
+      free(name);
+      return;
+   }
+   if (Bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 ||
+       Listen(fd, 5) < 0) {
+      Warn2("statistics socket \"%s\": %s", name, strerror(errno));
+      Close(fd);
+      free(name);
+      return;
+   }
+   Fcntl_l(fd, F_SETFD, FD_CLOEXEC);
+   socat_statsfd = fd;
+   socat_statsname = name;
+   socat_statspid = Getpid();
+   Info2("serving statistics on \"%s\" (fd %d)", name, fd);
+}
+
+/* a client connected to the statistics socket: sends the statistics and
+   closes the connection */
+static void socat_stats_serve(void) {
+   char buff[4096];
+   union sockaddr_union sa;
+   socklen_t salen = sizeof(sa);
+   size_t len;
+   int fd;
+
+   if ((fd = Accept(socat_statsfd, &sa.soa, &salen)) < 0) {
+      Info2("accept(%d, ...): %s", socat_statsfd, strerror(errno));
+      return;
+   }
+   len = socat_stats_json(buff, sizeof(buff));
+   if (writefull(fd, buff, len) < 0) {
+      Info2("write(%d, ...): %s", fd, strerror(errno));
+   }
+   Close(fd);
+}
+
+/* atexit() handler with option -S */
+static void socat_stats_exit(void) {
+   if (socat_stats.start.tv_sec == 0) {
+      return;	/* this process did not transfer data */
+   }
+   socat_stats_dump();
+   if (socat_statsfd >= 0 && socat_statspid == Getpid()) {
+      Close(socat_statsfd);
+      Unlink(socat_statsname);
+      socat_statsfd = -1;
+   }
+}
+
+#if HAVE_SYS_EPOLL_H
+/* option event-loop: instead of forking a process for each connection, the
+   listening socket and all connections are handled in this process with
+   epoll(). A connection consists of the accepted socket and a new instance of
+   the second address; both directions are buffered separately so a peer that
+   does not take data does not block the other connections.
+   With a datagram listener (UDP-LISTEN), a session is kept per peer address
+   in the hash table socat_evpeers: the datagrams of all peers are read from
+   the listening socket and passed to the instance of the second address of
+   their session, the answers are sent with sendto() on the listening socket.
+   Sessions end with -T; with max-children the longest idle session is closed
+   for a new peer */
+
+#define SOCAT_EVMAXEVENTS 64
+
+struct socat_evconn;
+
+/* a file descriptor of a connection that is registered with epoll */
+struct socat_evfd {
+   struct socat_evconn *conn;
+   int fd;
+   uint32_t events;	/* registered events; 0 when not registered */
+} ;
+
+/* one transfer direction of a connection */
+struct socat_evdir {
+   xiofile_t *in, *out;
+   struct socat_evfd *rd, *wr;
+   unsigned char *buff;
+   size_t off, len;	/* data in buff that still has to be written */
+   bool active;		/* this direction is used (see -u, -U) */
+   bool eof;		/* no more data from in: EOF, escape char, or error */
+   bool done;		/* EOF has been passed on to out */
+} ;
+
+struct socat_evconn {
+   xiofile_t *sock[2];	/* accepted socket, instance of second address */
+   bool dual2;		/* sock[1] is a dual address */
+   struct socat_evfd evfd[4];
+   int nevfd;
+   struct socat_evfd *connecting;	/* connect() of sock[1] in progress */
+   struct socat_evdir dir[2];	/* [0]: left to right, [1]: right to left */
+   bool failed;		/* a write error occurred, close the connection */
+   bool touched;	/* in the list of connections to check after epoll */
+   struct timeval lastio;	/* time of last transfer, for -T */
+   struct timeval closing;	/* time of first EOF, for -t; 0 when none */
+   struct socat_evconn *prev, *next;
+   bool dgram0;		/* sock[0] is a peer of the datagram listener */
+   union sockaddr_union peer;	/* with dgram0: key in socat_evpeers */
+   socklen_t peerlen;
+   unsigned int peerhash;
+   struct socat_evconn *hnext;	/* with dgram0: next in hash chain */
+} ;
+
+static int socat_epfd = -1;
+static struct socat_evfd socat_evstats;	/* marks the statistics socket */
+static struct socat_evfd socat_evchild;	/* marks xiochildfd() */
+static struct socat_evconn *socat_evconns;	/* list of active connections */
+static int socat_numconns;
+static int socat_numclosing;	/* connections in the -t phase */
+static struct socat_evconn **socat_evpeers;	/* sessions by peer address */
+static unsigned int socat_evpeersize;	/* number of chains, power of 2 */
+static unsigned int socat_numpeers;
+
+/* returns the number of milliseconds from now until since+intv, or 0 if this
+   time has already passed */
+static int socat_evremaining(const struct timeval *since,
+			     const struct timeval *intv,
+			     const struct timeval *now) {
+   long long ms;
+
+   ms = (long long)(since->tv_sec + intv->tv_sec - now->tv_sec) * 1000 +
+      (since->tv_usec + intv->tv_usec - now->tv_usec + 999) / 1000;
+   if (ms < 0)  return 0;
+   if (ms > INT_MAX)  return INT_MAX;
+   return ms;
+}
+
+#define SOCAT_EVPEERSIZE 256	/* initial number of hash chains */
+#define SOCAT_EVMAXDGRAMS 64	/* datagrams to read per wakeup */
+
+/* copies the sender address of a datagram to key, with the fields that do not
+   identify the peer cleared, so keys can be hashed and compared bytewise.
+   returns the length of the key */
+static socklen_t socat_evpeerkey(union sockaddr_union *key,
+				 const union sockaddr_union *sa,
+				 socklen_t salen) {
+   if (salen > sizeof(*key))  salen = sizeof(*key);
+   memset(key, 0, salen);
+   switch (sa->soa.sa_family) {
+#if WITH_IP4
+   case AF_INET:
+      key->ip4.sin_family = AF_INET;
+      key->ip4.sin_port   = sa->ip4.sin_port;
+      key->ip4.sin_addr   = sa->ip4.sin_addr;
+      break;
+#endif
+#if WITH_IP6
+   case AF_INET6:
+      key->ip6.sin6_family   = AF_INET6;
+      key->ip6.sin6_port     = sa->ip6.sin6_port;
+      key->ip6.sin6_addr     = sa->ip6.sin6_addr;
+      key->ip6.sin6_scope_id = sa->ip6.sin6_scope_id;
+      break;
+#endif
+   default:
+      memcpy(key, sa, salen);
+   }
+   return salen;
+}
+
+/* FNV-1a over the key of a datagram peer */
+static unsigned int socat_evpeerhash(const union sockaddr_union *key,
+				     socklen_t keylen) {
+   const unsigned char *p = (const unsigned char *)key;
+   uint32_t h = 2166136261U;
+   socklen_t i;
+
+   for (i = 0; i < keylen; ++i) {
+      h = (h ^ p[i]) * 16777619U;
+   }
+   return h;
+}
+
+/* returns the session of the datagram peer key, or NULL */
+static struct socat_evconn *socat_evpeerfind(const union sockaddr_union *key,
+					     socklen_t keylen,
+					     unsigned int hash) {
+   struct socat_evconn *conn;
+
+   if (socat_evpeers == NULL)  return NULL;
+   for (conn = socat_evpeers[hash & (socat_evpeersize-1)]; conn != NULL;
+	conn = conn->hnext) {
+      if (conn->peerhash == hash && conn->peerlen == keylen &&
+	  !memcmp(&conn->peer, key, keylen)) {
+	 return conn;
+      }
+   }
+   return NULL;
+}
+
+/* enters the session conn with its peer key into the hash table; doubles
+   the number of chains when it has as many sessions as chains.
+   returns 0 on success, or -1 when memory is missing */
+static int socat_evpeeradd(struct socat_evconn *conn) {
+   struct socat_evconn **chains, *c, *next;
+   unsigned int size, i;
+
+   if (socat_numpeers >= socat_evpeersize) {
+      size = socat_evpeersize ? 2*socat_evpeersize : SOCAT_EVPEERSIZE;
+      if ((chains = Calloc(size, sizeof(struct socat_evconn *))) == NULL) {
+	 if (socat_evpeers == NULL)  return -1;
+	 /* keep the table, the chains just get longer */
+      } else {
+	 for (i = 0; i < socat_evpeersize; ++i) {
+	    for (c = socat_evpeers[i]; c != NULL; c = next) {
+	       next = c->hnext;
+	       c->hnext = chains[c->peerhash & (size-1)];
+	       chains[c->peerhash & (size-1)] = c;
+	    }
+	 }
+	 free(socat_evpeers);
+	 socat_evpeers = chains;
+	 socat_evpeersize = size;
+      }
+   }
+   i = conn->peerhash & (socat_evpeersize-1);
+   conn->hnext = socat_evpeers[i];
+   socat_evpeers[i] = conn;
+   conn->dgram0 = true;
+   ++socat_numpeers;
+   return 0;
+}
+
+/* removes the session conn from the hash table */
+static void socat_evpeerdel(struct socat_evconn *conn) {
+   struct socat_evconn **cp;
+
+   for (cp = &socat_evpeers[conn->peerhash & (socat_evpeersize-1)];
+	*cp != NULL; cp = &(*cp)->hnext) {
+      if (*cp == conn) {
+	 *cp = conn->hnext;
+	 --socat_numpeers;
+	 return;
+      }
+   }
+}
+
+/* returns the connection's epoll record for fd; adds one if required */
+static struct socat_evfd *socat_evaddfd(struct socat_evconn *conn, int fd) {
+   int i;
+
+   for (i = 0; i < conn->nevfd; ++i) {
+      if (conn->evfd[i].fd == fd)  return &conn->evfd[i];
+   }
+   conn->evfd[i].conn   = conn;
+   conn->evfd[i].fd     = fd;
+   conn->evfd[i].events = 0;
+   ++conn->nevfd;
+   return &conn->evfd[i];
+}
+
+/* sets the output FD of a stream or pipe type descriptor to nonblocking
+   mode, so xiowritepart() can write what the FD takes and never blocks */
+static void socat_evnonblock(xiofile_t *xfd) {
+   struct single *pipe = XIO_WRSTREAM(xfd);
+   int fd = XIO_GETWRFD(xfd);
+   int flags;
+
+   if ((pipe->dtype & XIODATA_READMASK) == XIOREAD_READLINE)  return;
+   switch (pipe->dtype & XIODATA_WRITEMASK) {
+   case XIOWRITE_STREAM:
+   case XIOWRITE_PIPE:
+   case XIOWRITE_2PIPE:
+      break;
+   default:
+      return;
+   }
+   if ((flags = Fcntl(fd, F_GETFL)) < 0 ||
+       Fcntl_l(fd, F_SETFL, flags|O_NONBLOCK) < 0) {
+      Warn2("fcntl(%d, F_SETFL, O_NONBLOCK): %s", fd, strerror(errno));
+   }
+}
+
+/* registers the events that the connection currently waits for */
+static void socat_evupdate(struct socat_evconn *conn) {
+   struct epoll_event ev;
+   uint32_t events;
+   int i, d, op;
+
+   for (i = 0; i < conn->nevfd; ++i) {
+      struct socat_evfd *evfd = &conn->evfd[i];
+
+      events = 0;
+      for (d = 0; d < 2; ++d) {
+	 struct socat_evdir *dir = &conn->dir[d];
+	 if (!dir->active)  continue;
+	 if (dir->rd == evfd && !dir->eof && dir->len == 0)
+	    events |= EPOLLIN;
+	 if (dir->wr == evfd && dir->len > 0)
+	    events |= EPOLLOUT;
+      }
+      if (conn->connecting == evfd)
+	 events |= EPOLLOUT;
+      if (events == evfd->events)  continue;
+
+      if (events == 0) {
+	 op = EPOLL_CTL_DEL;
+      } else if (evfd->events == 0) {
+	 op = EPOLL_CTL_ADD;
+      } else {
+	 op = EPOLL_CTL_MOD;
+      }
+      ev.events   = events;
+      ev.data.ptr = evfd;
+      if (Epoll_ctl(socat_epfd, op, evfd->fd, &ev) < 0) {
+	 Error5("epoll_ctl(%d, %d, %d, {0x%x,}): %s",
+		socat_epfd, op, evfd->fd, events, strerror(errno));
+	 conn->failed = true;
+	 return;
+      }
+      evfd->events = events;
+   }
+}
+
+/* xioclose() leaves FDs open that a terminating process releases anyway,
+   e.g. sockets after shutdown() or the read end of PIPE; this process serves
+   further connections, so close them */
+static void socat_evclosefd(struct single *sfd) {
+   if (sfd->howtoend == END_CLOSE || sfd->howtoend == END_CLOSE_KILL ||
+       sfd->fd < 0) {
+      return;
+   }
+   if (Close(sfd->fd) < 0) {
+      Info2("close(%d): %s", sfd->fd, strerror(errno));
+   }
+   sfd->fd = -1;
+}
+
+/* frees the address xfd from xioclone() after xioclose(): its option arrays
+   and structures. The argument strings belong to the template and are shared
+   by all connections */
+static void socat_evfree(xiofile_t *xfd) {
+   int d;
+
+   if (xfd->tag == XIO_TAG_DUAL) {
+      for (d = 0; d < 2; ++d) {
+	 free(xfd->dual.stream[d]->opts);
+	 free(xfd->dual.stream[d]);
+      }
+   } else {
+      free(xfd->stream.opts);
+   }
+   free(xfd);
+}
+
+/* closes and frees the first address of a connection, a copy of the listener
+   from xioaccept() */
+static void socat_evrelease0(xiofile_t *sock0, bool dgram0) {
+   xioclose(sock0);
+   if (!dgram0) {
+      /* the peer of a datagram listener uses the listening socket */
+      socat_evclosefd(&sock0->stream);
+   }
+   free(sock0);
+}
+
+/* closes and frees the opened second address of a connection */
+static void socat_evrelease1(xiofile_t *xfd2) {
+   int d;
+
+   xioclose(xfd2);
+   if (xfd2->tag == XIO_TAG_DUAL) {
+      for (d = 0; d < 2; ++d) {
+	 socat_evclosefd(xfd2->dual.stream[d]);
+      }
+   } else {
+      socat_evclosefd(&xfd2->stream);
+   }
+   socat_evfree(xfd2);
+}
+
+/* closes both addresses of the connection and releases it */
+static void socat_evclose(struct socat_evconn *conn) {
+   int i, d;
+
+   for (i = 0; i < conn->nevfd; ++i) {
+      if (conn->evfd[i].events != 0) {
+	 Epoll_ctl(socat_epfd, EPOLL_CTL_DEL, conn->evfd[i].fd, NULL);
+      }
+   }
+   if (conn->dgram0) {
+      socat_evpeerdel(conn);
+   }
+   Info4("closing connection with FDs [%d,%d] and [%d,%d]",
+	 XIO_GETRDFD(conn->sock[0]), XIO_GETWRFD(conn->sock[0]),
+	 XIO_GETRDFD(conn->sock[1]), XIO_GETWRFD(conn->sock[1]));
+   socat_evrelease0(conn->sock[0], conn->dgram0);
+   socat_evrelease1(conn->sock[1]);
+
+   for (d = 0; d < 2; ++d) {
+      free(conn->dir[d].buff);
+   }
+   if (conn->closing.tv_sec != 0 || conn->closing.tv_usec != 0) {
+      --socat_numclosing;
+   }
+   if (conn->prev)  conn->prev->next = conn->next;
+   else             socat_evconns = conn->next;
+   if (conn->next)  conn->next->prev = conn->prev;
+   --socat_numconns;
+   free(conn);
+}
+
+/* opens a new instance of the second address for the accepted socket sock0
+   and adds the connection to the event loop. With dgram0, sock0 is a peer of
+   the datagram listener (see xioaccept_peer()) whose socket is not
+   registered here.
+   returns the connection, or NULL if it could not be established */
+static struct socat_evconn *socat_evopen(xiofile_t *sock0,
+					 const xiofile_t *tmpl2, bool dgram0,
+					 const struct timeval *now) {
+   struct socat_evconn *conn;
+   xiofile_t *xfd2;
+   int rw, d;
+
+   if (XIO_WRITABLE(sock0)) {
+      rw = XIO_READABLE(sock0) ? XIO_RDWR : XIO_RDONLY;
+   } else {
+      rw = XIO_WRONLY;
+   }
+   /* neither fork nor exec without fork: this process serves all
+      connections */
+   if ((xfd2 = xioclone(tmpl2)) == NULL) {
+      socat_evrelease0(sock0, dgram0);
+      return NULL;
+   }
+   if (xioopen_parsed(xfd2, rw|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYINPROGRESS)
+       == NULL) {
+      sock[1] = NULL;
+      socat_evfree(xfd2);
+      socat_evrelease0(sock0, dgram0);
+      return NULL;
+   }
+   sock[1] = NULL;	/* the connection is not kept in the global sockets */
+
+   if ((conn = Calloc(1, sizeof(struct socat_evconn))) == NULL) {
+      socat_evrelease0(sock0, dgram0);
+      socat_evrelease1(xfd2);
+      return NULL;
+   }
+   conn->sock[0] = sock0;
+   conn->sock[1] = xfd2;
+   conn->dual2 = (xfd2->tag == XIO_TAG_DUAL);
+   conn->lastio = *now;
+   conn->dir[0].in  = sock0;
+   conn->dir[0].out = xfd2;
+   conn->dir[0].active = XIO_READABLE(sock0) && XIO_WRITABLE(xfd2) &&
+      !socat_opts.righttoleft;
+   conn->dir[1].in  = xfd2;
+   conn->dir[1].out = sock0;
+   conn->dir[1].active = XIO_READABLE(xfd2) && XIO_WRITABLE(sock0) &&
+      !socat_opts.lefttoright;
+
+   conn->next = socat_evconns;
+   if (socat_evconns)  socat_evconns->prev = conn;
+   socat_evconns = conn;
+   ++socat_numconns;
+
+   for (d = 0; d < 2; ++d) {
+      struct socat_evdir *dir = &conn->dir[d];
+
+      if (!dir->active)  continue;
+      /* when converting nl to crnl, size might double */
+      if ((dir->buff = Malloc(2*socat_opts.bufsiz+1)) == NULL) {
+	 socat_evclose(conn);
+	 return NULL;
+      }
+      /* the datagrams of a peer arrive through socat_evdgram() */
+      dir->rd = (dgram0 && d == 0) ? NULL :
+	 socat_evaddfd(conn, XIO_GETRDFD(dir->in));
+      dir->wr = (dgram0 && d == 1) ? NULL :
+	 socat_evaddfd(conn, XIO_GETWRFD(dir->out));
+      socat_evnonblock(dir->out);
+      if (XIO_RDSTREAM(dir->in)->ignoreeof) {
+	 Warn("option ignoreeof is not supported with option event-loop");
+	 XIO_RDSTREAM(dir->in)->ignoreeof = false;
+      }
+   }
+   if (!conn->dual2 && (xfd2->stream.flags & XIO_DOESINPROGRESS)) {
+      /* until it completes, reads and writes find EAGAIN */
+      conn->connecting = socat_evaddfd(conn, xfd2->stream.fd);
+   }
+
+   Notice4("starting data transfer with FDs [%d,%d] and [%d,%d]",
+	   XIO_GETRDFD(sock0), XIO_GETWRFD(sock0),
+	   XIO_GETRDFD(xfd2), XIO_GETWRFD(xfd2));
+   socat_evupdate(conn);
+   if (conn->failed) {
+      socat_evclose(conn);
+      return NULL;
+   }
+   return conn;
+}
+
+/* epoll reported the socket of the second address whose connect() was in
+   progress: checks if the connection has been established */
+static void socat_evconnected(struct socat_evconn *conn) {
+   int fd = conn->connecting->fd;
+   int err = 0;
+   socklen_t errlen = sizeof(err);
+
+   conn->connecting = NULL;
+   if (Getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0) {
+      err = errno;
+   }
+   if (err != 0) {
+      Error2("connect(%d, ...): %s", fd, strerror(err));
+      conn->failed = true;
+      return;
+   }
+   Notice1("FD %d: connection established", fd);
+}
+
+/* writes as much of the buffered data of direction d as the output takes */
+static void socat_evwrite(struct socat_evconn *conn, int d) {
+   struct socat_evdir *dir = &conn->dir[d];
+   ssize_t writt;
+
+   writt = xiowritepart(dir->out, dir->buff+dir->off, dir->len-dir->off);
+   if (writt < 0) {
+      if (errno != EAGAIN) {
+	 Notice2("transfer from %d to %d is in error",
+		 XIO_GETRDFD(dir->in), XIO_GETWRFD(dir->out));
+	 conn->failed = true;
+      } else if (dir->wr == NULL) {
+	 /* the peer of a datagram listener, do not wait for it */
+	 Info2("dropping datagram of "F_Zu" bytes to fd %d",
+	       dir->len-dir->off, XIO_GETWRFD(dir->out));
+	 dir->off = dir->len = 0;
+      }
+      return;
+   }
+   socat_stats_write(d, writt);
+   Info3("transferred "F_Zu" bytes from %d to %d",
+	 writt, XIO_GETRDFD(dir->in), XIO_GETWRFD(dir->out));
+   dir->off += writt;
+   if (dir->off == dir->len) {
+      dir->off = dir->len = 0;
+   }
+}
+
+/* reads a block of data for direction d, converts it, and tries to write it
+   immediately */
+static void socat_evread(struct socat_evconn *conn, int d,
+			 const struct timeval *now) {
+   struct socat_evdir *dir = &conn->dir[d];
+   struct single *in = XIO_RDSTREAM(dir->in);
+   ssize_t bytes;
+
+   bytes = xioread(dir->in, dir->buff, socat_opts.bufsiz);
+   socat_stats_read(d, bytes);
+   if (bytes < 0) {
+      if (errno != EAGAIN) {
+	 Notice2("transfer from %d to %d is in error",
+		 XIO_GETRDFD(dir->in), XIO_GETWRFD(dir->out));
+	 dir->eof = true;
+      }
+      return;
+   }
+   if (bytes == 0) {
+      Notice2("socket %d (fd %d) is at EOF", d+1, XIO_GETRDFD(dir->in));
+      dir->eof = true;
+      return;
+   }
+   conn->lastio = *now;
+
+   if (xiotransfer_inspecting(dir->in, dir->out, d==1)) {
+      bytes = xiotransfer_inspect(dir->in, dir->out, dir->buff, bytes, d==1);
+   }
+   if (in->actescape || (in->readbytes != 0 && in->actbytes == 0)) {
+      /* no further read would provide data */
+      dir->eof = true;
+   }
+   if (bytes <= 0)  return;
+   dir->off = 0;
+   dir->len = bytes;
+   socat_evwrite(conn, d);
+}
+
+/* handles the events that epoll reported on evfd for direction d */
+static void socat_evdirection(struct socat_evconn *conn, int d,
+			      struct socat_evfd *evfd, uint32_t revents,
+			      const struct timeval *now) {
+   struct socat_evdir *dir = &conn->dir[d];
+   bool mayrd;
+
+   if (!dir->active)  return;
+   mayrd = (dir->rd == evfd && (revents & (EPOLLIN|EPOLLHUP|EPOLLERR)));
+   if (dir->wr == evfd && dir->len > 0 &&
+       (revents & (EPOLLOUT|EPOLLHUP|EPOLLERR))) {
+      socat_evwrite(conn, d);
+      /* data might wait in the input layer (e.g. SSL) without readability */
+      mayrd = mayrd || (dir->len == 0 && xiopending(dir->in) > 0);
+   }
+   while (mayrd && !conn->failed && !dir->eof && dir->len == 0) {
+      socat_evread(conn, d, now);
+      mayrd = (xiopending(dir->in) > 0);
+   }
+}
+
+/* passes EOFs on to the other side and checks the -t and -T timers.
+   returns true when the connection is finished */
+static bool socat_evcheck(struct socat_evconn *conn,
+			  const struct timeval *now) {
+   bool alldone = true;
+   int d;
+
+   if (conn->failed)  return true;
+   for (d = 0; d < 2; ++d) {
+      struct socat_evdir *dir = &conn->dir[d];
+
+      if (!dir->active)  continue;
+      if (dir->eof && dir->len == 0 && !dir->done) {
+	 xioshutdown(dir->out, SHUT_WR);
+	 dir->done = true;
+	 if (conn->closing.tv_sec == 0 && conn->closing.tv_usec == 0) {
+	    /* first EOF, start end timer */
+	    conn->closing = *now;
+	    ++socat_numclosing;
+	 }
+      }
+      if (!dir->done)  alldone = false;
+   }
+   if (alldone)  return true;
+
+   if ((conn->closing.tv_sec != 0 || conn->closing.tv_usec != 0) &&
+       socat_evremaining(&conn->closing, &socat_opts.closwait, now) == 0) {
+      Info4("connection with FDs %d and %d: no data within %ld.%06ld seconds after EOF",
+	    XIO_GETRDFD(conn->sock[0]), XIO_GETRDFD(conn->sock[1]),
+	    socat_opts.closwait.tv_sec, socat_opts.closwait.tv_usec);
+      return true;
+   }
+   if ((socat_opts.total_timeout.tv_sec != 0 ||
+	socat_opts.total_timeout.tv_usec != 0) &&
+       socat_evremaining(&conn->lastio, &socat_opts.total_timeout, now) == 0) {
+      Notice("inactivity timeout triggered");
+      return true;
+   }
+   return false;
+}
+
+/* reads up to SOCAT_EVMAXDGRAMS datagrams from the datagram listener sock1
+   into buff and passes each to the session of its sender. For a new peer it
+   opens a session, closing the longest idle one when max-children sessions
+   exist. A datagram is dropped when the session has not yet written the
+   previous one */
+static void socat_evdgram(const xiofile_t *tmpl2, unsigned char *buff,
+			  const struct timeval *now,
+			  struct timeval *lastaccept) {
+   int maxconns = sock1->stream.para.socket.evloop.maxconns;
+   union sockaddr_union pa, key;
+   socklen_t palen, keylen;
+   struct socat_evconn *conn, *c;
+   struct socat_evdir *dir;
+   xiofile_t *nsock;
+   ssize_t bytes;
+   unsigned int hash;
+   int i;
+
+   for (i = 0; i < SOCAT_EVMAXDGRAMS; ++i) {
+      palen = sizeof(pa);
+      bytes = xiorecvpeer(sock1, buff, socat_opts.bufsiz, &pa, &palen);
+      if (bytes < 0) {
+	 return;
+      }
+      keylen = socat_evpeerkey(&key, &pa, palen);
+      hash = socat_evpeerhash(&key, keylen);
+      if ((conn = socat_evpeerfind(&key, keylen, hash)) == NULL) {
+	 if (maxconns != 0 && socat_numconns >= maxconns) {
+	    struct socat_evconn *idle = socat_evconns;
+	    for (c = socat_evconns; c != NULL; c = c->next) {
+	       if (c->lastio.tv_sec < idle->lastio.tv_sec ||
+		   (c->lastio.tv_sec == idle->lastio.tv_sec &&
+		    c->lastio.tv_usec < idle->lastio.tv_usec)) {
+		  idle = c;
+	       }
+	    }
+	    Notice("maxchildren are active, closing the longest idle session");
+	    socat_evclose(idle);
+	 }
+	 if ((nsock = xioaccept_peer(sock1, &pa, palen)) == NULL) {
+	    continue;
+	 }
+	 *lastaccept = *now;
+	 if ((conn = socat_evopen(nsock, tmpl2, true, now)) == NULL) {
+	    continue;
+	 }
+	 conn->peer     = key;
+	 conn->peerlen  = keylen;
+	 conn->peerhash = hash;
+	 if (socat_evpeeradd(conn) < 0) {
+	    socat_evclose(conn);
+	    continue;
+	 }
+      }
+
+      socat_stats_read(0, bytes);
+      dir = &conn->dir[0];
+      if (!dir->active || dir->eof || bytes == 0) {
+	 continue;
+      }
+      if (dir->len > 0) {
+	 Info2("dropping datagram of "F_Zd" bytes to fd %d",
+	       bytes, XIO_GETWRFD(dir->out));
+	 continue;
+      }
+      conn->lastio = *now;
+      memcpy(dir->buff, buff, bytes);
+      if (xiotransfer_inspecting(dir->in, dir->out, false)) {
+	 bytes = xiotransfer_inspect(dir->in, dir->out, dir->buff, bytes,
+				     false);
+      }
+      if (bytes <= 0)  continue;
+      dir->off = 0;
+      dir->len = bytes;
+      socat_evwrite(conn, 0);
+      if (socat_evcheck(conn, now)) {
+	 socat_evclose(conn);
+      } else {
+	 socat_evupdate(conn);
+      }
+   }
+}
+
+/* the event loop: accepts connections on the listener sock1, opens a copy
+   of the parsed second address tmpl2 for each of them, and transfers data
+   until the listener was closed by accept-timeout and all connections have
+   terminated.
+   returns -1 on error or 0 on success */
+static int socat_eventloop(const xiofile_t *tmpl2) {
+   struct epoll_event events[SOCAT_EVMAXEVENTS];
+   struct socat_evconn *touched[SOCAT_EVMAXEVENTS];
+   struct epoll_event ev;
+   struct socat_evconn *conn, *next;
+   struct timeval now, lastaccept;
+   struct single *lis = &sock1->stream;
+   int maxconns = lis->para.socket.evloop.maxconns;
+   bool dgram = lis->para.socket.evloop.dgram;
+   unsigned char *dgrambuff = NULL;	/* receives the datagrams */
+   bool dgramready;
+   bool accepting = true;	/* accept-timeout did not yet occur */
+   bool listening = false;	/* listener is registered with epoll */
+   bool hastimeout;
+   int exitlevel;
+   int n, ntouched, i, timeout;
+   int result = 0;
+
+   if (xioshared(tmpl2)) {
+      Error("option event-loop: the second address must open its own FDs for each connection, not use existing ones like STDIO or FD");
+      return -1;
+   }
+   if (xioretrying(tmpl2)) {
+      Error("option event-loop: options retry and forever of the second address would stop all connections while waiting");
+      return -1;
+   }
+#if WITH_VSOCK && defined(SO_VM_SOCKETS_BUFFER_SIZE)
+   if (socat_opts.bufsizauto) {
+      socat_vsockbufsiz(sock1, NULL);	/* accepted sockets inherit it */
+   }
+#endif
+   if (socat_opts.bufsiz > (SIZE_MAX-1)/2) {
+      Error2("buffer size option (-b) to big - "F_Zu" (max is "F_Zu")", socat_opts.bufsiz, (SIZE_MAX-1)/2);
+      socat_opts.bufsiz = (SIZE_MAX-1)/2;
+   }
+   hastimeout = (lis->para.socket.accept_timeout.tv_sec != 0 ||
+		 lis->para.socket.accept_timeout.tv_usec != 0);
+
+   if (dgram && (dgrambuff = Malloc(socat_opts.bufsiz)) == NULL) {
+      return -1;
+   }
+   if ((socat_epfd = Epoll_create1(EPOLL_CLOEXEC)) < 0) {
+      Error1("epoll_create1(EPOLL_CLOEXEC): %s", strerror(errno));
+      free(dgrambuff);
+      return -1;
+   }
+
+   /* errors on one connection must not terminate the others */
+   exitlevel = diag_get_int('e');
+   diag_set_int('e', E_FATAL);
+
+   socat_stats_open();
+   if (socat_statsfd >= 0) {
+      ev.events = EPOLLIN;
+      ev.data.ptr = &socat_evstats;
+      if (Epoll_ctl(socat_epfd, EPOLL_CTL_ADD, socat_statsfd, &ev) < 0) {
+	 Warn3("epoll_ctl(%d, EPOLL_CTL_ADD, %d, ...): %s",
+	       socat_epfd, socat_statsfd, strerror(errno));
+      }
+   }
+   /* the children of EXEC and SYSTEM connections are waited for here */
+   xiosetchilddied();
+   if (xiochildfd() >= 0) {
+      ev.events = EPOLLIN;
+      ev.data.ptr = &socat_evchild;
+      if (Epoll_ctl(socat_epfd, EPOLL_CTL_ADD, xiochildfd(), &ev) < 0) {
+	 Warn3("epoll_ctl(%d, EPOLL_CTL_ADD, %d, ...): %s",
+	       socat_epfd, xiochildfd(), strerror(errno));
+      }
+   }
+
+   Notice1("starting event loop on listening FD %d", lis->fd);
+   Gettimeofday(&lastaccept, NULL);
+   while (accepting || socat_evconns != NULL) {
+
+      /* the listener takes part as long as max-children is not reached;
+	 a datagram listener also carries the data of the sessions */
+      if (accepting && !listening &&
+	  (dgram || maxconns == 0 || socat_numconns < maxconns)) {
+	 ev.events = EPOLLIN;
+	 ev.data.ptr = NULL;
+	 if (Epoll_ctl(socat_epfd, EPOLL_CTL_ADD, lis->fd, &ev) < 0) {
+	    Error3("epoll_ctl(%d, EPOLL_CTL_ADD, %d, ...): %s",
+		   socat_epfd, lis->fd, strerror(errno));
+	    result = -1;
+	    break;
+	 }
+	 listening = true;
+      } else if (listening && !dgram &&
+		 maxconns != 0 && socat_numconns >= maxconns) {
+	 Notice("maxchildren are active, waiting");
+	 Epoll_ctl(socat_epfd, EPOLL_CTL_DEL, lis->fd, NULL);
+	 listening = false;
+      }
+
+      Gettimeofday(&now, NULL);
+      timeout = -1;
+      if (accepting && hastimeout) {
+	 timeout = socat_evremaining(&lastaccept,
+				     &lis->para.socket.accept_timeout, &now);
+      }
+      if (socat_numclosing > 0 ||
+	  socat_opts.total_timeout.tv_sec != 0 ||
+	  socat_opts.total_timeout.tv_usec != 0) {
+	 for (conn = socat_evconns; conn != NULL; conn = conn->next) {
+	    int ms;
+	    if (conn->closing.tv_sec != 0 || conn->closing.tv_usec != 0) {
+	       ms = socat_evremaining(&conn->closing, &socat_opts.closwait,
+				      &now);
+	       if (timeout < 0 || ms < timeout)  timeout = ms;
+	    }
+	    if (socat_opts.total_timeout.tv_sec != 0 ||
+		socat_opts.total_timeout.tv_usec != 0) {
+	       ms = socat_evremaining(&conn->lastio,
+				      &socat_opts.total_timeout, &now);
+	       if (timeout < 0 || ms < timeout)  timeout = ms;
+	    }
+	 }
+      }
+
+      if (socat_dump_pending() &&
+	  (timeout < 0 || timeout > SOCAT_DUMPQ_RETRY)) {
+	 timeout = SOCAT_DUMPQ_RETRY;
+      }
+
+      n = Epoll_wait(socat_epfd, events, SOCAT_EVMAXEVENTS, timeout);
+      socat_dump_flushall();
+      if (n < 0) {
+	 int _errno = errno;
+	 diag_flush();	/* messages from signal handlers */
+	 if (socat_statsreq) {
+	    socat_stats_dump();
+	 }
+	 xiochildreap();
+	 errno = _errno;
+	 if (errno == EINTR)  continue;
+	 Error5("epoll_wait(%d, %p, %d, %d): %s",
+		socat_epfd, events, SOCAT_EVMAXEVENTS, timeout,
+		strerror(errno));
+	 result = -1;
+	 break;
+      }
+      Gettimeofday(&now, NULL);
+      socat_stats_wakeup();
+
+      ntouched = 0;
+      dgramready = false;
+      for (i = 0; i < n; ++i) {
+	 struct socat_evfd *evfd = events[i].data.ptr;
+
+	 if (evfd == NULL && dgram) {
+	    /* after the other events, because it might close sessions */
+	    dgramready = true;
+	    continue;
+	 }
+	 if (evfd == NULL) {
+	    /* listener; Accept() waits for a connection, so take only one
+	       per event; epoll reports the listener again when more wait */
+	    xiofile_t *nsock;
+	    if ((nsock = xioaccept(sock1)) != NULL) {
+	       lastaccept = now;
+	       socat_evopen(nsock, tmpl2, false, &now);
+	    }
+	    continue;
+	 }
+	 if (evfd == &socat_evstats) {
+	    socat_stats_serve();
+	    continue;
+	 }
+	 if (evfd == &socat_evchild) {
+	    xiochildreap();
+	    continue;
+	 }
+	 conn = evfd->conn;
+	 if (conn->connecting == evfd) {
+	    socat_evconnected(conn);
+	 }
+	 socat_evdirection(conn, 0, evfd, events[i].events, &now);
+	 socat_evdirection(conn, 1, evfd, events[i].events, &now);
+	 if (!conn->touched) {
+	    conn->touched = true;
+	    touched[ntouched++] = conn;
+	 }
+      }
+      for (i = 0; i < ntouched; ++i) {
+	 conn = touched[i];
+	 conn->touched = false;
+	 if (socat_evcheck(conn, &now)) {
+	    socat_evclose(conn);
+	 } else {
+	    socat_evupdate(conn);
+	 }
+      }
+      if (dgramready) {
+	 socat_evdgram(tmpl2, dgrambuff, &now, &lastaccept);
+      }
+
+      if (socat_numclosing > 0 ||
+	  socat_opts.total_timeout.tv_sec != 0 ||
+	  socat_opts.total_timeout.tv_usec != 0) {
+	 for (conn = socat_evconns; conn != NULL; conn = next) {
+	    next = conn->next;
+	    if (socat_evcheck(conn, &now)) {
+	       socat_evclose(conn);
+	    }
+	 }
+      }
+
+      if (accepting && hastimeout &&
+	  socat_evremaining(&lastaccept, &lis->para.socket.accept_timeout,
+			    &now) == 0) {
+	 Warn1("accept: %s", strerror(ETIMEDOUT));
+	 if (listening) {
+	    Epoll_ctl(socat_epfd, EPOLL_CTL_DEL, lis->fd, NULL);
+	    listening = false;
+	 }
+	 accepting = false;
+	 Notice("Waiting for connections to terminate");
+      }
+   }
+
+   while (socat_evconns != NULL) {
+      socat_evclose(socat_evconns);
+   }
+   free(socat_evpeers);  socat_evpeers = NULL;  socat_evpeersize = 0;
+   free(dgrambuff);
+   xioclose(sock1);
+   Close(socat_epfd);
+   socat_epfd = -1;
+   diag_set_int('e', exitlevel);
+   return result;
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
+#if WITH_VSOCK && defined(SO_VM_SOCKETS_BUFFER_SIZE)
+/* upper limit for the automatic transfer block size with VSOCK */
+#define SOCAT_VSOCK_MAXBUFSIZ (1024*1024)
+
+/* returns the socket buffer size when fd is a VSOCK socket, or 0 */
+static size_t socat_vsockfdbufsiz(int fd) {
+   union sockaddr_union sa;
+   socklen_t salen = sizeof(sa);
+   unsigned long long bufsiz;
+   socklen_t optlen = sizeof(bufsiz);
+
+   if (fd < 0 || Getsockname(fd, &sa.soa, &salen) < 0 ||
+       sa.soa.sa_family != AF_VSOCK) {
+      return 0;
+   }
+   if (Getsockopt(fd, AF_VSOCK, SO_VM_SOCKETS_BUFFER_SIZE, &bufsiz, &optlen)
+       < 0) {
+      Info2("getsockopt(%d, AF_VSOCK, SO_VM_SOCKETS_BUFFER_SIZE, ...): %s",
+	    fd, strerror(errno));
+      return 0;
+   }
+   return bufsiz;
+}
+
+/* without option -b: virtio-vsock has a high per packet overhead, so when one
+   of the addresses is a VSOCK socket, grow the transfer block size up to its
+   socket buffer size (see option vsock-buffer-size) */
+static void socat_vsockbufsiz(xiofile_t *xfd1, xiofile_t *xfd2) {
+   xiofile_t *xfds[2];
+   size_t bufsiz = 0, fdbufsiz;
+   int i;
+
+   xfds[0] = xfd1;  xfds[1] = xfd2;
+   for (i = 0; i < 2; ++i) {
+      if (xfds[i] == NULL)  continue;
+      fdbufsiz = socat_vsockfdbufsiz(XIO_GETRDFD(xfds[i]));
+      if (fdbufsiz > bufsiz)  bufsiz = fdbufsiz;
+      if (XIO_GETWRFD(xfds[i]) != XIO_GETRDFD(xfds[i])) {
+	 fdbufsiz = socat_vsockfdbufsiz(XIO_GETWRFD(xfds[i]));
+	 if (fdbufsiz > bufsiz)  bufsiz = fdbufsiz;
+      }
+   }
+   if (bufsiz > SOCAT_VSOCK_MAXBUFSIZ) {
+      bufsiz = SOCAT_VSOCK_MAXBUFSIZ;
+   }
+   if (bufsiz > socat_opts.bufsiz) {
+      Info1("VSOCK: using transfer block size "F_Zu, bufsiz);
+      socat_opts.bufsiz = bufsiz;
+   }
+}
+#endif /* WITH_VSOCK && defined(SO_VM_SOCKETS_BUFFER_SIZE) */
+
+#define CR '\r'
+#define LF '\n'
+
+
+/* converts the newline characters (or character sequences) from the one
+   specified in lineterm1 to that of lineterm2. Possible values are
+   LINETERM_CR, LINETERM_CRNL, LINETERM_RAW.
+   bytes specifies the number of bytes input and output; buff must provide
+   space for 2*bytes */
+int cv_newline(unsigned char *buff, ssize_t *bytes,
+	       int lineterm1, int lineterm2) {
+   /* must perform newline changes */
+   if (lineterm1 <= LINETERM_CR && lineterm2 <= LINETERM_CR) {
+      /* no change in data length */
+      if (lineterm1 == LINETERM_RAW) {
+	 newline_replace(buff, *bytes, '\n', '\r');
+      } else {
+	 newline_replace(buff, *bytes, '\r', '\n');
+      }
+
+   } else if (lineterm1 == LINETERM_CRNL) {
+      /* buffer might become shorter */
+      *bytes = newline_contract(buff, buff, *bytes,
+				lineterm2 == LINETERM_RAW ? '\n' : '\r');
+   } else {
+      /* buffer becomes longer (up to double length); the data before the
+	 first newline stays in place, the rest is expanded from a copy */
+      static unsigned char *buf2;	/*! not threadsafe */
+      static size_t buf2siz;
+      unsigned char from, *p;
+      size_t tail;
+
+      if (lineterm1 == LINETERM_RAW) {
+	 from = '\n';
+      } else {
+	 from = '\r';
+      }
+      if ((p = memchr(buff, from, *bytes)) == NULL) {
+	 return 0;
+      }
+      tail = buff + *bytes - p;
+      if (tail > buf2siz) {
+	 free(buf2);
+	 if ((buf2 = Malloc(Max(tail, socat_opts.bufsiz))) == NULL) {
+	    buf2siz = 0;
+	    return -1;
 	 }
+	 buf2siz = Max(tail, socat_opts.bufsiz);
       }
-      *bytes = t - buff;;
+      memcpy(buf2, p, tail);
+      *bytes = (p - buff) + newline_expand(p, buf2, tail, from);
    }
    return 0;
 }
@@ -1614,5 +4297,8 @@ static void socat_unlock(void) {
  */
 static int socat_newchild(void) {
    havelock = false;
+   socat_forked = true;
+   /* the parent process writes what it has queued */
+   socat_dumpq[0].len = socat_dumpq[1].len = socat_dumpq[2].len = 0;
    return 0;
 }
@@ -343,6 +343,14 @@ int sycSSL_set_fd(SSL *ssl, int fd) {
    return result;
 }
 
+int sycSSL_set_session(SSL *ssl, SSL_SESSION *session) {
+   int result;
+   Debug2("SSL_set_session(%p, %p)", ssl, session);
+   result = SSL_set_session(ssl, session);
+   Debug1("SSL_set_session() -> %d", result);
+   return result;
+}
+
 int sycSSL_connect(SSL *ssl) {
    int result;
    Debug1("SSL_connect(%p)", ssl);
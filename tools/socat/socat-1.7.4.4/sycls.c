@@ -20,6 +20,24 @@
 #include "sysutils.h"
 #include "sycls.h"
 
+#if WITH_FAST_SYCLS
+/* the wrappers are still built, but sycls.h maps the calls past them */
+#undef Read
+#undef Write
+#undef Splice
+#undef Poll
+#undef Select
+#undef Epoll_wait
+#undef Recv
+#undef Recvfrom
+#undef Recvmsg
+#undef Send
+#undef Sendto
+#undef Sendmsg
+#undef Recvmmsg
+#undef Sendmmsg
+#endif /* WITH_FAST_SYCLS */
+
 
 #if WITH_SYCLS
 
@@ -570,6 +588,27 @@ ssize_t Write(int fd, const void *buf, size_t count) {
    return result;
 }
 
+#if HAVE_SPLICE
+ssize_t Splice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out,
+	       size_t len, unsigned int flags) {
+   ssize_t result;
+   int _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug6("splice(%d, %p, %d, %p, "F_Zu", 0x%x)",
+	  fd_in, off_in, fd_out, off_out, len, flags);
+#endif /* WITH_SYCLS */
+   result = splice(fd_in, off_in, fd_out, off_out, len, flags);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("splice -> "F_Zd, result);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return result;
+}
+#endif /* HAVE_SPLICE */
+
 int Fcntl(int fd, int cmd) {
    int result, _errno;
    if (!diag_in_handler) diag_flush();
@@ -905,6 +944,58 @@ int Pselect(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
 }
 #endif /* HAVE_PSELECT */
 
+#if HAVE_SYS_EPOLL_H
+int Epoll_create1(int flags) {
+   int result, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("epoll_create1(0x%x)", flags);
+#endif /* WITH_SYCLS */
+   result = epoll_create1(flags);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("epoll_create1() -> %d", result);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return result;
+}
+
+int Epoll_ctl(int epfd, int op, int fd, struct epoll_event *event) {
+   int result, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug4("epoll_ctl(%d, %d, %d, {0x%x,})",
+	  epfd, op, fd, event?event->events:0);
+#endif /* WITH_SYCLS */
+   result = epoll_ctl(epfd, op, fd, event);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("epoll_ctl() -> %d", result);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return result;
+}
+
+int Epoll_wait(int epfd, struct epoll_event *events, int maxevents,
+	       int timeout) {
+   int result, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug4("epoll_wait(%d, %p, %d, %d)", epfd, events, maxevents, timeout);
+#endif /* WITH_SYCLS */
+   result = epoll_wait(epfd, events, maxevents, timeout);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("epoll_wait() -> %d", result);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return result;
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
 #if WITH_SYCLS
 
 pid_t Fork(void) {
@@ -1003,6 +1094,16 @@ int Link(const char *oldpath, const char *newpath) {
    return retval;
 }
 
+int Rename(const char *oldpath, const char *newpath) {
+   int retval, _errno;
+   Debug2("rename(\"%s\", \"%s\")", oldpath, newpath);
+   retval = rename(oldpath, newpath);
+   _errno = errno;
+   Debug1("rename() -> %d", retval);
+   errno = _errno;
+   return retval;
+}
+
 int Execvp(const char *file, char *const argv[]) {
    int result, _errno;
    if (argv[1] == NULL)
@@ -1025,6 +1126,29 @@ int Execvp(const char *file, char *const argv[]) {
    return result;
 }
 
+#if HAVE_POSIX_SPAWNP
+/* unlike most functions, posix_spawnp() returns the error number instead of
+   setting errno */
+int Posix_spawnp(pid_t *pid, const char *file,
+		 const posix_spawn_file_actions_t *actions,
+		 const posix_spawnattr_t *attr,
+		 char *const argv[], char *const envp[]) {
+   int result;
+   if (argv[1] == NULL)
+      Debug2("posix_spawnp(pid, \"%s\", actions, attr, \"%s\", envp)",
+	     file, argv[0]);
+   else if (argv[2] == NULL)
+      Debug3("posix_spawnp(pid, \"%s\", actions, attr, \"%s\" \"%s\", envp)",
+	     file, argv[0], argv[1]);
+   else
+      Debug5("posix_spawnp(pid, \"%s\", actions, attr, \"%s\" \"%s\" \"%s\"%s, envp)",
+	     file, argv[0], argv[1], argv[2], argv[3]?" ...":"");
+   result = posix_spawnp(pid, file, actions, attr, argv, envp);
+   Debug2("posix_spawnp() -> %d, pid "F_pid, result, *pid);
+   return result;
+}
+#endif /* HAVE_POSIX_SPAWNP */
+
 #endif /* WITH_SYCLS */
 
 int System(const char *string) {
@@ -1370,6 +1494,69 @@ int Sendto(int s, const void *mesg, size_t len, int flags,
 }
 #endif /* _WITH_SOCKET */
 
+#if _WITH_SOCKET
+int Sendmsg(int s, const struct msghdr *msgh, int flags) {
+   int retval, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+#if defined(HAVE_STRUCT_MSGHDR_MSGCONTROL) && defined(HAVE_STRUCT_MSGHDR_MSGCONTROLLEN)
+   Debug9("sendmsg(%d, %p{%p,%u,%p,"F_Zu",%p,"F_Zu"}, %d)", s, msgh,
+	  msgh->msg_name, msgh->msg_namelen,  msgh->msg_iov,  msgh->msg_iovlen,
+	  msgh->msg_control,  msgh->msg_controllen, flags);
+#else
+   Debug7("sendmsg(%d, %p{%p,%u,%p,%u}, %d)", s, msgh,
+	  msgh->msg_name, msgh->msg_namelen,  msgh->msg_iov,  msgh->msg_iovlen,
+	  flags);
+#endif
+#endif /* WITH_SYCLS */
+   retval = sendmsg(s, msgh, flags);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("sendmsg() -> %d", retval);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return retval;
+}
+#endif /* _WITH_SOCKET */
+
+#if _WITH_SOCKET && HAVE_RECVMMSG
+int Recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+	     struct timespec *timeout) {
+   int retval, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug5("recvmmsg(%d, %p, %u, %d, %p)", s, msgvec, vlen, flags, timeout);
+#endif /* WITH_SYCLS */
+   retval = recvmmsg(s, msgvec, vlen, flags, timeout);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("recvmmsg() -> %d", retval);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return retval;
+}
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG */
+
+#if _WITH_SOCKET && HAVE_SENDMMSG
+int Sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags) {
+   int retval, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug4("sendmmsg(%d, %p, %u, %d)", s, msgvec, vlen, flags);
+#endif /* WITH_SYCLS */
+   retval = sendmmsg(s, msgvec, vlen, flags);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("sendmmsg() -> %d", retval);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return retval;
+}
+#endif /* _WITH_SOCKET && HAVE_SENDMMSG */
+
 #if WITH_SYCLS
 
 #if _WITH_SOCKET
@@ -60,6 +60,10 @@ int Pipe(int filedes[2]);
 #endif /* WITH_SYCLS */
 ssize_t Read(int fd, void *buf, size_t count);
 ssize_t Write(int fd, const void *buf, size_t count);
+#if HAVE_SPLICE
+ssize_t Splice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out,
+	       size_t len, unsigned int flags);
+#endif /* HAVE_SPLICE */
 int Fcntl(int fd, int cmd);
 int Fcntl_l(int fd, int cmd, long arg);
 int Fcntl_lock(int fd, int cmd, struct flock *l);
@@ -87,6 +91,12 @@ int Select(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
 	   struct timeval *timeout);
 int Pselect(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
 	    const struct timespec *timeout, const sigset_t *sigmask);
+#if HAVE_SYS_EPOLL_H
+int Epoll_create1(int flags);
+int Epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+int Epoll_wait(int epfd, struct epoll_event *events, int maxevents,
+	       int timeout);
+#endif /* HAVE_SYS_EPOLL_H */
 #if WITH_SYCLS
 pid_t Fork(void);
 #endif /* WITH_SYCLS */
@@ -102,7 +112,14 @@ int Sigprocmask(int how, const sigset_t *set, sigset_t *oset);
 unsigned int Alarm(unsigned int seconds);
 int Kill(pid_t pid, int sig);
 int Link(const char *oldpath, const char *newpath);
+int Rename(const char *oldpath, const char *newpath);
 int Execvp(const char *file, char *const argv[]);
+#if HAVE_POSIX_SPAWNP
+int Posix_spawnp(pid_t *pid, const char *file,
+		 const posix_spawn_file_actions_t *actions,
+		 const posix_spawnattr_t *attr,
+		 char *const argv[], char *const envp[]);
+#endif
 #endif /* WITH_SYCLS */
 int System(const char *string);
 #if WITH_SYCLS
@@ -131,6 +148,14 @@ int Recvmsg(int s, struct msghdr *msg, int flags);
 int Send(int s, const void *mesg, size_t len, int flags);
 int Sendto(int s, const void *msg, size_t len, int flags,
 	   const struct sockaddr *to, socklen_t tolen);
+int Sendmsg(int s, const struct msghdr *msg, int flags);
+#if HAVE_RECVMMSG
+int Recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+	     struct timespec *timeout);
+#endif
+#if HAVE_SENDMMSG
+int Sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags);
+#endif
 #if WITH_SYCLS
 int Shutdown(int fd, int how);
 #endif /* WITH_SYCLS */
@@ -236,7 +261,9 @@ void Add_history(const char *string);
 #define Alarm(s) alarm(s)
 #define Kill(p,s) kill(p,s)
 #define Link(o,n) link(o,n)
+#define Rename(o,n) rename(o,n)
 #define Execvp(f,a) execvp(f,a)
+#define Posix_spawnp(p,f,a,t,v,e) posix_spawnp(p,f,a,t,v,e)
 #define Socketpair(d,t,p,s) socketpair(d,t,p,s)
 #define Socket(d,t,p) socket(d,t,p)
 #define Bind(s,m,a) bind(s,m,a)
@@ -282,4 +309,23 @@ void Add_history(const char *string);
 
 #endif /* !WITH_SYCLS */
 
+#if WITH_FAST_SYCLS
+/* the system calls of the data transfer go to the C library directly, without
+   tracing and the diag_flush() calls (see configure --enable-fast-sycls) */
+#define Read(f,b,c) read(f,b,c)
+#define Write(f,b,c) write(f,b,c)
+#define Splice(fi,oi,fo,oo,l,f) splice(fi,oi,fo,oo,l,f)
+#define Poll(u,n,t) poll(u,n,t)
+#define Select(n,r,w,e,t) select(n,r,w,e,t)
+#define Epoll_wait(e,v,m,t) epoll_wait(e,v,m,t)
+#define Recv(s,b,l,f) recv(s,b,l,f)
+#define Recvfrom(s,b,l,f,a,al) recvfrom(s,b,l,f,a,al)
+#define Recvmsg(s,m,f) recvmsg(s,m,f)
+#define Send(s,m,l,f) send(s,m,l,f)
+#define Sendto(s,m,l,f,t,tl) sendto(s,m,l,f,t,tl)
+#define Sendmsg(s,m,f) sendmsg(s,m,f)
+#define Recvmmsg(s,m,v,f,t) recvmmsg(s,m,v,f,t)
+#define Sendmmsg(s,m,v,f) sendmmsg(s,m,v,f)
+#endif /* WITH_FAST_SYCLS */
+
 #endif /* !defined(__sycls_h_included) */
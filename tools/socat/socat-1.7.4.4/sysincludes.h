@@ -93,6 +93,17 @@
 #if HAVE_SYS_FILE_H
 #include <sys/file.h>	/* LOCK_EX, on AIX directly included */
 #endif
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>	/* epoll_create1(), for option event-loop */
+#endif
+#if HAVE_SPAWN_H
+#include <spawn.h>	/* posix_spawnp(), for EXEC and SYSTEM */
+#endif
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>	/* io_uring, for option -I */
+#include <sys/syscall.h>	/* __NR_io_uring_setup */
+#include <sys/mman.h>	/* mmap() of the io_uring rings */
+#endif
 #if WITH_IP4 || WITH_IP6
 #  if HAVE_NETINET_IN_H
 #include <netinet/in.h>	/* struct sockaddr_in, htonl() */
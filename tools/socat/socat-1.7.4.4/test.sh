@@ -15657,6 +15657,2069 @@ esac
 N=$((N+1))
 
 
+# Test if socat transfers data between two plain stream FDs with splice(),
+# and if the data arrives unchanged
+NAME=SPLICE_TRANSFER
+case "$TESTS" in
+*%$N%*|*%functions%*|*%splice%*|*%$NAME%*)
+TEST="$NAME: zero copy transfer with splice()"
+# Let socat copy a file of random data to another file with info logging.
+# When the log shows that splice() was used and the files are identical the
+# test succeeded
+if ! eval $NUMCOND; then :;
+elif [ "$UNAME" != Linux ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}only on Linux${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ti="$td/test$N.input"
+to="$td/test$N.output"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+CMD0="$TRACE $SOCAT $opts -d -d -d -u OPEN:$ti CREATE:$to"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0"
+rc0=$?
+if [ "$rc0" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "using splice()" "${te}0"; then
+    $PRINTF "$FAILED (splice() not used)\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! cmp -s "$ti" "$to"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+# Test if socat keeps data that the peer does not take immediately in the write
+# buffer, and delivers all of it in order
+NAME=WRITE_BUFFER
+case "$TESTS" in
+*%$N%*|*%functions%*|*%system%*|*%$NAME%*)
+TEST="$NAME: buffering data for a peer that does not read"
+# Let socat copy a text file to a subprocess that starts reading only after a
+# second. Option escape prevents splice(), so the data passes socat's buffers.
+# When the debug log shows that data was buffered and the output is identical
+# with the input the test succeeded
+if ! eval $NUMCOND; then :;
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ti="$td/test$N.input"
+to="$td/test$N.output"
+seq 1 150000 >"$ti"
+CMD0="$TRACE $SOCAT $opts -d -d -d -d -u OPEN:$ti,escape=0x1d SYSTEM:\"sleep 1; cat >$to\""
+printf "test $F_n $TEST... " $N
+eval "$CMD0" >/dev/null 2>"${te}0"
+rc0=$?
+if [ "$rc0" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "buffering .* bytes for fd" "${te}0"; then
+    $PRINTF "$FAILED (data not buffered)\n"
+    echo "$CMD0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! cmp -s "$ti" "$to"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+# Test if option event-loop serves several connections concurrently from one
+# process
+NAME=EVENT_LOOP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: concurrent connections in one process with event-loop"
+# Start a TCP listener with event-loop and echo. The first client sends data
+# and keeps its connection open for some time; the second client connects
+# later. The test succeeds when the second client gets its echo while the
+# first connection is still active, the first client gets its echo too, and
+# the server did not fork
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions event-loop); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,event-loop PIPE"
+CMD1="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+(echo "$da 1"; sleep 2) |$CMD1 >"${tf}1" 2>"${te}1" &
+pid1=$!
+sleep 1
+echo "$da 2" |$CMD1 >"${tf}2" 2>"${te}2"
+rc2=$?
+kill -0 $pid1 2>/dev/null; rc1=$?	# first client must still be active
+wait $pid1
+kill $pid0 2>/dev/null; wait
+if [ "$rc2" -ne 0 ] || [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "(echo \"$da 1\"; sleep 2) |$CMD1"
+    echo "echo \"$da 2\" |$CMD1"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da 1" |diff - "${tf}1" >"$tdiff" ||
+     ! echo "$da 2" |diff - "${tf}2" >>"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif grep -q "forked off child" "${te}0"; then
+    $PRINTF "$FAILED (forked)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+# Test if option workers starts several listening processes on the same port
+# and terminates them with the master process
+NAME=LISTEN_WORKERS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: option workers with SO_REUSEPORT listener processes"
+# Start a forking TCP listener with three workers and echo, and let five
+# clients connect. The test succeeds when all clients get their echo, three
+# different processes were listening, and the port is free again after the
+# master process has been killed
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions workers); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,fork,workers=3 PIPE"
+CMD1="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT"
+CMD2="$TRACE $SOCAT $opts -u TCP4-LISTEN:$PORT,$REUSEADDR,accept-timeout=0.1 /dev/null"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+rc1=0
+for i in 1 2 3 4 5; do
+    echo "$da $i" |$CMD1 >>"${tf}1" 2>>"${te}1" || rc1=1
+done
+kill $pid0 2>/dev/null; wait
+sleep 1
+$CMD2 >/dev/null 2>"${te}2"
+if [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! for i in 1 2 3 4 5; do echo "$da $i"; done |diff - "${tf}1" >"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$(grep "listening on" "${te}0" |sed 's/.*socat\[\([0-9]*\)\].*/\1/' |sort -u |wc -l)" -ne 3 ]; then
+    $PRINTF "$FAILED (not 3 workers)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif grep -q "Address already in use" "${te}2"; then
+    $PRINTF "$FAILED (workers still active)\n"
+    echo "$CMD0 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+NAME=PRECONNECT
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: option preconnect hands out prepared connections"
+# Start an echo server and a forking TCP listener that forwards to it with
+# preconnect=2, and let three clients connect one after the other. The test
+# succeeds when all clients get their echo and the forwarder used prepared
+# connections
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions preconnect); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+ts=$PORT; PORT=$((PORT+1))
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$ts,$REUSEADDR,fork PIPE"
+CMD1="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,fork TCP4:$LOCALHOST:$ts,preconnect=2"
+CMD2="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $ts 1
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+sleep 1
+rc2=0
+for i in 1 2 3; do
+    echo "$da $i" |$CMD2 >>"${tf}2" 2>>"${te}2" || rc2=1
+    sleep 0.2
+done
+kill $pid1 $pid0 2>/dev/null; wait
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! for i in 1 2 3; do echo "$da $i"; done |diff - "${tf}2" >"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD1 &"
+    cat "${te}1"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$(grep -c "using prepared connection" "${te}1")" -ne 3 ]; then
+    $PRINTF "$FAILED (no prepared connections used)\n"
+    echo "$CMD1 &"
+    cat "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=BATCH_UDP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%udp%*|*%udp4%*|*%ip4%*|*%recv%*|*%$NAME%*)
+TEST="$NAME: option batch relays datagrams with recvmmsg()/sendmmsg()"
+# Start a receiver that writes the datagrams to a file, and a relay with option
+# batch from a UDP4-RECV address to UDP4-SENDTO. Send some datagrams to the
+# relay; the test succeeds when all of them arrive unchanged and the relay used
+# sendmmsg()
+if ! eval $NUMCOND; then :;
+elif ! testfeats udp ip4 >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}UDP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions batch); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+ts=$PORT; PORT=$((PORT+1))
+CMD0="$TRACE $SOCAT $opts -u UDP4-RECV:$ts,bind=$LOCALHOST OPEN:$tf,creat,trunc"
+CMD1="$TRACE $SOCAT $opts -d -d -d -u UDP4-RECV:$PORT,bind=$LOCALHOST,batch=16 UDP4-SENDTO:$LOCALHOST:$ts"
+CMD2="$TRACE $SOCAT $opts -u - UDP4-SENDTO:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waitudp4port $ts 1
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waitudp4port $PORT 1
+rc2=0
+for i in 1 2 3 4 5; do
+    echo "$da $i" |$CMD2 2>>"${te}2" || rc2=1
+done
+sleep 1
+kill $pid1 $pid0 2>/dev/null; wait
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! for i in 1 2 3 4 5; do echo "$da $i"; done |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    cat "${te}1"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "using sendmmsg()" "${te}1"; then
+    $PRINTF "$FAILED (sendmmsg() not used)\n"
+    echo "$CMD1 &"
+    cat "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=STATISTICS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%stdio%*|*%$NAME%*)
+TEST="$NAME: option -S prints transfer statistics at exit"
+# Pass some data through socat -S -u and check that the JSON line on stderr
+# has the right byte counts
+if ! eval $NUMCOND; then :;
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD="$TRACE $SOCAT $opts -S -u - -"
+printf "test $F_n $TEST... " $N
+echo "$da" |$CMD >"$tf" 2>"$te"
+rc=$?
+len=$(($(echo "$da" |wc -c)))
+if [ "$rc" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD"
+    cat "$te"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "\"left_to_right\":{\"bytes_read\":$len,\"bytes_written\":$len," "$te"; then
+    $PRINTF "$FAILED (no statistics)\n"
+    echo "$CMD"
+    cat "$te"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+NAME=STATISTICS_SOCKET
+case "$TESTS" in
+*%$N%*|*%functions%*|*%unix%*|*%$NAME%*)
+TEST="$NAME: option -S<path> serves statistics on a UNIX socket"
+# Start socat -S<path> relaying between a pipe and a UNIX listener, send some
+# data, and query the statistics socket while the connection is still open
+if ! eval $NUMCOND; then :;
+elif ! testfeats unix >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}UNIX not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ts="$td/test$N.socket"
+tst="$td/test$N.stats"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -S$tst UNIX-LISTEN:$ts PIPE"
+CMD1="$TRACE $SOCAT $opts - UNIX-CONNECT:$ts"
+CMD2="$TRACE $SOCAT $opts -u UNIX-CONNECT:$tst -"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waitfile $ts
+(echo "$da"; sleep 2) |$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waitfile $tst
+sleep 0.5
+$CMD2 >"$tf" 2>"${te}2"
+rc2=$?
+kill $pid1 $pid0 2>/dev/null; wait
+len=$(($(echo "$da" |wc -c)))
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "\"left_to_right\":{\"bytes_read\":$len," "$tf"; then
+    $PRINTF "$FAILED (wrong statistics)\n"
+    echo "$CMD0 &"
+    echo "$CMD2"
+    cat "$tf"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=VERBOSE_HEXDUMP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%stdio%*|*%$NAME%*)
+TEST="$NAME: format of the combined -v -x dump"
+# Pass a few bytes with a newline and a control character through socat -v -x
+# and compare the dump without the time stamp with the expected text
+if ! eval $NUMCOND; then :;
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+CMD="$TRACE $SOCAT $opts -v -x -u - -"
+printf "test $F_n $TEST... " $N
+printf "ab\tc\n\001" |$CMD >"$tf" 2>"$te"
+rc=$?
+sed 's/^> .*  length=/> length=/' "$te" >"$te.dump"
+if [ "$rc" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD"
+    cat "$te"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! printf "> length=6 from=0 to=5\n %s%33s  ab.c.\n %s%45s  .\n--\n" "61 62 09 63 0a" "" "01" "" |diff - "$te.dump" >"$tdiff"; then
+    $PRINTF "$FAILED (dump differs)\n"
+    echo "$CMD"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=CRNL_CONVERSION
+case "$TESTS" in
+*%$N%*|*%functions%*|*%stdio%*|*%$NAME%*)
+TEST="$NAME: options crnl and cr convert line terminators of large blocks"
+# Pass many short lines through socat with crnl on the output side, then back
+# through socat with crnl on the input side and cr on the output side. Compare
+# the results with conversions by tr and sed
+if ! eval $NUMCOND; then :;
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+tt="$td/test$N.txt"
+seq 1 20000 >"$tt"
+CMD0="$TRACE $SOCAT $opts -u - -,crnl"
+CMD1="$TRACE $SOCAT $opts -u -,crnl -,cr"
+printf "test $F_n $TEST... " $N
+$CMD0 <"$tt" >"${tf}0" 2>"${te}0"
+rc0=$?
+$CMD1 <"${tf}0" >"${tf}1" 2>"${te}1"
+rc1=$?
+if [ "$rc0" -ne 0 -o "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! sed 's/$/\r/' "$tt" |cmp -s - "${tf}0"; then
+    $PRINTF "$FAILED (crnl output differs)\n"
+    echo "$CMD0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! tr '\n' '\r' <"$tt" |cmp -s - "${tf}1"; then
+    $PRINTF "$FAILED (cr output differs)\n"
+    echo "$CMD1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=ESCAPE_BULK
+case "$TESTS" in
+*%$N%*|*%functions%*|*%escape%*|*%$NAME%*)
+TEST="$NAME: escape char at the end of a large block of data"
+# Pass a large file with the escape char followed by more data through socat
+# with option escape. The output must be the data before the escape char.
+# Then pass a bit more than a pipe holds, the escape char, and after a second
+# more data to a reader that waits two seconds: the escape char is found while
+# output is buffered, and socat must not read and forward the later data
+if ! eval $NUMCOND; then :;
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ti="$td/test$N.input"
+tx="$td/test$N.expect"
+seq 1 20000 >"$tx"
+{ cat "$tx"; printf "\035after escape\n"; } >"$ti"
+CMD0="$TRACE $SOCAT $opts -u OPEN:$ti,escape=0x1d -"
+CMD1="$TRACE $SOCAT $opts -u -b 8192 STDIN,escape=0x1d STDOUT"
+printf "test $F_n $TEST... " $N
+$CMD0 >"$tf" 2>"${te}0"
+rc0=$?
+seq 1 20000 |head -c 70000 >"${tx}1"
+{ cat "${tx}1"; printf "\035"; sleep 1; echo "after escape"; } |
+    $CMD1 2>"${te}1" |{ sleep 2; cat; } >"${tf}1"
+if [ "$rc0" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! cmp -s "$tx" "$tf"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! cmp -s "${tx}1" "${tf}1"; then
+    $PRINTF "$FAILED (data after escape char with buffered output)\n"
+    echo "... |$CMD1 |..."
+    cat "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0"; echo "... |$CMD1 |..."; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=IOURING_TRANSFER
+case "$TESTS" in
+*%$N%*|*%functions%*|*%engine%*|*%$NAME%*)
+TEST="$NAME: transfer loop on io_uring (option -I)"
+# Pass a file of random data through "cat" with option -I: stdin is read and
+# stdout is written with io_uring read/writev, the socketpair to the child
+# with multishot recv. When the log shows the io_uring loop and the output
+# equals the input the test succeeded
+if ! eval $NUMCOND; then :;
+elif ! feat=$(testfeats iouring); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+te="$td/test$N.stderr"
+ti="$td/test$N.input"
+to="$td/test$N.output"
+dd if=/dev/urandom of="$ti" bs=1024 count=2048 2>/dev/null
+CMD0="$TRACE $SOCAT $opts -d -d -I - EXEC:cat"
+printf "test $F_n $TEST... " $N
+$CMD0 <"$ti" >"$to" 2>"${te}0"
+rc0=$?
+if [ "$rc0" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif grep -q "using poll()" "${te}0"; then
+    $PRINTF "${YELLOW}io_uring not available${NORMAL}\n"
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! grep -q "starting io_uring transfer loop" "${te}0"; then
+    $PRINTF "$FAILED (io_uring not used)\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! cmp -s "$ti" "$to"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test if an OpenSSL client resumes the session stored by option
+# openssl-session-cache, with a forking server that keeps its ticket keys in
+# the file of the same option
+NAME=OPENSSL_SESSION_CACHE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%socket%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: OpenSSL client resumes session from openssl-session-cache"
+if ! eval $NUMCOND; then :;
+elif ! testfeats openssl >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}OPENSSL not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! testfeats tcp ip4 >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP/IPv4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+gentestcert testcli
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts OPENSSL-LISTEN:$PORT,pf=ip4,reuseaddr,fork,cert=testsrv.pem,cafile=testcli.crt,session-cache=$td/test$N.keys PIPE"
+CMD1="$TRACE $SOCAT $opts -d -d - OPENSSL-CONNECT:$LOCALHOST:$PORT,pf=ip4,cert=testcli.pem,cafile=testsrv.crt,session-cache=$td/test$N.session"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+rc1=$?
+echo "$da" |$CMD1 >"${tf}2" 2>"${te}2"
+rc2=$?
+kill $pid0 2>/dev/null; wait
+if [ $rc1 -ne 0 -o $rc2 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    cat "${te}0" >&2
+    echo "$CMD1" >&2
+    cat "${te}1" "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da" |diff - "${tf}2" >$tdiff; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD1" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "SSL session negotiated" "${te}1" ||
+     ! grep -q "SSL session resumed" "${te}2"; then
+    $PRINTF "$FAILED (session not resumed)\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD1" >&2
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &" >&2; echo "$CMD1" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+# Test if a forking OpenSSL server builds its context again on SIGHUP: the
+# second client only trusts the certificate that replaced the first one
+NAME=OPENSSL_LISTEN_RELOAD
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%socket%*|*%fork%*|*%signal%*|*%$NAME%*)
+TEST="$NAME: OpenSSL server reloads certificate on SIGHUP"
+if ! eval $NUMCOND; then :;
+elif ! testfeats openssl >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}OPENSSL not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! testfeats tcp ip4 >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP/IPv4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+gentestcert testcli
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+cp testsrv.pem $td/test$N.pem
+CMD0="$TRACE $SOCAT $opts OPENSSL-LISTEN:$PORT,pf=ip4,reuseaddr,fork,cert=$td/test$N.pem,verify=0 PIPE"
+CMD1="$TRACE $SOCAT $opts - OPENSSL-CONNECT:$LOCALHOST:$PORT,pf=ip4,cafile=testsrv.crt"
+CMD2="$TRACE $SOCAT $opts - OPENSSL-CONNECT:$LOCALHOST:$PORT,pf=ip4,cafile=testcli.crt"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+rc1=$?
+cp testcli.pem $td/test$N.pem
+kill -HUP $pid0 2>/dev/null
+sleep 1
+echo "$da" |$CMD2 >"${tf}2" 2>"${te}2"
+rc2=$?
+kill -0 $pid0 2>/dev/null; rc0=$?
+kill $pid0 2>/dev/null; wait
+if [ $rc1 -ne 0 -o $rc2 -ne 0 -o $rc0 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    cat "${te}0" >&2
+    echo "$CMD1" >&2
+    cat "${te}1" >&2
+    echo "$CMD2" >&2
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da" |diff - "${tf}2" >$tdiff; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD2" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &" >&2; echo "$CMD1" >&2; echo "$CMD2" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+# Test option openssl-ktls: data passes a connection where both peers let
+# the kernel handle the TLS records when it supports it, otherwise OpenSSL
+# keeps them in user space
+NAME=OPENSSL_KTLS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%socket%*|*%$NAME%*)
+TEST="$NAME: OpenSSL transfer with option openssl-ktls"
+if ! eval $NUMCOND; then :;
+elif ! testfeats openssl >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}OPENSSL not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! testfeats tcp ip4 >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP/IPv4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+ti="$td/test$N.data"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+CMD0="$TRACE $SOCAT $opts OPENSSL-LISTEN:$PORT,pf=ip4,reuseaddr,cert=testsrv.pem,verify=0,ktls PIPE"
+CMD1="$TRACE $SOCAT $opts -t 1 - OPENSSL-CONNECT:$LOCALHOST:$PORT,pf=ip4,cafile=testsrv.crt,ktls"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+$CMD1 <"$ti" >"$tf" 2>"${te}1"
+rc1=$?
+kill $pid0 2>/dev/null; wait
+if [ $rc1 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    cat "${te}0" >&2
+    echo "$CMD1" >&2
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! cmp "$ti" "$tf" >$tdiff 2>&1; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD1" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &" >&2; echo "$CMD1" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+# Test if the children of a forking listener take the address of the connect
+# address from the cache of option resolve-ttl: a stub DNS server, made of
+# socat and a shell script, logs each query
+NAME=RESOLVE_CACHE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%udp%*|*%socket%*|*%fork%*|*%root%*|*%$NAME%*)
+TEST="$NAME: children use address cached by resolve-ttl"
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp udp ip4 system >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP/UDP/IPv4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif [ $(id -u) -ne 0 ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}must be root${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! unshare -m true 2>/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}unshare -m not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+tdns="$td/test$N.dns.sh"
+tconf="$td/test$N.resolv.conf"
+tq="$td/test$N.queries"
+da="test$N $(date) $RANDOM"
+dnsaddr=127.0.53.1
+# answers the query on stdin: type A with 127.0.0.1, other types without data
+cat >"$tdns" <<'EOT'
+#! /bin/sh
+log="$1"
+set -- $(od -An -tu1 -v)
+id1=$1; id2=$2; shift 12
+eval "qt=\${$(($#-2))}"
+echo "query type $qt" >>"$log"
+if [ "$qt" = 1 ]; then an=1; else an=0; fi
+ans="$id1 $id2 129 128 0 1 0 $an 0 0 0 0 $*"
+if [ $an = 1 ]; then ans="$ans 192 12 0 1 0 1 0 0 0 60 0 4 127 0 0 1"; fi
+fmt=; for b in $ans; do fmt="$fmt\\$(printf %03o $b)"; done
+printf "$fmt"	# in one write, so in one datagram
+EOT
+chmod +x "$tdns"
+printf "nameserver $dnsaddr\noptions timeout:1 attempts:1\n" >"$tconf"
+touch "$tq"
+CMD0="$TRACE $SOCAT $opts UDP4-RECVFROM:53,bind=$dnsaddr,reuseaddr,fork SYSTEM:\"$tdns $tq\""
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,fork PIPE"
+CMD2="$TRACE $SOCAT $opts TCP4-LISTEN:$((PORT+1)),reuseaddr,fork TCP4:test$N.socat.example:$PORT,resolve-ttl=60"
+CMD3="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$((PORT+1))"
+# the refresh helper must not take the only slot of max-children
+CMD4="$TRACE $SOCAT $opts TCP4-LISTEN:$((PORT+2)),reuseaddr,fork,max-children=1 TCP4:test$N.socat.example:$PORT,resolve-ttl=1"
+CMD5="$TRACE $SOCAT $opts -T 4 - TCP4:$LOCALHOST:$((PORT+2))"
+printf "test $F_n $TEST... " $N
+eval "$CMD0" >/dev/null 2>"${te}0" &
+pid0=$!
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+unshare -m sh -c "mount --bind $tconf /etc/resolv.conf && exec $CMD2" >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $((PORT+1)) 1
+rc3=0
+for i in 1 2 3; do
+    echo "$da $i" |$CMD3 >>"$tf" 2>>"${te}3" || rc3=$?
+done
+kill $pid2 2>/dev/null
+nq=$(wc -l <"$tq")
+unshare -m sh -c "mount --bind $tconf /etc/resolv.conf && exec $CMD4" >/dev/null 2>"${te}4" &
+pid4=$!
+waittcp4port $((PORT+2)) 1
+rc5=0
+for i in 4 5 6; do
+    usleep 1500000	# more than resolve-ttl
+    (echo "$da $i"; sleep 1) |$CMD5 >>"$tf" 2>>"${te}5" || rc5=$?
+done
+kill $pid0 $pid1 $pid4 2>/dev/null; wait
+if [ $rc3 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD1 &" >&2
+    echo "$CMD2 &" >&2
+    cat "${te}2" >&2
+    echo "$CMD3" >&2
+    cat "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ $rc5 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD4 &" >&2
+    cat "${te}4" >&2
+    echo "$CMD5" >&2
+    cat "${te}5" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! printf "$da 1\n$da 2\n$da 3\n$da 4\n$da 5\n$da 6\n" |diff - "$tf" >$tdiff; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD2 &" >&2
+    echo "$CMD3" >&2
+    echo "$CMD4 &" >&2
+    echo "$CMD5" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$nq" -ne 1 ]; then
+    $PRINTF "$FAILED ($nq queries)\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD2 &" >&2
+    cat "$tq" "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &" >&2; echo "$CMD2 &" >&2; echo "$CMD3" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+3))
+N=$((N+1))
+
+# Test if option happy-eyeballs tries the other addresses of a host name when
+# the connection to the first one fails. /etc/hosts, in a private mount
+# namespace, gives the name two addresses, the server listens only on one
+NAME=HAPPY_EYEBALLS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%socket%*|*%root%*|*%$NAME%*)
+TEST="$NAME: happy-eyeballs connects to the second address of a name"
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP/IPv4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif [ $(id -u) -ne 0 ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}must be root${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! unshare -m true 2>/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}unshare -m not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+thosts="$td/test$N.hosts"
+da="test$N $(date) $RANDOM"
+printf "127.0.0.1 test$N.socat.example\n127.0.0.2 test$N.socat.example\n" >"$thosts"
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,bind=127.0.0.2 PIPE"
+CMD1="$TRACE $SOCAT $opts - TCP4:test$N.socat.example:$PORT,happy-eyeballs"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+echo "$da" |unshare -m sh -c "mount --bind $thosts /etc/hosts && exec $CMD1" >"$tf" 2>"${te}1"
+rc1=$?
+kill $pid0 2>/dev/null; wait
+if [ $rc1 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    cat "${te}0" >&2
+    echo "$CMD1" >&2
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da" |diff - "$tf" >$tdiff; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &" >&2
+    echo "$CMD1" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &" >&2; echo "$CMD1" >&2; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=LISTEN_PREFORK
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: option prefork with idle children accepting connections"
+# Start a forking TCP listener with two pre-forked children and echo, and let
+# four clients connect. The test succeeds when all clients get their echo,
+# only children accepted connections, and the port is free again after the
+# pool process has been killed
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions prefork); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,fork,prefork=2,prefork-max=3 PIPE"
+CMD1="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT"
+CMD2="$TRACE $SOCAT $opts -u TCP4-LISTEN:$PORT,$REUSEADDR,accept-timeout=0.1 /dev/null"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+rc1=0
+for i in 1 2 3 4; do
+    echo "$da $i" |$CMD1 >>"${tf}1" 2>>"${te}1" || rc1=1
+done
+kill $pid0 2>/dev/null; wait
+sleep 1
+$CMD2 >/dev/null 2>"${te}2"
+if [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! for i in 1 2 3 4; do echo "$da $i"; done |diff - "${tf}1" >"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$(grep "accepting connection" "${te}0" |wc -l)" -ne 4 ] ||
+	 grep "accepting connection" "${te}0" |grep -q "socat\[$pid0\]"; then
+    $PRINTF "$FAILED (not accepted by children)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif grep -q "Address already in use" "${te}2"; then
+    $PRINTF "$FAILED (idle children still active)\n"
+    echo "$CMD0 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=UDP_EVENT_LOOP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%udp%*|*%udp4%*|*%ip4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: UDP sessions by peer in one process with event-loop"
+# Start a UDP listener with event-loop and echo. Two clients with different
+# source ports send a datagram each, the first keeps its session open while
+# the second one sends. The test succeeds when each client gets its own echo
+# and the server did not fork
+if ! eval $NUMCOND; then :;
+elif ! testfeats udp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}UDP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions event-loop); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d -T 5 UDP4-LISTEN:$PORT,event-loop PIPE"
+CMD1="$TRACE $SOCAT $opts -t 1 - UDP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waitudp4port $PORT 1
+(echo "$da 1"; sleep 2) |$CMD1 >"${tf}1" 2>"${te}1" &
+pid1=$!
+sleep 1
+echo "$da 2" |$CMD1 >"${tf}2" 2>"${te}2"
+rc2=$?
+wait $pid1
+rc1=$?
+kill $pid0 2>/dev/null; wait
+if [ "$rc2" -ne 0 ] || [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "(echo \"$da 1\"; sleep 2) |$CMD1"
+    echo "echo \"$da 2\" |$CMD1"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da 1" |diff - "${tf}1" >"$tdiff" ||
+     ! echo "$da 2" |diff - "${tf}2" >>"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif grep -q "forked off child" "${te}0" ||
+     [ "$(grep -c "accepting UDP connection" "${te}0")" -ne 2 ]; then
+    $PRINTF "$FAILED (sessions)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=EXEC_SPAWN
+case "$TESTS" in
+*%$N%*|*%functions%*|*%exec%*|*%system%*|*%$NAME%*)
+TEST="$NAME: EXEC and SYSTEM started with posix_spawnp()"
+# Run EXEC with options pipes and setsid, and SYSTEM with option stderr; both
+# must be started with posix_spawnp() and pass the data. EXEC with option
+# path must still fork
+if ! eval $NUMCOND; then :;
+elif ! testfeats exec system >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}EXEC or SYSTEM not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif [ "$UNAME" != Linux ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}only on Linux${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d - EXEC:$CAT,pipes,setsid"
+CMD1="$TRACE $SOCAT $opts -d -d - SYSTEM:\"$CAT; echo stderr >&2\",stderr"
+CMD2="$TRACE $SOCAT $opts -d -d - EXEC:$CAT,path=/bin:/usr/bin"
+printf "test $F_n $TEST... " $N
+echo "$da" |$CMD0 >"${tf}0" 2>"${te}0"
+rc0=$?
+echo "$da" |eval "$CMD1" >"${tf}1" 2>"${te}1"
+rc1=$?
+echo "$da" |$CMD2 >"${tf}2" 2>"${te}2"
+rc2=$?
+if [ "$rc0" -ne 0 ] || [ "$rc1" -ne 0 ] || [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0"
+    echo "$CMD1"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! echo "$da" |diff - "${tf}0" >"$tdiff" ||
+     ! printf "%s\nstderr\n" "$da" |diff - "${tf}1" >>"$tdiff" ||
+     ! echo "$da" |diff - "${tf}2" >>"$tdiff"; then
+    $PRINTF "$FAILED (data differs)\n"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! grep -q "spawned child process" "${te}0" ||
+     ! grep -q "spawned child process" "${te}1" ||
+     grep -q "spawned child process" "${te}2"; then
+    $PRINTF "$FAILED (not spawned)\n"
+    echo "$CMD0"
+    cat "${te}0"
+    echo "$CMD1"
+    cat "${te}1"
+    echo "$CMD2"
+    cat "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0"; echo "$CMD1"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=SIGCHLD_REAP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%ip4%*|*%tcp%*|*%tcp4%*|*%listen%*|*%fork%*|*%zombie%*|*%signal%*|*%$NAME%*)
+TEST="$NAME: children reaped outside of the SIGCHLD handler"
+# Start a TCP listener with fork and max-children=2 whose children run SYSTEM.
+# Connect 20 clients one after the other; each must get its answer, so the
+# listener waited for its children, and none of them may stay a zombie
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen system >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 or SYSTEM not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,fork,max-children=2 SYSTEM:\"echo '$da'\""
+CMD1="$TRACE $SOCAT $opts -T 2 - TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+eval "$CMD0" >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+rc1=0
+: >"$tf"
+for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+    $CMD1 </dev/null >>"$tf" 2>>"${te}1" || rc1=1
+done
+sleep 1
+l="$(childprocess $pid0)"
+kill $pid0 2>/dev/null; wait
+if [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$(grep -c "^$da\$" "$tf")" -ne 20 ]; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    cat "${te}0"
+    cat "$tf"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif $(isdefunct "$l"); then
+    $PRINTF "$FAILED (zombie)\n"
+    echo "$CMD0 &"
+    echo "$l"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=ALLOW_FILE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%ip4%*|*%tcp%*|*%tcp4%*|*%listen%*|*%fork%*|*%range%*|*%signal%*|*%$NAME%*)
+TEST="$NAME: options allow-file and deny-file, reload on SIGHUP"
+# Start a TCP listener with fork, allow-file with 127.0.0.0/8, and deny-file
+# with the more specific 127.0.0.1/32. A client from 127.0.0.1 must be refused.
+# Then replace the deny-file entry and send SIGHUP: the next client must get
+# its data echoed
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ta="$td/test$N.allow"
+tn="$td/test$N.deny"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+echo "127.0.0.0/8	# loopback" >"$ta"
+echo "10.0.0.0/8, 127.0.0.1/32" >"$tn"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,fork,allow-file=$ta,deny-file=$tn PIPE"
+CMD1="$TRACE $SOCAT $opts -T 2 - TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+echo "10.0.0.0/8" >"$tn"
+kill -HUP $pid0 2>/dev/null
+psleep 0.5
+echo "$da" |$CMD1 >"${tf}2" 2>"${te}2"
+rc2=$?
+kill $pid0 2>/dev/null; wait
+if [ -s "${tf}1" ] || ! grep -q "refusing connection .* allow-file" "${te}0"; then
+    $PRINTF "$FAILED (not refused)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${tf}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$rc2" -ne 0 ] || ! echo "$da" |diff - "${tf}2" >"$tdiff"; then
+    $PRINTF "$FAILED (not reloaded)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}2"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+NAME=SPLICE_STALLED
+case "$TESTS" in
+*%$N%*|*%functions%*|*%splice%*|*%ip4%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: splice() output that does not take data does not stall the other direction"
+# The server of socat's nonblocking right address sends a line after a second
+# but never reads; small socket buffers make splice() write only a part. The client writes much more data than the socket buffers
+# take, so the splice() direction to the server gets stuck; the line from the
+# server must nevertheless reach the client
+if ! eval $NUMCOND; then :;
+elif [ "$UNAME" != Linux ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}only on Linux${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! testfeats tcp ip4 listen system >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 or SYSTEM not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+PORT0=$PORT; PORT=$((PORT+1))
+PORT1=$PORT; PORT=$((PORT+1))
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT0,$REUSEADDR,rcvbuf=4096 SYSTEM:\"sleep 1; echo '$da'; sleep 5\""
+CMD1="$TRACE $SOCAT $opts -d -d -b 65536 TCP4-LISTEN:$PORT1,$REUSEADDR TCP4:$LOCALHOST:$PORT0,nonblock,sndbuf=4096"
+CMD2="$TRACE $SOCAT $opts -T 4 - TCP4:$LOCALHOST:$PORT1"
+printf "test $F_n $TEST... " $N
+eval "$CMD0" >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT0 1
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT1 1
+dd if=/dev/zero bs=1048576 count=32 2>/dev/null |$CMD2 2>"${te}2" |head -n 1 >"$tf"
+kill $pid0 $pid1 2>/dev/null; wait
+if ! echo "$da" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+N=$((N+1))
+
+
+# Test if option event-loop releases all FDs of a closed connection, and
+# refuses a second address whose FDs all connections would share
+NAME=EVENT_LOOP_CLOSE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: event-loop closes all FDs of a connection"
+# Start a TCP listener with event-loop and echo through PIPE and let five
+# clients connect one after the other. The listener must have as many FDs open
+# as after the first connection. A listener with event-loop and STDIO must
+# fail with an error message
+if ! eval $NUMCOND; then :;
+elif [ ! -d /proc/$$/fd ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}/proc/<pid>/fd not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions event-loop); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,event-loop PIPE"
+CMD1="$TRACE $SOCAT $opts -t 0.5 - TCP4:$LOCALHOST:$PORT"
+CMD2="$TRACE $SOCAT $opts TCP4-LISTEN:$((PORT+1)),$REUSEADDR,accept-timeout=1,event-loop STDIO"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD1 >"$tf" 2>"${te}1"
+sleep 1
+nfd1=$(ls /proc/$pid0/fd |wc -l)
+for i in 2 3 4 5; do
+    echo "$da" |$CMD1 >>"$tf" 2>>"${te}1"
+done
+sleep 1
+nfd5=$(ls /proc/$pid0/fd |wc -l)
+kill $pid0 2>/dev/null; wait
+$CMD2 </dev/null >/dev/null 2>"${te}2"
+rc2=$?
+if [ "$(grep -c "^$da\$" "$tf")" -ne 5 ]; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1" "$tf"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$nfd5" -ne "$nfd1" ]; then
+    $PRINTF "$FAILED ($nfd1 FDs after 1 connection, $nfd5 after 5)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$rc2" -eq 0 ] || ! grep -q " E option event-loop" "${te}2"; then
+    $PRINTF "$FAILED (STDIO accepted)\n"
+    echo "$CMD2"
+    cat "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+2))
+N=$((N+1))
+
+
+# Test if socat with option crnl and a write buffer that takes just one byte
+# still transfers the data instead of looping without reading
+NAME=WRITE_BUFFER_CRNL
+case "$TESTS" in
+*%$N%*|*%functions%*|*%stdio%*|*%$NAME%*)
+TEST="$NAME: crnl conversion with a one byte write buffer"
+# Copy a line with -b 1 to stdout with conversion to CRNL. When socat has
+# terminated after a second and the output has CRNL the test succeeded
+if ! eval $NUMCOND; then :;
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tk="$td/test$N.kill"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -b 1 -u - STDOUT,crnl"
+printf "test $F_n $TEST... " $N
+echo "$da" |$CMD0 >"$tf" 2>"${te}0" &
+pid0=$!
+sleep 1
+if kill $pid0 2>"$tk"; then
+    $PRINTF "$FAILED (socat hangs)\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! printf "%s\r\n" "$da" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0" >&2
+    cat "${te}0" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0"; fi
+    numOK=$((numOK+1))
+fi
+wait
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+# Test if option -t terminates socat after EOF even when the other direction
+# still has buffered data that its peer does not take
+NAME=WRITE_BUFFER_TIMEOUT
+case "$TESTS" in
+*%$N%*|*%functions%*|*%ip4%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: -t terminates a shutdown with unwritten data"
+# The server sends EOF at once but stops reading when its output pipe is full.
+# The client sends much more data than the socket buffers take; after the EOF
+# from the server it must terminate after -t 1 second although its write
+# buffer is not empty
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+te="$td/test$N.stderr"
+tk="$td/test$N.kill"
+CMD0="$TRACE $SOCAT $opts -t 10 TCP4-LISTEN:$PORT,$REUSEADDR,rcvbuf=4096 STDIO"
+CMD1="$TRACE $SOCAT $opts -t 1 -,escape=0x1d TCP4:$LOCALHOST:$PORT,sndbuf=4096"
+printf "test $F_n $TEST... " $N
+$CMD0 </dev/null 2>"${te}0" |sleep 6 &
+waittcp4port $PORT 1
+dd if=/dev/zero bs=1048576 count=16 2>/dev/null |$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+sleep 3
+if kill $pid1 2>"$tk"; then
+    $PRINTF "$FAILED (socat hangs)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+wait
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+# Test if socat applies vsock-buffer-max before vsock-buffer-size, whose
+# value the kernel limits to the current maximum, and if other socket
+# addresses refuse the VSOCK options
+NAME=VSOCK_BUFFER_SIZE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%vsock%*|*%socket%*|*%$NAME%*)
+TEST="$NAME: order and scope of the VSOCK buffer options"
+# Start a VSOCK listener with vsock-buffer-size before vsock-buffer-max; the
+# debug log must show the setsockopt() of SO_VM_SOCKETS_BUFFER_MAX_SIZE (2)
+# before that of SO_VM_SOCKETS_BUFFER_SIZE (0). Then TCP4-LISTEN with
+# vsock-buffer-size must fail with an option error
+if ! eval $NUMCOND; then :;
+elif ! fea=$(testfeats VSOCK); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$fea not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions vsock-buffer-size); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$(echo "$feat"| tr 'a-z' 'A-Z') not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+te="$td/test$N.stderr"
+CMD0="$TRACE $SOCAT $opts -d -d -d -d VSOCK-LISTEN:$PORT,vsock-buffer-size=524288,vsock-buffer-max=524288 PIPE"
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,$REUSEADDR,vsock-buffer-size=65536 PIPE"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+sleep 1
+kill $pid0 2>/dev/null; wait
+$CMD1 >/dev/null 2>"${te}1" </dev/null &
+pid1=$!
+sleep 1
+kill $pid1 2>/dev/null; wait $pid1
+rc1=$?
+order=$(grep -o "setsockopt([0-9]*, 40, [0-9]" "${te}0" |sed 's/.* //' |tr -d '\n')
+if ! grep -q "listening on AF=40" "${te}0"; then
+    $PRINTF "${YELLOW}VSOCK listen does not work${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif [ "$order" != 20 ]; then
+    $PRINTF "$FAILED (setsockopt order \"$order\")\n"
+    echo "$CMD0 &" >&2
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ $rc1 -eq 0 ] || ! grep -q " E .*vsock-buffer-size" "${te}1"; then
+    $PRINTF "$FAILED (TCP4 accepts vsock-buffer-size)\n"
+    echo "$CMD1" >&2
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+# Test if option -t terminates the io_uring transfer loop after EOF even when
+# the other direction still has queued data that its peer does not take
+NAME=IOURING_TIMEOUT
+case "$TESTS" in
+*%$N%*|*%functions%*|*%engine%*|*%ip4%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: -t terminates the io_uring loop with unwritten data"
+# Like WRITE_BUFFER_TIMEOUT, with option -I and pipes on the client's stdio
+# so both directions are possible with io_uring. When the client has
+# terminated 3 seconds later the test succeeded
+if ! eval $NUMCOND; then :;
+elif ! feat=$(testfeats iouring); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+te="$td/test$N.stderr"
+CMD0="$TRACE $SOCAT $opts -t 10 TCP4-LISTEN:$PORT,$REUSEADDR,rcvbuf=4096 STDIO"
+CMD1="$TRACE $SOCAT $opts -d -d -I -t 1 - TCP4:$LOCALHOST:$PORT,sndbuf=4096"
+printf "test $F_n $TEST... " $N
+$CMD0 </dev/null 2>"${te}0" |sleep 6 &
+waittcp4port $PORT 1
+dd if=/dev/zero bs=1048576 count=16 2>/dev/null |$CMD1 2>"${te}1" |cat >/dev/null &
+sleep 3
+if grep -q "using poll()" "${te}1"; then
+    $PRINTF "${YELLOW}io_uring not available${NORMAL}\n"
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! grep -q "exiting with status" "${te}1"; then
+    $PRINTF "$FAILED (socat hangs)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+wait
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+# Test if option event-loop can run the program of an EXEC address for
+# several connections one after the other
+NAME=EVENT_LOOP_EXEC
+case "$TESTS" in
+*%$N%*|*%functions%*|*%exec%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: event-loop with EXEC for consecutive connections"
+# Start a TCP listener with event-loop whose EXEC address prints a text, and
+# let four clients connect one after the other. Each client must receive the
+# text; the program name and arguments are shared by all connections
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen exec >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 or EXEC not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions event-loop); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N-$RANDOM-$RANDOM"
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,$REUSEADDR,event-loop EXEC:\"echo $da\""
+CMD1="$TRACE $SOCAT $opts -u TCP4:$LOCALHOST:$PORT -"
+printf "test $F_n $TEST... " $N
+eval "$CMD0" >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+for i in 1 2 3 4; do
+    $CMD1 2>>"${te}1"
+done >"$tf"
+kill $pid0 2>/dev/null; wait
+if ! for i in 1 2 3 4; do echo "$da"; done |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+NAME=ALLOW_FILE_PREFORK
+case "$TESTS" in
+*%$N%*|*%functions%*|*%ip4%*|*%tcp%*|*%tcp4%*|*%listen%*|*%fork%*|*%prefork%*|*%signal%*|*%$NAME%*)
+TEST="$NAME: allow-file reload on SIGHUP with prefork"
+# Start a TCP listener with prefork and a deny-file with 127.0.0.1/32, so a
+# client from 127.0.0.1 is refused by an idle child. Then replace the
+# deny-file entry and send SIGHUP to the pool process: it must pass the
+# signal to the idle children, and the next client must get its data echoed
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions prefork deny-file); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$(echo "$feat"| tr 'a-z' 'A-Z') not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tn="$td/test$N.deny"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+echo "10.0.0.0/8, 127.0.0.1/32" >"$tn"
+CMD0="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT,$REUSEADDR,fork,prefork=2,deny-file=$tn PIPE"
+CMD1="$TRACE $SOCAT $opts -T 2 - TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+echo "10.0.0.0/8" >"$tn"
+kill -HUP $pid0 2>/dev/null
+psleep 0.5
+echo "$da" |$CMD1 >"${tf}2" 2>"${te}2"
+rc2=$?
+kill $pid0 2>/dev/null; wait
+if [ -s "${tf}1" ] || ! grep -q "refusing connection .* deny-file" "${te}0"; then
+    $PRINTF "$FAILED (not refused)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${tf}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$rc2" -ne 0 ] || ! echo "$da" |diff - "${tf}2" >"$tdiff"; then
+    $PRINTF "$FAILED (not reloaded)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}2"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+# Test if option event-loop can forward several connections to a TCP address
+NAME=EVENT_LOOP_TCP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: event-loop with TCP connect for consecutive connections"
+# Start an echo server with fork, and a TCP listener with event-loop that
+# connects to it for each client. Let three clients connect one after the
+# other; each must get its data echoed, so the event-loop process must survive
+# the end of the first connections
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions event-loop); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N-$RANDOM-$RANDOM"
+PORT0=$PORT
+PORT=$((PORT+1))
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT0,$REUSEADDR,fork PIPE"
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,$REUSEADDR,event-loop TCP4:$LOCALHOST:$PORT0"
+CMD2="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT0 1
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+for i in 1 2 3; do
+    echo "$da $i" |$CMD2 2>>"${te}2"
+done >"$tf"
+kill -0 $pid1 2>/dev/null; rc1=$?
+kill $pid0 $pid1 2>/dev/null; wait
+if [ $rc1 -ne 0 ]; then
+    $PRINTF "$FAILED (event-loop process has gone)\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! for i in 1 2 3; do echo "$da $i"; done |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND, feats
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+# Test if option event-loop keeps serving the established connections while
+# the TCP connect of a new one is pending
+NAME=EVENT_LOOP_CONNECT
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: event-loop does not wait for a pending connect"
+# Start an echo server with max-children=1 and backlog=1 and a TCP listener
+# with event-loop that connects to it. The first client takes the only child
+# of the echo server, further connections fill its accept queue, so it drops
+# the SYN of the connect for the second client. Meanwhile the first client
+# must get its data echoed
+if ! eval $NUMCOND; then :;
+elif ! testfeats tcp ip4 listen >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}TCP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! feat=$(testoptions event-loop); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N-$RANDOM-$RANDOM"
+PORT0=$PORT
+PORT=$((PORT+1))
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT0,$REUSEADDR,fork,max-children=1,backlog=1 PIPE"
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,$REUSEADDR,event-loop TCP4:$LOCALHOST:$PORT0"
+CMD2="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT"
+CMD3="$TRACE $SOCAT $opts -u - TCP4:$LOCALHOST:$PORT0"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT0 1
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+(echo "$da 1"; sleep 3; echo "$da 2"; sleep 1) |$CMD2 >"$tf" 2>"${te}2" &
+pid2=$!
+usleep 500000
+pids3=
+for i in 1 2 3; do
+    sleep 6 |$CMD3 2>/dev/null &
+    pids3="$pids3 $!"
+done
+usleep 500000
+sleep 6 |$CMD2 >/dev/null 2>"${te}4" &
+pid4=$!
+wait $pid2
+kill $pid0 $pid1 $pids3 $pid4 2>/dev/null; wait
+if ! printf "$da 1\n$da 2\n" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}0" "${te}1" "${te}2"
+    cat "$tdiff"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+# Test if option -S prints the statistics on SIGUSR1 in a child process of
+# UDP4-RECVFROM with fork, where the parent uses SIGUSR1 to learn that the
+# child has read the packet
+NAME=STATISTICS_RECVFROM
+case "$TESTS" in
+*%$N%*|*%functions%*|*%udp%*|*%udp4%*|*%ip4%*|*%recvfrom%*|*%fork%*|*%signal%*|*%$NAME%*)
+TEST="$NAME: option -S with SIGUSR1 in a UDP4-RECVFROM child"
+# The SYSTEM command sends SIGUSR1 to its socat child process, which then must
+# print its statistics once on the signal and once at exit
+if ! eval $NUMCOND; then :;
+elif ! testfeats udp ip4 system >/dev/null || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}UDP4 not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -S UDP4-RECVFROM:$PORT,reuseaddr,fork SYSTEM:'kill -USR1 \$PPID; cat'"
+CMD1="$TRACE $SOCAT $opts -t 1 - UDP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+eval "$CMD0" >/dev/null 2>"${te}0" &
+pid0=$!
+waitudp4port $PORT 1
+echo "$da" |$CMD1 >"$tf" 2>"${te}1"
+rc1=$?
+sleep 1
+kill $pid0 2>/dev/null; wait
+# the lines of the child process, not of the parent
+nstats=$(grep '"left_to_right"' "${te}0" |grep -v "\"pid\":$pid0," |wc -l)
+if [ $rc1 -ne 0 ]; then
+    $PRINTF "$FAILED\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0" "${te}1"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif [ "$nstats" -ne 2 ]; then
+    $PRINTF "$FAILED ($nstats statistics lines)\n"
+    echo "$CMD0 &"
+    echo "$CMD1"
+    cat "${te}0"
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    numOK=$((numOK+1))
+fi
+fi # NUMCOND
+ ;;
+esac
+PORT=$((PORT+1))
+N=$((N+1))
+
+
+
+
+
+
+
+
 # end of common tests
 
 ##################################################################################
@@ -0,0 +1,645 @@
+/* source: transfer-bench.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* benchmark of the socat transfer loop: runs ./socat (or $SOCAT) with -S
+   between two endpoints of this program for several address pairs and
+   transfer block sizes (-b), and prints one JSON object with, per run, the
+   throughput, the reads, writes, and polls that socat counted per MB, the CPU
+   time of socat per MB, and the 50th and 99th percentile of the time that a
+   single block takes through socat. The data and block sizes are fixed and
+   the endpoints use kernel assigned ports, so runs can be compared.
+   Pairs that are not available (e.g. vsock without vsock_loopback, or a socat
+   without OPENSSL) are reported with "skipped".
+   build and run it with "make bench";
+   usage: ./transfer-bench [MB [bufsize,...]] */
+
+#include "config.h"
+#include "xioconfig.h"	/* what features are enabled */
+
+#include "sysincludes.h"
+#include <sys/resource.h>	/* struct rusage */
+
+#if WITH_VSOCK && HAVE_LINUX_VM_SOCKETS_H
+#define BENCH_VSOCK 1
+#endif
+
+#define BENCH_TIMEOUT 10000	/* ms without progress until a run fails */
+#define BENCH_CHUNK 65536	/* bytes per write into socat */
+#define BENCH_ROUNDS 200	/* blocks sent one by one for the latency */
+#define BENCH_DGRAM 8192	/* maximal datagram size */
+#define BENCH_WINDOW 8		/* datagrams in flight, within the socket buffers */
+
+/* one instance of the endpoints and socat processes */
+struct bench_run {
+   int src;		/* this program writes to socat */
+   int sink;		/* this program reads from socat */
+   bool dgram;		/* src and sink are UDP sockets */
+   int npid;
+   pid_t pid[2];
+   FILE *err[2];	/* stderr of the socat processes */
+   struct rusage ru[2];
+   int status[2];
+} ;
+
+struct bench_result {
+   double mbps;
+   double syscalls;	/* per MB */
+   double cpums;	/* per MB */
+   double p50, p99;	/* usec per block */
+   unsigned long lost;	/* datagrams */
+} ;
+
+static const char *socat = "./socat";
+static char tmpdir[] = "/tmp/transfer-bench.XXXXXX";
+static bool havecert;
+
+static double now(void) {
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* starts socat with argv (without the program name); its stdin and stdout
+   are fdin and fdout when >= 0, its stderr goes to a temporary file that is
+   stored in run for the statistics */
+static int bench_socat(struct bench_run *run, const char *argv[],
+		       int fdin, int fdout) {
+   const char *args[16];
+   FILE *err;
+   pid_t pid;
+   int i;
+
+   args[0] = socat;
+   for (i = 0; argv[i] != NULL && i < 14; ++i)  args[i+1] = argv[i];
+   args[i+1] = NULL;
+   if ((err = tmpfile()) == NULL)  return -1;
+   if ((pid = fork()) < 0) {
+      fclose(err);
+      return -1;
+   }
+   if (pid == 0) {
+      if (fdin >= 0)  dup2(fdin, 0);
+      if (fdout >= 0)  dup2(fdout, 1);
+      dup2(fileno(err), 2);
+      /* socat must not keep the other ends, e.g. of the pipes */
+      for (i = 3; i < 1024; ++i)  close(i);
+      execv(socat, (char *const *)args);
+      _exit(127);
+   }
+   run->err[run->npid] = err;
+   run->pid[run->npid++] = pid;
+   return 0;
+}
+
+/* returns a socket of type bound to the loopback address of family with a
+   kernel assigned port (UNIX: a new name in tmpdir), listening for streams,
+   and stores the port or path in name */
+static int bench_listen(int family, int type, char *name, size_t namelen) {
+   union {
+      struct sockaddr sa;
+      struct sockaddr_in ip4;
+      struct sockaddr_un un;
+#if BENCH_VSOCK
+      struct sockaddr_vm vm;
+#endif
+   } sa;
+   socklen_t salen;
+   static int nunix;
+   int fd;
+
+   memset(&sa, 0, sizeof(sa));
+   switch (family) {
+   case AF_INET:
+      sa.ip4.sin_family = AF_INET;
+      sa.ip4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      salen = sizeof(sa.ip4);
+      break;
+   case AF_UNIX:
+      sa.un.sun_family = AF_UNIX;
+      snprintf(sa.un.sun_path, sizeof(sa.un.sun_path), "%s/s%d",
+	       tmpdir, nunix++);
+      salen = sizeof(sa.un);
+      break;
+#if BENCH_VSOCK
+   case AF_VSOCK:
+      sa.vm.svm_family = AF_VSOCK;
+      sa.vm.svm_cid = VMADDR_CID_ANY;
+      sa.vm.svm_port = VMADDR_PORT_ANY;
+      salen = sizeof(sa.vm);
+      break;
+#endif
+   default:
+      return -1;
+   }
+   if ((fd = socket(family, type, 0)) < 0)  return -1;
+   if (bind(fd, &sa.sa, salen) < 0 ||
+       (type == SOCK_STREAM && listen(fd, 4) < 0) ||
+       getsockname(fd, &sa.sa, &salen) < 0) {
+      close(fd);
+      return -1;
+   }
+   switch (family) {
+   case AF_INET:
+      snprintf(name, namelen, "%u", ntohs(sa.ip4.sin_port));  break;
+   case AF_UNIX:
+      snprintf(name, namelen, "%s", sa.un.sun_path);  break;
+#if BENCH_VSOCK
+   case AF_VSOCK:
+      snprintf(name, namelen, "%u", sa.vm.svm_port);  break;
+#endif
+   }
+   return fd;
+}
+
+/* returns a free UDP or TCP port on 127.0.0.1 for a socat listener */
+static int bench_freeport(int type, char *name, size_t namelen) {
+   int fd;
+
+   if ((fd = bench_listen(AF_INET, type, name, namelen)) < 0)  return -1;
+   close(fd);
+   return 0;
+}
+
+/* waits until socat has bound port of type on 127.0.0.1 */
+static int bench_waitbound(int type, const char *port) {
+   struct sockaddr_in sa;
+   int i, fd, rc;
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sin_family = AF_INET;
+   sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   sa.sin_port = htons(atoi(port));
+   for (i = 0; i < BENCH_TIMEOUT/10; ++i) {
+      if ((fd = socket(AF_INET, type, 0)) < 0)  return -1;
+      rc = bind(fd, (struct sockaddr *)&sa, sizeof(sa));
+      close(fd);
+      if (rc < 0 && errno == EADDRINUSE)  return 0;
+      usleep(10000);
+   }
+   return -1;
+}
+
+/* accepts the connection of socat on listener fd; gives up when the last
+   socat process of run terminated */
+static int bench_accept(struct bench_run *run, int fd) {
+   struct pollfd pfd;
+   siginfo_t info;
+   int i;
+
+   pfd.fd = fd;
+   pfd.events = POLLIN;
+   for (i = 0; i < BENCH_TIMEOUT/50; ++i) {
+      if (poll(&pfd, 1, 50) > 0) {
+	 return accept(fd, NULL, NULL);
+      }
+      info.si_pid = 0;
+      if (waitid(P_PID, run->pid[run->npid-1], &info,
+		 WEXITED|WNOHANG|WNOWAIT) == 0 && info.si_pid != 0) {
+	 return -1;
+      }
+   }
+   return -1;
+}
+
+/* connects a UDP socket to port on 127.0.0.1 */
+static int bench_udp(const char *port) {
+   struct sockaddr_in sa;
+   int fd;
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sin_family = AF_INET;
+   sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   sa.sin_port = htons(atoi(port));
+   if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)  return -1;
+   if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/* starts socat for pair with transfer block size bufsiz, and returns the
+   endpoints in run. returns 0 on success, or -1 with a reason in *why */
+static int bench_start(const char *pair, int bufsiz, struct bench_run *run,
+		       const char **why) {
+   char b[32], addr1[512], addr2[512], a[128], s[128], p[32];
+   const char *argv[12];
+   int lis1 = -1, lis2 = -1;
+   int family = AF_INET;
+   int pipes[2][2];
+
+   memset(run, 0, sizeof(*run));
+   run->src = run->sink = -1;
+   snprintf(b, sizeof(b), "-b%d", bufsiz);
+   *why = "socat did not connect";
+
+   if (!strcmp(pair, "pipe")) {
+      if (pipe(pipes[0]) < 0 || pipe(pipes[1]) < 0) {
+	 *why = strerror(errno);
+	 return -1;
+      }
+      argv[0] = "-S"; argv[1] = b; argv[2] = "-u";
+      argv[3] = "STDIN"; argv[4] = "STDOUT"; argv[5] = NULL;
+      if (bench_socat(run, argv, pipes[0][0], pipes[1][1]) < 0) {
+	 *why = strerror(errno);
+	 return -1;
+      }
+      close(pipes[0][0]);
+      close(pipes[1][1]);
+      run->src = pipes[0][1];
+      run->sink = pipes[1][0];
+      return 0;
+   }
+
+   if (!strcmp(pair, "udp")) {
+      if (bench_freeport(SOCK_DGRAM, p, sizeof(p)) < 0 ||
+	  (run->sink = bench_listen(AF_INET, SOCK_DGRAM, s, sizeof(s))) < 0) {
+	 *why = strerror(errno);
+	 return -1;
+      }
+      run->dgram = true;
+      snprintf(addr1, sizeof(addr1), "UDP4-RECV:%s,bind=127.0.0.1", p);
+      snprintf(addr2, sizeof(addr2), "UDP4-SENDTO:127.0.0.1:%s", s);
+      argv[0] = "-S"; argv[1] = b; argv[2] = "-u"; argv[3] = "-T1";
+      argv[4] = addr1; argv[5] = addr2; argv[6] = NULL;
+      if (bench_socat(run, argv, -1, -1) < 0 ||
+	  bench_waitbound(SOCK_DGRAM, p) < 0 ||
+	  (run->src = bench_udp(p)) < 0) {
+	 return -1;
+      }
+      return 0;
+   }
+
+   if (!strcmp(pair, "unix")) {
+      family = AF_UNIX;
+#if BENCH_VSOCK
+   } else if (!strcmp(pair, "vsock")) {
+      family = AF_VSOCK;
+#endif
+   } else if (strcmp(pair, "tcp") && strcmp(pair, "openssl")) {
+      *why = "not available in this build";
+      return -1;
+   }
+   if ((lis1 = bench_listen(family, SOCK_STREAM, a, sizeof(a))) < 0 ||
+       (lis2 = bench_listen(family, SOCK_STREAM, s, sizeof(s))) < 0) {
+      *why = strerror(errno);
+      if (lis1 >= 0)  close(lis1);
+      return -1;
+   }
+   switch (family) {
+   case AF_UNIX:
+      snprintf(addr1, sizeof(addr1), "UNIX-CONNECT:%s", a);
+      snprintf(addr2, sizeof(addr2), "UNIX-CONNECT:%s", s);
+      break;
+#if BENCH_VSOCK
+   case AF_VSOCK:
+      snprintf(addr1, sizeof(addr1), "VSOCK-CONNECT:1:%s", a);
+      snprintf(addr2, sizeof(addr2), "VSOCK-CONNECT:1:%s", s);
+      break;
+#endif
+   default:
+      /* all TCP connections without Nagle, whose delays would hide the time
+	 of socat in the latency run */
+      snprintf(addr1, sizeof(addr1), "TCP4:127.0.0.1:%s,nodelay", a);
+      snprintf(addr2, sizeof(addr2), "TCP4:127.0.0.1:%s,nodelay", s);
+   }
+
+   if (!strcmp(pair, "openssl")) {
+      /* TLS between two socat processes on loopback */
+      char tls1[512], tls2[1024];
+
+      if (!havecert) {
+	 *why = "no certificate (openssl command failed)";
+	 close(lis1);  close(lis2);
+	 return -1;
+      }
+      if (bench_freeport(SOCK_STREAM, p, sizeof(p)) < 0) {
+	 *why = strerror(errno);
+	 close(lis1);  close(lis2);
+	 return -1;
+      }
+      snprintf(tls2, sizeof(tls2),
+	       "OPENSSL-LISTEN:%s,bind=127.0.0.1,reuseaddr,nodelay,cert=%s/bench.pem,verify=0",
+	       p, tmpdir);
+      argv[0] = "-S"; argv[1] = b; argv[2] = "-u";
+      argv[3] = tls2; argv[4] = addr2; argv[5] = NULL;
+      if (bench_socat(run, argv, -1, -1) < 0 ||
+	  bench_waitbound(SOCK_STREAM, p) < 0) {
+	 close(lis1);  close(lis2);
+	 return -1;
+      }
+      snprintf(tls1, sizeof(tls1), "OPENSSL:127.0.0.1:%s,nodelay,verify=0", p);
+      argv[3] = addr1; argv[4] = tls1;
+   } else {
+      argv[0] = "-S"; argv[1] = b; argv[2] = "-u";
+      argv[3] = addr1; argv[4] = addr2; argv[5] = NULL;
+   }
+   if (bench_socat(run, argv, -1, -1) < 0) {
+      *why = strerror(errno);
+      close(lis1);  close(lis2);
+      return -1;
+   }
+   run->src  = bench_accept(run, lis1);
+   run->sink = bench_accept(run, lis2);
+   close(lis1);
+   close(lis2);
+   if (run->src < 0 || run->sink < 0)  return -1;
+   if (family == AF_INET) {
+      int one = 1;
+      setsockopt(run->src,  IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      setsockopt(run->sink, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+   }
+   return 0;
+}
+
+/* ends the run: closes the endpoints and waits for the socat processes,
+   killing them when they do not exit within BENCH_TIMEOUT */
+static void bench_stop(struct bench_run *run) {
+   double t0 = now();
+   int i, n = 0;
+
+   if (run->src >= 0)   close(run->src);
+   if (run->sink >= 0)  close(run->sink);
+   run->src = run->sink = -1;
+   while (n < run->npid) {
+      for (i = 0; i < run->npid; ++i) {
+	 if (run->pid[i] > 0 &&
+	     wait4(run->pid[i], &run->status[i], WNOHANG, &run->ru[i]) > 0) {
+	    run->pid[i] = 0;
+	    ++n;
+	 }
+      }
+      if (n < run->npid) {
+	 if (now() - t0 > BENCH_TIMEOUT/1000.0) {
+	    for (i = 0; i < run->npid; ++i)
+	       if (run->pid[i] > 0)  kill(run->pid[i], SIGKILL);
+	 }
+	 usleep(1000);
+      }
+   }
+}
+
+/* adds the reads, writes, EAGAINs, and wakeups of the -S statistics of each
+   socat process of run; returns -1 when a process printed none */
+static int bench_syscalls(struct bench_run *run, double *syscalls) {
+   static const char *keys[] = {
+      "\"wakeups\":", "\"reads\":", "\"writes\":", "\"eagain\":", NULL };
+   char line[4096], *p;
+   bool found;
+   int i, k;
+
+   *syscalls = 0;
+   for (i = 0; i < run->npid; ++i) {
+      found = false;
+      rewind(run->err[i]);
+      while (fgets(line, sizeof(line), run->err[i]) != NULL) {
+	 if (strncmp(line, "{\"pid\":", 7))  continue;
+	 found = true;
+	 for (k = 0; keys[k] != NULL; ++k) {
+	    for (p = line; (p = strstr(p, keys[k])) != NULL;
+		 p += strlen(keys[k])) {
+	       *syscalls += strtod(p + strlen(keys[k]), NULL);
+	    }
+	 }
+      }
+      fclose(run->err[i]);
+      run->err[i] = NULL;
+      if (!found)  return -1;
+   }
+   return 0;
+}
+
+/* passes total bytes through the stream of run with blocks of BENCH_CHUNK
+   and checks that they arrive; returns the seconds, or -1 on error */
+static double bench_stream(struct bench_run *run, size_t total) {
+   static unsigned char out[BENCH_CHUNK], in[BENCH_CHUNK];
+   struct pollfd pfd[2];
+   size_t sent = 0, recvd = 0, i;
+   double t0;
+   ssize_t n;
+
+   for (i = 0; i < sizeof(out); ++i)  out[i] = i * 7;
+   fcntl(run->src, F_SETFL, fcntl(run->src, F_GETFL)|O_NONBLOCK);
+   t0 = now();
+   while (recvd < total) {
+      pfd[0].fd = sent < total ? run->src : -1;
+      pfd[0].events = POLLOUT;
+      pfd[1].fd = run->sink;
+      pfd[1].events = POLLIN;
+      if (poll(pfd, 2, BENCH_TIMEOUT) <= 0)  return -1;
+      if (pfd[0].revents) {
+	 size_t len = sizeof(out) - sent % sizeof(out);
+	 if (len > total - sent)  len = total - sent;
+	 if ((n = write(run->src, out + sent % sizeof(out), len)) < 0) {
+	    if (errno != EAGAIN)  return -1;
+	 } else if ((sent += n) == total) {
+	    close(run->src);	/* EOF for socat */
+	    run->src = -1;
+	 }
+      }
+      if (pfd[1].revents) {
+	 if ((n = read(run->sink, in, sizeof(in))) <= 0)  return -1;
+	 for (i = 0; i < (size_t)n; ++i) {
+	    if (in[i] != (unsigned char)((recvd + i) % sizeof(out) * 7)) {
+	       fprintf(stderr, "data differs at byte %lu\n",
+		       (unsigned long)(recvd + i));
+	       return -1;
+	    }
+	 }
+	 recvd += n;
+      }
+   }
+   return now() - t0;
+}
+
+/* sends total bytes in datagrams of size with up to BENCH_WINDOW in flight;
+   a datagram that did not arrive within 100ms counts as lost. returns the
+   seconds, or -1 on error */
+static double bench_dgrams(struct bench_run *run, size_t total, size_t size,
+			   unsigned long *lost) {
+   static unsigned char buff[BENCH_DGRAM];
+   unsigned long sent = 0, recvd = 0, count = (total + size - 1) / size;
+   struct pollfd pfd;
+   double t0;
+   ssize_t n;
+
+   memset(buff, 'x', sizeof(buff));
+   *lost = 0;
+   t0 = now();
+   while (recvd + *lost < count) {
+      while (sent < count && sent - recvd - *lost < BENCH_WINDOW) {
+	 if (send(run->src, buff, size, 0) < 0) {
+	    if (errno == ECONNREFUSED)  continue;
+	    return -1;
+	 }
+	 ++sent;
+      }
+      pfd.fd = run->sink;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, 100) <= 0) {
+	 *lost += sent - recvd - *lost;	/* the window is lost */
+	 continue;
+      }
+      if ((n = recv(run->sink, buff, sizeof(buff), 0)) < 0)  return -1;
+      ++recvd;
+   }
+   *lost = count - recvd;
+   return now() - t0;
+}
+
+static int bench_cmp(const void *a, const void *b) {
+   double x = *(const double *)a, y = *(const double *)b;
+   return x < y ? -1 : x > y;
+}
+
+/* sends BENCH_ROUNDS blocks of size one at a time and takes the time until
+   each arrived completely; stores the percentiles in usecs */
+static int bench_latency(struct bench_run *run, size_t size,
+			 double *p50, double *p99) {
+   static unsigned char buff[1<<20];
+   double lat[BENCH_ROUNDS], t0;
+   struct pollfd pfd;
+   size_t got, off;
+   ssize_t n;
+   int r, nlat = 0;
+
+   if (size > sizeof(buff))  size = sizeof(buff);
+   if (run->dgram && size > BENCH_DGRAM)  size = BENCH_DGRAM;
+   memset(buff, 'y', size);
+   fcntl(run->src, F_SETFL, fcntl(run->src, F_GETFL) & ~O_NONBLOCK);
+   for (r = 0; r < BENCH_ROUNDS; ++r) {
+      t0 = now();
+      for (off = 0; off < size; off += n) {
+	 if ((n = write(run->src, buff + off, size - off)) < 0)  return -1;
+      }
+      pfd.fd = run->sink;
+      pfd.events = POLLIN;
+      for (got = 0; got < size; got += n) {
+	 if (poll(&pfd, 1, run->dgram ? 100 : BENCH_TIMEOUT) <= 0) {
+	    if (run->dgram)  break;	/* lost, not counted */
+	    return -1;
+	 }
+	 if ((n = read(run->sink, buff, sizeof(buff))) <= 0)  return -1;
+      }
+      if (got >= size)  lat[nlat++] = (now() - t0) * 1e6;
+   }
+   if (nlat == 0)  return -1;
+   qsort(lat, nlat, sizeof(double), bench_cmp);
+   *p50 = lat[nlat/2];
+   *p99 = lat[(nlat*99)/100 < nlat ? (nlat*99)/100 : nlat-1];
+   return 0;
+}
+
+/* runs pair with bufsiz: a throughput run with the statistics, then a
+   latency run. returns 0, or -1 with a reason in *why */
+static int bench_pair(const char *pair, int bufsiz, size_t total,
+		      struct bench_result *res, const char **why) {
+   struct bench_run run;
+   double secs, cpu = 0.0;
+   int i;
+
+   memset(res, 0, sizeof(*res));
+   if (bench_start(pair, bufsiz, &run, why) < 0) {
+      bench_stop(&run);
+      for (i = 0; i < run.npid; ++i)  fclose(run.err[i]);
+      return -1;
+   }
+   if (run.dgram) {
+      size_t size = bufsiz < BENCH_DGRAM ? bufsiz : BENCH_DGRAM;
+      secs = bench_dgrams(&run, total, size, &res->lost);
+      total -= res->lost * size;
+   } else {
+      secs = bench_stream(&run, total);
+   }
+   bench_stop(&run);
+   if (secs <= 0 || bench_syscalls(&run, &res->syscalls) < 0) {
+      *why = "transfer failed";
+      for (i = 0; i < run.npid; ++i)  if (run.err[i])  fclose(run.err[i]);
+      return -1;
+   }
+   for (i = 0; i < run.npid; ++i) {
+      cpu += run.ru[i].ru_utime.tv_sec + run.ru[i].ru_utime.tv_usec / 1e6 +
+	 run.ru[i].ru_stime.tv_sec + run.ru[i].ru_stime.tv_usec / 1e6;
+   }
+   res->mbps = total / 1048576.0 / secs;
+   res->syscalls /= total / 1048576.0;
+   res->cpums = cpu * 1000.0 / (total / 1048576.0);
+
+   if (bench_start(pair, bufsiz, &run, why) < 0 ||
+       bench_latency(&run, bufsiz, &res->p50, &res->p99) < 0) {
+      *why = "latency run failed";
+      bench_stop(&run);
+      for (i = 0; i < run.npid; ++i)  if (run.err[i])  fclose(run.err[i]);
+      return -1;
+   }
+   bench_stop(&run);
+   for (i = 0; i < run.npid; ++i)  fclose(run.err[i]);
+   return 0;
+}
+
+int main(int argc, const char *argv[]) {
+   static const char *pairs[] = {
+      "pipe", "unix", "tcp", "vsock", "openssl", "udp", NULL };
+   static const int defsizes[] = { 4096, 8192, 65536, 0 };
+   int sizes[16], nsizes = 0;
+   size_t mb = 64, total;
+   struct bench_result res;
+   const char *why, *p;
+   char cmd[512];
+   bool first = true;
+   int i, j;
+
+   if (argc > 1)  mb = atoi(argv[1]);
+   if (mb == 0)  mb = 1;
+   if (argc > 2) {
+      for (p = argv[2]; *p && nsizes < 15; ) {
+	 if ((sizes[nsizes] = atoi(p)) > 0)  ++nsizes;
+	 if ((p = strchr(p, ',')) == NULL)  break;
+	 ++p;
+      }
+   }
+   if (nsizes == 0) {
+      for (nsizes = 0; defsizes[nsizes]; ++nsizes)
+	 sizes[nsizes] = defsizes[nsizes];
+   }
+   if (getenv("SOCAT"))  socat = getenv("SOCAT");
+   signal(SIGPIPE, SIG_IGN);
+   if (mkdtemp(tmpdir) == NULL) {
+      perror(tmpdir);
+      return 1;
+   }
+   snprintf(cmd, sizeof(cmd),
+	    "openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost "
+	    "-keyout %s/bench.pem -out %s/bench.crt >/dev/null 2>&1 && "
+	    "cat %s/bench.crt >>%s/bench.pem", tmpdir, tmpdir, tmpdir, tmpdir);
+   havecert = (system(cmd) == 0);
+
+   printf("{\"socat\":\"%s\",\"mb\":%lu,\"results\":[",
+	  socat, (unsigned long)mb);
+   for (i = 0; pairs[i] != NULL; ++i) {
+      /* datagrams are slower, keep the run short */
+      total = (!strcmp(pairs[i], "udp") ? (mb+7)/8 : mb) * 1048576;
+      for (j = 0; j < nsizes; ++j) {
+	 printf("%s\n {\"pair\":\"%s\",\"bufsize\":%d,",
+		first ? "" : ",", pairs[i], sizes[j]);
+	 first = false;
+	 if (bench_pair(pairs[i], sizes[j], total, &res, &why) < 0) {
+	    printf("\"skipped\":\"%s\"}", why);
+	 } else {
+	    printf("\"mb_per_s\":%.1f,\"syscalls_per_mb\":%.1f,"
+		   "\"cpu_ms_per_mb\":%.3f,\"latency_usec\":{\"p50\":%.1f,"
+		   "\"p99\":%.1f}",
+		   res.mbps, res.syscalls, res.cpums, res.p50, res.p99);
+	    if (!strcmp(pairs[i], "udp"))  printf(",\"lost\":%lu", res.lost);
+	    printf("}");
+	 }
+	 fflush(stdout);
+      }
+   }
+   printf("\n]}\n");
+
+   snprintf(cmd, sizeof(cmd), "rm -rf %s", tmpdir);
+   system(cmd);
+   return 0;
+}
@@ -0,0 +1,270 @@
+/* source: uring.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains a small io_uring layer for the transfer loop of socat
+   (option -I). It talks to the kernel with the raw system calls, so it does
+   not need liburing */
+
+#include "config.h"
+
+#include "sysincludes.h"
+
+#include "mytypes.h"
+#include "compat.h"
+#include "error.h"
+#include "sycls.h"
+#include "uring.h"
+
+#if WITH_IOURING
+
+#define uring_load(p)    __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define uring_store(p,v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static int uring_setup(unsigned int entries, struct io_uring_params *p) {
+   return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_register(int fd, unsigned int opcode, void *arg,
+			  unsigned int nr_args) {
+   return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+int uring_init(struct uring *ur, unsigned int entries) {
+   struct io_uring_params p;
+   size_t sqsz, cqsz;
+   unsigned int i;
+   int _errno;
+
+   memset(ur, 0, sizeof(*ur));
+   ur->fd = -1;
+   memset(&p, 0, sizeof(p));
+   /* only this process submits, and it collects completions only in
+      uring_enter(): let the kernel run completion work there */
+   p.flags = IORING_SETUP_SINGLE_ISSUER|IORING_SETUP_DEFER_TASKRUN;
+   if ((ur->fd = uring_setup(entries, &p)) < 0 && errno == EINVAL) {
+      /* before Linux 6.1 */
+      memset(&p, 0, sizeof(p));
+      ur->fd = uring_setup(entries, &p);
+   }
+   if (ur->fd < 0) {
+      _errno = errno;
+      Info2("io_uring_setup(%u, ...): %s", entries, strerror(errno));
+      errno = _errno;
+      return -1;
+   }
+   Debug3("io_uring_setup(%u, {flags=0x%x, ...}) -> %d",
+	  entries, p.flags, ur->fd);
+   ur->features = p.features;
+   if (!(p.features & IORING_FEAT_SINGLE_MMAP) ||
+       !(p.features & IORING_FEAT_EXT_ARG)) {
+      Info1("io_uring features 0x%x: kernel too old", p.features);
+      Close(ur->fd);
+      ur->fd = -1;
+      errno = ENOSYS;
+      return -1;
+   }
+   Fcntl_l(ur->fd, F_SETFD, FD_CLOEXEC);
+
+   sqsz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+   cqsz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+   ur->ringsz = Max(sqsz, cqsz);
+   ur->ring = mmap(NULL, ur->ringsz, PROT_READ|PROT_WRITE,
+		   MAP_SHARED|MAP_POPULATE, ur->fd, IORING_OFF_SQ_RING);
+   if (ur->ring == MAP_FAILED) {
+      _errno = errno;
+      Warn1("mmap(..., IORING_OFF_SQ_RING): %s", strerror(errno));
+      ur->ring = NULL;
+      uring_exit(ur);
+      errno = _errno;
+      return -1;
+   }
+   ur->sqessz = p.sq_entries * sizeof(struct io_uring_sqe);
+   ur->sqes = mmap(NULL, ur->sqessz, PROT_READ|PROT_WRITE,
+		   MAP_SHARED|MAP_POPULATE, ur->fd, IORING_OFF_SQES);
+   if (ur->sqes == MAP_FAILED) {
+      _errno = errno;
+      Warn1("mmap(..., IORING_OFF_SQES): %s", strerror(errno));
+      ur->sqes = NULL;
+      uring_exit(ur);
+      errno = _errno;
+      return -1;
+   }
+
+   ur->sqhead  = (unsigned int *)((char *)ur->ring + p.sq_off.head);
+   ur->sqtail  = (unsigned int *)((char *)ur->ring + p.sq_off.tail);
+   ur->sqarray = (unsigned int *)((char *)ur->ring + p.sq_off.array);
+   ur->sqmask  = *(unsigned int *)((char *)ur->ring + p.sq_off.ring_mask);
+   ur->sqentries = p.sq_entries;
+   ur->sqlocal = *ur->sqtail;
+   ur->cqhead  = (unsigned int *)((char *)ur->ring + p.cq_off.head);
+   ur->cqtail  = (unsigned int *)((char *)ur->ring + p.cq_off.tail);
+   ur->cqmask  = *(unsigned int *)((char *)ur->ring + p.cq_off.ring_mask);
+   ur->cqes = (struct io_uring_cqe *)((char *)ur->ring + p.cq_off.cqes);
+   /* SQE i always sits in slot i */
+   for (i = 0; i < p.sq_entries; ++i) {
+      ur->sqarray[i] = i;
+   }
+   return 0;
+}
+
+void uring_exit(struct uring *ur) {
+   if (ur->sqes != NULL) {
+      munmap(ur->sqes, ur->sqessz);
+      ur->sqes = NULL;
+   }
+   if (ur->ring != NULL) {
+      munmap(ur->ring, ur->ringsz);
+      ur->ring = NULL;
+   }
+   if (ur->fd >= 0) {
+      Close(ur->fd);
+      ur->fd = -1;
+   }
+}
+
+struct io_uring_sqe *uring_getsqe(struct uring *ur) {
+   struct io_uring_sqe *sqe;
+
+   if (ur->sqlocal - uring_load(ur->sqhead) >= ur->sqentries) {
+      return NULL;
+   }
+   sqe = &ur->sqes[ur->sqlocal & ur->sqmask];
+   memset(sqe, 0, sizeof(*sqe));
+   ++ur->sqlocal;
+   return sqe;
+}
+
+int uring_enter(struct uring *ur, unsigned int waitnr,
+		const struct timeval *timeout) {
+   struct io_uring_getevents_arg arg;
+   struct __kernel_timespec ts;
+   unsigned int submit, flags = 0;
+   void *argp = NULL;
+   size_t argsz = 0;
+   int result;
+
+   uring_store(ur->sqtail, ur->sqlocal);
+   submit = ur->sqlocal - uring_load(ur->sqhead);
+   if (waitnr > 0) {
+      flags |= IORING_ENTER_GETEVENTS;
+      if (timeout != NULL) {
+	 ts.tv_sec  = timeout->tv_sec;
+	 ts.tv_nsec = timeout->tv_usec * 1000;
+	 memset(&arg, 0, sizeof(arg));
+	 arg.ts = (unsigned long)&ts;
+	 flags |= IORING_ENTER_EXT_ARG;
+	 argp = &arg;
+	 argsz = sizeof(arg);
+      }
+   }
+   if (submit == 0 && waitnr == 0) {
+      return 0;
+   }
+   result = syscall(__NR_io_uring_enter, ur->fd, submit, waitnr, flags,
+		    argp, argsz);
+   return result;
+}
+
+struct io_uring_cqe *uring_peekcqe(struct uring *ur) {
+   unsigned int head = *ur->cqhead;
+
+   if (head == uring_load(ur->cqtail)) {
+      return NULL;
+   }
+   return &ur->cqes[head & ur->cqmask];
+}
+
+void uring_cqeseen(struct uring *ur) {
+   uring_store(ur->cqhead, *ur->cqhead + 1);
+}
+
+
+int uring_bufring_init(struct uring *ur, struct uring_bufring *b,
+		       unsigned short bgid, unsigned short entries,
+		       size_t bufsiz) {
+   struct io_uring_buf_reg reg;
+   unsigned short i;
+   int _errno;
+
+   memset(b, 0, sizeof(*b));
+   b->bgid = bgid;
+   b->entries = entries;
+   b->bufsiz = bufsiz;
+   b->brsz = entries * sizeof(struct io_uring_buf);
+   b->br = mmap(NULL, b->brsz, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+   if (b->br == MAP_FAILED) {
+      _errno = errno;
+      Warn2("mmap(NULL, "F_Zu", ...): %s", b->brsz, strerror(errno));
+      b->br = NULL;
+      errno = _errno;
+      return -1;
+   }
+#if HAVE_PROTOTYPE_LIB_posix_memalign
+   /* for files with O_DIRECT */
+   if ((_errno = Posix_memalign((void **)&b->bufs, getpagesize(),
+			       entries * bufsiz)) != 0) {
+      Warn1("posix_memalign(): %s", strerror(_errno));
+      b->bufs = NULL;
+      uring_bufring_exit(ur, b);
+      errno = _errno;
+      return -1;
+   }
+#else
+   if ((b->bufs = Malloc(entries * bufsiz)) == NULL) {
+      uring_bufring_exit(ur, b);
+      errno = ENOMEM;
+      return -1;
+   }
+#endif
+   memset(&reg, 0, sizeof(reg));
+   reg.ring_addr = (unsigned long)b->br;
+   reg.ring_entries = entries;
+   reg.bgid = bgid;
+   if (uring_register(ur->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+      _errno = errno;
+      Info2("io_uring_register(%d, IORING_REGISTER_PBUF_RING, ...): %s",
+	    ur->fd, strerror(errno));
+      free(b->bufs);  b->bufs = NULL;
+      munmap(b->br, b->brsz);  b->br = NULL;
+      errno = _errno;
+      return -1;
+   }
+   for (i = 0; i < entries; ++i) {
+      struct io_uring_buf *buf = &b->br->bufs[i];
+      buf->addr = (unsigned long)uring_bufaddr(b, i);
+      buf->len  = bufsiz;
+      buf->bid  = i;
+   }
+   b->tail = entries;
+   uring_store(&b->br->tail, b->tail);
+   return 0;
+}
+
+void uring_bufring_exit(struct uring *ur, struct uring_bufring *b) {
+   if (b->br != NULL) {
+      if (b->bufs != NULL) {
+	 /* was registered */
+	 struct io_uring_buf_reg reg;
+	 memset(&reg, 0, sizeof(reg));
+	 reg.bgid = b->bgid;
+	 uring_register(ur->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+      }
+      munmap(b->br, b->brsz);
+      b->br = NULL;
+   }
+   free(b->bufs);
+   b->bufs = NULL;
+}
+
+void uring_bufring_put(struct uring_bufring *b, unsigned short bid) {
+   struct io_uring_buf *buf = &b->br->bufs[b->tail & (b->entries-1)];
+
+   buf->addr = (unsigned long)uring_bufaddr(b, bid);
+   buf->len  = b->bufsiz;
+   buf->bid  = bid;
+   uring_store(&b->br->tail, ++b->tail);
+}
+
+#endif /* WITH_IOURING */
@@ -0,0 +1,71 @@
+/* source: uring.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __uring_h_included
+#define __uring_h_included 1
+
+#if WITH_IOURING
+
+/* a minimal io_uring instance on top of the raw system calls (there is no
+   dependency on liburing): the submission and completion rings are mmap()'ed
+   from the kernel; SQEs are published with uring_enter() */
+struct uring {
+   int fd;
+   unsigned int features;	/* IORING_FEAT_* */
+   void *ring;			/* the SQ and CQ rings (single mmap) */
+   size_t ringsz;
+   struct io_uring_sqe *sqes;
+   size_t sqessz;
+   unsigned int *sqhead, *sqtail, *sqarray;
+   unsigned int sqmask, sqentries;
+   unsigned int sqlocal;	/* tail of SQEs not yet published */
+   unsigned int *cqhead, *cqtail;
+   unsigned int cqmask;
+   struct io_uring_cqe *cqes;
+} ;
+
+/* a ring of provided buffers (IORING_REGISTER_PBUF_RING); read and recv
+   requests with IOSQE_BUFFER_SELECT pick a buffer of group bgid */
+struct uring_bufring {
+   struct io_uring_buf_ring *br;
+   size_t brsz;
+   unsigned short bgid;
+   unsigned short entries;	/* power of 2 */
+   unsigned short tail;
+   unsigned char *bufs;		/* entries*bufsiz bytes */
+   size_t bufsiz;
+} ;
+
+/* creates the instance with at least entries SQEs. Requires IORING_FEAT_
+   SINGLE_MMAP and IORING_FEAT_EXT_ARG (Linux 5.11).
+   returns 0 on success, or -1 with errno set */
+extern int uring_init(struct uring *ur, unsigned int entries);
+extern void uring_exit(struct uring *ur);
+/* returns a cleared SQE, or NULL when the SQ ring is full */
+extern struct io_uring_sqe *uring_getsqe(struct uring *ur);
+/* submits the new SQEs, and waits until at least waitnr CQEs are available or
+   the timeout (NULL: none) elapsed.
+   returns the number of SQEs submitted, or -1 with errno (EINTR, ETIME) */
+extern int uring_enter(struct uring *ur, unsigned int waitnr,
+		       const struct timeval *timeout);
+/* returns the next CQE, or NULL when there is none */
+extern struct io_uring_cqe *uring_peekcqe(struct uring *ur);
+/* releases the CQE returned by uring_peekcqe() */
+extern void uring_cqeseen(struct uring *ur);
+
+/* allocates entries (power of 2) buffers of bufsiz bytes, registers them as
+   group bgid and provides all of them.
+   returns 0 on success, or -1 with errno set */
+extern int uring_bufring_init(struct uring *ur, struct uring_bufring *b,
+			      unsigned short bgid, unsigned short entries,
+			      size_t bufsiz);
+extern void uring_bufring_exit(struct uring *ur, struct uring_bufring *b);
+/* gives buffer bid back to the kernel */
+extern void uring_bufring_put(struct uring_bufring *b, unsigned short bid);
+
+#define uring_bufaddr(b,bid) ((b)->bufs + (size_t)(bid)*(b)->bufsiz)
+
+#endif /* WITH_IOURING */
+
+#endif /* !defined(__uring_h_included) */
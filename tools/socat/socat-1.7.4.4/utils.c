@@ -67,6 +67,29 @@ const struct wordent *keyw(const struct wordent *keywds, const char *name, unsig
    return NULL;
 }
 
+/* search the keyword-table for name using the perfect hash generated for
+   this table by mkkeywhash.sh: one hash computation and one compare.
+   returns the pointer to the matching field of the keyword or NULL if no
+   keyword was found. */
+const struct wordent *keyw_hash(const struct wordent *keywds, const struct wordhash *hash, const char *name) {
+   uint32_t h = hash->seed;
+   const unsigned char *c;
+   unsigned int i;
+
+   /* like mkkeywhash.sh: h = h*33 + tolower(c) */
+   for (c = (const unsigned char *)name; *c; ++c) {
+      if (*c >= 0x80)  return NULL;	/* no keyword has such characters */
+      h = h*33 + tolower(*c);
+   }
+   i = hash->slot[(h/hash->buckets + hash->disp[h%hash->buckets])
+		  & (hash->size-1)];
+   if (i == 0 || i > hash->num)
+      return NULL;
+   if (strcasecmp(keywds[i-1].name, name))
+      return NULL;
+   return &keywds[i-1];
+}
+
 /* Linux: setenv(), AIX (4.3?): putenv() */
 #if !HAVE_SETENV
 int setenv(const char *name, const char *value, int overwrite) {
@@ -11,6 +11,16 @@ struct wordent {
    void *desc;
 } ;
 
+/* a perfect hash over a wordent table, generated by mkkeywhash.sh */
+struct wordhash {
+   unsigned int num;		/* number of keywords in the table */
+   uint32_t seed;
+   unsigned int buckets;	/* number of entries in disp */
+   unsigned int size;		/* number of entries in slot, power of 2 */
+   const unsigned short *disp;	/* displacement of each bucket */
+   const unsigned short *slot;	/* table index+1, 0 for empty slot */
+} ;
+
 #if !HAVE_PROTOTYPE_LIB_memrchr
 extern void *memrchr(const void *s, int c, size_t n);
 #endif
@@ -20,6 +30,7 @@ extern int setenv(const char *name, const char *value, int overwrite);
 #endif /* !HAVE_SETENV */
 
 extern const struct wordent *keyw(const struct wordent *keywds, const char *name, unsigned int nkeys);
+extern const struct wordent *keyw_hash(const struct wordent *keywds, const struct wordhash *hash, const char *name);
 
 
 #define XIOSAN_ZERO_MASK                  0x000f
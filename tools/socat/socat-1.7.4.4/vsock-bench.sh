@@ -0,0 +1,47 @@
+#! /usr/bin/env bash
+# source: vsock-bench.sh
+# Copyright Gerhard Rieger and contributors (see file CHANGES)
+# Published under the GNU General Public License V.2, see file COPYING
+
+# measures the throughput of socat over a local VSOCK connection, with the
+# classic transfer block size of 8192 bytes and with the automatic block size
+# that socat uses for VSOCK (with and without larger socket buffers).
+# it requires the vsock_loopback kernel module (CID 1):
+#   modprobe vsock_loopback
+# usage: ./vsock-bench.sh [MBytes [port]]
+
+if [ -x ./socat ]; then
+    SOCAT=./socat
+else
+    SOCAT=socat
+fi
+
+MB=${1:-1024}
+PORT=${2:-47001}
+
+# runs one transfer of $MB MBytes; $1: options for socat, $2: address options
+bench () {
+    local t0 t1 ms
+    $SOCAT $1 -u VSOCK-LISTEN:$PORT,reuseaddr$2 /dev/null &
+    local pid=$!
+    sleep 0.5
+    t0=$(date +%s%N)
+    if ! dd if=/dev/zero bs=1M count=$MB 2>/dev/null |
+	$SOCAT $1 -u - VSOCK-CONNECT:1:$PORT$2; then
+	kill $pid 2>/dev/null; wait $pid 2>/dev/null
+	echo "transfer failed (is vsock_loopback loaded?)" >&2
+	exit 1
+    fi
+    wait $pid
+    t1=$(date +%s%N)
+    ms=$(( (t1-t0)/1000000 ))
+    [ $ms -gt 0 ] || ms=1
+    printf "%-42s %8d MB/s\n" "${3}" $(( MB*1000/ms ))
+    PORT=$((PORT+1))
+}
+
+echo "transferring $MB MBytes over VSOCK loopback"
+bench "-b 8192" "" "-b 8192 (before)"
+bench "" "" "automatic block size"
+bench "" ",vsock-buffer-max=1048576,vsock-buffer-size=1048576" \
+      "automatic, vsock-buffer-size=1048576"
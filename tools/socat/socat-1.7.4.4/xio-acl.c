@@ -0,0 +1,395 @@
+/* source: xio-acl.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for the peer access lists of options
+   allow-file and deny-file */
+
+#include "xiosysincludes.h"
+
+#if _WITH_SOCKET
+
+#include "xioopen.h"
+#include "xio-acl.h"
+
+const struct optdesc opt_allow_file = { "allow-file", NULL, OPT_ALLOW_FILE, GROUP_RANGE, PH_ACCEPT, TYPE_FILENAME, OFUNC_SPEC };
+const struct optdesc opt_deny_file  = { "deny-file",  NULL, OPT_DENY_FILE,  GROUP_RANGE, PH_ACCEPT, TYPE_FILENAME, OFUNC_SPEC };
+
+/* The files list IPv4 and IPv6 networks as address[/bits] and VSOCK CIDs as
+   vsock:cid[/bits], separated by white space or commas; '#' starts a
+   comment. They are read once into a path compressed binary trie per
+   address family, and again on SIGHUP. A check walks the trie along the bits
+   of the peer address and takes the verdict of the longest matching prefix;
+   for the same prefix in both files deny wins. A peer that matches no entry
+   is refused when allow-file is given, else permitted */
+
+#define XIOACL_IP4   0
+#define XIOACL_IP6   1
+#define XIOACL_VSOCK 2
+#define XIOACL_FAMILIES 3
+
+#define XIOACL_ALLOW 1
+#define XIOACL_DENY  2
+
+static const unsigned xioacl_bits[XIOACL_FAMILIES] = { 32, 128, 32 };
+
+struct xioacl_node {
+   struct xioacl_node *child[2];
+   unsigned char key[16];	/* the prefix; bits past plen are 0 */
+   unsigned char plen;		/* prefix length in bits */
+   unsigned char verdict;	/* 0 for a branch only, XIOACL_ALLOW/DENY */
+} ;
+
+struct xioacl {
+   char *allowfile;
+   char *denyfile;
+   struct xioacl_node *root[XIOACL_FAMILIES];
+   sig_atomic_t sighups;	/* xio_sighup_count at the last load */
+   bool reload;		/* listener with fork or event-loop: read files again
+			   on SIGHUP */
+} ;
+
+static int xioacl_bit(const unsigned char *key, unsigned bit) {
+   return (key[bit>>3] >> (7-(bit&7))) & 1;
+}
+
+/* returns the number of leading bits, at most max, that a and b share */
+static unsigned xioacl_common(const unsigned char *a, const unsigned char *b,
+			      unsigned max) {
+   unsigned i = 0;
+   unsigned char x;
+
+   while (i+8 <= max && a[i>>3] == b[i>>3]) {
+      i += 8;
+   }
+   if (i < max) {
+      x = a[i>>3] ^ b[i>>3];
+      while (i < max && !(x & (0x80 >> (i&7)))) {
+	 ++i;
+      }
+   }
+   return i;
+}
+
+static struct xioacl_node *xioacl_node(const unsigned char *key,
+				       unsigned plen, int verdict) {
+   struct xioacl_node *n;
+   unsigned i;
+
+   if ((n = Calloc(1, sizeof(struct xioacl_node))) == NULL) {
+      return NULL;
+   }
+   memcpy(n->key, key, (plen+7)/8);
+   if (plen & 7) {
+      n->key[plen>>3] &= 0xff << (8-(plen&7));
+   }
+   for (i = (plen+7)/8; i < sizeof(n->key); ++i) {
+      n->key[i] = 0;
+   }
+   n->plen = plen;
+   n->verdict = verdict;
+   return n;
+}
+
+static void xioacl_free(struct xioacl_node *n) {
+   if (n == NULL)  return;
+   xioacl_free(n->child[0]);
+   xioacl_free(n->child[1]);
+   free(n);
+}
+
+/* adds the prefix key/plen with verdict to the trie at *pp.
+   returns 0 on success, or -1 when out of memory */
+static int xioacl_insert(struct xioacl_node **pp, const unsigned char *key,
+			 unsigned plen, int verdict) {
+   struct xioacl_node *n, *m, *leaf;
+   unsigned c;
+
+   while ((n = *pp) != NULL) {
+      c = xioacl_common(n->key, key, MIN(n->plen, plen));
+      if (c == n->plen) {
+	 if (c == plen) {
+	    /* the same prefix again */
+	    if (n->verdict != XIOACL_DENY)  n->verdict = verdict;
+	    return 0;
+	 }
+	 pp = &n->child[xioacl_bit(key, n->plen)];
+	 continue;
+      }
+      if (c == plen) {
+	 /* the new prefix is on the path to n */
+	 if ((m = xioacl_node(key, plen, verdict)) == NULL)  return -1;
+	 m->child[xioacl_bit(n->key, plen)] = n;
+	 *pp = m;
+	 return 0;
+      }
+      /* n and the new prefix branch after c bits */
+      if ((m = xioacl_node(key, c, 0)) == NULL)  return -1;
+      if ((leaf = xioacl_node(key, plen, verdict)) == NULL) {
+	 free(m);
+	 return -1;
+      }
+      m->child[xioacl_bit(n->key, c)] = n;
+      m->child[xioacl_bit(key, c)] = leaf;
+      *pp = m;
+      return 0;
+   }
+   if ((*pp = xioacl_node(key, plen, verdict)) == NULL)  return -1;
+   return 0;
+}
+
+/* returns the verdict of the longest prefix in the trie that matches the
+   bits of key, or 0 */
+static int xioacl_lookup(const struct xioacl_node *n, const unsigned char *key,
+			 unsigned bits) {
+   int verdict = 0;
+
+   while (n != NULL) {
+      if (xioacl_common(n->key, key, n->plen) < n->plen) {
+	 break;
+      }
+      if (n->verdict)  verdict = n->verdict;
+      if (n->plen >= bits) {
+	 break;
+      }
+      n = n->child[xioacl_bit(key, n->plen)];
+   }
+   return verdict;
+}
+
+/* parses one entry of a file to its address family, key, and prefix length.
+   returns 0 on success, or -1 when it is not valid */
+static int xioacl_parse(const char *entry, int *family, unsigned char *key,
+			unsigned *plen) {
+   char addr[64];
+   const char *slash;
+   char *end;
+   size_t len;
+   unsigned long val;
+
+   if ((slash = strchr(entry, '/')) != NULL) {
+      len = slash - entry;
+   } else {
+      len = strlen(entry);
+   }
+   if (len == 0 || len >= sizeof(addr)) {
+      return -1;
+   }
+   memcpy(addr, entry, len);  addr[len] = '\0';
+   memset(key, 0, 16);
+
+   if (!strncasecmp(addr, "vsock:", 6)) {
+      val = strtoul(addr+6, &end, 0);
+      if (addr[6] == '\0' || *end != '\0' || val > 0xffffffffUL) {
+	 return -1;
+      }
+      *family = XIOACL_VSOCK;
+      key[0] = val >> 24;  key[1] = val >> 16;  key[2] = val >> 8;  key[3] = val;
+   } else {
+      if (addr[0] == '[' && addr[len-1] == ']') {
+	 memmove(addr, addr+1, len-2);  addr[len-2] = '\0';
+      }
+      if (strchr(addr, ':') != NULL) {
+#if WITH_IP6
+	 if (inet_pton(AF_INET6, addr, key) != 1)  return -1;
+	 *family = XIOACL_IP6;
+#else
+	 return -1;
+#endif
+      } else {
+	 if (inet_pton(AF_INET, addr, key) != 1)  return -1;
+	 *family = XIOACL_IP4;
+      }
+   }
+
+   *plen = xioacl_bits[*family];
+   if (slash != NULL) {
+      val = strtoul(slash+1, &end, 10);
+      if (slash[1] == '\0' || *end != '\0' || val > *plen) {
+	 return -1;
+      }
+      *plen = val;
+   }
+   return 0;
+}
+
+/* adds the entries of file to the tries with verdict.
+   returns the number of entries, or -1 on error */
+static int xioacl_load(struct xioacl_node *root[], const char *file,
+		       int verdict) {
+   FILE *fp;
+   char entry[64];
+   unsigned char key[16];
+   unsigned plen, line = 1, entryline = 1;
+   size_t len = 0;
+   int family, c, entries = 0;
+   bool comment = false;
+
+   if ((fp = fopen(file, "r")) == NULL) {
+      Error2("%s: %s", file, strerror(errno));
+      return -1;
+   }
+   while (true) {
+      c = getc(fp);
+      if (c != EOF && !comment && c != '#' && c != ',' && !isspace(c)) {
+	 if (len == 0)  entryline = line;
+	 if (len+1 >= sizeof(entry)) {
+	    entry[len] = '\0';
+	    Error3("%s:%u: entry too long: \"%s...\"", file, entryline, entry);
+	    fclose(fp);
+	    return -1;
+	 }
+	 entry[len++] = c;
+	 continue;
+      }
+      if (len > 0) {
+	 entry[len] = '\0';
+	 len = 0;
+	 if (xioacl_parse(entry, &family, key, &plen) < 0) {
+	    Error3("%s:%u: invalid network \"%s\"", file, entryline, entry);
+	    fclose(fp);
+	    return -1;
+	 }
+	 if (xioacl_insert(&root[family], key, plen, verdict) < 0) {
+	    fclose(fp);
+	    return -1;
+	 }
+	 ++entries;
+      }
+      if (c == '#')  comment = true;
+      if (c == '\n') {
+	 comment = false;
+	 ++line;
+      }
+      if (c == EOF)  break;
+   }
+   if (ferror(fp)) {
+      Error2("%s: %s", file, strerror(errno));
+      fclose(fp);
+      return -1;
+   }
+   fclose(fp);
+   Info3("%s: %d %s entries", file, entries,
+	 verdict==XIOACL_ALLOW?"allow":"deny");
+   return entries;
+}
+
+/* reads the files of acl into new tries and replaces the old ones.
+   returns 0 on success, or -1 and keeps the old tries */
+static int xioacl_read(struct xioacl *acl) {
+   struct xioacl_node *root[XIOACL_FAMILIES] = { NULL };
+   int i;
+
+   if ((acl->allowfile != NULL &&
+	xioacl_load(root, acl->allowfile, XIOACL_ALLOW) < 0) ||
+       (acl->denyfile != NULL &&
+	xioacl_load(root, acl->denyfile, XIOACL_DENY) < 0)) {
+      for (i = 0; i < XIOACL_FAMILIES; ++i) {
+	 xioacl_free(root[i]);
+      }
+      return -1;
+   }
+   for (i = 0; i < XIOACL_FAMILIES; ++i) {
+      xioacl_free(acl->root[i]);
+      acl->root[i] = root[i];
+   }
+   return 0;
+}
+
+/* returns 0 if option allow-file or deny-file was found and the files could
+   be read,
+   returns 1 if none was found,
+   returns -1 if a file could not be read */
+int xio_retropt_acl(xiosingle_t *xfd, struct opt *opts) {
+   struct xioacl *acl;
+
+   if ((acl = Calloc(1, sizeof(struct xioacl))) == NULL) {
+      return -1;
+   }
+   retropt_string(opts, OPT_ALLOW_FILE, &acl->allowfile);
+   retropt_string(opts, OPT_DENY_FILE,  &acl->denyfile);
+   if (acl->allowfile == NULL && acl->denyfile == NULL) {
+      free(acl);
+      return 1;
+   }
+   acl->sighups = xio_sighup_count;
+   if (xioacl_read(acl) < 0) {
+      free(acl->allowfile);  free(acl->denyfile);  free(acl);
+      return -1;
+   }
+   if (xfd->flags & (XIO_DOESFORK|XIO_DOESEVENTLOOP)) {
+      /* without fork or event-loop SIGHUP keeps its usual meaning */
+      acl->reload = true;
+      xio_sighup_arm();
+   }
+   xfd->para.socket.acl = acl;
+   return 0;
+}
+
+/* in a worker or an idle child of option prefork: fork has restored the
+   SIGHUP handling of socat, count the signals again for the reload */
+void xioacl_arm(struct xioacl *acl) {
+   if (acl != NULL && acl->reload) {
+      xio_sighup_arm();
+   }
+}
+
+/* checks the peer address pa against the lists; reads the files again after
+   a SIGHUP. returns 0 if permitted, or -1 if refused */
+int xioacl_check(struct xioacl *acl, const union sockaddr_union *pa) {
+   const unsigned char *key;
+   unsigned char cid[4];
+   int family, verdict;
+   int result;
+
+   if (acl->sighups != xio_sighup_count) {
+      int exitlevel = diag_get_int('e');	/* save current exit level */
+      acl->sighups = xio_sighup_count;
+      diag_set_int('e', E_FATAL);	/* a bad file must not terminate the server */
+      result = xioacl_read(acl);
+      diag_set_int('e', exitlevel);	/* restore old exit level */
+      if (result < 0) {
+	 Warn("SIGHUP: failed to reload allow-file or deny-file, keeping the old lists");
+      } else {
+	 Notice("SIGHUP: reloaded allow-file and deny-file");
+      }
+   }
+
+   switch (pa->soa.sa_family) {
+#if WITH_IP4
+   case AF_INET:
+      family = XIOACL_IP4;
+      key = (const unsigned char *)&pa->ip4.sin_addr;
+      break;
+#endif /* WITH_IP4 */
+#if WITH_IP6
+   case AF_INET6:
+      key = (const unsigned char *)&pa->ip6.sin6_addr;
+      if (IN6_IS_ADDR_V4MAPPED(&pa->ip6.sin6_addr)) {
+	 /* an IPv4 client of a dual stack socket */
+	 family = XIOACL_IP4;
+	 key += 12;
+      } else {
+	 family = XIOACL_IP6;
+      }
+      break;
+#endif /* WITH_IP6 */
+#if WITH_VSOCK
+   case AF_VSOCK:
+      family = XIOACL_VSOCK;
+      cid[0] = pa->vm.svm_cid >> 24;  cid[1] = pa->vm.svm_cid >> 16;
+      cid[2] = pa->vm.svm_cid >> 8;   cid[3] = pa->vm.svm_cid;
+      key = cid;
+      break;
+#endif /* WITH_VSOCK */
+   default:
+      return acl->allowfile != NULL ? -1 : 0;
+   }
+
+   verdict = xioacl_lookup(acl->root[family], key, xioacl_bits[family]);
+   if (verdict == XIOACL_ALLOW)  return 0;
+   if (verdict == XIOACL_DENY)   return -1;
+   return acl->allowfile != NULL ? -1 : 0;
+}
+
+#endif /* _WITH_SOCKET */
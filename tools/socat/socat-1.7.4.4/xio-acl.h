@@ -0,0 +1,19 @@
+/* source: xio-acl.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_acl_h_included
+#define __xio_acl_h_included 1
+
+#if _WITH_SOCKET
+
+extern const struct optdesc opt_allow_file;
+extern const struct optdesc opt_deny_file;
+
+extern int xio_retropt_acl(xiosingle_t *xfd, struct opt *opts);
+extern void xioacl_arm(struct xioacl *acl);
+extern int xioacl_check(struct xioacl *acl, const union sockaddr_union *pa);
+
+#endif /* _WITH_SOCKET */
+
+#endif /* !defined(__xio_acl_h_included) */
@@ -33,6 +33,24 @@ static int xioopen_exec(int argc, const char *argv[], struct opt *opts,
    int status;
    bool dash = false;
    int duptostderr;
+   const char *ends[] = { " ", NULL };
+   const char *hquotes[] = { "'", NULL };
+   const char *squotes[] = { "\"", NULL };
+   const char *nests[] = {
+      "'", "'",
+      "(", ")",
+      "[", "]",
+      "{", "}",
+      NULL
+   } ;
+   char **pargv = NULL;
+   int pargc;
+   size_t len;
+   const char *strp;
+   char *token; /*! */
+   char *tokp;
+   char *tmp;
+   struct xiospawn spawn;
 
    if (argc != 2) {
       Error3("\"%s:%s\": wrong number of parameters (%d instead of 1)", argv[0], argv[1], argc-1);
@@ -40,72 +58,63 @@ static int xioopen_exec(int argc, const char *argv[], struct opt *opts,
       
    retropt_bool(opts, OPT_DASH, &dash);
 
-   status = _xioopen_foxec(xioflags, &fd->stream, groups, &opts, &duptostderr);
-   if (status < 0)  return status;
-   if (status == 0) {	/* child */
-      const char *ends[] = { " ", NULL };
-      const char *hquotes[] = { "'", NULL };
-      const char *squotes[] = { "\"", NULL };
-      const char *nests[] = {
-	 "'", "'",
-	 "(", ")",
-	 "[", "]",
-	 "{", "}",
-	 NULL
-      } ;
-      char **pargv = NULL;
-      int pargc;
-      size_t len;
-      const char *strp;
-      char *token; /*! */
-      char *tokp;
-      char *path = NULL;
-      char *tmp;
-      int numleft;
-
-      /*! Close(something) */
-      /* parse command line */
-      Debug1("child: args = \"%s\"", argv[1]);
-      pargv = Malloc(8*sizeof(char *));
-      if (pargv == NULL)  return STAT_RETRYLATER;
-      len = strlen(argv[1])+1;
-      strp = argv[1];
-      token = Malloc(len); /*! */
-      tokp = token;
+   /* parse command line; before forking, so it can be passed to
+      posix_spawnp() too */
+   Debug1("args = \"%s\"", argv[1]);
+   pargv = Malloc(8*sizeof(char *));
+   if (pargv == NULL)  return STAT_RETRYLATER;
+   len = strlen(argv[1])+1;
+   strp = argv[1];
+   token = Malloc(len); /*! */
+   if (token == NULL) {
+      free(pargv);
+      return STAT_RETRYLATER;
+   }
+   tokp = token;
+   if (nestlex(&strp, &tokp, &len, ends, hquotes, squotes, nests,
+	       true, true, false) < 0) {
+      Error("internal: miscalculated string lengths");
+   }
+   *tokp++ = '\0';
+   pargv[0] = strrchr(tokp-1, '/');
+   if (pargv[0] == NULL)  pargv[0] = token;  else  ++pargv[0];
+   pargc = 1;
+   while (*strp == ' ') {
+      while (*++strp == ' ')  ;
+      if ((pargc & 0x07) == 0) {
+	 pargv = Realloc(pargv, (pargc+8)*sizeof(char *));
+	 if (pargv == NULL)  return STAT_RETRYLATER;
+      }
+      pargv[pargc++] = tokp;
       if (nestlex(&strp, &tokp, &len, ends, hquotes, squotes, nests,
 		  true, true, false) < 0) {
 	 Error("internal: miscalculated string lengths");
       }
       *tokp++ = '\0';
-      pargv[0] = strrchr(tokp-1, '/');
-      if (pargv[0] == NULL)  pargv[0] = token;  else  ++pargv[0];
-      pargc = 1;
-      while (*strp == ' ') {
-	 while (*++strp == ' ')  ;
-	 if ((pargc & 0x07) == 0) {
-	    pargv = Realloc(pargv, (pargc+8)*sizeof(char *));
-	    if (pargv == NULL)  return STAT_RETRYLATER;
-	 }
-	 pargv[pargc++] = tokp;
-	 if (nestlex(&strp, &tokp, &len, ends, hquotes, squotes, nests,
-		     true, true, false) < 0) {
-	    Error("internal: miscalculated string lengths");
-	 }
-	 *tokp++ = '\0';
-      }
-      pargv[pargc] = NULL;
+   }
+   pargv[pargc] = NULL;
 
-      if ((tmp = Malloc(strlen(pargv[0])+2)) == NULL) {
-	 return STAT_RETRYLATER;
-      }
-      if (dash) {
-	 tmp[0] = '-';
-	 strcpy(tmp+1, pargv[0]);
-      } else {
-	 strcpy(tmp, pargv[0]);
-      }
-      pargv[0] = tmp;
+   if ((tmp = Malloc(strlen(pargv[0])+2)) == NULL) {
+      free(token);  free(pargv);
+      return STAT_RETRYLATER;
+   }
+   if (dash) {
+      tmp[0] = '-';
+      strcpy(tmp+1, pargv[0]);
+   } else {
+      strcpy(tmp, pargv[0]);
+   }
+   pargv[0] = tmp;
+
+   spawn.file = token;
+   spawn.argv = pargv;
+   status = _xioopen_foxec(xioflags, &fd->stream, groups, &opts, &duptostderr,
+			   &spawn);
+   if (status == 0) {	/* child */
+      char *path = NULL;
+      int numleft;
 
+      /*! Close(something) */
       if (setopt_path(opts, &path) < 0) {
 	 /* this could be dangerous, so let us abort this child... */
 	 Exit(1);
@@ -136,6 +145,10 @@ static int xioopen_exec(int argc, const char *argv[], struct opt *opts,
    }
 
    /* parent */
+   free(pargv[0]);
+   free(pargv);
+   free(token);
+   if (status < 0)  return status;
    return 0;
 }
 #endif /* WITH_EXEC */
@@ -100,6 +100,11 @@ const struct optdesc opt_res_defnames = { "res-defnames", "defnames", OPT_RES_DE
 const struct optdesc opt_res_stayopen = { "res-stayopen", "stayopen", OPT_RES_STAYOPEN, GROUP_SOCK_IP, PH_INIT, TYPE_BOOL, OFUNC_OFFSET_MASKS, XIO_OFFSETOF(para.socket.ip.res_opts), XIO_SIZEOF(para.socket.ip.res_opts), RES_STAYOPEN };
 const struct optdesc opt_res_dnsrch   = { "res-dnsrch",   "dnsrch",   OPT_RES_DNSRCH,   GROUP_SOCK_IP, PH_INIT, TYPE_BOOL, OFUNC_OFFSET_MASKS, XIO_OFFSETOF(para.socket.ip.res_opts), XIO_SIZEOF(para.socket.ip.res_opts), RES_DNSRCH };
 #endif /* HAVE_RESOLV_H */
+const struct optdesc opt_resolve_ttl     = { "resolve-ttl",     NULL, OPT_RESOLVE_TTL,     GROUP_SOCK_IP, PH_EARLY, TYPE_TIMESPEC, OFUNC_SPEC };
+const struct optdesc opt_resolve_neg_ttl = { "resolve-neg-ttl", NULL, OPT_RESOLVE_NEG_TTL, GROUP_SOCK_IP, PH_EARLY, TYPE_TIMESPEC, OFUNC_SPEC };
+const struct optdesc opt_resolve_async   = { "resolve-async",   NULL, OPT_RESOLVE_ASYNC,   GROUP_SOCK_IP, PH_EARLY, TYPE_BOOL,     OFUNC_SPEC };
+const struct optdesc opt_happy_eyeballs       = { "happy-eyeballs",       "happy",       OPT_HAPPY_EYEBALLS,       GROUP_SOCK_IP, PH_INIT, TYPE_BOOL,    OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.happy), XIO_SIZEOF(para.socket.ip.happy) };
+const struct optdesc opt_happy_eyeballs_delay = { "happy-eyeballs-delay", "happy-delay", OPT_HAPPY_EYEBALLS_DELAY, GROUP_SOCK_IP, PH_INIT, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.happy_delay), XIO_SIZEOF(para.socket.ip.happy_delay) };
 
 #endif /* WITH_IP4 || WITH_IP6 */
 
@@ -463,6 +468,488 @@ int xiogetaddrinfo(const char *node, const char *service,
 }
 
 
+/* cache of resolved addresses, with options resolve-ttl and resolve-neg-ttl.
+   a process that forks children fills it before (xioresolve_prefetch()), so
+   the children find the address there instead of asking the resolver again.
+   with resolve-async an expired address is still used while a helper process
+   resolves the name again and passes the result back through a pipe */
+#define XIORESOLVE_ENTRIES 16
+
+struct xioresolve_entry {
+   char *node;			/* NULL: unused entry */
+   char *service;
+   int family, socktype, protocol;
+   unsigned long res_opts0, res_opts1;
+   struct timespec ttl, negttl;
+   bool async;
+   bool valid;			/* status and sau may be used until expires */
+   int status;			/* result of xiogetaddrinfo() */
+   union sockaddr_union sau;
+   socklen_t socklen;
+   struct timeval expires;
+   pid_t helper;		/* process refreshing the entry, or 0 */
+   pid_t owner;			/* the process that started the helper */
+   pid_t keeper;		/* the process calling xioresolve_refresh() */
+   int helperfd;		/* read end of the pipe from the helper */
+} ;
+
+/* what the helper process writes to its pipe */
+struct xioresolve_result {
+   int status;
+   socklen_t socklen;
+   union sockaddr_union sau;
+} ;
+
+static struct xioresolve_entry xioresolve_cache[XIORESOLVE_ENTRIES];
+
+static struct xioresolve_entry *
+   xioresolve_find(const char *node, const char *service,
+		   int family, int socktype, int protocol,
+		   unsigned long res_opts0, unsigned long res_opts1) {
+   struct xioresolve_entry *e;
+   int i;
+
+   for (i = 0; i < XIORESOLVE_ENTRIES; ++i) {
+      e = &xioresolve_cache[i];
+      if (e->node != NULL && !strcmp(e->node, node) &&
+	  (e->service == NULL ? service == NULL :
+	   service != NULL && !strcmp(e->service, service)) &&
+	  e->family == family && e->socktype == socktype &&
+	  e->protocol == protocol &&
+	  e->res_opts0 == res_opts0 && e->res_opts1 == res_opts1) {
+	 return e;
+      }
+   }
+   return NULL;
+}
+
+/* returns an unused entry, or the one that expires first */
+static struct xioresolve_entry *xioresolve_alloc(void) {
+   struct xioresolve_entry *e, *oldest = &xioresolve_cache[0];
+   int i;
+
+   for (i = 0; i < XIORESOLVE_ENTRIES; ++i) {
+      e = &xioresolve_cache[i];
+      if (e->node == NULL) {
+	 return e;
+      }
+      if (e->expires.tv_sec < oldest->expires.tv_sec ||
+	  (e->expires.tv_sec == oldest->expires.tv_sec &&
+	   e->expires.tv_usec < oldest->expires.tv_usec)) {
+	 oldest = e;
+      }
+   }
+   Info1("resolve: dropping cached address of \"%s\"", oldest->node);
+   if (oldest->helper != 0 && oldest->owner == Getpid()) {
+      Close(oldest->helperfd);	/* the helper's write fails, it exits */
+   }
+   free(oldest->node);
+   free(oldest->service);
+   memset(oldest, 0, sizeof(*oldest));
+   return oldest;
+}
+
+static bool xioresolve_expired(const struct xioresolve_entry *e) {
+   struct timeval now;
+
+   Gettimeofday(&now, NULL);
+   return now.tv_sec > e->expires.tv_sec ||
+      (now.tv_sec == e->expires.tv_sec && now.tv_usec >= e->expires.tv_usec);
+}
+
+/* stores the result of a resolver call in the entry */
+static void xioresolve_store(struct xioresolve_entry *e, int status,
+			     const union sockaddr_union *sau,
+			     socklen_t socklen) {
+   const struct timespec *ttl;
+
+   if (status == STAT_OK) {
+      e->status = STAT_OK;
+      memcpy(&e->sau, sau, socklen);
+      e->socklen = socklen;
+      e->valid = (e->ttl.tv_sec != 0 || e->ttl.tv_nsec != 0);
+      ttl = &e->ttl;
+   } else if (e->valid && e->status == STAT_OK && e->async) {
+      /* keep the address that worked until the resolver answers again */
+      Warn1("resolve: keeping the expired address of \"%s\"", e->node);
+      ttl = &e->negttl;
+   } else {
+      e->status = status;
+      e->valid = (e->negttl.tv_sec != 0 || e->negttl.tv_nsec != 0);
+      ttl = &e->negttl;
+   }
+   Gettimeofday(&e->expires, NULL);
+   e->expires.tv_sec  += ttl->tv_sec;
+   e->expires.tv_usec += ttl->tv_nsec/1000;
+   if (e->expires.tv_usec >= 1000000) {
+      ++e->expires.tv_sec;  e->expires.tv_usec -= 1000000;
+   }
+}
+
+/* forks a helper process that resolves the entry again; its result is taken
+   by xioresolve_collect() */
+static void xioresolve_start(struct xioresolve_entry *e) {
+   struct xioresolve_result r;
+   int fds[2];
+   pid_t pid;
+
+   if (e->helper != 0) {
+      return;	/* running, maybe in the parent process */
+   }
+   if (Pipe(fds) < 0) {
+      Warn1("pipe(): %s", strerror(errno));
+      return;
+   }
+   if ((pid = xio_fork(false, E_WARN)) < 0) {
+      Close(fds[0]);  Close(fds[1]);
+      return;
+   }
+   if (pid == 0) {	/* helper process */
+      Close(fds[0]);
+      diag_set_int('e', E_FATAL);	/* a failure is just passed back */
+      memset(&r, 0, sizeof(r));
+      r.socklen = sizeof(r.sau);
+      r.status =
+	 xiogetaddrinfo(e->node, e->service, e->family, e->socktype,
+			e->protocol, &r.sau, &r.socklen,
+			e->res_opts0, e->res_opts1);
+      Write(fds[1], &r, sizeof(r));
+      diag_flush();
+      /* do not run the exit handlers, they would shut down the addresses of
+	 the parent */
+      _exit(0);
+   }
+   Close(fds[1]);
+   Fcntl_l(fds[0], F_SETFD, FD_CLOEXEC);
+   e->helper   = pid;
+   e->owner    = Getpid();
+   e->helperfd = fds[0];
+   Info2("resolve: refreshing address of \"%s\" in process "F_pid,
+	 e->node, pid);
+}
+
+/* when the helper process of the entry has finished, stores its result */
+static void xioresolve_collect(struct xioresolve_entry *e) {
+   struct xioresolve_result r;
+   struct pollfd pfd;
+   ssize_t bytes;
+   int status;
+
+   if (e->helper == 0 || e->owner != Getpid()) {
+      return;	/* a helper of the parent process delivers to the parent */
+   }
+   pfd.fd = e->helperfd;  pfd.events = POLLIN;  pfd.revents = 0;
+   if (Poll(&pfd, 1, 0) <= 0) {
+      return;	/* still resolving */
+   }
+   bytes = Read(e->helperfd, &r, sizeof(r));
+   Close(e->helperfd);
+   /* it exits right after writing; xiochildreap() might have been faster,
+      then it has already taken the helper off num_child */
+   if (Waitpid(e->helper, &status, 0) == e->helper) {
+      if (num_child) num_child--;	/* as xiochildreap() does */
+   }
+   e->helper = 0;
+   if (bytes != sizeof(r)) {
+      Warn1("resolve: refreshing address of \"%s\" failed", e->node);
+      return;
+   }
+   Info1("resolve: refreshed address of \"%s\"", e->node);
+   xioresolve_store(e, r.status, &r.sau, r.socklen);
+}
+
+/* returns the address of the entry, resolving it when it is not valid;
+   level: of the message about a cached failure */
+static int xioresolve_lookup(struct xioresolve_entry *e,
+			     union sockaddr_union *sau, socklen_t *socklen,
+			     int level) {
+   union sockaddr_union sa;
+   socklen_t salen = sizeof(sa);
+   int status;
+
+   xioresolve_collect(e);
+   if (e->valid && !xioresolve_expired(e)) {
+      Debug1("resolve: using cached result for \"%s\"", e->node);
+   } else if (e->valid && e->status == STAT_OK && e->async) {
+      if (e->keeper == 0 || e->keeper == Getpid()) {
+	 xioresolve_start(e);	/* otherwise the parent refreshes it */
+      }
+      Info1("resolve: using expired address of \"%s\"", e->node);
+   } else {
+      status =
+	 xiogetaddrinfo(e->node, e->service, e->family, e->socktype,
+			e->protocol, &sa, &salen, e->res_opts0, e->res_opts1);
+      xioresolve_store(e, status, &sa, salen);
+      if (status != STAT_OK) {
+	 return status;		/* xiogetaddrinfo() reported it */
+      }
+   }
+   if (e->status != STAT_OK) {
+      Msg1(level, "resolve: \"%s\" failed recently, not asking again before resolve-neg-ttl expires",
+	   e->node);
+      return e->status;
+   }
+   memset(sau, 0, *socklen);
+   if (*socklen > e->socklen) {
+      *socklen = e->socklen;
+   }
+   memcpy(sau, &e->sau, *socklen);
+   return STAT_OK;
+}
+
+/* like xiogetaddrinfo(), but retrieves the options resolve-ttl,
+   resolve-neg-ttl, and resolve-async, and with them uses the cache.
+   returns: STAT_OK, STAT_RETRYLATER, STAT_NORETRY
+*/
+int xioresolve(const char *node, const char *service,
+	       int family, int socktype, int protocol,
+	       union sockaddr_union *sau, socklen_t *socklen,
+	       unsigned long res_opts0, unsigned long res_opts1,
+	       struct opt *opts) {
+   struct timespec ttl = { 0, 0 }, negttl = { 0, 0 };
+   bool async = false;
+   struct xioresolve_entry *e;
+
+   retropt_timespec(opts, OPT_RESOLVE_TTL,     &ttl);
+   retropt_timespec(opts, OPT_RESOLVE_NEG_TTL, &negttl);
+   retropt_bool(opts, OPT_RESOLVE_ASYNC, &async);
+   if (node == NULL ||
+       (ttl.tv_sec == 0 && ttl.tv_nsec == 0 &&
+	negttl.tv_sec == 0 && negttl.tv_nsec == 0)) {
+      return xiogetaddrinfo(node, service, family, socktype, protocol,
+			    sau, socklen, res_opts0, res_opts1);
+   }
+
+   if ((e = xioresolve_find(node, service, family, socktype, protocol,
+			    res_opts0, res_opts1)) == NULL) {
+      e = xioresolve_alloc();
+      if ((e->node = strdup(node)) == NULL ||
+	  (service != NULL && (e->service = strdup(service)) == NULL)) {
+	 Error("strdup(): out of memory");
+	 free(e->node);  e->node = NULL;
+	 return STAT_NORETRY;
+      }
+      e->family    = family;
+      e->socktype  = socktype;
+      e->protocol  = protocol;
+      e->res_opts0 = res_opts0;
+      e->res_opts1 = res_opts1;
+   }
+   e->ttl    = ttl;
+   e->negttl = negttl;
+   e->async  = async;
+   return xioresolve_lookup(e, sau, socklen, E_ERROR);
+}
+
+/* for loops that connect again (retry, fork): when the address was resolved
+   by xioresolve() with the cache, renews *sau after the cache entry expired.
+   failures keep the previous address; family may be the family of *sau
+   when the address was resolved with PF_UNSPEC.
+   returns STAT_OK */
+int xioresolve_update(const char *node, const char *service,
+		      int family, int socktype, int protocol,
+		      union sockaddr_union *sau, socklen_t *socklen,
+		      unsigned long res_opts0, unsigned long res_opts1) {
+   struct xioresolve_entry *e;
+   union sockaddr_union sa;
+   socklen_t salen = sizeof(sa);
+   int errlevel;
+   int status;
+
+   if (node == NULL) {
+      return STAT_OK;
+   }
+   if ((e = xioresolve_find(node, service, family, socktype, protocol,
+			    res_opts0, res_opts1)) == NULL &&
+       (e = xioresolve_find(node, service, PF_UNSPEC, socktype, protocol,
+			    res_opts0, res_opts1)) == NULL) {
+      return STAT_OK;	/* resolved without the cache, keep it */
+   }
+   if (!e->valid || !xioresolve_expired(e)) {
+      return STAT_OK;	/* not kept, or *sau is still current */
+   }
+   errlevel = diag_get_int('e');
+   diag_set_int('e', E_FATAL);
+   status = xioresolve_lookup(e, &sa, &salen, E_WARN);
+   diag_set_int('e', errlevel);
+   if (status != STAT_OK) {
+      Warn1("resolve: keeping previous address of \"%s\"", node);
+      return STAT_OK;
+   }
+   if (sa.soa.sa_family != sau->soa.sa_family) {
+      Info1("resolve: \"%s\" now resolves to another address family, keeping previous address",
+	    node);
+      return STAT_OK;
+   }
+   if (salen != *socklen || memcmp(&sa, sau, salen)) {
+      Info1("resolve: address of \"%s\" changed", node);
+      memcpy(sau, &sa, salen);
+      *socklen = salen;
+   }
+   return STAT_OK;
+}
+
+/* for processes that fork children, e.g. before each accept(): takes the
+   results of finished helper processes and starts new ones for expired
+   entries, so the next children get a current address without waiting for
+   the resolver */
+void xioresolve_refresh(void) {
+   struct xioresolve_entry *e;
+   int i;
+
+   for (i = 0; i < XIORESOLVE_ENTRIES; ++i) {
+      e = &xioresolve_cache[i];
+      if (e->node == NULL || !e->valid) {
+	 continue;
+      }
+      e->keeper = Getpid();
+      xioresolve_collect(e);
+      if (xioresolve_expired(e) &&
+	  (e->helper == 0 || e->owner != Getpid())) {
+	 e->helper = 0;		/* forget the helper of our parent */
+	 xioresolve_start(e);
+      }
+   }
+}
+
+
+/* returns true when a and b are the same IPv4 or IPv6 address */
+static bool xiosameaddr(const struct sockaddr *a, const struct sockaddr *b) {
+   if (a->sa_family != b->sa_family)  return false;
+   switch (a->sa_family) {
+#if WITH_IP4
+   case PF_INET:
+      return ((struct sockaddr_in *)a)->sin_addr.s_addr ==
+	 ((struct sockaddr_in *)b)->sin_addr.s_addr;
+#endif /* WITH_IP4 */
+#if WITH_IP6
+   case PF_INET6:
+      return !memcmp(&((struct sockaddr_in6 *)a)->sin6_addr,
+		     &((struct sockaddr_in6 *)b)->sin6_addr,
+		     sizeof(struct in6_addr));
+#endif /* WITH_IP6 */
+   }
+   return false;
+}
+
+/* for option happy-eyeballs: resolves node to all of its addresses (at most
+   XIO_HAPPY_MAXADDRS) and writes them to the malloc'ed array *addrs in the
+   order of RFC 8305: first is the address xiogetaddrinfo() chose, the others
+   follow with alternating families. all get the port of first.
+   returns the number of addresses, at least 1 (just first) when node is
+   numeric or cannot be resolved, or -1 on malloc failure */
+int xiogetaddrinfo_all(const char *node, int family, int socktype,
+		       int protocol, const union sockaddr_union *first,
+		       union sockaddr_union **addrs,
+		       unsigned long res_opts0, unsigned long res_opts1) {
+   union sockaddr_union *list;
+   int num = 1;
+#if HAVE_GETADDRINFO
+   union sockaddr_union same[XIO_HAPPY_MAXADDRS], other[XIO_HAPPY_MAXADDRS];
+   int nsame = 0, nother = 0, isame = 0, iother = 0;
+   struct addrinfo hints = {0};
+   struct addrinfo *res = NULL, *record;
+   unsigned long save_res_opts = 0;
+   union sockaddr_union *sau;
+   uint16_t port = 0;	/* network byte order */
+   int i;
+   int error_num;
+#endif /* HAVE_GETADDRINFO */
+
+   if ((list = Malloc(XIO_HAPPY_MAXADDRS*sizeof(union sockaddr_union)))
+       == NULL) {
+      return -1;
+   }
+   memcpy(&list[0], first, sizeof(union sockaddr_union));
+   *addrs = list;
+
+#if HAVE_GETADDRINFO
+   if (node == NULL || node[0] == '[') {
+      return 1;		/* numeric IPv6 address */
+   }
+#if HAVE_RESOLV_H
+   if (res_opts0 | res_opts1) {
+      if (!(_res.options & RES_INIT)) {
+         Res_init();	/*!!! returns -1 on error */
+      }
+      save_res_opts = _res.options;
+      _res.options &= ~res_opts0;
+      _res.options |= res_opts1;
+   }
+#endif /* HAVE_RESOLV_H */
+   hints.ai_family = family;
+   hints.ai_socktype = socktype;
+   hints.ai_protocol = protocol;
+   error_num = Getaddrinfo(node, NULL, &hints, &res);
+#if HAVE_RESOLV_H
+   if (res_opts0 | res_opts1) {
+      _res.options = (_res.options & (~res_opts0&~res_opts1) |
+		      save_res_opts& ( res_opts0| res_opts1));
+   }
+#endif
+   if (error_num != 0) {
+      Info2("getaddrinfo(\"%s\", NULL, ...): %s", node,
+	    (error_num == EAI_SYSTEM)?strerror(errno):gai_strerror(error_num));
+      return 1;
+   }
+
+   for (record = res; record != NULL; record = record->ai_next) {
+      if (record->ai_family != PF_INET && record->ai_family != PF_INET6) {
+	 continue;
+      }
+      if (xiosameaddr(record->ai_addr, &first->soa)) {
+	 continue;
+      }
+      if (record->ai_family == first->soa.sa_family) {
+	 for (i = 0; i < nsame; ++i) {
+	    if (xiosameaddr(record->ai_addr, &same[i].soa))  break;
+	 }
+	 if (i < nsame || nsame >= XIO_HAPPY_MAXADDRS)  continue;
+	 sau = &same[nsame++];
+      } else {
+	 for (i = 0; i < nother; ++i) {
+	    if (xiosameaddr(record->ai_addr, &other[i].soa))  break;
+	 }
+	 if (i < nother || nother >= XIO_HAPPY_MAXADDRS)  continue;
+	 sau = &other[nother++];
+      }
+      memset(sau, 0, sizeof(*sau));
+      memcpy(sau, record->ai_addr,
+	     MIN(record->ai_addrlen, sizeof(union sockaddr_union)));
+   }
+   freeaddrinfo(res);
+
+   switch (first->soa.sa_family) {
+#if WITH_IP4
+   case PF_INET:  port = first->ip4.sin_port;  break;
+#endif
+#if WITH_IP6
+   case PF_INET6: port = first->ip6.sin6_port; break;
+#endif
+   }
+   /* first was of the same family, so start with the other one */
+   while (num < XIO_HAPPY_MAXADDRS && (iother < nother || isame < nsame)) {
+      if (iother < nother && (num%2 == 1 || isame >= nsame)) {
+	 sau = &other[iother++];
+      } else {
+	 sau = &same[isame++];
+      }
+      memcpy(&list[num], sau, sizeof(union sockaddr_union));
+      switch (sau->soa.sa_family) {
+#if WITH_IP4
+      case PF_INET:  list[num].ip4.sin_port  = port; break;
+#endif
+#if WITH_IP6
+      case PF_INET6: list[num].ip6.sin6_port = port; break;
+#endif
+      }
+      ++num;
+   }
+#endif /* HAVE_GETADDRINFO */
+   return num;
+}
+
+
 #if defined(HAVE_STRUCT_CMSGHDR) && defined(CMSG_DATA)
 /* Converts the ancillary message in *cmsg into a form useable for further
    processing. knows the specifics of common message types.
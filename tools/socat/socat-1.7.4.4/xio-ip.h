@@ -5,6 +5,8 @@
 #ifndef __xio_ip_h_included
 #define __xio_ip_h_included 1
 
+#define XIO_HAPPY_MAXADDRS 16	/* addresses tried with happy-eyeballs */
+
 extern const struct optdesc opt_ip_options;
 extern const struct optdesc opt_ip_pktinfo;
 extern const struct optdesc opt_ip_recvtos;
@@ -38,11 +40,30 @@ extern const struct optdesc opt_res_recurse;
 extern const struct optdesc opt_res_defnames;
 extern const struct optdesc opt_res_stayopen;
 extern const struct optdesc opt_res_dnsrch;
+extern const struct optdesc opt_resolve_ttl;
+extern const struct optdesc opt_resolve_neg_ttl;
+extern const struct optdesc opt_resolve_async;
+extern const struct optdesc opt_happy_eyeballs;
+extern const struct optdesc opt_happy_eyeballs_delay;
 
 extern int xiogetaddrinfo(const char *node, const char *service,
 			  int family, int socktype, int protocol,
 			  union sockaddr_union *sa, socklen_t *socklen,
 			  unsigned long res_opts0, unsigned long res_opts1);
+extern int xioresolve(const char *node, const char *service,
+		      int family, int socktype, int protocol,
+		      union sockaddr_union *sau, socklen_t *socklen,
+		      unsigned long res_opts0, unsigned long res_opts1,
+		      struct opt *opts);
+extern int xioresolve_update(const char *node, const char *service,
+			     int family, int socktype, int protocol,
+			     union sockaddr_union *sau, socklen_t *socklen,
+			     unsigned long res_opts0, unsigned long res_opts1);
+extern void xioresolve_refresh(void);
+extern int xiogetaddrinfo_all(const char *node, int family, int socktype,
+			      int protocol, const union sockaddr_union *first,
+			      union sockaddr_union **addrs,
+			      unsigned long res_opts0, unsigned long res_opts1);
 extern
 int xiolog_ancillary_ip(struct cmsghdr *cmsg, int *num,
 			char *typbuff, int typlen,
@@ -14,6 +14,7 @@
 #include "xio-listen.h"
 #include "xio-ip6.h"
 #include "xio-ipapp.h"
+#include "xio-preconnect.h"
 
 const struct optdesc opt_sourceport = { "sourceport", "sp",       OPT_SOURCEPORT,  GROUP_IPAPP,     PH_LATE,TYPE_2BYTE,	OFUNC_SPEC };
 /*const struct optdesc opt_port = { "port",  NULL,    OPT_PORT,        GROUP_IPAPP, PH_BIND,    TYPE_USHORT,	OFUNC_SPEC };*/
@@ -49,17 +50,34 @@ int xioopen_ipapp_connect(int argc, const char *argv[], struct opt *opts,
 
    retropt_bool(opts, OPT_FORK, &dofork);
 
-   if (_xioopen_ipapp_prepare(opts, &opts0, hostname, portname, &pf, ipproto,
+   if (!dofork && (xfd->fd = xiopreconnect_take(opts)) >= 0) {
+      return _xio_openlate(xfd, opts);
+   }
+
+   if (_xioopen_ipapp_prepare(xfd, opts, &opts0, hostname, portname,
+			      &pf, ipproto,
 			      xfd->para.socket.ip.res_opts[1],
 			      xfd->para.socket.ip.res_opts[0],
 			      them, &themlen, us, &uslen, &needbind, &lowport,
 			      socktype) != STAT_OK) {
       return STAT_NORETRY;
    }
+   /* like the other addresses, leave the options of the caller alone; the
+      frees below only release our copies */
+   if ((opts = copyopts(opts0, GROUP_ALL)) == NULL) {
+      free(opts0);
+      return STAT_NORETRY;
+   }
 
    if (dofork) {
       xiosetchilddied();	/* set SIGCHLD handler */
    }
+   /* the event loop must not wait for the connection; it takes the socket
+      while connect() is in progress */
+   if ((xioflags & XIO_MAYINPROGRESS) && socktype == SOCK_STREAM &&
+       !dofork && xfd->para.socket.ip.happy_num <= 1) {
+      xfd->flags |= XIO_DOESINPROGRESS;
+   }
 
    if (xioopts.logopt == 'm') {
       Info("starting connect loop, switching to syslog");
@@ -77,11 +95,23 @@ int xioopen_ipapp_connect(int argc, const char *argv[], struct opt *opts,
 #endif /* WITH_RETRY */
 	 level = E_ERROR;
 
-      result =
-	 _xioopen_connect(xfd,
-			  needbind?us:NULL, uslen,
-			  (struct sockaddr *)them, themlen,
-			  opts, pf, socktype, ipproto, lowport, level);
+      xioresolve_update(hostname, portname, pf, socktype, ipproto,
+			them, &themlen,
+			xfd->para.socket.ip.res_opts[1],
+			xfd->para.socket.ip.res_opts[0]);
+      if (xfd->para.socket.ip.happy_num > 1) {
+	 result =
+	    _xioopen_connect_happy(xfd, needbind?us:NULL, uslen,
+				   xfd->para.socket.ip.happy_addrs,
+				   xfd->para.socket.ip.happy_num,
+				   opts, socktype, ipproto, lowport, level);
+      } else {
+	 result =
+	    _xioopen_connect(xfd,
+			     needbind?us:NULL, uslen,
+			     (struct sockaddr *)them, themlen,
+			     opts, pf, socktype, ipproto, lowport, level);
+      }
       switch (result) {
       case STAT_OK: break;
 #if WITH_RETRY
@@ -149,10 +179,14 @@ int xioopen_ipapp_connect(int argc, const char *argv[], struct opt *opts,
 /* returns STAT_OK on success or some other value on failure
    applies and consumes the following options:
    PH_EARLY
-   OPT_PROTOCOL_FAMILY, OPT_BIND, OPT_SOURCEPORT, OPT_LOWPORT
+   OPT_PROTOCOL_FAMILY, OPT_BIND, OPT_SOURCEPORT, OPT_LOWPORT,
+   OPT_RESOLVE_TTL, OPT_RESOLVE_NEG_TTL, OPT_RESOLVE_ASYNC
+   with option happy-eyeballs (already applied to xfd) it resolves all
+   addresses of hostname to xfd->para.socket.ip.happy_addrs
  */
 int
-   _xioopen_ipapp_prepare(struct opt *opts, struct opt **opts0,
+   _xioopen_ipapp_prepare(struct single *xfd,
+			   struct opt *opts, struct opt **opts0,
 			   const char *hostname,
 			   const char *portname,
 			   int *pf,
@@ -164,16 +198,18 @@ int
 			   int socktype) {
    uint16_t port;
    char infobuff[256];
+   int reqpf;		/* the family requested, maybe PF_UNSPEC */
    int result;
 
    retropt_socket_pf(opts, pf);
+   reqpf = *pf;
 
    if ((result =
-	xiogetaddrinfo(hostname, portname,
-		       *pf, socktype, protocol,
-		       (union sockaddr_union *)them, themlen,
-		       res_opts0, res_opts1
-		       ))
+	xioresolve(hostname, portname,
+		   *pf, socktype, protocol,
+		   (union sockaddr_union *)them, themlen,
+		   res_opts0, res_opts1, opts
+		   ))
        != STAT_OK) {
       return STAT_NORETRY;	/*! STAT_RETRYLATER? */
    }
@@ -181,6 +217,20 @@ int
       *pf = them->soa.sa_family;
    }
 
+   if (xfd->para.socket.ip.happy_delay.tv_sec  != 0 ||
+       xfd->para.socket.ip.happy_delay.tv_usec != 0) {
+      xfd->para.socket.ip.happy = true;
+   }
+   if (xfd->para.socket.ip.happy && socktype == SOCK_STREAM &&
+       xfd->para.socket.ip.happy_addrs == NULL) {
+      xfd->para.socket.ip.happy_num =
+	 xiogetaddrinfo_all(hostname, reqpf, socktype, protocol, them,
+			    &xfd->para.socket.ip.happy_addrs,
+			    res_opts0, res_opts1);
+      Info2("happy-eyeballs: %d addresses of \"%s\"",
+	    xfd->para.socket.ip.happy_num, hostname);
+   }
+
    applyopts(-1, opts, PH_EARLY);
 
    /* 3 means: IP address AND port accepted */
@@ -220,6 +270,58 @@ int
 	   sockaddr_info((struct sockaddr *)them, *themlen, infobuff, sizeof(infobuff)));
    return STAT_OK;
 }
+
+/* when the parsed address tmpl is a TCP or SCTP connect address with option
+   resolve-ttl, resolves its host now and keeps the result in the cache of
+   xioresolve(), so the children of a forking first address do not ask the
+   resolver each.
+   call this function before opening the first address.
+   returns 0, or -1 on error */
+int xioresolve_prefetch(const xiofile_t *tmpl) {
+   xiofile_t *xfd;
+   struct single *sfd;
+   union sockaddr_union them;
+   socklen_t themlen = sizeof(them);
+   int pf;
+   int errlevel;
+   int i;
+
+   if (tmpl->tag == XIO_TAG_DUAL ||
+       tmpl->stream.addr->func != xioopen_ipapp_connect ||
+       tmpl->stream.argc != 3) {
+      return 0;
+   }
+   /* without resolve-ttl or resolve-neg-ttl there is no cache to fill */
+   for (i = 0; tmpl->stream.opts[i].desc != ODESC_END; ++i) {
+      if (tmpl->stream.opts[i].desc == &opt_resolve_ttl ||
+	  tmpl->stream.opts[i].desc == &opt_resolve_neg_ttl)
+	 break;
+   }
+   if (tmpl->stream.opts[i].desc == ODESC_END) {
+      return 0;
+   }
+   /* applying the options must not consume them in the template */
+   if ((xfd = xioclone(tmpl)) == NULL) {
+      return -1;
+   }
+   sfd = &xfd->stream;
+   pf = sfd->addr->arg3;
+   if (applyopts_single(sfd, sfd->opts, PH_INIT) < 0) {
+      free(sfd->opts);  free(xfd);
+      return -1;
+   }
+   retropt_socket_pf(sfd->opts, &pf);
+   /* a failure is reported by the process that opens the address */
+   errlevel = diag_get_int('e');
+   diag_set_int('e', E_FATAL);
+   xioresolve(sfd->argv[1], sfd->argv[2],
+	      pf, sfd->addr->arg1, sfd->addr->arg2, &them, &themlen,
+	      sfd->para.socket.ip.res_opts[1], sfd->para.socket.ip.res_opts[0],
+	      sfd->opts);
+   diag_set_int('e', errlevel);
+   free(sfd->opts);  free(xfd);
+   return 0;
+}
 #endif /* WITH_IP4 */
 
 
@@ -18,7 +18,8 @@ extern int xioopen_ipapp_connect(int argc, const char *argv[], struct opt *opts,
 			 unsigned groups, int socktype,
 			 int ipproto, int protname);
 extern int
-   _xioopen_ipapp_prepare(struct opt *opts, struct opt **opts0,
+   _xioopen_ipapp_prepare(struct single *xfd,
+			   struct opt *opts, struct opt **opts0,
 			   const char *hostname,
 			   const char *portname, int *pf, int protocol,
 			   unsigned long res_opts0, unsigned long res_opts1,
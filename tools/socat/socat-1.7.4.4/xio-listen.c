@@ -15,17 +15,32 @@
 #include "xio-ip4.h"
 #include "xio-listen.h"
 #include "xio-tcpwrap.h"
+#include "xio-acl.h"
 
 /***** LISTEN options *****/
 const struct optdesc opt_backlog = { "backlog",   NULL, OPT_BACKLOG,     GROUP_LISTEN, PH_LISTEN, TYPE_INT,    OFUNC_SPEC };
 const struct optdesc opt_fork    = { "fork",      NULL, OPT_FORK,        GROUP_CHILD,   PH_PASTACCEPT, TYPE_BOOL,  OFUNC_SPEC };
 const struct optdesc opt_max_children = { "max-children",      NULL, OPT_MAX_CHILDREN,        GROUP_CHILD,   PH_PASTACCEPT, TYPE_INT,  OFUNC_SPEC };
+#if HAVE_SYS_EPOLL_H
+const struct optdesc opt_event_loop = { "event-loop", NULL, OPT_EVENT_LOOP, GROUP_LISTEN, PH_PASTACCEPT, TYPE_BOOL, OFUNC_SPEC };
+#endif
+#ifdef SO_REUSEPORT
+const struct optdesc opt_workers = { "workers", NULL, OPT_WORKERS, GROUP_LISTEN, PH_PASTACCEPT, TYPE_INT, OFUNC_SPEC };
+#endif
+const struct optdesc opt_prefork     = { "prefork",     NULL, OPT_PREFORK,     GROUP_LISTEN, PH_PASTACCEPT, TYPE_INT, OFUNC_SPEC };
+const struct optdesc opt_prefork_max = { "prefork-max", NULL, OPT_PREFORK_MAX, GROUP_LISTEN, PH_PASTACCEPT, TYPE_INT, OFUNC_SPEC };
 /**/
 #if (WITH_UDP || WITH_TCP)
 const struct optdesc opt_range   = { "range",     NULL, OPT_RANGE,       GROUP_RANGE,  PH_ACCEPT, TYPE_STRING, OFUNC_SPEC };
 #endif
 const struct optdesc opt_accept_timeout = { "accept-timeout", "listen-timeout", OPT_ACCEPT_TIMEOUT, GROUP_LISTEN, PH_LISTEN, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.accept_timeout) };
 
+/* when set, the accept loop of _xioopen_listen() calls this function in the
+   listening process before each accept(), also after a signal interrupted
+   it. With option workers, the master passes SIGHUP to the workers then.
+   OPENSSL-LISTEN uses it to reload its context on SIGHUP */
+void (*xiolisten_hook)(struct single *xfd);
+
 
 /*
    applies and consumes the following option:
@@ -84,6 +99,344 @@ int
 }
 
 
+/* determines the addresses of the accepted socket ps and checks if the peer
+   is permitted (range, tcpwrap, sourceport, lowport).
+   *pa and *la are set to NULL when the address could not be determined.
+   Returns 0 when the connection is permitted, or -1 when it was rejected; in
+   this case ps has already been closed */
+static int _xioopen_accepted(struct single *xfd, int ps,
+			     union sockaddr_union **pa, socklen_t *pas,
+			     union sockaddr_union **la, socklen_t *las) {
+   char infobuff[256];
+   char peername[256];
+   char sockname[256];
+
+   if (Getpeername(ps, &(*pa)->soa, pas) < 0) {
+      Warn4("getpeername(%d, %p, {"F_socklen"}): %s",
+	    ps, *pa, *pas, strerror(errno));
+      *pa = NULL;
+   }
+   if (Getsockname(ps, &(*la)->soa, las) < 0) {
+      Warn4("getsockname(%d, %p, {"F_socklen"}): %s",
+	    ps, *la, *las, strerror(errno));
+      *la = NULL;
+   }
+   Notice2("accepting connection from %s on %s",
+	   *pa?
+	   sockaddr_info(&(*pa)->soa, *pas, peername, sizeof(peername)):"NULL",
+	   *la?
+	   sockaddr_info(&(*la)->soa, *las, sockname, sizeof(sockname)):"NULL");
+
+   if (*pa != NULL && *la != NULL && xiocheckpeer(xfd, *pa, *la) < 0) {
+      if (Shutdown(ps, 2) < 0) {
+	 Info2("shutdown(%d, 2): %s", ps, strerror(errno));
+      }
+      Close(ps);
+      return -1;
+   }
+
+   if (*pa != NULL)
+      Info1("permitting connection from %s",
+	    sockaddr_info((struct sockaddr *)*pa, *pas,
+			  infobuff, sizeof(infobuff)));
+   return 0;
+}
+
+
+#ifdef SO_REUSEPORT
+/* with option workers: index of this worker process, -1 in other processes */
+static int xiolisten_worker = -1;
+static pid_t xiolisten_master;		/* the process that forked the workers */
+static pid_t *xiolisten_workerpids;
+static int xiolisten_numworkers;
+
+/* atexit handler of the master process: terminate the worker processes */
+static void _xioopen_listen_killworkers(void) {
+   int i;
+
+   if (Getpid() != xiolisten_master) {
+      return;	/* a worker or one of its children */
+   }
+   for (i = 0; i < xiolisten_numworkers; ++i) {
+      if (xiolisten_workerpids[i] > 0) {
+	 Kill(xiolisten_workerpids[i], SIGTERM);
+      }
+   }
+}
+
+/* SIGHUP handler of the master process when the listener reloads something on
+   SIGHUP (xiolisten_hook, allow-file, deny-file): pass the signal to the
+   workers */
+static void _xioopen_listen_hupworkers(int signum) {
+   int i, _errno;
+
+   _errno = errno;
+   diag_in_handler = 1;
+   for (i = 0; i < xiolisten_numworkers; ++i) {
+      if (xiolisten_workerpids[i] > 0) {
+	 Kill(xiolisten_workerpids[i], signum);
+      }
+   }
+   diag_in_handler = 0;
+   errno = _errno;
+}
+
+/* option workers: forks the worker processes that each create their own
+   listening socket with SO_REUSEPORT, so the kernel distributes incoming
+   connections among them and each of them accepts and serves connections
+   independently. The master process only waits for the workers and
+   terminates them when it exits itself; it does not return from this
+   function.
+   With hup the master passes SIGHUP to the workers.
+   Returns the index of the worker (0..workers-1) in the worker process, or -1
+   when no worker could be started */
+static int _xioopen_listen_workers(int workers, bool hup, int level) {
+   int i, alive = 0, exitcode = 0, status;
+   pid_t pid;
+
+   if (xiolisten_worker >= 0) {
+      return xiolisten_worker;	/* retry in a worker process */
+   }
+   if ((xiolisten_workerpids = Calloc(workers, sizeof(pid_t))) == NULL) {
+      return -1;
+   }
+   xiolisten_numworkers = workers;
+   xiolisten_master = Getpid();
+   Atexit(_xioopen_listen_killworkers);
+
+   for (i = 0; i < workers; ++i) {
+      if ((pid = xio_fork(false, level)) < 0) {
+	 break;
+      }
+      if (pid == 0) {
+	 xiolisten_worker = i;
+	 Info2("worker %d of %d", i+1, workers);
+	 return i;
+      }
+      xiolisten_workerpids[i] = pid;
+      ++alive;
+   }
+   if (alive == 0) {
+      return -1;
+   }
+   if (hup) {
+      struct sigaction act;
+      memset(&act, 0, sizeof(act));
+      act.sa_handler = _xioopen_listen_hupworkers;
+      sigfillset(&act.sa_mask);
+      Sigaction(SIGHUP, &act, NULL);
+   }
+
+   while (alive > 0) {
+      if ((pid = Waitpid(-1, &status, 0)) < 0) {
+	 if (errno == EINTR)  continue;
+	 Warn2("waitpid(-1, %p, 0): %s", &status, strerror(errno));
+	 break;
+      }
+      for (i = 0; i < workers; ++i) {
+	 if (xiolisten_workerpids[i] == pid)  break;
+      }
+      if (i == workers) {
+	 continue;
+      }
+      xiolisten_workerpids[i] = 0;
+      --alive;
+      if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+	 Info2("worker process "F_pid" (%d) terminated", pid, i+1);
+      } else {
+	 Warn3("worker process "F_pid" (%d) terminated with status 0x%x",
+	       pid, i+1, status);
+	 exitcode = 1;
+      }
+   }
+   Exit(exitcode);
+   return -1;	/* not reached */
+}
+#endif /* SO_REUSEPORT */
+
+
+/* with option prefork: the pipe through which idle children report to the
+   pool process that they accepted a connection. an idle child keeps only the
+   write end, a busy one none */
+static int xiolisten_preforkpipe[2] = { -1, -1 };
+static pid_t xiolisten_preforkmaster;	/* the pool process */
+static pid_t *xiolisten_idlepids;	/* its idle children */
+static int xiolisten_numidle;
+
+/* atexit handler of the pool process: terminate the idle children; the busy
+   ones finish their connections like the children of option fork */
+static void _xioopen_listen_killidle(void) {
+   int i;
+
+   if (Getpid() != xiolisten_preforkmaster) {
+      return;
+   }
+   for (i = 0; i < xiolisten_numidle; ++i) {
+      Kill(xiolisten_idlepids[i], SIGTERM);
+   }
+}
+
+/* SIGHUP handler of the pool process when the listener reloads something on
+   SIGHUP: pass the signal to the idle children; the busy ones have the SIGHUP
+   handling of socat. it counts the signal too, so a child started later reads
+   the files again */
+static void _xioopen_listen_hupidle(int signum) {
+   int i, _errno;
+
+   _errno = errno;
+   diag_in_handler = 1;
+   ++xio_sighup_count;
+   for (i = 0; i < xiolisten_numidle; ++i) {
+      Kill(xiolisten_idlepids[i], signum);
+   }
+   diag_in_handler = 0;
+   errno = _errno;
+}
+
+/* the child is busy or has terminated, in both cases it is not idle */
+static void _xioopen_listen_prefork_notidle(pid_t pid) {
+   int i;
+
+   for (i = 0; i < xiolisten_numidle; ++i) {
+      if (xiolisten_idlepids[i] == pid) {
+	 xiolisten_idlepids[i] = xiolisten_idlepids[--xiolisten_numidle];
+	 break;
+      }
+   }
+}
+
+/* in an idle child of option prefork that accepted a connection: tell the
+   pool process to start a new idle child */
+static void _xioopen_listen_prefork_busy(void) {
+   pid_t pid = Getpid();
+
+   if (Write(xiolisten_preforkpipe[1], &pid, sizeof(pid)) < 0) {
+      Warn2("write(%d, ...): %s", xiolisten_preforkpipe[1], strerror(errno));
+   }
+   Close(xiolisten_preforkpipe[1]);
+   xiolisten_preforkpipe[1] = -1;
+   Info1("just born: child process "F_pid, pid);
+   xiosetenvulong("PID", pid, 1);
+   xio_sighup_reset();	/* the pool process no longer passes SIGHUP here */
+}
+
+/* option prefork: keeps prefork idle children that block in accept() on the
+   listening socket, so a connection does not wait for fork(). an idle child
+   that accepted a connection serves it and terminates; it reports through a
+   pipe that it is busy, and xiochildreap() reports terminated children
+   through xiochilddied_hook. the pool process then starts new children until
+   prefork of them are idle again or preforkmax children exist (0: no limit).
+   With hup the pool process passes SIGHUP to the idle children.
+   The pool process does not return from this function.
+   Returns 0 in the child process, or -1 when no child could be started */
+static int _xioopen_listen_prefork(int prefork, int preforkmax, bool hup,
+				   int level) {
+   struct pollfd fds[2];
+   pid_t pid;
+   ssize_t bytes;
+
+   if (Pipe(xiolisten_preforkpipe) < 0) {
+      Error2("pipe(%p): %s", xiolisten_preforkpipe, strerror(errno));
+      return -1;
+   }
+   /* a busy child must never block on it */
+   Fcntl_l(xiolisten_preforkpipe[1], F_SETFL,
+	   Fcntl(xiolisten_preforkpipe[1], F_GETFL)|O_NONBLOCK);
+   if ((xiolisten_idlepids = Calloc(prefork, sizeof(pid_t))) == NULL) {
+      return -1;
+   }
+   xiolisten_preforkmaster = Getpid();
+   Atexit(_xioopen_listen_killidle);
+   xiochilddied_hook = _xioopen_listen_prefork_notidle;
+   if (hup) {
+      struct sigaction act;
+      memset(&act, 0, sizeof(act));
+      act.sa_handler = _xioopen_listen_hupidle;
+      sigfillset(&act.sa_mask);
+      Sigaction(SIGHUP, &act, NULL);
+   }
+
+   while (true) {
+      xiochildreap();
+      while (xiolisten_numidle < prefork &&
+	     (preforkmax == 0 || num_child < preforkmax)) {
+	 if ((pid = xio_fork(false, level==E_ERROR?level:E_WARN)) < 0) {
+	    if (num_child == 0) {
+	       return -1;
+	    }
+	    break;	/* try again when a child terminated */
+	 }
+	 if (pid == 0) {	/* child */
+	    xiochilddied_hook = NULL;
+	    Close(xiolisten_preforkpipe[0]);
+	    xiolisten_preforkpipe[0] = -1;
+	    free(xiolisten_idlepids);  xiolisten_idlepids = NULL;
+	    xiolisten_numidle = 0;
+	    return 0;
+	 }
+	 xiolisten_idlepids[xiolisten_numidle++] = pid;
+	 Info2("prefork: started child "F_pid", %d idle",
+	       pid, xiolisten_numidle);
+      }
+      if (xiolisten_numidle < prefork) {
+	 Notice1("prefork: %d children are active, waiting", num_child);
+      }
+
+      fds[0].fd = xiolisten_preforkpipe[0];
+      fds[0].events = POLLIN;
+      fds[1].fd = xiochildfd();
+      fds[1].events = POLLIN;
+      if (Poll(fds, 2, -1) < 0) {
+	 if (errno == EINTR)  continue;
+	 Error3("poll({%d,POLLIN}{%d,POLLIN}, 2, -1): %s",
+		fds[0].fd, fds[1].fd, strerror(errno));
+	 Exit(1);
+      }
+      if (!(fds[0].revents & (POLLIN|POLLHUP))) {
+	 continue;	/* a child terminated */
+      }
+      bytes = Read(xiolisten_preforkpipe[0], &pid, sizeof(pid));
+      if (bytes < 0) {
+	 if (errno == EINTR)  continue;
+	 Error4("read(%d, %p, "F_Zu"): %s", xiolisten_preforkpipe[0], &pid,
+		sizeof(pid), strerror(errno));
+	 Exit(1);
+      }
+      if (bytes != sizeof(pid)) {
+	 continue;
+      }
+      _xioopen_listen_prefork_notidle(pid);
+   }
+   return -1;	/* not reached */
+}
+
+
+/* waits until the listening socket fd becomes readable, a child terminated,
+   or a SIGHUP arrived, so the accept loop reaps the child or reloads before it
+   accepts. the listening socket is non-blocking, so another process that
+   accepted the connection first does not block us in accept().
+   returns 1 when fd is readable, else 0 */
+static int _xioopen_listen_poll(int fd) {
+   struct pollfd fds[3];
+
+   fds[0].fd = fd;
+   fds[0].events = POLLIN;
+   fds[1].fd = xiochildfd();
+   fds[1].events = POLLIN;
+   fds[2].fd = xio_sighup_fd();
+   fds[2].events = POLLIN;
+   if (xiopoll(fds, 3, NULL) < 0) {
+      if (errno != EINTR) {
+	 Warn4("poll({%d,POLLIN}{%d,POLLIN}{%d,POLLIN}, 3, -1): %s",
+	       fds[0].fd, fds[1].fd, fds[2].fd, strerror(errno));
+	 return 1;	/* let accept() report the problem */
+      }
+      return 0;
+   }
+   return (fds[0].revents & (POLLIN|POLLERR|POLLHUP)) != 0;
+}
+
+
 /* creates the listening socket, bind, applies options; waits for incoming
    connection, checks its source address and port. Depending on fork option, it
    may fork a subprocess.
@@ -92,6 +445,8 @@ int
    from us->af_family; for other socket types pf == us->af_family
    Returns 0 if a connection was accepted; with fork option, this is always in
    a subprocess!
+   With option event-loop it returns 0 with the listening socket in xfd->fd;
+   the application then accepts the connections with xioaccept().
    Other return values indicate a problem; this can happen in the master
    process or in a subprocess.
    This function does not retry. If you need retries, handle this in a
@@ -110,7 +465,11 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
    int backlog = 5;	/* why? 1 seems to cause problems under some load */
    char *rangename;
    bool dofork = false;
+   bool doeventloop = false;
    int maxchildren = 0;
+   int workers = 0;
+   int prefork = 0, preforkmax = 0;
+   bool hup;	/* the listener reloads something on SIGHUP */
    char infobuff[256];
    char lisname[256];
    union sockaddr_union _peername;
@@ -131,13 +490,87 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
       xfd->flags |= XIO_DOESFORK;
    }
 
+#if HAVE_SYS_EPOLL_H
+   retropt_bool(opts, OPT_EVENT_LOOP, &doeventloop);
+#endif
+
+   if (doeventloop) {
+      if (!(xioflags & XIO_MAYEVENTLOOP)) {
+	 Error("option event-loop not allowed here");
+	 return STAT_NORETRY;
+      }
+      if (dofork) {
+	 Error("options fork and event-loop are mutually exclusive");
+	 return STAT_NORETRY;
+      }
+      xfd->flags |= XIO_DOESEVENTLOOP;
+   }
+
    retropt_int(opts, OPT_MAX_CHILDREN, &maxchildren);
 
-   if (! dofork && maxchildren) {
-       Error("option max-children not allowed without option fork");
+   if (! dofork && ! doeventloop && maxchildren) {
+       Error("option max-children not allowed without option fork or event-loop");
        return STAT_NORETRY;
    }
 
+   /* before workers and prefork, so their processes inherit the lists */
+   if (xio_retropt_acl(xfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+   hup = (xiolisten_hook != NULL || xfd->para.socket.acl != NULL);
+
+#ifdef SO_REUSEPORT
+   retropt_int(opts, OPT_WORKERS, &workers);
+   if (workers > 1) {
+      int worker;
+
+      if (! dofork && ! doeventloop) {
+	 Error("option workers not allowed without option fork or event-loop");
+	 return STAT_NORETRY;
+      }
+      if (us->sa_family != AF_INET
+#if WITH_IP6
+	  && us->sa_family != AF_INET6
+#endif
+	  ) {
+	 Error("option workers requires an IP listen address");
+	 return STAT_NORETRY;
+      }
+      if (maxchildren && maxchildren < workers) {
+	 Error2("max-children=%d is less than workers=%d", maxchildren, workers);
+	 return STAT_NORETRY;
+      }
+      if ((worker = _xioopen_listen_workers(workers, hup, level)) < 0) {
+	 return STAT_RETRYLATER;
+      }
+      xioacl_arm(xfd->para.socket.acl);
+      /* each worker gets its share of max-children, so the sum of the
+	 connections in all workers does not exceed the given value */
+      if (maxchildren) {
+	 maxchildren = maxchildren/workers + (worker < maxchildren%workers);
+      }
+   }
+#endif /* SO_REUSEPORT */
+
+   retropt_int(opts, OPT_PREFORK, &prefork);
+   retropt_int(opts, OPT_PREFORK_MAX, &preforkmax);
+   if (prefork > 0) {
+      if (! dofork) {
+	 Error("option prefork not allowed without option fork");
+	 return STAT_NORETRY;
+      }
+      if (preforkmax == 0) {
+	 preforkmax = maxchildren;
+      }
+      if (preforkmax && preforkmax < prefork) {
+	 Error2("prefork-max=%d is less than prefork=%d", preforkmax, prefork);
+	 return STAT_NORETRY;
+      }
+   } else if (preforkmax) {
+      Error("option prefork-max not allowed without option prefork");
+      return STAT_NORETRY;
+   }
+
    if (applyopts_single(xfd, opts, PH_INIT) < 0)  return -1;
 
    if (dofork) {
@@ -152,6 +585,18 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
    applyopts_offset(xfd, opts);
    applyopts_cloexec(xfd->fd, opts);
 
+#ifdef SO_REUSEPORT
+   if (workers > 1) {
+      int one = 1;
+      if (Setsockopt(xfd->fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+	 Error2("setsockopt(%d, SOL_SOCKET, SO_REUSEPORT, {1}): %s",
+		xfd->fd, strerror(errno));
+	 Close(xfd->fd);
+	 return STAT_NORETRY;
+      }
+   }
+#endif /* SO_REUSEPORT */
+
    applyopts(xfd->fd, opts, PH_PREBIND);
    applyopts(xfd->fd, opts, PH_BIND);
    if (Bind(xfd->fd, (struct sockaddr *)us, uslen) < 0) {
@@ -230,17 +675,45 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
    } else {
       Info("starting accept loop");
    }
+
+   if (doeventloop) {
+      /* the application calls xioaccept() when the socket becomes readable;
+	 keep the remaining options for the accepted sockets */
+      Notice1("listening on %s", sockaddr_info(us, uslen, lisname, sizeof(lisname)));
+      if (Fcntl_l(xfd->fd, F_SETFL, Fcntl(xfd->fd, F_GETFL)|O_NONBLOCK) < 0) {
+	 Warn2("fcntl(%d, F_SETFL, O_NONBLOCK): %s", xfd->fd, strerror(errno));
+      }
+      xfd->para.socket.evloop.opts     = copyopts(opts, GROUP_ALL);
+      xfd->para.socket.evloop.maxconns = maxchildren;
+      xfd->para.socket.evloop.proto    = proto;
+      dropopts(opts, PH_ALL);
+      return 0;
+   }
+   if (Fcntl_l(xfd->fd, F_SETFL, Fcntl(xfd->fd, F_GETFL)|O_NONBLOCK) < 0) {
+      Warn2("fcntl(%d, F_SETFL, O_NONBLOCK): %s", xfd->fd, strerror(errno));
+   }
+   if (prefork > 0) {
+      if (_xioopen_listen_prefork(prefork, preforkmax, hup, level) < 0) {
+	 Close(xfd->fd);
+	 return STAT_RETRYLATER;
+      }
+      xioacl_arm(xfd->para.socket.acl);
+      /* idle child: accept one connection and serve it */
+      dofork = false;
+#if WITH_RETRY
+      xfd->forever = false;  xfd->retry = 0;
+      level = E_ERROR;
+#endif /* WITH_RETRY */
+   }
    while (true) {	/* but we only loop if fork option is set */
-      char peername[256];
-      char sockname[256];
       int ps;		/* peer socket */
 
       pa = &_peername;
       la = &_sockname;
       salen = sizeof(struct sockaddr);
+      Notice1("listening on %s", sockaddr_info(us, uslen, lisname, sizeof(lisname)));
       do {
 	 /*? int level = E_ERROR;*/
-	 Notice1("listening on %s", sockaddr_info(us, uslen, lisname, sizeof(lisname)));
 	 if (xfd->para.socket.accept_timeout.tv_sec > 0 ||
 	     xfd->para.socket.accept_timeout.tv_usec > 0) {
 	    fd_set rfd;
@@ -286,13 +759,30 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
 	       Exit(0);
 	    }
 	 }
+	 xio_sighup_drain();	/* before the hook looks at the count */
+	 if (xiolisten_hook != NULL) {
+	    xiolisten_hook(xfd);
+	 }
+#if _WITH_IP4 || _WITH_IP6
+	 xioresolve_refresh();	/* for the connect address of the children */
+#endif
+	 xiochildreap();	/* e.g. after EINTR */
+	 if (!_xioopen_listen_poll(xfd->fd)) {
+	    continue;
+	 }
 	 ps = Accept(xfd->fd, (struct sockaddr *)&sa, &salen);
 	 if (ps >= 0) {
 	    /*0 Info4("accept(%d, %p, {"F_Zu"}) -> %d", xfd->fd, &sa, salen, ps);*/
+	    /* on some systems it inherits O_NONBLOCK of the listening socket */
+	    Fcntl_l(ps, F_SETFL, Fcntl(ps, F_GETFL)&~O_NONBLOCK);
 	    break;	/* success, break out of loop */
 	 }
-	 if (errno == EINTR) {
-	    continue;
+	 if (errno == EINTR || errno == EAGAIN
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+	     || errno == EWOULDBLOCK
+#endif
+	     ) {
+	    continue;	/* e.g. another idle child of prefork was faster */
 	 }
 	 if (errno == ECONNABORTED) {
 	    Notice4("accept(%d, %p, {"F_socklen"}): %s",
@@ -305,35 +795,10 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
 	 return STAT_RETRYLATER;
       } while (true);
       applyopts_cloexec(ps, opts);
-      if (Getpeername(ps, &pa->soa, &pas) < 0) {
-	 Warn4("getpeername(%d, %p, {"F_socklen"}): %s",
-	       ps, pa, pas, strerror(errno));
-	 pa = NULL;
-      }
-      if (Getsockname(ps, &la->soa, &las) < 0) {
-	 Warn4("getsockname(%d, %p, {"F_socklen"}): %s",
-	       ps, la, las, strerror(errno));
-	 la = NULL;
-      }
-      Notice2("accepting connection from %s on %s",
-	      pa?
-	      sockaddr_info(&pa->soa, pas, peername, sizeof(peername)):"NULL",
-	      la?
-	      sockaddr_info(&la->soa, las, sockname, sizeof(sockname)):"NULL");
-
-      if (pa != NULL && la != NULL && xiocheckpeer(xfd, pa, la) < 0) {
-	 if (Shutdown(ps, 2) < 0) {
-	    Info2("shutdown(%d, 2): %s", ps, strerror(errno));
-	 }
-	 Close(ps);
+      if (_xioopen_accepted(xfd, ps, &pa, &pas, &la, &las) < 0) {
 	 continue;
       }
 
-      if (pa != NULL)
-	 Info1("permitting connection from %s",
-	       sockaddr_info((struct sockaddr *)pa, pas,
-			     infobuff, sizeof(infobuff)));
-
       if (dofork) {
 	 pid_t pid;	/* mostly int; only used with fork */
          sigset_t mask_sigchld;
@@ -384,14 +849,16 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
          Sigprocmask(SIG_UNBLOCK, &mask_sigchld, NULL);
 
 	 while (maxchildren) {
+	    xiochildreap();
 	    if (num_child < maxchildren) break;
 	    Notice("maxchildren are active, waiting");
-	    /* UINT_MAX would even be nicer, but Openindiana works only
-	       with 31 bits */
-	    while (!Sleep(INT_MAX)) ;	/* any signal lets us continue */
+	    xiochildwait();
 	 }
 	 Info("still listening");
       } else {
+	 if (xiolisten_preforkpipe[1] >= 0) {
+	    _xioopen_listen_prefork_busy();
+	 }
 	 if (Close(xfd->fd) < 0) {
 	    Info2("close(%d): %s", xfd->fd, strerror(errno));
 	 }
@@ -413,4 +880,105 @@ int _xioopen_listen(struct single *xfd, int xioflags, struct sockaddr *us, sockl
    return 0;
 }
 
+
+/* accepts one connection on a listening address that was opened with option
+   event-loop, checks the peer and applies the remaining options to the new
+   socket.
+   Like accept(), it waits for a connection, so call it when the listening
+   socket is readable.
+   Returns a new xio descriptor for the connection, or NULL: errno EAGAIN
+   means that the connection was aborted or that the peer was rejected. */
+xiofile_t *xioaccept(xiofile_t *sock) {
+   struct single *xfd = &sock->stream;
+   xiofile_t *nfd;
+   struct opt *opts;
+   union sockaddr_union _peername;
+   union sockaddr_union _sockname;
+   union sockaddr_union *pa = &_peername;	/* peer address */
+   union sockaddr_union *la = &_sockname;	/* local address */
+   socklen_t pas = sizeof(_peername);	/* peer address size */
+   socklen_t las = sizeof(_sockname);	/* local address size */
+   union sockaddr_union sa;
+   socklen_t salen;
+   int ps;		/* peer socket */
+   int _errno;
+
+   if (sock->tag == XIO_TAG_DUAL || !(xfd->flags & XIO_DOESEVENTLOOP)) {
+      Error1("xioaccept(): descriptor %p is not an event-loop listener", sock);
+      errno = EINVAL;
+      return NULL;
+   }
+
+   do {
+      salen = sizeof(sa);
+      ps = Accept(xfd->fd, &sa.soa, &salen);
+   } while (ps < 0 && errno == EINTR);
+   if (ps < 0) {
+      _errno = errno;
+      switch (_errno) {
+      case EAGAIN:
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+      case EWOULDBLOCK:
+#endif
+	 break;
+      case ECONNABORTED:
+	 Notice4("accept(%d, %p, {"F_socklen"}): %s",
+		 xfd->fd, &sa, salen, strerror(_errno));
+	 break;
+      default:
+	 Warn4("accept(%d, %p, {"F_socklen"}): %s",
+	       xfd->fd, &sa, salen, strerror(_errno));
+	 errno = _errno;
+	 return NULL;
+      }
+      errno = EAGAIN;
+      return NULL;
+   }
+
+   opts = copyopts(xfd->para.socket.evloop.opts, GROUP_ALL);
+   applyopts_cloexec(ps, opts);
+   if (_xioopen_accepted(xfd, ps, &pa, &pas, &la, &las) < 0) {
+      free(opts);
+      errno = EAGAIN;
+      return NULL;
+   }
+
+   if ((nfd = Malloc(sizeof(xiofile_t))) == NULL) {
+      Close(ps);
+      free(opts);
+      return NULL;
+   }
+   /* the connection inherits the data type and end handling of the
+      listener, but not its cleanup duties */
+   memcpy(nfd, sock, sizeof(xiofile_t));
+   nfd->stream.flags &= ~XIO_DOESEVENTLOOP;
+   nfd->stream.fd = ps;
+   nfd->stream.opts = NULL;
+   nfd->stream.havelock = false;
+   nfd->stream.opt_unlink_close = false;
+   nfd->stream.unlink_close = NULL;
+   nfd->stream.para.socket.evloop.opts = NULL;
+
+   applyopts(ps, opts, PH_FD);
+   applyopts(ps, opts, PH_PASTSOCKET);
+   applyopts(ps, opts, PH_CONNECTED);
+   if (_xio_openlate(&nfd->stream, opts) < 0) {
+      _errno = errno;
+      Close(ps);
+      free(nfd);
+      free(opts);
+      errno = _errno;
+      return NULL;
+   }
+   free(opts);
+
+   /* set the env vars describing the local and remote sockets */
+   if (la != NULL)
+      xiosetsockaddrenv("SOCK", la, las, xfd->para.socket.evloop.proto);
+   if (pa != NULL)
+      xiosetsockaddrenv("PEER", pa, pas, xfd->para.socket.evloop.proto);
+
+   return nfd;
+}
+
 #endif /* WITH_LISTEN */
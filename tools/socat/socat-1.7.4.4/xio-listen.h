@@ -8,6 +8,10 @@
 extern const struct optdesc opt_backlog;
 extern const struct optdesc opt_fork;
 extern const struct optdesc opt_max_children;
+extern const struct optdesc opt_event_loop;
+extern const struct optdesc opt_workers;
+extern const struct optdesc opt_prefork;
+extern const struct optdesc opt_prefork_max;
 extern const struct optdesc opt_range;
 extern const struct optdesc opt_accept_timeout;
 
@@ -20,4 +24,6 @@ int _xioopen_listen(struct single *fd, int xioflags,
 		    struct sockaddr *us, socklen_t uslen,
 		 struct opt *opts, int pf, int socktype, int proto, int level);
 
+extern void (*xiolisten_hook)(struct single *xfd);
+
 #endif /* !defined(__xio_listen_h_included) */
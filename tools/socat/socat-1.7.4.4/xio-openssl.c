@@ -15,6 +15,7 @@
 #include "xio-socket.h"	/* _xioopen_connect() */
 #include "xio-listen.h"
 #include "xio-udp.h"
+#include "xio-ip.h"
 #include "xio-ipapp.h"
 #include "xio-ip6.h"
 
@@ -58,6 +59,13 @@ static int openssl_handle_peer_certificate(struct single *xfd,
 static int xioSSL_set_fd(struct single *xfd, int level);
 static int xioSSL_connect(struct single *xfd, const char *opt_commonname, bool opt_ver, int level);
 static int openssl_delete_cert_info(void);
+static int openssl_session_cache(SSL_CTX *ctx, bool server, char *filename);
+static void openssl_session_load(SSL *ssl, const char *snihost);
+static void openssl_ktls_check(struct single *xfd);
+static void openssl_reload_prepare(struct opt *opts, bool opt_ver,
+				   const char *opt_cert, bool use_dtls);
+static void openssl_reload_hook(struct single *xfd);
+static void openssl_reload_reset(void);
 
 
 /* description record for ssl connect */
@@ -126,6 +134,7 @@ const struct optdesc opt_openssl_cafile      = { "openssl-cafile",     "cafile",
 const struct optdesc opt_openssl_capath      = { "openssl-capath",     "capath", OPT_OPENSSL_CAPATH,      GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 const struct optdesc opt_openssl_egd         = { "openssl-egd",        "egd",    OPT_OPENSSL_EGD,         GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 const struct optdesc opt_openssl_pseudo      = { "openssl-pseudo",     "pseudo", OPT_OPENSSL_PSEUDO,      GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
+const struct optdesc opt_openssl_ktls        = { "openssl-ktls",       "ktls",   OPT_OPENSSL_KTLS,        GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L && !defined(OPENSSL_NO_COMP)
 const struct optdesc opt_openssl_compress    = { "openssl-compress",   "compress", OPT_OPENSSL_COMPRESS,  GROUP_OPENSSL, PH_SPEC, TYPE_STRING,   OFUNC_SPEC };
 #endif
@@ -137,6 +146,7 @@ const struct optdesc opt_openssl_commonname  = { "openssl-commonname", "cn",
 const struct optdesc opt_openssl_no_sni      = { "openssl-no-sni",    "nosni",   OPT_OPENSSL_NO_SNI,      GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
 const struct optdesc opt_openssl_snihost     = { "openssl-snihost",   "snihost", OPT_OPENSSL_SNIHOST,     GROUP_OPENSSL, PH_SPEC, TYPE_STRING,   OFUNC_SPEC };
 #endif
+const struct optdesc opt_openssl_session_cache = { "openssl-session-cache", "session-cache", OPT_OPENSSL_SESSION_CACHE, GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 
 
 /* If FIPS is compiled in, we need to track if the user asked for FIPS mode.
@@ -175,6 +185,8 @@ static void openssl_conn_loginfo(SSL *ssl) {
    Notice1("SSL connection using %s", string);
    xiosetenv("OPENSSL_CIPHER", string, 1, NULL);
 
+   Notice1("SSL session %s", SSL_session_reused(ssl)?"resumed":"negotiated");
+
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L && !defined(OPENSSL_NO_COMP)
    {
       const COMP_METHOD *comp, *expansion;
@@ -290,7 +302,8 @@ static int
    retropt_int(opts, OPT_SO_PROTOTYPE, &ipproto);
 
    result =
-      _xioopen_ipapp_prepare(opts, &opts0, hostname, portname, &pf, ipproto,
+      _xioopen_ipapp_prepare(xfd, opts, &opts0, hostname, portname,
+			     &pf, ipproto,
 			     xfd->para.socket.ip.res_opts[1],
 			     xfd->para.socket.ip.res_opts[0],
 			     them, &themlen, us, &uslen,
@@ -313,12 +326,24 @@ static int
 #endif /* WITH_RETRY */
 	 level = E_ERROR;
 
+      xioresolve_update(hostname, portname, pf, socktype, ipproto,
+			them, &themlen,
+			xfd->para.socket.ip.res_opts[1],
+			xfd->para.socket.ip.res_opts[0]);
       /* this cannot fork because we retrieved fork option above */
-      result =
-	 _xioopen_connect(xfd,
-			  needbind?us:NULL, uslen,
-			  (struct sockaddr *)them, themlen,
-			  opts, pf, socktype, ipproto, lowport, level);
+      if (xfd->para.socket.ip.happy_num > 1) {
+	 result =
+	    _xioopen_connect_happy(xfd, needbind?us:NULL, uslen,
+				   xfd->para.socket.ip.happy_addrs,
+				   xfd->para.socket.ip.happy_num,
+				   opts, socktype, ipproto, lowport, level);
+      } else {
+	 result =
+	    _xioopen_connect(xfd,
+			     needbind?us:NULL, uslen,
+			     (struct sockaddr *)them, themlen,
+			     opts, pf, socktype, ipproto, lowport, level);
+      }
       switch (result) {
       case STAT_OK: break;
 #if WITH_RETRY
@@ -400,6 +425,7 @@ static int
    } while (true);	/* drop out on success */
 
    openssl_conn_loginfo(xfd->para.openssl.ssl);
+   openssl_ktls_check(xfd);
 
    free((void *)opt_commonname);
    free((void *)opt_snihost);
@@ -453,6 +479,8 @@ int _xioopen_openssl_connect(struct single *xfd,
    }
 #endif
 
+   openssl_session_load(ssl, no_sni?NULL:snihost);
+
    result = xioSSL_connect(xfd, opt_commonname, opt_ver, level);
    if (result != STAT_OK) {
       sycSSL_free(xfd->para.openssl.ssl);
@@ -541,6 +569,8 @@ static int
 
    applyopts(-1, opts, PH_EARLY);
 
+   /* the options for building the context again on SIGHUP */
+   openssl_reload_prepare(opts, opt_ver, opt_cert, use_dtls);
    result =
       _xioopen_openssl_prepare(opts, xfd, true, &opt_ver, opt_cert, &ctx, &use_dtls);
    if (result != STAT_OK)  return STAT_NORETRY;
@@ -574,7 +604,9 @@ static int
       /* this can fork() for us; it only returns on error or on
 	 successful establishment of connection */
       if (ipproto == IPPROTO_TCP) {
-	 result = _xioopen_listen(xfd, xioflags,
+	 /* the TLS handshake requires a process per connection */
+	 xiolisten_hook = openssl_reload_hook;
+	 result = _xioopen_listen(xfd, xioflags&~XIO_MAYEVENTLOOP,
 			       (struct sockaddr *)us, uslen,
 			       opts, pf, socktype, ipproto,
 #if WITH_RETRY
@@ -583,9 +615,11 @@ static int
 			       E_ERROR
 #endif /* WITH_RETRY */
 			       );
+	 xiolisten_hook = NULL;
+	 openssl_reload_reset();
 #if WITH_UDP
       } else {
-	 result = _xioopen_ipdgram_listen(xfd, xioflags,
+	 result = _xioopen_ipdgram_listen(xfd, xioflags&~XIO_MAYEVENTLOOP,
 		us, uslen, opts, pf, socktype, ipproto);
 #endif /* WITH_UDP */
       }
@@ -610,6 +644,8 @@ static int
 	 return result;
       }
 
+      /* the context may have been reloaded while listening */
+      ctx = xfd->para.openssl.ctx;
       result = _xioopen_openssl_listen(xfd, opt_ver, opt_commonname, ctx, level);
       switch (result) {
       case STAT_OK: break;
@@ -632,6 +668,7 @@ static int
       }
 
       openssl_conn_loginfo(xfd->para.openssl.ssl);
+      openssl_ktls_check(xfd);
       break;
 
    }	/* drop out on success */
@@ -924,6 +961,8 @@ int
    char *opt_compress = NULL;	/* compression method */
 #endif
    bool opt_pseudo = false;	/* use pseudo entropy if nothing else */
+   char *opt_sesscache = NULL;	/* file with session or ticket keys */
+   bool opt_ktls = false;	/* let the kernel handle the TLS records */
    unsigned long err;
    int result;
 
@@ -941,6 +980,8 @@ int
    retropt_string(opts, OPT_OPENSSL_DHPARAM, &opt_dhparam);
    retropt_string(opts, OPT_OPENSSL_EGD, &opt_egd);
    retropt_bool(opts,OPT_OPENSSL_PSEUDO, &opt_pseudo);
+   retropt_string(opts, OPT_OPENSSL_SESSION_CACHE, &opt_sesscache);
+   retropt_bool(opts, OPT_OPENSSL_KTLS, &opt_ktls);
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L
    retropt_string(opts, OPT_OPENSSL_COMPRESS, &opt_compress);
 #endif
@@ -1350,6 +1391,20 @@ cont_out:
 	 openssl_SSL_ERROR_SSL(E_ERROR/*!*/, "SSL_CTX_use_PrivateKey_file");
 	 return STAT_RETRYLATER;
       }
+#ifdef SSL_CTX_build_cert_chain
+      /* without a chain in the file, OpenSSL looks up the issuer certificates
+	 in the trust store with each handshake; do it once here */
+      {
+	 STACK_OF(X509) *chain = NULL;
+	 SSL_CTX_get0_chain_certs(ctx, &chain);
+	 if (chain == NULL || sk_X509_num(chain) == 0) {
+	    if (SSL_CTX_build_cert_chain(ctx, SSL_BUILD_CHAIN_FLAG_IGNORE_ERROR) > 0) {
+	       SSL_CTX_set_mode(ctx, SSL_MODE_NO_AUTO_CHAIN);
+	    }
+	    ERR_clear_error();
+	 }
+      }
+#endif /* defined(SSL_CTX_build_cert_chain) */
 
       if (opt_dhparam == NULL) {
 	 opt_dhparam = (char *)opt_cert;
@@ -1398,10 +1453,349 @@ cont_out:
 			    NULL);
    }
 
+   if (server) {
+      /* OpenSSL refuses to resume sessions of verified clients without it */
+      SSL_CTX_set_session_id_context(ctx, (const unsigned char *)"socat", 5);
+   }
+   if (opt_sesscache != NULL) {
+      if (openssl_session_cache(ctx, server, opt_sesscache) < 0) {
+	 return STAT_NORETRY;
+      }
+   }
+   if (opt_ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+      /* OpenSSL silently keeps the records in user space when the kernel or
+	 the negotiated cipher does not support it */
+      SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+      Warn("option openssl-ktls: not supported by OpenSSL library, ignoring it");
+#endif
+   }
+
    return STAT_OK;
 }
 
 
+/* option openssl-session-cache: a client stores the last session it got from
+   the server in the file and resumes it on the next connection; a server
+   keeps its TLS ticket keys in the file, so that all processes using it (the
+   children of fork, other socat instances, a restarted server) accept the
+   tickets that any of them has issued. The file is replaced atomically, so
+   concurrent processes see either the old or the new contents */
+
+#define OPENSSL_SESSION_MAX 16384	/* max length of a stored session */
+
+static int openssl_sesscache_index = -1;	/* SSL_CTX ex_data: file name */
+
+/* reads up to len bytes of file name.
+   returns the number of bytes read, or -1 (missing file: errno==ENOENT) */
+static ssize_t openssl_file_read(const char *name, void *buff, size_t len) {
+   ssize_t bytes;
+   int fd, _errno;
+
+   if ((fd = Open(name, O_RDONLY, 0)) < 0) {
+      if (errno != ENOENT) {
+	 _errno = errno;
+	 Warn2("open(\"%s\", O_RDONLY): %s", name, strerror(errno));
+	 errno = _errno;
+      }
+      return -1;
+   }
+   if ((bytes = Read(fd, buff, len)) < 0) {
+      Warn4("read(%d, %p, "F_Zu"): %s", fd, buff, len, strerror(errno));
+   }
+   Close(fd);
+   return bytes;
+}
+
+/* writes data into a new file beside name, and then replaces name with it
+   (replace), or links it to name when it does not yet exist (!replace).
+   returns 0 on success, 1 when name existed (!replace), or -1 on error */
+static int openssl_file_store(const char *name, const void *data, size_t len,
+			      bool replace) {
+   size_t tmplen = strlen(name) + 16;
+   char *tmpname;
+   int fd, result = 0;
+
+   if ((tmpname = Malloc(tmplen)) == NULL) {
+      return -1;
+   }
+   snprintf(tmpname, tmplen, "%s.%u", name, (unsigned int)Getpid());
+   if ((fd = Open(tmpname, O_WRONLY|O_CREAT|O_TRUNC, 0600)) < 0) {
+      Warn2("open(\"%s\", O_WRONLY|O_CREAT|O_TRUNC, 0600): %s",
+	    tmpname, strerror(errno));
+      free(tmpname);
+      return -1;
+   }
+   if (writefull(fd, data, len) < 0) {
+      Close(fd);
+      Unlink(tmpname);
+      free(tmpname);
+      return -1;
+   }
+   Close(fd);
+   if (replace) {
+      if (Rename(tmpname, name) < 0) {
+	 Warn3("rename(\"%s\", \"%s\"): %s", tmpname, name, strerror(errno));
+	 Unlink(tmpname);
+	 result = -1;
+      }
+   } else {
+      if (Link(tmpname, name) < 0) {
+	 if (errno == EEXIST) {
+	    result = 1;
+	 } else {
+	    Warn3("link(\"%s\", \"%s\"): %s", tmpname, name, strerror(errno));
+	    result = -1;
+	 }
+      }
+      Unlink(tmpname);
+   }
+   free(tmpname);
+   return result;
+}
+
+/* the new session callback of a client: stores the session in the file */
+static int openssl_session_new(SSL *ssl, SSL_SESSION *session) {
+   const char *name;
+   unsigned char *der, *p;
+   int len;
+
+   name = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), openssl_sesscache_index);
+   if (name == NULL) {
+      return 0;
+   }
+   if ((len = i2d_SSL_SESSION(session, NULL)) <= 0 ||
+       len > OPENSSL_SESSION_MAX) {
+      Info1("TLS session of %d bytes not stored", len);
+      return 0;
+   }
+   if ((der = Malloc(len)) == NULL) {
+      return 0;
+   }
+   p = der;
+   i2d_SSL_SESSION(session, &p);
+   if (openssl_file_store(name, der, len, true) == 0) {
+      Info2("stored TLS session (%d bytes) in \"%s\"", len, name);
+   }
+   OPENSSL_cleanse(der, len);
+   free(der);
+   return 0;	/* we did not keep a reference */
+}
+
+/* sets up the SSL_CTX for option openssl-session-cache; filename must stay
+   valid with the context.
+   returns 0 on success, or -1 on error */
+static int openssl_session_cache(SSL_CTX *ctx, bool server, char *filename) {
+   if (openssl_sesscache_index < 0 &&
+       (openssl_sesscache_index =
+	SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL)) < 0) {
+      Error("SSL_CTX_get_ex_new_index(): failed");
+      return -1;
+   }
+   SSL_CTX_set_ex_data(ctx, openssl_sesscache_index, filename);
+
+   if (!server) {
+      /* the sessions are only kept in the file */
+      SSL_CTX_set_session_cache_mode(ctx,
+				     SSL_SESS_CACHE_CLIENT|
+				     SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      SSL_CTX_sess_set_new_cb(ctx, openssl_session_new);
+      return 0;
+   }
+
+   {
+      unsigned char keys[128];
+      long keylen;
+      ssize_t bytes;
+      int result;
+
+      /* 80 bytes since OpenSSL 1.1.0, 48 before */
+      keylen = SSL_CTX_get_tlsext_ticket_keys(ctx, NULL, 0);
+      if (keylen <= 0 || keylen > (long)sizeof(keys)) {
+	 Error1("openssl-session-cache: unsupported ticket key length %ld",
+		keylen);
+	 return -1;
+      }
+      bytes = openssl_file_read(filename, keys, keylen);
+      if (bytes < 0 && errno == ENOENT) {
+	 if (RAND_bytes(keys, keylen) != 1) {
+	    openssl_SSL_ERROR_SSL(E_ERROR, "RAND_bytes");
+	    return -1;
+	 }
+	 result = openssl_file_store(filename, keys, keylen, false);
+	 if (result < 0) {
+	    return -1;
+	 } else if (result == 0) {
+	    Info1("generated TLS ticket keys in \"%s\"", filename);
+	    bytes = keylen;
+	 } else {
+	    /* another process was faster */
+	    bytes = openssl_file_read(filename, keys, keylen);
+	 }
+      }
+      if (bytes != keylen) {
+	 Error3("\"%s\": "F_Zd" bytes, expected %ld bytes of TLS ticket keys",
+		filename, bytes, keylen);
+	 return -1;
+      }
+      if (SSL_CTX_set_tlsext_ticket_keys(ctx, keys, keylen) != 1) {
+	 openssl_SSL_ERROR_SSL(E_ERROR, "SSL_CTX_set_tlsext_ticket_keys");
+	 return -1;
+      }
+      OPENSSL_cleanse(keys, sizeof(keys));
+   }
+   return 0;
+}
+
+/* offers the session stored in the file of option openssl-session-cache
+   for resumption */
+static void openssl_session_load(SSL *ssl, const char *snihost) {
+   unsigned char buff[OPENSSL_SESSION_MAX];
+   const unsigned char *p = buff;
+   SSL_SESSION *session;
+   const char *name;
+   ssize_t bytes;
+
+   if (openssl_sesscache_index < 0 ||
+       (name = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl),
+				   openssl_sesscache_index)) == NULL) {
+      return;
+   }
+   if ((bytes = openssl_file_read(name, buff, sizeof(buff))) <= 0) {
+      return;
+   }
+   if ((session = d2i_SSL_SESSION(NULL, &p, bytes)) == NULL) {
+      Warn1("\"%s\": no valid TLS session, ignoring it", name);
+      ERR_clear_error();
+      return;
+   }
+   OPENSSL_cleanse(buff, bytes);
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+   if (!SSL_SESSION_is_resumable(session) ||
+       snihost != NULL && SSL_SESSION_get0_hostname(session) != NULL &&
+       strcmp(SSL_SESSION_get0_hostname(session), snihost)) {
+      Info1("TLS session in \"%s\" not usable for this server", name);
+      SSL_SESSION_free(session);
+      return;
+   }
+#endif
+   if (sycSSL_set_session(ssl, session) != 1) {
+      openssl_SSL_ERROR_SSL(E_WARN, "SSL_set_session");
+   }
+   SSL_SESSION_free(session);
+}
+
+
+/* after the handshake: notes which directions of the connection the kernel
+   handles (option openssl-ktls). socat can then move their data with
+   splice() */
+static void openssl_ktls_check(struct single *xfd) {
+#ifdef SSL_OP_ENABLE_KTLS
+   SSL *ssl = xfd->para.openssl.ssl;
+#endif
+
+   xfd->para.openssl.ktls_send = false;
+   xfd->para.openssl.ktls_recv = false;
+#ifdef SSL_OP_ENABLE_KTLS
+   if (!(SSL_get_options(ssl) & SSL_OP_ENABLE_KTLS)) {
+      return;
+   }
+   xfd->para.openssl.ktls_send = (BIO_get_ktls_send(SSL_get_wbio(ssl)) > 0);
+   xfd->para.openssl.ktls_recv = (BIO_get_ktls_recv(SSL_get_rbio(ssl)) > 0);
+   if (xfd->para.openssl.ktls_send || xfd->para.openssl.ktls_recv) {
+      Notice2("kernel TLS used for %s%s",
+	      xfd->para.openssl.ktls_send?"sending":"",
+	      xfd->para.openssl.ktls_recv?
+	      (xfd->para.openssl.ktls_send?" and receiving":"receiving"):"");
+   } else {
+      Info("kernel TLS not available for this connection");
+   }
+#endif /* defined(SSL_OP_ENABLE_KTLS) */
+}
+
+
+/* OPENSSL-LISTEN with fork builds its context once, the children only create
+   their SSL objects from it. On SIGHUP the listening process builds a new
+   context from the original options, so that changed certificate, key, and
+   CA files take effect for the following connections; when this fails it
+   keeps the old one */
+
+static struct opt *openssl_reload_opts;	/* copy of the OpenSSL options */
+static bool openssl_reload_ver;
+static const char *openssl_reload_cert;
+static bool openssl_reload_dtls;
+static bool openssl_reload_armed;	/* SIGHUP handler installed */
+static sig_atomic_t openssl_reload_sighups;	/* xio_sighup_count at last load */
+
+static void openssl_reload_prepare(struct opt *opts, bool opt_ver,
+				   const char *opt_cert, bool use_dtls) {
+   if (openssl_reload_opts != NULL) {
+      return;	/* retry */
+   }
+   openssl_reload_opts = copyopts(opts, GROUP_OPENSSL);
+   openssl_reload_ver  = opt_ver;
+   openssl_reload_cert = opt_cert;
+   openssl_reload_dtls = use_dtls;
+}
+
+/* rebuilds the context of xfd from the saved options */
+static void openssl_reload_ctx(struct single *xfd) {
+   SSL_CTX *oldctx = xfd->para.openssl.ctx, *ctx = NULL;
+   struct opt *opts;
+   bool opt_ver = openssl_reload_ver;
+   bool use_dtls = openssl_reload_dtls;
+   int exitlevel;
+   int result;
+
+   if ((opts = copyopts(openssl_reload_opts, GROUP_ALL)) == NULL) {
+      return;
+   }
+   exitlevel = diag_get_int('e');	/* save current exit level */
+   diag_set_int('e', E_FATAL);	/* a bad file must not terminate the server */
+   result = _xioopen_openssl_prepare(opts, xfd, true, &opt_ver,
+				     openssl_reload_cert, &ctx, &use_dtls);
+   diag_set_int('e', exitlevel);	/* restore old exit level */
+   dropopts(opts, PH_ALL); free(opts);
+   if (result != STAT_OK) {
+      if (ctx != NULL && ctx != oldctx) {
+	 sycSSL_CTX_free(ctx);
+      }
+      xfd->para.openssl.ctx = oldctx;
+      Warn("SIGHUP: failed to reload OpenSSL context, keeping the old one");
+      return;
+   }
+   sycSSL_CTX_free(oldctx);
+   Notice("SIGHUP: reloaded OpenSSL context");
+}
+
+/* xiolisten_hook of OPENSSL-LISTEN: runs in the listening process before each
+   accept() */
+static void openssl_reload_hook(struct single *xfd) {
+   if (!(xfd->flags & XIO_DOESFORK)) {
+      return;
+   }
+   if (!openssl_reload_armed) {
+      openssl_reload_sighups = xio_sighup_count;
+      xio_sighup_arm();
+      openssl_reload_armed = true;
+   }
+   if (openssl_reload_sighups != xio_sighup_count) {
+      openssl_reload_sighups = xio_sighup_count;
+      openssl_reload_ctx(xfd);
+   }
+}
+
+/* in the child process, or when listening is done: restore the SIGHUP
+   handling of socat */
+static void openssl_reload_reset(void) {
+   if (openssl_reload_armed) {
+      xio_sighup_reset();
+      openssl_reload_armed = false;
+   }
+}
+
+
 /* analyses an OpenSSL error condition, prints the appropriate messages with
    severity 'level' and returns one of STAT_OK, STAT_RETRYLATER, or
    STAT_NORETRY */
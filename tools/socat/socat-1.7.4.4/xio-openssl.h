@@ -36,6 +36,8 @@ extern const struct optdesc opt_openssl_fips;
 extern const struct optdesc opt_openssl_commonname;
 extern const struct optdesc opt_openssl_no_sni;
 extern const struct optdesc opt_openssl_snihost;
+extern const struct optdesc opt_openssl_session_cache;
+extern const struct optdesc opt_openssl_ktls;
 
 extern int
    _xioopen_openssl_prepare(struct opt *opts, struct single *xfd,
@@ -0,0 +1,245 @@
+/* source: xio-preconnect.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for keeping established connections of a
+   connect type address ready (option preconnect) */
+
+#include "xiosysincludes.h"
+
+#if _WITH_SOCKET
+
+#include "xioopen.h"
+#include "xio-ipapp.h"
+#include "xio-vsock.h"
+#include "xio-preconnect.h"
+
+const struct optdesc opt_preconnect = { "preconnect", NULL, OPT_PRECONNECT, GROUP_SOCKET, PH_PRECONNECT, TYPE_INT, OFUNC_SPEC };
+
+/* the pool process keeps up to n connected sockets queued in a UNIX stream
+   socket pair, each one as SCM_RIGHTS with one data byte. A process that
+   takes a socket from the queue writes back one byte, so the pool connects
+   a replacement. */
+static int xiopreconnect_fd = -1;	/* our end of the socket pair */
+static pid_t xiopreconnect_pid = 0;	/* the pool process */
+static pid_t xiopreconnect_master = 0;
+
+/* longest pause of the pool after failed connects */
+#define XIOPRECONNECT_MAXWAIT 32
+
+static void xiopreconnect_kill(void) {
+   if (Getpid() != xiopreconnect_master) {
+      return;	/* a child process */
+   }
+   if (xiopreconnect_pid > 0) {
+      Kill(xiopreconnect_pid, SIGTERM);
+   }
+}
+
+/* passes the socket fd through the pair */
+static int xiopreconnect_send(int pairfd, int fd) {
+   struct msghdr msgh = { 0 };
+   struct iovec iov;
+   union {
+      struct cmsghdr cmsg;
+      char space[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct cmsghdr *cmsg;
+   char data = 'c';
+
+   iov.iov_base = &data;  iov.iov_len = 1;
+   msgh.msg_iov = &iov;  msgh.msg_iovlen = 1;
+   memset(&ctl, 0, sizeof(ctl));
+   msgh.msg_control = &ctl;  msgh.msg_controllen = sizeof(ctl.space);
+   cmsg = CMSG_FIRSTHDR(&msgh);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type  = SCM_RIGHTS;
+   cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+   memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+   if (Sendmsg(pairfd, &msgh, 0) < 0) {
+      Error2("sendmsg(%d, {SCM_RIGHTS}, 0): %s", pairfd, strerror(errno));
+      return -1;
+   }
+   return 0;
+}
+
+/* main loop of the pool process; does not return */
+static void xiopreconnect_pool(const xiofile_t *tmpl, int xioflags,
+			       int pairfd, int num) {
+   struct pollfd pfd;
+   int spare = 0;	/* connections in the queue */
+   int wait = 1;	/* seconds to pause after a failed connect */
+   pid_t parent = getppid();
+   char buff[64];
+   ssize_t bytes;
+   int i;
+
+   Info3("preconnect: keeping %d connections to %s:%s ready", num,
+	 tmpl->stream.argv[1], tmpl->stream.argv[2]);
+   while (true) {
+      while (spare < num) {
+	 xiofile_t *xfd;
+
+	 /* the address was parsed once, each connection takes a copy */
+	 if ((xfd = xioopen_parsed(xioclone(tmpl), xioflags)) == NULL) {
+	    break;
+	 }
+	 /* the connection belongs to the queue now, so do not let xioexit()
+	    shut it down */
+	 for (i = 0; i < XIO_MAXSOCK; ++i) {
+	    if (sock[i] == xfd)  sock[i] = NULL;
+	 }
+	 if (xiopreconnect_send(pairfd, xfd->stream.fd) < 0) {
+	    Exit(1);
+	 }
+	 Close(xfd->stream.fd);
+	 free(xfd->stream.opts);  free(xfd);
+	 ++spare;
+	 wait = 1;
+	 Debug2("preconnect: %d of %d connections ready", spare, num);
+      }
+
+      pfd.fd = pairfd;  pfd.events = POLLIN;  pfd.revents = 0;
+      if (Poll(&pfd, 1, spare < num ? wait*1000 : 1000) < 0) {
+	 if (errno == EINTR)  continue;
+	 Error1("poll(): %s", strerror(errno));
+	 Exit(1);
+      }
+      if (getppid() != parent) {
+	 Info("preconnect: parent process has gone, exiting");
+	 Exit(0);
+      }
+      if (pfd.revents == 0) {
+	 if (spare < num && wait < XIOPRECONNECT_MAXWAIT)  wait *= 2;
+	 continue;
+      }
+      if ((bytes = Read(pairfd, buff, sizeof(buff))) <= 0) {
+	 Exit(0);
+      }
+      spare -= bytes;
+      if (spare < 0)  spare = 0;
+   }
+}
+
+/* if the parsed address tmpl has option preconnect, starts the pool process
+   for it.
+   call this function before opening the other address, so the pool does not
+   inherit its file descriptors.
+   returns 0 on success or when there is nothing to do, -1 on error */
+int xiopreconnect(const xiofile_t *tmpl, int xioflags) {
+   xiofile_t *xfd;
+   int num = 0;
+   int sv[2];
+   pid_t pid;
+
+   if (tmpl->tag == XIO_TAG_DUAL) {
+      return 0;
+   }
+   /* retrieving the option must not consume it in the template */
+   if ((xfd = xioclone(tmpl)) == NULL) {
+      return -1;
+   }
+   if (retropt_int(xfd->stream.opts, OPT_PRECONNECT, &num) < 0) {
+      free(xfd->stream.opts);  free(xfd);
+      return 0;
+   }
+   if (false
+#if WITH_IP4
+       || xfd->stream.addr->func == xioopen_ipapp_connect
+#endif
+#if WITH_VSOCK
+       || xfd->stream.addr == &addr_vsock_connect
+#endif
+       ) {
+      ;
+   } else {
+      Error1("%s: option preconnect requires a TCP or VSOCK connect address",
+	     xfd->stream.argv[0]);
+      free(xfd->stream.opts);  free(xfd);
+      return -1;
+   }
+   if (num <= 0) {
+      free(xfd->stream.opts);  free(xfd);
+      return 0;
+   }
+
+   if (Socketpair(PF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+      Error1("socketpair(PF_UNIX, SOCK_STREAM, 0, ...): %s", strerror(errno));
+      free(xfd->stream.opts);  free(xfd);
+      return -1;
+   }
+   if ((pid = xio_fork(false, E_ERROR)) < 0) {
+      Close(sv[0]);  Close(sv[1]);
+      free(xfd->stream.opts);  free(xfd);
+      return -1;
+   }
+   if (pid == 0) {	/* pool process */
+      Close(sv[0]);
+      xiopreconnect_pool(xfd, xioflags, sv[1], num);
+   }
+   --num_child;		/* the pool does not count for max-children */
+   free(xfd->stream.opts);  free(xfd);
+   Close(sv[1]);
+   Fcntl_l(sv[0], F_SETFD, FD_CLOEXEC);
+   xiopreconnect_fd = sv[0];
+   xiopreconnect_pid = pid;
+   xiopreconnect_master = Getpid();
+   Atexit(xiopreconnect_kill);
+   return 0;
+}
+
+/* retrieves option preconnect and, when the pool process runs, takes one of
+   its connections that the peer did not close yet.
+   returns the connected socket, or -1 when the caller has to connect by
+   itself */
+int xiopreconnect_take(struct opt *opts) {
+   int num = 0;
+   struct msghdr msgh = { 0 };
+   struct iovec iov;
+   union {
+      struct cmsghdr cmsg;
+      char space[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct cmsghdr *cmsg;
+   struct pollfd pfd;
+   char data;
+   int fd;
+
+   if (retropt_int(opts, OPT_PRECONNECT, &num) < 0 || num <= 0 ||
+       xiopreconnect_fd < 0) {
+      return -1;
+   }
+
+   while (true) {
+      iov.iov_base = &data;  iov.iov_len = 1;
+      msgh.msg_iov = &iov;  msgh.msg_iovlen = 1;
+      msgh.msg_control = &ctl;  msgh.msg_controllen = sizeof(ctl.space);
+      if (Recvmsg(xiopreconnect_fd, &msgh, MSG_DONTWAIT) <= 0) {
+	 Info("preconnect: no connection ready");
+	 return -1;
+      }
+      data = 'c';
+      Write(xiopreconnect_fd, &data, 1);	/* request replacement */
+      if ((cmsg = CMSG_FIRSTHDR(&msgh)) == NULL ||
+	  cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+	 Warn("preconnect: message without file descriptor");
+	 continue;
+      }
+      memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+      /* the peer might have closed the connection while it was waiting */
+      pfd.fd = fd;  pfd.events = POLLIN;  pfd.revents = 0;
+      if (Poll(&pfd, 1, 0) > 0) {
+	 if ((pfd.revents & (POLLERR|POLLHUP|POLLNVAL)) ||
+	     Recv(fd, &data, 1, MSG_PEEK|MSG_DONTWAIT) <= 0) {
+	    Info1("preconnect: dropping closed connection on fd %d", fd);
+	    Close(fd);
+	    continue;
+	 }
+      }
+      Notice1("preconnect: using prepared connection on fd %d", fd);
+      return fd;
+   }
+}
+
+#endif /* _WITH_SOCKET */
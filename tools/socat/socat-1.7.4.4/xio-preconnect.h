@@ -0,0 +1,12 @@
+/* source: xio-preconnect.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_preconnect_h_included
+#define __xio_preconnect_h_included 1
+
+extern const struct optdesc opt_preconnect;
+
+extern int xiopreconnect_take(struct opt *opts);
+
+#endif /* !defined(__xio_preconnect_h_included) */
@@ -40,7 +40,121 @@ const struct optdesc opt_sigint  = { "sigint",    NULL, OPT_SIGINT,      GROUP_P
 const struct optdesc opt_sigquit = { "sigquit",   NULL, OPT_SIGQUIT,     GROUP_PARENT, PH_LATE,        TYPE_CONST,      OFUNC_SIGNAL, SIGQUIT };
 
 
+#if HAVE_POSIX_SPAWNP
+/* checks if posix_spawnp() can do what the child process would do with the
+   child options copts: only setsid and setpgid may be left, and there must
+   be no user to switch to */
+static bool _xioopen_spawnable(struct opt *copts) {
+   struct opt *opt;
+
+   if (xioopts.nospawn || delayeduser)  return false;
+   for (opt = copts; opt->desc != ODESC_END; ++opt) {
+      if (opt->desc == ODESC_DONE)  continue;
+      switch (opt->desc->optcode) {
+#ifdef POSIX_SPAWN_SETSID
+      case OPT_SETSID:
+#endif
+      case OPT_SETPGID:
+	 break;
+      default:
+	 return false;
+      }
+   }
+   return true;
+}
+
+/* starts spawn->file with posix_spawnp() in a child process that gets rdfd
+   as fdi (when writing to it) and wrfd as fdo (when reading from it), and
+   closes the parent's ends closefds[2] (-1 when unused). This avoids copying
+   the address space of socat with fork().
+   returns the pid of the child; 0 when the descriptors conflict and fork()
+   must be used; or -1 on error */
+static pid_t _xioopen_spawn(const struct xiospawn *spawn, struct opt *copts,
+			    int rw, int rdfd, int wrfd, const int closefds[2],
+			    int fdi, int fdo, bool withstderr) {
+   posix_spawn_file_actions_t actions;
+   posix_spawnattr_t attr;
+   sigset_t sigdef;
+   short flags = POSIX_SPAWN_SETSIGDEF;
+   bool setsid = false;
+   int pgid;
+   pid_t pid;
+   int i, result;
+
+   /* the file actions are applied in order; the fork() code handles the
+      overlapping cases with temporary descriptors */
+   if ((rw == XIO_RDWR && rdfd != wrfd && fdi == wrfd) ||
+       (withstderr && (rdfd == 2 || wrfd == 2))) {
+      return 0;
+   }
+   if ((result = posix_spawn_file_actions_init(&actions)) != 0) {
+      Error1("posix_spawn_file_actions_init(): %s", strerror(result));
+      return -1;
+   }
+   for (i = 0; i < 2; ++i) {
+      if (closefds[i] >= 0)
+	 posix_spawn_file_actions_addclose(&actions, closefds[i]);
+   }
+   if (rw != XIO_RDONLY && rdfd != fdi)
+      posix_spawn_file_actions_adddup2(&actions, rdfd, fdi);
+   if (rw != XIO_WRONLY && wrfd != fdo)
+      posix_spawn_file_actions_adddup2(&actions, wrfd, fdo);
+   if (withstderr)
+      posix_spawn_file_actions_adddup2(&actions, fdo, 2);
+   if (rdfd >= 0 && rdfd != fdi && rdfd != fdo)
+      posix_spawn_file_actions_addclose(&actions, rdfd);
+   if (wrfd >= 0 && wrfd != rdfd && wrfd != fdi && wrfd != fdo)
+      posix_spawn_file_actions_addclose(&actions, wrfd);
+
+   /* the child should have default handling for SIGCHLD, see fork() code */
+   posix_spawnattr_init(&attr);
+   sigemptyset(&sigdef);
+   sigaddset(&sigdef, SIGCHLD);
+   posix_spawnattr_setsigdefault(&attr, &sigdef);
+#ifdef POSIX_SPAWN_SETSID
+   retropt_bool(copts, OPT_SETSID, &setsid);
+   if (setsid)  flags |= POSIX_SPAWN_SETSID;
+#endif
+   if (retropt_int(copts, OPT_SETPGID, &pgid) >= 0) {
+      flags |= POSIX_SPAWN_SETPGROUP;
+      posix_spawnattr_setpgroup(&attr, pgid);
+   }
+   posix_spawnattr_setflags(&attr, flags);
+
+   result = Posix_spawnp(&pid, spawn->file, &actions, &attr, spawn->argv,
+			 environ);
+   posix_spawnattr_destroy(&attr);
+   posix_spawn_file_actions_destroy(&actions);
+   if (result != 0) {
+      Error2("posix_spawnp(\"%s\", ...): %s", spawn->file, strerror(result));
+      return -1;
+   }
+   num_child++;
+   Notice2("spawned child process "F_pid" executing \"%s\"",
+	   pid, spawn->file);
+   return pid;
+}
+
+/* when posix_spawnp() could not start the child: closes the ends of both
+   sides of the pipes (usepipes) or of the socketpair, so that xioclose() does
+   not close them again */
+static void _xioopen_foxec_closeall(struct single *fd, int rw, bool usepipes,
+				    const int rdpip[2], const int wrpip[2],
+				    const int sv[2]) {
+   if (usepipes) {
+      if (rw != XIO_WRONLY) {  Close(rdpip[0]);  Close(rdpip[1]);  }
+      if (rw != XIO_RDONLY) {  Close(wrpip[0]);  Close(wrpip[1]);  }
+      if (rw == XIO_RDWR)  fd->para.exec.fdout = -1;
+   } else {
+      Close(sv[0]);  Close(sv[1]);
+   }
+   fd->fd = -1;
+}
+#endif /* HAVE_POSIX_SPAWNP */
+
 /* fork for exec/system, but return before exec'ing.
+   When spawn is not NULL and the options allow it, the child process is
+   started with posix_spawnp() instead and the function returns as parent.
    return=0: is child process
    return>0: is parent process
    return<0: error occurred, assume parent process and no child exists !!!
@@ -49,7 +163,8 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 		struct single *fd,
 		unsigned groups,
 		   struct opt **copts,	/* in: opts; out: opts for child */
-		   int *duptostderr	/* out: redirect stderr to output fd */
+		   int *duptostderr,	/* out: redirect stderr to output fd */
+		   const struct xiospawn *spawn	/* NULL: always fork */
 		) {
    struct opt *popts;	/* parent process options */
    int numleft;
@@ -74,6 +189,7 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
    bool withstderr = false;
    bool nofork = false;
    bool withfork;
+   bool spawned = false;	/* child was started with posix_spawnp() */
    char *tn = NULL;
    int trigger[2];
 
@@ -382,7 +498,36 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 
    xiosetchilddied();	/* set SIGCHLD handler */
 
-   if (withfork) {
+#if HAVE_POSIX_SPAWNP
+   if (withfork && spawn != NULL &&
+#if HAVE_PTY
+       !usepty &&
+#endif
+       _xioopen_spawnable(*copts)) {
+      if (usepipes) {
+	 int closefds[2];
+	 closefds[0] = (rw != XIO_WRONLY ? rdpip[0] : -1);
+	 closefds[1] = (rw != XIO_RDONLY ? wrpip[1] : -1);
+	 pid = _xioopen_spawn(spawn, *copts, rw,
+			      rw != XIO_RDONLY ? wrpip[0] : -1,
+			      rw != XIO_WRONLY ? rdpip[1] : -1,
+			      closefds, fdi, fdo, withstderr);
+      } else {
+	 int closefds[2];
+	 closefds[0] = sv[0];
+	 closefds[1] = -1;
+	 pid = _xioopen_spawn(spawn, *copts, rw, sv[1], sv[1], closefds,
+			      fdi, fdo, withstderr);
+      }
+      if (pid < 0) {
+	 _xioopen_foxec_closeall(fd, rw, usepipes, rdpip, wrpip, sv);
+	 return -1;
+      }
+      spawned = (pid > 0);
+   }
+#endif /* HAVE_POSIX_SPAWNP */
+
+   if (withfork && !spawned) {
       Socketpair(PF_UNIX, SOCK_STREAM, 0, trigger);
       pid = xio_fork(true, E_ERROR);
       if (pid < 0) {
@@ -564,8 +709,10 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
    }
 
    /* for parent (this is our socat process) */
-   Notice1("forked off child process "F_pid, pid);
-   Close(trigger[1]);
+   if (!spawned) {
+      Notice1("forked off child process "F_pid, pid);
+      Close(trigger[1]);
+   }
 
 #if 0
    if ((popts = copyopts(*copts,
@@ -598,7 +745,7 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
       return STAT_NORETRY;
    }
 
-   {
+   if (!spawned) {
       struct pollfd fds[1];
       fds[0].fd = trigger[0];
       fds[0].events = POLLIN|POLLHUP;
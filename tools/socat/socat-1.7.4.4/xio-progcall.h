@@ -18,11 +18,19 @@ extern const struct optdesc opt_sighup;
 extern const struct optdesc opt_sigint;
 extern const struct optdesc opt_sigquit;
 
+/* the program that the child process executes; lets _xioopen_foxec() start
+   it with posix_spawnp() instead of fork() */
+struct xiospawn {
+   const char *file;	/* searched in PATH */
+   char *const *argv;
+} ;
+
 extern int _xioopen_foxec(int rw,	/* O_RDONLY etc. */
 		struct single *fd,
 		unsigned groups,
 		struct opt **opts,
-			  int *duptostderr
+			  int *duptostderr,
+			  const struct xiospawn *spawn
 		);
 extern int setopt_path(struct opt *opts, char **path);
 extern
@@ -128,7 +128,7 @@ static int xioopen_proxy_connect(int argc, const char *argv[], struct opt *opts,
    if (result != STAT_OK)  return result;
 
    result =
-      _xioopen_ipapp_prepare(opts, &opts0, proxyname, proxyport,
+      _xioopen_ipapp_prepare(xfd, opts, &opts0, proxyname, proxyport,
 			     &pf, ipproto,
 			     xfd->para.socket.ip.res_opts[1],
 			     xfd->para.socket.ip.res_opts[0],
@@ -148,11 +148,23 @@ static int xioopen_proxy_connect(int argc, const char *argv[], struct opt *opts,
 #endif /* WITH_RETRY */
          level = E_ERROR;
 
-   result =
-      _xioopen_connect(xfd,
-		       needbind?us:NULL, sizeof(*us),
-		       (struct sockaddr *)them, themlen,
-		       opts, pf, socktype, IPPROTO_TCP, lowport, level);
+      xioresolve_update(proxyname, proxyport, pf, socktype, ipproto,
+			them, &themlen,
+			xfd->para.socket.ip.res_opts[1],
+			xfd->para.socket.ip.res_opts[0]);
+      if (xfd->para.socket.ip.happy_num > 1) {
+	 result =
+	    _xioopen_connect_happy(xfd, needbind?us:NULL, sizeof(*us),
+				   xfd->para.socket.ip.happy_addrs,
+				   xfd->para.socket.ip.happy_num,
+				   opts, socktype, IPPROTO_TCP, lowport, level);
+      } else {
+	 result =
+	    _xioopen_connect(xfd,
+			     needbind?us:NULL, sizeof(*us),
+			     (struct sockaddr *)them, themlen,
+			     opts, pf, socktype, IPPROTO_TCP, lowport, level);
+      }
       switch (result) {
       case STAT_OK: break;
 #if WITH_RETRY
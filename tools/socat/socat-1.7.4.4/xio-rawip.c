@@ -13,6 +13,7 @@
 #include "xio-ip.h"
 #include "xio-ip6.h"
 #include "xio-tcpwrap.h"
+#include "xio-acl.h"
 
 #include "xio-rawip.h"
 
@@ -188,6 +189,9 @@ int xioopen_rawip_datagram(int argc, const char *argv[], struct opt *opts,
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(xfd, opts);
 #endif /* WITH_LIBWRAP */
+   if (xio_retropt_acl(xfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
 
    _xio_openlate(xfd, opts);
    return STAT_OK;
@@ -27,6 +27,7 @@
 #include "xio-listen.h"
 #include "xio-ipapp.h"	/*! not clean */
 #include "xio-tcpwrap.h"
+#include "xio-acl.h"
 
 
 static
@@ -192,6 +193,9 @@ const struct optdesc opt_fiosetown   = { "fiosetown", NULL, OPT_FIOSETOWN,   GRO
 const struct optdesc opt_siocspgrp   = { "siocspgrp", NULL, OPT_SIOCSPGRP,   GROUP_SOCKET, PH_PASTSOCKET, TYPE_INT,  OFUNC_IOCTL,  SIOCSPGRP };
 #endif
 const struct optdesc opt_bind        = { "bind",      NULL, OPT_BIND,        GROUP_SOCKET, PH_BIND, TYPE_STRING,OFUNC_SPEC };
+#if HAVE_RECVMMSG
+const struct optdesc opt_batch = { "batch", NULL, OPT_BATCH, GROUP_SOCKET, PH_INIT, TYPE_UINT, OFUNC_OFFSET, XIO_OFFSETOF(batch.num) };
+#endif
 const struct optdesc opt_connect_timeout = { "connect-timeout", NULL, OPT_CONNECT_TIMEOUT, GROUP_SOCKET, PH_PASTSOCKET, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.connect_timeout) };
 const struct optdesc opt_protocol_family = { "protocol-family", "pf", OPT_PROTOCOL_FAMILY, GROUP_SOCKET, PH_PRESOCKET,  TYPE_STRING,  OFUNC_SPEC };
 const struct optdesc opt_protocol        = { "protocol",        NULL, OPT_PROTOCOL,        GROUP_SOCKET, PH_PRESOCKET,  TYPE_STRING,  OFUNC_SPEC };
@@ -697,6 +701,9 @@ int xioopen_socket_datagram(int argc, const char *argv[], struct opt *opts,
       xfd->dtype |= XIOREAD_RECV_CHECKRANGE;
       free(rangename);
    }
+   if (xio_retropt_acl(xfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
 
    _xio_openlate(xfd, opts);
    return STAT_OK;
@@ -757,6 +764,9 @@ int xiogetpacketinfo(int fd)
    OFUNC_OFFSET, 
    OPT_SO_TYPE, OPT_SO_PROTOTYPE, OPT_USER, OPT_GROUP, OPT_CLOEXEC
    Does not fork, does not retry.
+   With XIO_DOESINPROGRESS in xfd->flags it does not wait for connect() but
+   leaves the nonblocking FD to the caller; the flag is cleared when connect()
+   succeeded immediately or connect-timeout makes it wait.
    returns 0 on success.
 */
 int _xioopen_connect(struct single *xfd, union sockaddr_union *us, size_t uslen,
@@ -794,6 +804,11 @@ int _xioopen_connect(struct single *xfd, union sockaddr_union *us, size_t uslen,
 
    if (xfd->para.socket.connect_timeout.tv_sec  != 0 ||
        xfd->para.socket.connect_timeout.tv_usec != 0) {
+      xfd->flags &= ~XIO_DOESINPROGRESS;	/* wait as the user asked for */
+   }
+   if (xfd->para.socket.connect_timeout.tv_sec  != 0 ||
+       xfd->para.socket.connect_timeout.tv_usec != 0 ||
+       (xfd->flags & XIO_DOESINPROGRESS)) {
       fcntl_flags = Fcntl(xfd->fd, F_GETFL);
       Fcntl_l(xfd->fd, F_SETFL, fcntl_flags|O_NONBLOCK);
    }
@@ -865,6 +880,11 @@ int _xioopen_connect(struct single *xfd, union sockaddr_union *us, size_t uslen,
 	       return STAT_RETRYLATER;
 	    }
 	    Fcntl_l(xfd->fd, F_SETFL, fcntl_flags);
+	 } else if (xfd->flags & XIO_DOESINPROGRESS) {
+	    /* the caller waits for writability; the FD stays nonblocking */
+	    Info4("connect(%d, %s, "F_Zd"): %s",
+		  xfd->fd, sockaddr_info(them, themlen, infobuff, sizeof(infobuff)),
+		  themlen, strerror(errno));
 	 } else {
 	    Warn4("connect(%d, %s, "F_Zd"): %s",
 		  xfd->fd, sockaddr_info(them, themlen, infobuff, sizeof(infobuff)),
@@ -895,6 +915,7 @@ int _xioopen_connect(struct single *xfd, union sockaddr_union *us, size_t uslen,
 	 return STAT_RETRYLATER;
       }
    } else {	/* result >= 0 */
+      xfd->flags &= ~XIO_DOESINPROGRESS;
       Notice1("successfully connected from local address %s",
 	      sockaddr_info(&la.soa, themlen, infobuff, sizeof(infobuff)));
    }
@@ -912,6 +933,243 @@ int _xioopen_connect(struct single *xfd, union sockaddr_union *us, size_t uslen,
 }
 
 
+/* for option happy-eyeballs: starts a non-blocking connect() to them, with
+   its own copy of opts in *aopts.
+   returns the socket, connected or with connect() in progress, or -1 */
+static int _xioopen_connect_start(struct single *xfd,
+				  union sockaddr_union *us, size_t uslen,
+				  union sockaddr_union *them,
+				  struct opt *opts, struct opt **aopts,
+				  int *fcntl_flags,
+				  int socktype, int protocol, bool alt) {
+   int pf = them->soa.sa_family;
+   socklen_t themlen;
+   char infobuff[256];
+   int _errno;
+   int fd;
+
+   themlen = (pf == PF_INET ? sizeof(struct sockaddr_in) :
+	      sizeof(struct sockaddr_in6));
+   if (us != NULL && us->soa.sa_family != pf) {
+      Info1("not connecting to %s: bind address of other family",
+	    sockaddr_info(&them->soa, themlen, infobuff, sizeof(infobuff)));
+      return -1;
+   }
+   if ((*aopts = copyopts(opts, GROUP_ALL)) == NULL) {
+      return -1;
+   }
+   if ((fd = xiosocket(*aopts, pf, socktype, protocol, E_INFO)) < 0) {
+      free(*aopts);
+      return -1;
+   }
+   xfd->fd = fd;
+   applyopts_offset(xfd, *aopts);
+   applyopts(fd, *aopts, PH_PASTSOCKET);
+   applyopts(fd, *aopts, PH_FD);
+   applyopts_cloexec(fd, *aopts);
+   if (xiobind(xfd, us, uslen, *aopts, pf, alt, E_INFO) < 0) {
+      Close(fd);  free(*aopts);
+      return -1;
+   }
+   applyopts(fd, *aopts, PH_CONNECT);
+   *fcntl_flags = Fcntl(fd, F_GETFL);
+   Fcntl_l(fd, F_SETFL, *fcntl_flags|O_NONBLOCK);
+   if (Connect(fd, &them->soa, themlen) < 0 && errno != EINPROGRESS) {
+      _errno = errno;
+      Info4("connect(%d, %s, "F_socklen"): %s",
+	    fd, sockaddr_info(&them->soa, themlen, infobuff, sizeof(infobuff)),
+	    themlen, strerror(errno));
+      Close(fd);  free(*aopts);
+      errno = _errno;
+      return -1;
+   }
+   return fd;
+}
+
+/* like _xioopen_connect(), but for option happy-eyeballs (RFC 8305): tries
+   the num addresses of addrs (IPv4 and IPv6) in parallel: starts the next
+   connect() when the previous one did not succeed within delay or failed.
+   keeps the socket that connects first and closes the others. the options
+   are applied to each attempt; opts then holds what the successful one left.
+   connect-timeout limits the whole procedure.
+   Does not fork, does not retry.
+   returns 0 on success. */
+int _xioopen_connect_happy(struct single *xfd,
+			   union sockaddr_union *us, size_t uslen,
+			   union sockaddr_union *addrs, int num,
+			   struct opt *opts, int socktype, int protocol,
+			   bool alt, int level) {
+   struct pollfd fds[XIO_HAPPY_MAXADDRS];
+   struct opt *aopts[XIO_HAPPY_MAXADDRS];	/* options of each attempt */
+   int aaddr[XIO_HAPPY_MAXADDRS];	/* index in addrs of each attempt */
+   int aflags[XIO_HAPPY_MAXADDRS];	/* fcntl flags of each socket */
+   struct timeval delay, now, nextstart, deadline = {0}, timeout, *to;
+   bool havedeadline = false;
+   int pending = 0, next = 0, winner = -1;
+   int lasterr = 0, lastaddr = 0;
+   socklen_t addrlen;
+   char infobuff[256];
+   int i, n, err;
+   socklen_t errlen;
+   int result;
+
+   delay = xfd->para.socket.ip.happy_delay;
+   if (delay.tv_sec == 0 && delay.tv_usec == 0) {
+      delay.tv_usec = 250000;	/* recommended by RFC 8305 */
+   }
+   if (num > XIO_HAPPY_MAXADDRS)  num = XIO_HAPPY_MAXADDRS;
+
+   Gettimeofday(&now, NULL);
+   nextstart = now;
+   while (winner < 0) {
+      /* start the next attempt when its time has come or none is pending */
+      while (next < num &&
+	     (pending == 0 ||
+	      now.tv_sec > nextstart.tv_sec ||
+	      (now.tv_sec == nextstart.tv_sec &&
+	       now.tv_usec >= nextstart.tv_usec))) {
+	 i = next++;
+	 Info1("happy-eyeballs: connecting to %s",
+	       sockaddr_info(&addrs[i].soa, sizeof(addrs[i]),
+			     infobuff, sizeof(infobuff)));
+	 fds[pending].fd =
+	    _xioopen_connect_start(xfd, us, uslen, &addrs[i], opts,
+				   &aopts[pending], &aflags[pending],
+				   socktype, protocol, alt);
+	 if (fds[pending].fd < 0) {
+	    lasterr = errno;  lastaddr = i;
+	    continue;	/* try the next address now */
+	 }
+	 if (!havedeadline &&
+	     (xfd->para.socket.connect_timeout.tv_sec  != 0 ||
+	      xfd->para.socket.connect_timeout.tv_usec != 0)) {
+	    deadline.tv_sec  = now.tv_sec  +
+	       xfd->para.socket.connect_timeout.tv_sec;
+	    deadline.tv_usec = now.tv_usec +
+	       xfd->para.socket.connect_timeout.tv_usec;
+	    if (deadline.tv_usec >= 1000000) {
+	       deadline.tv_usec -= 1000000;  ++deadline.tv_sec;
+	    }
+	    havedeadline = true;
+	 }
+	 fds[pending].events = POLLOUT;
+	 aaddr[pending] = i;
+	 ++pending;
+	 nextstart.tv_sec  = now.tv_sec  + delay.tv_sec;
+	 nextstart.tv_usec = now.tv_usec + delay.tv_usec;
+	 if (nextstart.tv_usec >= 1000000) {
+	    nextstart.tv_usec -= 1000000;  ++nextstart.tv_sec;
+	 }
+	 break;
+      }
+      if (pending == 0) {
+	 addrlen = (addrs[lastaddr].soa.sa_family == PF_INET ?
+		    sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6));
+	 Msg2(level, "connecting to %s: %s",
+	      sockaddr_info(&addrs[lastaddr].soa, addrlen,
+			    infobuff, sizeof(infobuff)),
+	      strerror(lasterr));
+	 return STAT_RETRYLATER;
+      }
+
+      /* wait until an attempt completes, the next one is due, or timeout */
+      to = NULL;
+      if (next < num) {
+	 timeout = nextstart;  to = &timeout;
+      }
+      if (havedeadline &&
+	  (to == NULL || deadline.tv_sec < timeout.tv_sec ||
+	   (deadline.tv_sec == timeout.tv_sec &&
+	    deadline.tv_usec < timeout.tv_usec))) {
+	 timeout = deadline;  to = &timeout;
+      }
+      if (to != NULL) {
+	 /* absolute time to interval */
+	 timeout.tv_sec  -= now.tv_sec;
+	 timeout.tv_usec -= now.tv_usec;
+	 if (timeout.tv_usec < 0) {
+	    timeout.tv_usec += 1000000;  --timeout.tv_sec;
+	 }
+	 if (timeout.tv_sec < 0) {
+	    timeout.tv_sec = 0;  timeout.tv_usec = 0;
+	 }
+      }
+      result = xiopoll(fds, pending, to);
+      if (result < 0 && errno != EINTR) {
+	 Msg2(level, "xiopoll({...}, %d, ...): %s", pending, strerror(errno));
+	 break;
+      }
+      Gettimeofday(&now, NULL);
+
+      for (n = 0; result > 0 && n < pending; ) {
+	 if (fds[n].revents == 0) {
+	    ++n;  continue;
+	 }
+	 errlen = sizeof(err);
+	 if (Getsockopt(fds[n].fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0) {
+	    err = errno;
+	 }
+	 if (err == 0) {
+	    winner = n;
+	    break;
+	 }
+	 addrlen = (addrs[aaddr[n]].soa.sa_family == PF_INET ?
+		    sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6));
+	 Info3("connect(%d, %s, ...): %s", fds[n].fd,
+	       sockaddr_info(&addrs[aaddr[n]].soa, addrlen,
+			     infobuff, sizeof(infobuff)),
+	       strerror(err));
+	 lasterr = err;  lastaddr = aaddr[n];
+	 Close(fds[n].fd);  free(aopts[n]);
+	 /* the next address need not wait */
+	 nextstart = now;
+	 --pending;
+	 fds[n] = fds[pending];  aopts[n] = aopts[pending];
+	 aaddr[n] = aaddr[pending];  aflags[n] = aflags[pending];
+      }
+      if (winner < 0 && havedeadline &&
+	  (now.tv_sec > deadline.tv_sec ||
+	   (now.tv_sec == deadline.tv_sec && now.tv_usec >= deadline.tv_usec))) {
+	 addrlen = (addrs[aaddr[0]].soa.sa_family == PF_INET ?
+		    sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6));
+	 Msg2(level, "connecting to %s: %s",
+	      sockaddr_info(&addrs[aaddr[0]].soa, addrlen,
+			    infobuff, sizeof(infobuff)),
+	      strerror(ETIMEDOUT));
+	 break;
+      }
+   }
+
+   /* close the attempts that did not win */
+   for (n = 0; n < pending; ++n) {
+      if (n == winner)  continue;
+      Close(fds[n].fd);  free(aopts[n]);
+   }
+   if (winner < 0) {
+      return STAT_RETRYLATER;
+   }
+
+   xfd->fd = fds[winner].fd;
+   Fcntl_l(xfd->fd, F_SETFL, aflags[winner]);
+   /* the copy is not longer than opts */
+   for (n = 0; aopts[winner][n].desc != ODESC_END; ++n) ;
+   memcpy(opts, aopts[winner], (n+1)*sizeof(struct opt));
+   free(aopts[winner]);
+   addrlen = (addrs[aaddr[winner]].soa.sa_family == PF_INET ?
+	      sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6));
+   Notice2("successfully connected to %s (address %d)",
+	   sockaddr_info(&addrs[aaddr[winner]].soa, addrlen,
+			 infobuff, sizeof(infobuff)),
+	   aaddr[winner]+1);
+
+   applyopts_fchown(xfd->fd, opts);	/* OPT_USER, OPT_GROUP */
+   applyopts(xfd->fd, opts, PH_CONNECTED);
+   applyopts(xfd->fd, opts, PH_LATE);
+
+   return STAT_OK;
+}
+
+
 /* a subroutine that is common to all socket addresses that want to connect
    to a peer address.
    might fork.
@@ -1082,9 +1340,10 @@ int _xioopen_dgram_sendto(/* them is already in xfd->peersa */
    again if it calls select()/poll() before the child process reads the
    packet.
    To solve this problem we implement the following mechanism:
-   The sub process sends a SIGUSR1 when it has read the packet (or a SIGCHLD if
-   it dies before). The parent process waits until it receives that signal and
-   only then continues to listen.
+   The sub process sends a SIGUSR1 when it has read the packet (or terminates
+   before). The parent process waits until it receives that signal or
+   xiochildreap() finds the sub process terminated, and only then continues
+   to listen.
    To prevent a signal from another process to trigger our loop, we pass the
    pid of the sub process to the signal handler in xio_waitingfor. The signal
    handler sets xio_hashappened if the pid matched.
@@ -1092,70 +1351,21 @@ int _xioopen_dgram_sendto(/* them is already in xfd->peersa */
 static pid_t xio_waitingfor;	/* info from recv loop to signal handler:
 				   indicates the pid of the child process
 				   that should send us the USR1 signal */
-static bool xio_hashappened;	/* info from signal handler to loop: child
-				   process has read ("consumed") the packet */
+static volatile sig_atomic_t xio_hashappened;	/* info from signal handler
+				   to loop: child process has read ("consumed")
+				   the packet */
 static int xio_childstatus;
+#if HAVE_SIGACTION
+static struct sigaction xio_prevusr1;	/* SIGUSR1 action before ours, e.g.
+				   for the statistics of socat -S */
+#endif
 
-/* this is the signal handler for USR1 and CHLD */
+/* this is the signal handler for USR1; is async-signal-safe */
 void xiosigaction_hasread(int signum
 #if HAVE_STRUCT_SIGACTION_SA_SIGACTION && defined(SA_SIGINFO)
 			  , siginfo_t *siginfo, void *ucontext
 #endif
 			  ) {
-   pid_t pid;
-   int _errno;
-   int status = 0;
-   bool wassig = false;
-
-   _errno = errno;
-   diag_in_handler = 1;
-#if HAVE_STRUCT_SIGACTION_SA_SIGACTION && defined(SA_SIGINFO)
-   Debug5("xiosigaction_hasread(%d, {%d,%d,%d,"F_pid"}, )",
-	  signum, siginfo->si_signo, siginfo->si_errno, siginfo->si_code,
-	  siginfo->si_pid);
-#else
-   Debug1("xiosigaction_hasread(%d)", signum);
-#endif
-   if (signum == SIGCHLD) {
-      do {
-	 pid = Waitpid(-1, &status, WNOHANG);
-	 if (pid == 0) {
-	    Msg(wassig?E_INFO:E_WARN,
-		"waitpid(-1, {}, WNOHANG): no child has exited");
-	    Info("xiosigaction_hasread() finished");
-	    Debug("xiosigaction_hasread() ->");
-	    diag_in_handler = 0;
-	    errno = _errno;
-	    return;
-	 } else if (pid < 0 && errno == ECHILD) {
-	    Msg(wassig?E_INFO:E_WARN,
-		 "waitpid(-1, {}, WNOHANG): "F_strerror);
-	    Info("xiosigaction_hasread() finished");
-	    Debug("xiosigaction_hasread() ->");
-	    diag_in_handler = 0;
-	    errno = _errno;
-	    return;
-	 }
-	 wassig = true;
-	 if (pid < 0) {
-	    Warn1("waitpid(-1, {%d}, WNOHANG): "F_strerror, status);
-	    Info("xiosigaction_hasread() finished");
-	    Debug("xiosigaction_hasread() ->");
-	    diag_in_handler = 0;
-	    errno = _errno;
-	    return;
-	 }
-	 if (pid == xio_waitingfor) {
-	    xio_waitingfor = 0; 	/* so this child will not set hashappened again */
-	    xio_hashappened = true;
-            xio_childstatus = WEXITSTATUS(status);
-	    Debug("xiosigaction_hasread() ->");
-	    diag_in_handler = 0;
-	    errno = _errno;
-	    return;
-	 }
-      } while (1);
-   }
 #if HAVE_STRUCT_SIGACTION_SA_SIGACTION && defined(SA_SIGINFO)
    if (xio_waitingfor == siginfo->si_pid) {
       xio_hashappened = true;
@@ -1164,12 +1374,8 @@ void xiosigaction_hasread(int signum
    xio_hashappened = true;
 #endif
 #if !HAVE_SIGACTION
-   Signal(sig, xiosigaction_hasread);
+   Signal(signum, xiosigaction_hasread);
 #endif /* !HAVE_SIGACTION */
-   Debug("xiosigaction_hasread() ->");
-   diag_in_handler = 0;
-   errno = _errno;
-   return;
 }
 
 
@@ -1252,6 +1458,10 @@ int _xioopen_dgram_recvfrom(struct single *xfd, int xioflags,
    xio_retropt_tcpwrap(xfd, opts);
 #endif /* && (WITH_TCP || WITH_UDP) && WITH_LIBWRAP */
 
+   if (xio_retropt_acl(xfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+
    if (xioopts.logopt == 'm') {
       Info("starting recvfrom loop, switching to syslog");
       diag_set('y', xioopts.syslogfac);  xioopts.logopt = 'y';
@@ -1278,24 +1488,18 @@ int _xioopen_dgram_recvfrom(struct single *xfd, int xioflags,
       act.sa_handler = xiosigaction_hasread;
 #endif
       sigfillset(&act.sa_mask);
-      if (Sigaction(SIGUSR1, &act, NULL) < 0) {
+      if (Sigaction(SIGUSR1, &act, &xio_prevusr1) < 0) {
          /*! Linux man does not explicitely say that errno is defined */
          Warn1("sigaction(SIGUSR1, {&xiosigaction_subaddr_ok}, NULL): %s", strerror(errno));
       }
-      if (Sigaction(SIGCHLD, &act, NULL) < 0) {
-         /*! Linux man does not explicitely say that errno is defined */
-         Warn1("sigaction(SIGCHLD, {&xiosigaction_subaddr_ok}, NULL): %s", strerror(errno));
-      }
    }
 #else /* !HAVE_SIGACTION */
    /*!!!*/
       if (Signal(SIGUSR1, xiosigaction_hasread) == SIG_ERR) {
 	 Warn1("signal(SIGUSR1, xiosigaction_hasread): %s", strerror(errno));
       }
-      if (Signal(SIGCHLD, xiosigaction_hasread) == SIG_ERR) {
-	 Warn1("signal(SIGCHLD, xiosigaction_hasread): %s", strerror(errno));
-      }
 #endif /* !HAVE_SIGACTION */
+      xiosetchilddied();	/* set SIGCHLD handler */
    }
 
    while (true) {	/* but we only loop if fork option is set */
@@ -1320,18 +1524,26 @@ int _xioopen_dgram_recvfrom(struct single *xfd, int xioflags,
 
       Info("Recvfrom: Checking/waiting for next packet");
       /* loop until select()/poll() returns valid */
+      if (us != NULL) {
+	 Notice1("receiving on %s", sockaddr_info(us, uslen, lisname, sizeof(lisname)));
+      } else {
+	 Notice1("receiving IP protocol %u", proto);
+      }
       do {
-	 struct pollfd readfd;
+	 struct pollfd readfd[2];
 	 /*? int level = E_ERROR;*/
-	 if (us != NULL) {
-	    Notice1("receiving on %s", sockaddr_info(us, uslen, lisname, sizeof(lisname)));
-	 } else {
-	    Notice1("receiving IP protocol %u", proto);
-	 }
-	 readfd.fd = xfd->fd;
-	 readfd.events = POLLIN;
-	 if (xiopoll(&readfd, 1, NULL) > 0) {
-	    break;
+	 /* a child that terminates while we wait is reaped here, not only
+	    with the next packet */
+	 xiochildreap();
+	 readfd[0].fd = xfd->fd;
+	 readfd[0].events = POLLIN;
+	 readfd[1].fd = xiochildfd();
+	 readfd[1].events = POLLIN;
+	 if (xiopoll(readfd, 2, NULL) > 0) {
+	    if (readfd[0].revents != 0) {
+	       break;
+	    }
+	    continue;	/* a child terminated */
 	 }
 
 	 if (errno == EINTR) {
@@ -1409,6 +1621,10 @@ int _xioopen_dgram_recvfrom(struct single *xfd, int xioflags,
 	 }
 
 	 if (pid == 0) {	/* child */
+#if HAVE_SIGACTION
+	    /* SIGUSR1 is ours only in the parent */
+	    Sigaction(SIGUSR1, &xio_prevusr1, NULL);
+#endif
 	    /* no reason to block SIGCHLD in child process */
 	    Sigprocmask(SIG_SETMASK, &oldset, NULL);
 	    xfd->ppid = Getppid();	/* send parent a signal when packet has
@@ -1444,7 +1660,14 @@ int _xioopen_dgram_recvfrom(struct single *xfd, int xioflags,
 	  Sigprocmask(SIG_SETMASK, &oldset, NULL);
 	  Sleep(1);	/* any signal speeds up return */
 #endif /* ! HAVE_PSELECT */
+	  xiochildreap();
+	  if (xio_waitingfor != 0 &&
+	      xiochildunknown(xio_waitingfor, &xio_childstatus)) {
+	     xio_waitingfor = 0;	/* terminated before it sent USR1 */
+	     xio_hashappened = true;
+	  }
 	 } while (!xio_hashappened) ;
+	 xio_waitingfor = 0;
 	 xio_hashappened = false;
 
          if (xio_childstatus != 0) {
@@ -1512,6 +1735,10 @@ int _xioopen_dgram_recv(struct single *xfd, int xioflags,
    xio_retropt_tcpwrap(xfd, opts);
 #endif /* && (WITH_TCP || WITH_UDP) && WITH_LIBWRAP */
 
+   if (xio_retropt_acl(xfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+
    if (xioopts.logopt == 'm') {
       Info("starting recvfrom loop, switching to syslog");
       diag_set('y', xioopts.syslogfac);  xioopts.logopt = 'y';
@@ -1726,6 +1953,19 @@ int xiocheckpeer(xiosingle_t *xfd,
    }
 #endif /* WITH_IP4 */
 
+   if (xfd->para.socket.acl != NULL) {
+      if (pa == NULL)  { return -1; }
+      if (xioacl_check(xfd->para.socket.acl, pa) < 0) {
+	 Warn1("refusing connection from %s due to allow-file or deny-file option",
+	       sockaddr_info(&pa->soa, 0,
+			     infobuff, sizeof(infobuff)));
+	 return -1;
+      }
+      Info1("permitting connection from %s due to allow-file or deny-file option",
+	    sockaddr_info(&pa->soa, 0,
+			  infobuff, sizeof(infobuff)));
+   }
+
 #if WITH_TCP || WITH_UDP
    if (xfd->para.socket.ip.dosourceport) {
       if (pa == NULL)  { return -1; }
@@ -26,6 +26,7 @@ extern const struct addrdesc xioaddr_socket_datagram;
 extern const struct addrdesc xioaddr_socket_recvfrom;
 extern const struct addrdesc xioaddr_socket_recv;
 
+extern const struct optdesc opt_batch;
 extern const struct optdesc opt_connect_timeout;
 extern const struct optdesc opt_so_debug;
 extern const struct optdesc opt_so_acceptconn;
@@ -95,6 +96,11 @@ extern int _xioopen_connect(struct single *fd,
 			    struct opt *opts,
 			    int pf, int socktype, int protocol,
 			    bool alt, int level);
+extern int _xioopen_connect_happy(struct single *xfd,
+				  union sockaddr_union *us, size_t uslen,
+				  union sockaddr_union *addrs, int num,
+				  struct opt *opts, int socktype, int protocol,
+				  bool alt, int level);
 
 /* common to xioopen_udp_sendto, ..unix_sendto, ..rawip */
 extern 
@@ -83,7 +83,7 @@ static int xioopen_socks4_connect(int argc, const char *argv[], struct opt *opts
    result = _xioopen_socks4_prepare(targetport, opts, &socksport, sockhead, &buflen);
    if (result != STAT_OK)  return result;
    result =
-      _xioopen_ipapp_prepare(opts, &opts0, sockdname, socksport,
+      _xioopen_ipapp_prepare(xfd, opts, &opts0, sockdname, socksport,
 			     &pf, ipproto,
 			     xfd->para.socket.ip.res_opts[1],
 			     xfd->para.socket.ip.res_opts[0],
@@ -123,12 +123,24 @@ static int xioopen_socks4_connect(int argc, const char *argv[], struct opt *opts
 	 return result;
       }
 
+      xioresolve_update(sockdname, socksport, pf, socktype, ipproto,
+			them, &themlen,
+			xfd->para.socket.ip.res_opts[1],
+			xfd->para.socket.ip.res_opts[0]);
       /* this cannot fork because we retrieved fork option above */
-      result =
-	 _xioopen_connect (xfd,
-			   needbind?us:NULL, sizeof(*us),
-			   (struct sockaddr *)them, themlen,
-			   opts, pf, socktype, IPPROTO_TCP, lowport, level);
+      if (xfd->para.socket.ip.happy_num > 1) {
+	 result =
+	    _xioopen_connect_happy(xfd, needbind?us:NULL, sizeof(*us),
+				   xfd->para.socket.ip.happy_addrs,
+				   xfd->para.socket.ip.happy_num,
+				   opts, socktype, IPPROTO_TCP, lowport, level);
+      } else {
+	 result =
+	    _xioopen_connect (xfd,
+			      needbind?us:NULL, sizeof(*us),
+			      (struct sockaddr *)them, themlen,
+			      opts, pf, socktype, IPPROTO_TCP, lowport, level);
+      }
       switch (result) {
       case STAT_OK: break;
 #if WITH_RETRY
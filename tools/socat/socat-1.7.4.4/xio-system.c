@@ -34,8 +34,15 @@ static int xioopen_system(int argc, const char *argv[], struct opt *opts,
    int duptostderr;
    int result;
    const char *string = argv[1];
-
-   status = _xioopen_foxec(xioflags, &fd->stream, groups, &opts, &duptostderr);
+   char *shargv[] = { "sh", "-c", NULL, NULL };
+   struct xiospawn spawn;
+
+   /* what system() executes, for posix_spawnp() */
+   shargv[2] = (char *)string;
+   spawn.file = "/bin/sh";
+   spawn.argv = shargv;
+   status = _xioopen_foxec(xioflags, &fd->stream, groups, &opts, &duptostderr,
+			   &spawn);
    if (status < 0)  return status;
    if (status == 0) {	/* child */
       int numleft;
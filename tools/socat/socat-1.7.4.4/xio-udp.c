@@ -15,6 +15,7 @@
 #include "xio-ip.h"
 #include "xio-ipapp.h"
 #include "xio-tcpwrap.h"
+#include "xio-acl.h"
 
 #include "xio-udp.h"
 
@@ -79,8 +80,9 @@ int _xioopen_ipdgram_listen(struct single *sfd,
 	struct opt *opts, int pf, int socktype, int ipproto) {
    union sockaddr_union themunion;
    union sockaddr_union *them = &themunion;
-   struct pollfd readfd;
+   struct pollfd readfd[2];
    bool dofork = false;
+   bool doeventloop = false;
    int maxchildren = 0;
    pid_t pid;
    char *rangename;
@@ -98,10 +100,26 @@ int _xioopen_ipdgram_listen(struct single *sfd,
       }
    }
 
+#if WITH_LISTEN && HAVE_SYS_EPOLL_H
+   retropt_bool(opts, OPT_EVENT_LOOP, &doeventloop);
+#endif
+
+   if (doeventloop) {
+      if (!(xioflags & XIO_MAYEVENTLOOP)) {
+	 Error("option event-loop not allowed here");
+	 return STAT_NORETRY;
+      }
+      if (dofork) {
+	 Error("options fork and event-loop are mutually exclusive");
+	 return STAT_NORETRY;
+      }
+      sfd->flags |= XIO_DOESEVENTLOOP;
+   }
+
    retropt_int(opts, OPT_MAX_CHILDREN, &maxchildren);
 
-   if (! dofork && maxchildren) {
-       Error("option max-children not allowed without option fork");
+   if (! dofork && ! doeventloop && maxchildren) {
+       Error("option max-children not allowed without option fork or event-loop");
        return STAT_NORETRY;
    }
 
@@ -119,6 +137,9 @@ int _xioopen_ipdgram_listen(struct single *sfd,
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* WITH_LIBWRAP */
+   if (xio_retropt_acl(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
 
    if (retropt_ushort(opts, OPT_SOURCEPORT, &sfd->para.socket.ip.sourceport)
        >= 0) {
@@ -178,11 +199,39 @@ int _xioopen_ipdgram_listen(struct single *sfd,
 		 sockaddr_info(&us->soa, uslen, infobuff, sizeof(infobuff)));
       }
 
-      readfd.fd = sfd->fd;
-      readfd.events = POLLIN|POLLERR;
-      while (xiopoll(&readfd, 1, NULL) < 0) {
-	 if (errno != EINTR)  break;
+#if WITH_LISTEN
+      if (doeventloop) {
+	 /* the application reads the datagrams with xiorecvpeer() and
+	    creates a session per peer with xioaccept_peer(); keep the
+	    remaining options for them */
+	 if (Fcntl_l(sfd->fd, F_SETFL, Fcntl(sfd->fd, F_GETFL)|O_NONBLOCK)
+	     < 0) {
+	    Warn2("fcntl(%d, F_SETFL, O_NONBLOCK): %s",
+		  sfd->fd, strerror(errno));
+	 }
+	 sfd->para.socket.evloop.opts     = copyopts(opts, GROUP_ALL);
+	 sfd->para.socket.evloop.maxconns = maxchildren;
+	 sfd->para.socket.evloop.proto    = ipproto;
+	 sfd->para.socket.evloop.dgram    = true;
+	 sfd->howtoend = END_CLOSE;
+	 dropopts(opts, PH_ALL);
+	 return 0;
       }
+#endif /* WITH_LISTEN */
+
+      /* a child that terminates while we wait is reaped here, not only
+	 with the next packet */
+      readfd[0].fd = sfd->fd;
+      readfd[0].events = POLLIN|POLLERR;
+      readfd[1].fd = xiochildfd();
+      readfd[1].events = POLLIN;
+      do {
+	 xiochildreap();
+	 if (xiopoll(readfd, 2, NULL) < 0) {
+	    if (errno != EINTR)  break;
+	    continue;
+	 }
+      } while (readfd[0].revents == 0);
 
       themlen = socket_init(pf, them);
       do {
@@ -233,11 +282,10 @@ int _xioopen_ipdgram_listen(struct single *sfd,
 	 }
 
 	 while (maxchildren) {
+	    xiochildreap();
 	    if (num_child < maxchildren) break;
 	    Notice("maxchildren are active, waiting");
-	    /* UINT_MAX would even be nicer, but Openindiana works only
-	       with 31 bits */
-	    while (!Sleep(INT_MAX)) ;	/* any signal lets us continue */
+	    xiochildwait();
 	 }
 	 Info("still listening");
 	 continue;
@@ -326,6 +374,100 @@ int xioopen_ipdgram_listen(int argc, const char *argv[], struct opt *opts,
 				  opts, pf, socktype, ipproto);
 }
 
+#if WITH_LISTEN
+/* reads one datagram from the event-loop listener sock (see option
+   event-loop) into buff and returns its sender in pa, palen.
+   returns the number of bytes, or -1 with errno EAGAIN when no datagram is
+   waiting or it could not be read */
+ssize_t xiorecvpeer(xiofile_t *sock, void *buff, size_t bufsiz,
+		    union sockaddr_union *pa, socklen_t *palen) {
+   struct single *xfd = &sock->stream;
+   socklen_t salen = *palen;
+   ssize_t bytes;
+   int _errno;
+
+   do {
+      *palen = salen;
+      bytes = Recvfrom(xfd->fd, buff, bufsiz, 0, &pa->soa, palen);
+   } while (bytes < 0 && errno == EINTR);
+   if (bytes < 0) {
+      _errno = errno;
+      switch (_errno) {
+      case EAGAIN:
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+      case EWOULDBLOCK:
+#endif
+	 break;
+      default:
+	 /* e.g. ECONNREFUSED from an ICMP error of a previous sendto() */
+	 Info4("recvfrom(%d, %p, "F_Zu", 0, ...): %s",
+	       xfd->fd, buff, bufsiz, strerror(_errno));
+      }
+      errno = EAGAIN;
+      return -1;
+   }
+   return bytes;
+}
+
+/* checks the peer pa of a datagram that arrived on the event-loop listener
+   sock and creates the front of a new session for it: a copy of the
+   listener that shares its socket and sends to pa.
+   returns the new descriptor, or NULL when the peer is not permitted or on
+   error */
+xiofile_t *xioaccept_peer(xiofile_t *sock, const union sockaddr_union *pa,
+			  socklen_t palen) {
+   struct single *xfd = &sock->stream;
+   xiofile_t *nfd;
+   union sockaddr_union la;
+   socklen_t las = sizeof(la);
+   char infobuff[256];
+
+   if (sock->tag == XIO_TAG_DUAL || !(xfd->flags & XIO_DOESEVENTLOOP) ||
+       !xfd->para.socket.evloop.dgram) {
+      Error1("xioaccept_peer(): descriptor %p is not a datagram event-loop listener", sock);
+      errno = EINVAL;
+      return NULL;
+   }
+   if (Getsockname(xfd->fd, &la.soa, &las) < 0) {
+      Warn4("getsockname(%d, %p, {"F_socklen"}): %s",
+	    xfd->fd, &la.soa, las, strerror(errno));
+      las = 0;
+   }
+   if (xiocheckpeer(xfd, (union sockaddr_union *)pa, &la) < 0) {
+      Notice1("forbidding UDP connection from %s",
+	      sockaddr_info(&pa->soa, palen, infobuff, sizeof(infobuff)));
+      errno = EACCES;
+      return NULL;
+   }
+   Notice1("accepting UDP connection from %s",
+	   sockaddr_info(&pa->soa, palen, infobuff, sizeof(infobuff)));
+
+   if ((nfd = Malloc(sizeof(xiofile_t))) == NULL) {
+      return NULL;
+   }
+   /* the session sends with sendto() on the socket of the listener, so it
+      must neither shut down nor close it */
+   memcpy(nfd, sock, sizeof(xiofile_t));
+   nfd->stream.flags &= ~XIO_DOESEVENTLOOP;
+   nfd->stream.dtype = XIODATA_RECVFROM;
+   memcpy(&nfd->stream.peersa, pa, palen);
+   nfd->stream.salen = palen;
+   nfd->stream.howtoend = END_NONE;
+   nfd->stream.howtoshut = XIOSHUT_NONE;
+   nfd->stream.wrbuf.dontwait = true;	/* drop instead of blocking */
+   nfd->stream.opts = NULL;
+   nfd->stream.para.socket.evloop.opts = NULL;
+
+   /* set the env vars describing the local and remote sockets */
+   if (las > 0)
+      xiosetsockaddrenv("SOCK", &la, las, xfd->para.socket.evloop.proto);
+   xiosetsockaddrenv("PEER", (union sockaddr_union *)pa, palen,
+		     xfd->para.socket.evloop.proto);
+   return nfd;
+}
+#endif /* WITH_LISTEN */
+
+
 static
 int xioopen_udp_sendto(int argc, const char *argv[], struct opt *opts,
 		     int xioflags, xiofile_t *xxfd, unsigned groups,
@@ -474,6 +616,9 @@ int xioopen_udp_datagram(int argc, const char *argv[], struct opt *opts,
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(xfd, opts);
 #endif /* WITH_LIBWRAP */
+   if (xio_retropt_acl(xfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
 
    _xio_openlate(xfd, opts);
    return STAT_OK;
@@ -628,6 +773,9 @@ int xioopen_udp_recv(int argc, const char *argv[], struct opt *opts,
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(&xfd->stream, opts);
 #endif /* WITH_LIBWRAP */
+   if (xio_retropt_acl(&xfd->stream, opts) < 0) {
+      return STAT_NORETRY;
+   }
 
    if (retropt_ushort(opts, OPT_SOURCEPORT,
 		      &xfd->stream.para.socket.ip.sourceport)
@@ -12,6 +12,7 @@
 #include "xio-listen.h"
 #include "xio-socket.h"
 #include "xio-vsock.h"
+#include "xio-preconnect.h"
 
 static int xioopen_vsock_connect(int argc, const char *argv[], struct opt *opts,
         int xioflags, xiofile_t *xxfd, unsigned groups, int abstract,
@@ -22,15 +23,21 @@ static int xioopen_vsock_listen(int argc, const char *argv[], struct opt *opts,
 
 const struct addrdesc addr_vsock_connect = { "vsock-connect", 1 + XIO_RDWR,
     xioopen_vsock_connect,
-    GROUP_FD|GROUP_SOCKET|GROUP_CHILD|GROUP_RETRY,
+    GROUP_FD|GROUP_SOCKET|GROUP_SOCK_VSOCK|GROUP_CHILD|GROUP_RETRY,
     0, 0, 0 HELP(":<cid>:<port>") };
 #if WITH_LISTEN
 const struct addrdesc addr_vsock_listen  = { "vsock-listen", 1 + XIO_RDWR,
     xioopen_vsock_listen,
-    GROUP_FD|GROUP_SOCKET|GROUP_LISTEN|GROUP_CHILD|GROUP_RETRY,
+    GROUP_FD|GROUP_SOCKET|GROUP_SOCK_VSOCK|GROUP_LISTEN|GROUP_CHILD|GROUP_RANGE|GROUP_RETRY,
     0, 0, 0 HELP(":<port>") };
 #endif /* WITH_LISTEN */
 
+#ifdef SO_VM_SOCKETS_BUFFER_SIZE
+const struct optdesc opt_vsock_buffer_size = { "vsock-buffer-size", NULL, OPT_VSOCK_BUFFER_SIZE, GROUP_SOCK_VSOCK, PH_PASTSOCKET, TYPE_LONGLONG, OFUNC_SOCKOPT, AF_VSOCK, SO_VM_SOCKETS_BUFFER_SIZE };
+const struct optdesc opt_vsock_buffer_min  = { "vsock-buffer-min",  NULL, OPT_VSOCK_BUFFER_MIN,  GROUP_SOCK_VSOCK, PH_PASTSOCKET, TYPE_LONGLONG, OFUNC_SOCKOPT, AF_VSOCK, SO_VM_SOCKETS_BUFFER_MIN_SIZE };
+const struct optdesc opt_vsock_buffer_max  = { "vsock-buffer-max",  NULL, OPT_VSOCK_BUFFER_MAX,  GROUP_SOCK_VSOCK, PH_PASTSOCKET, TYPE_LONGLONG, OFUNC_SOCKOPT, AF_VSOCK, SO_VM_SOCKETS_BUFFER_MAX_SIZE };
+#endif /* SO_VM_SOCKETS_BUFFER_SIZE */
+
 static int vsock_addr_init(struct sockaddr_vm *sa, const char *cid_str,
         const char *port_str) {
    int ret;
@@ -45,10 +52,36 @@ static int vsock_addr_init(struct sockaddr_vm *sa, const char *cid_str,
    return STAT_OK;
 }
 
+#ifdef SO_VM_SOCKETS_BUFFER_SIZE
+/* the kernel clamps SO_VM_SOCKETS_BUFFER_SIZE to the current min and max
+   values, so move vsock-buffer-size behind vsock-buffer-min and
+   vsock-buffer-max, whatever order the user gave */
+static void vsock_sortopts(struct opt *opts) {
+   struct opt size;
+   int i, n, unsorted;
+
+   for (n = 0; opts[n].desc != ODESC_END; ++n) ;
+   i = 0;  unsorted = n;
+   while (i < unsorted) {
+      if (opts[i].desc != &opt_vsock_buffer_size) {
+	 ++i;  continue;
+      }
+      size = opts[i];
+      memmove(&opts[i], &opts[i+1], (n-i-1)*sizeof(struct opt));
+      opts[n-1] = size;
+      --unsorted;
+   }
+}
+#endif /* SO_VM_SOCKETS_BUFFER_SIZE */
+
 static int vsock_init(struct opt *opts, struct single *xfd) {
 
    xfd->howtoend = END_SHUTDOWN;
 
+#ifdef SO_VM_SOCKETS_BUFFER_SIZE
+   vsock_sortopts(opts);
+#endif
+
    if (applyopts_single(xfd, opts, PH_INIT) < 0)
       return STAT_NORETRY;
 
@@ -89,6 +122,10 @@ static int xioopen_vsock_connect(int argc, const char *argv[], struct opt *opts,
       return ret;
    }
 
+   if ((xfd->fd = xiopreconnect_take(opts)) >= 0) {
+      return _xio_openlate(xfd, opts);
+   }
+
    ret = retropt_bind(opts, pf, socktype, protocol,
                       (struct sockaddr *)&sa_local, &sa_len, 3, 0, 0);
    if (ret == STAT_NORETRY)
@@ -8,6 +8,10 @@
 extern const struct addrdesc addr_vsock_connect;
 extern const struct addrdesc addr_vsock_listen;
 
+extern const struct optdesc opt_vsock_buffer_size;
+extern const struct optdesc opt_vsock_buffer_min;
+extern const struct optdesc opt_vsock_buffer_max;
+
 extern int xiosetsockaddrenv_vsock(int idx, char *namebuff, size_t namelen,
 			       char *valuebuff, size_t valuelen,
 			       struct sockaddr_vm *sa, int ipproto);
@@ -32,12 +32,19 @@ struct opt;
 #define XIO_MAYEXEC    16 /* address is allowed to exec a prog (exec+nofork) */
 #define XIO_MAYCONVERT 32 /* address is allowed to perform modifications on the
 			     stream data, e.g. SSL, REALDINE; CRLF */
+#define XIO_MAYEVENTLOOP 64 /* listen address may leave accepting connections
+			       to the applications event loop (event-loop) */
+#define XIO_MAYINPROGRESS 128 /* connect address may return while connect()
+				is still in progress (event-loop) */
 
 /* the status flags of xiofile_t */
 #define XIO_DOESFORK    XIO_MAYFORK
 #define XIO_DOESCHILD   XIO_MAYCHILD
 #define XIO_DOESEXEC    XIO_MAYEXEC
 #define XIO_DOESCONVERT XIO_MAYCONVERT
+#define XIO_DOESEVENTLOOP XIO_MAYEVENTLOOP
+#define XIO_DOESINPROGRESS XIO_MAYINPROGRESS /* the FD becomes writable when
+						connect() has completed */
 
 
 /* methods for reading and writing, and for related checks */
@@ -102,6 +109,7 @@ typedef struct {
    char default_ip;	/* default prot.fam for IP based listen ('4' or '6') */
    char preferred_ip;	/* preferred prot.fam. for name resolution ('0' for
 			   unspecified, '4', or '6') */
+   bool nospawn;	/* start EXEC and SYSTEM children with fork() only */
 } xioopts_t;
 
 /* pack the description of a lock file */
@@ -122,6 +130,10 @@ struct para_ip {
 	bool     dosourceport; 	/* check the source port of incoming connection or packets */
 	uint16_t sourceport;		/* host byte order */
 	bool     lowport;
+	bool     happy;		/* option happy-eyeballs */
+	struct timeval happy_delay;	/* between the connect attempts */
+	int      happy_num;	/* number of happy_addrs */
+	union sockaddr_union *happy_addrs;	/* all resolved addresses */
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
 	bool   dolibwrap;
 	char    *libwrapname;
@@ -132,6 +144,35 @@ struct para_ip {
 } ;
 #endif /* _WITH_IP4 || _WITH_IP6 */
 
+/* ring buffer for data that has been read but could not yet be written */
+struct xioring {
+   unsigned char *buff;
+   size_t size;		/* capacity; 0..no buffer, write synchronously */
+   size_t head;		/* offset of the oldest waiting byte */
+   size_t len;		/* number of waiting bytes */
+   bool   dontwait;	/* FD is a socket, send() with MSG_DONTWAIT */
+} ;
+
+#define XIO_BATCHMAX	1024	/* most datagrams per call, like UIO_MAXIOV */
+#define XIO_BATCHCTRL	256	/* space for ancillary messages per datagram */
+
+#if _WITH_SOCKET && HAVE_RECVMMSG
+/* datagrams received with one recvmmsg() call (option batch); xioread()
+   returns them one by one */
+struct xiobatch {
+   unsigned int num;	/* datagrams per call; 0..receive them singly */
+   size_t bufsiz;	/* space for each datagram */
+   unsigned char *buff;
+   struct mmsghdr *msgs;
+   struct iovec *iov;
+   union sockaddr_union *from;
+   char *ctrl;		/* ancillary messages */
+   unsigned int *accepted;	/* datagrams that passed the peer checks */
+   unsigned int len;	/* number of accepted datagrams */
+   unsigned int next;	/* the next one for xioread() */
+} ;
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG */
+
 /* a non-dual file descriptor */ 
 typedef struct single {
    enum xiotag tag;	/* see  enum xiotag  */
@@ -192,6 +233,10 @@ typedef struct single {
    pid_t ppid;			/* parent pid, only if we send it signals */
    int escape;			/* escape character; -1 for no escape */
    bool actescape;		/* escape character found in input data */
+   struct xioring wrbuf;	/* data waiting to be written, see xiowritebuffered() */
+#if _WITH_SOCKET && HAVE_RECVMMSG
+   struct xiobatch batch;	/* received datagrams, see xioread_batch() */
+#endif
    union {
       struct {
 	 int fdout;		/* use fd for output */
@@ -207,10 +252,19 @@ typedef struct single {
 	 bool null_eof;		/* with dgram: empty packet means EOF */
 	 bool dorange;
 	 struct xiorange range;	/* restrictions for peer address */
+	 struct xioacl *acl;	/* allow-file, deny-file */
 #if _WITH_IP4 || _WITH_IP6
 	 struct para_ip ip;
 #endif /* _WITH_IP4 || _WITH_IP6 */
 	 /* up to here, keep consistent copy in openssl part !!! */
+#if WITH_LISTEN
+	 struct {
+	    struct opt *opts;	/* options to apply to each accepted socket */
+	    int maxconns;	/* max-children; 0 for unlimited */
+	    int proto;
+	    bool dgram;		/* datagram listener, sessions by peer */
+	 } evloop;		/* with option event-loop */
+#endif /* WITH_LISTEN */
 #if WITH_UNIX
 	 struct {
 	    bool     tight;
@@ -246,6 +300,7 @@ typedef struct single {
 	 bool null_eof;		/* with dgram: empty packet means EOF */
 	 bool dorange;
 	 struct xiorange range;	/* restrictions for peer address */
+	 struct xioacl *acl;	/* allow-file, deny-file */
 #if _WITH_IP4 || _WITH_IP6
 	 struct para_ip ip;
 #endif /* _WITH_IP4 || _WITH_IP6 */
@@ -258,6 +313,8 @@ typedef struct single {
 #if HAVE_SSL_CTX_set_max_proto_version || defined(SSL_CTX_set_max_proto_version)
 	 char *max_proto_version;
 #endif
+	 bool ktls_send;	/* the kernel encrypts, splice() possible */
+	 bool ktls_recv;	/* the kernel decrypts, splice() possible */
       } openssl;
 #endif /* WITH_OPENSSL */
 #if WITH_TUN
@@ -327,6 +384,9 @@ struct addrdesc {
 #define XIO_WRSTREAM(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[1]:&(s)->stream)
 #define XIO_GETRDFD(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[0]->fd:(s)->stream.fd)
 #define XIO_GETWRFD(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[1]->fd:(((s)->stream.dtype&XIODATA_WRITEMASK)==XIOWRITE_2PIPE)?(s)->stream.para.exec.fdout:(((s)->stream.dtype&XIODATA_WRITEMASK)==XIOWRITE_PIPE)?(s)->stream.para.bipipe.fdout:(s)->stream.fd)
+/* number of bytes waiting in the write buffer, and free space in it */
+#define XIO_WRPENDING(s) (XIO_WRSTREAM(s)->wrbuf.len)
+#define XIO_WRROOM(s) (XIO_WRSTREAM(s)->wrbuf.size-XIO_WRSTREAM(s)->wrbuf.len)
 #define XIO_EOF(s) (XIO_RDSTREAM(s)->eof && !XIO_RDSTREAM(s)->ignoreeof)
 
 typedef unsigned long flags_t;
@@ -439,27 +499,55 @@ extern int xio_forked_inchild(void);
 extern int xiosetopt(char what, const char *arg);
 extern int xioinqopt(char what, char *arg, size_t n);
 extern xiofile_t *xioopen(const char *args, int flags);
+extern xiofile_t *xioparse(const char *addr);
+extern xiofile_t *xioclone(const xiofile_t *tmpl);
+extern bool xioshared(const xiofile_t *tmpl);
+extern bool xioretrying(const xiofile_t *tmpl);
+extern xiofile_t *xioopen_parsed(xiofile_t *xfd, int flags);
+extern int xiopreconnect(const xiofile_t *tmpl, int xioflags);
+extern int xioresolve_prefetch(const xiofile_t *tmpl);
+extern xiofile_t *xioaccept(xiofile_t *sock);
+extern ssize_t xiorecvpeer(xiofile_t *sock, void *buff, size_t bufsiz,
+			   union sockaddr_union *pa, socklen_t *palen);
+extern xiofile_t *xioaccept_peer(xiofile_t *sock,
+				 const union sockaddr_union *pa,
+				 socklen_t palen);
 extern int xioopensingle(char *addr, struct single *xfd, int xioflags);
 extern int xioopenhelp(FILE *of, int level);
 
 /* must be outside function for use by childdied handler */
 extern xiofile_t *sock1, *sock2;
-#define NUMUNKNOWN 4
-extern pid_t diedunknown[NUMUNKNOWN];	/* child died before it is registered */
-#define diedunknown1 (diedunknown[0])
-#define diedunknown2 (diedunknown[1])
-#define diedunknown3 (diedunknown[2])
-#define diedunknown4 (diedunknown[3])
-extern int   statunknown[NUMUNKNOWN]; 	/* exit state of unknown dead child */
 
 extern int xiosetsigchild(xiofile_t *xfd, int (*callback)(struct single *));
 extern int xiosetchilddied(void);
+extern void (*xiochilddied_hook)(pid_t pid);
 extern int xio_opt_signal(pid_t pid, int signum);
+extern volatile sig_atomic_t xio_sighup_count;
+extern void xio_sighup_arm(void);
+extern void xio_sighup_reset(void);
+extern int xio_sighup_fd(void);
+extern void xio_sighup_drain(void);
 extern void childdied(int signum);
+extern int xiochildfd(void);
+extern int xiochildreap(void);
+extern int xiochildwait(void);
+extern int xiochildunknown(pid_t pid, int *status);
+extern void xiochildunknown_clear(void);
+extern void xiochild_forked(void);
 
 extern ssize_t xioread(xiofile_t *sock1, void *buff, size_t bufsiz);
 extern ssize_t xiopending(xiofile_t *sock1);
 extern ssize_t xiowrite(xiofile_t *sock1, const void *buff, size_t bufsiz);
+extern ssize_t xiowritepart(xiofile_t *sock1, const void *buff, size_t bufsiz);
+extern int xiowrbuf_init(xiofile_t *sock1, size_t bufsiz);
+extern ssize_t xiowritebuffered(xiofile_t *sock1, const void *buff, size_t bufsiz, bool maywrite);
+extern ssize_t xioflush(xiofile_t *sock1);
+#if _WITH_SOCKET && HAVE_RECVMMSG
+extern void xioread_batchfree(struct single *pipe);
+#endif
+#if _WITH_SOCKET && HAVE_SENDMMSG
+extern ssize_t xiowritebatch(xiofile_t *sock1, struct iovec *iov, unsigned int n);
+#endif
 extern int xioshutdown(xiofile_t *sock, int how);
 
 extern int xioclose(xiofile_t *sock);
@@ -53,6 +53,8 @@ int xioclose1(struct single *pipe) {
    if (pipe->fd >= 0) {
       switch (pipe->howtoend) {
       case END_KILL: case END_SHUTDOWN_KILL: case END_CLOSE_KILL:
+	 /* a child that already terminated reports its exit status */
+	 xiochildreap();
 	 if (pipe->para.exec.pid > 0) {
 	    pid_t pid;
 
@@ -80,6 +82,20 @@ int xioclose1(struct single *pipe) {
       case END_NONE: default: break;
       }
    }
+   /* the write end of PIPE and of EXEC/SYSTEM with pipes is a separate FD */
+   if ((pipe->dtype & XIODATA_WRITEMASK) == XIOWRITE_PIPE &&
+       pipe->para.bipipe.fdout >= 0) {
+      if (Close(pipe->para.bipipe.fdout) < 0) {
+	 Info2("close(%d): %s", pipe->para.bipipe.fdout, strerror(errno));
+      }
+      pipe->para.bipipe.fdout = -1;
+   } else if ((pipe->dtype & XIODATA_WRITEMASK) == XIOWRITE_2PIPE &&
+	      pipe->para.exec.fdout >= 0) {
+      if (Close(pipe->para.exec.fdout) < 0) {
+	 Info2("close(%d): %s", pipe->para.exec.fdout, strerror(errno));
+      }
+      pipe->para.exec.fdout = -1;
+   }
 
    /* unlock */
    if (pipe->havelock) {
@@ -92,6 +108,17 @@ int xioclose1(struct single *pipe) {
       }
       free(pipe->unlink_close);
    }
+   if (pipe->wrbuf.buff != NULL) {
+      if (pipe->wrbuf.len > 0) {
+	 Info2("fd %d: discarding "F_Zu" unwritten bytes", pipe->fd, pipe->wrbuf.len);
+      }
+      free(pipe->wrbuf.buff);
+      pipe->wrbuf.buff = NULL;
+      pipe->wrbuf.size = pipe->wrbuf.len = 0;
+   }
+#if _WITH_SOCKET && HAVE_RECVMMSG
+   xioread_batchfree(pipe);
+#endif
 
    pipe->tag = XIO_TAG_INVALID;
    return 0;	/*! */
@@ -42,7 +42,7 @@ static const char *optiontypenames[] = {
 /* keep consistent with xioopts.h:#define GROUP_* ! */
 static const char *addressgroupnames[] = {
 	"FD",		"FIFO",		"CHR",		"BLK",
-	"REG",		"SOCKET",	"READLINE",	"undef",
+	"REG",		"SOCKET",	"READLINE",	"VSOCK",
 	"NAMED",	"OPEN",		"EXEC",		"FORK",
 	"LISTEN",	"DEVICE",	"CHILD",	"RETRY",
 	"TERMIOS",	"RANGE",	"PTY",		"PARENT",
@@ -166,12 +166,10 @@ static int xio_nokill(xiofile_t *sock) {
    returns 0 on success or != 0 if an error occurred */
 int xio_forked_inchild(void) {
    int result = 0;
-   int i;
 
    diag_fork();
-   for (i=0; i<NUMUNKNOWN; ++i) {
-      diedunknown[i] = 0;
-   }
+   xiochild_forked();
+   xio_sighup_reset();
    num_child = 0;
    xiodroplocks();
 #if WITH_FIPS
@@ -205,6 +203,9 @@ pid_t xio_fork(bool subchild, int level) {
    const char *forkwaitstring;
    int forkwaitsecs = 0;
 
+   /* children that terminated meanwhile, so num_child is up to date */
+   xiochildreap();
+   xiochildunknown_clear();
    if ((pid = Fork()) < 0) {
       Msg1(level, "fork(): %s", strerror(errno));
       return pid;
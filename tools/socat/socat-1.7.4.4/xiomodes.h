@@ -33,6 +33,8 @@
 #include "xio-socks.h"
 #include "xio-proxy.h"
 #include "xio-vsock.h"
+#include "xio-preconnect.h"
+#include "xio-acl.h"
 #endif /* _WITH_SOCKET */
 #include "xio-progcall.h"
 #include "xio-exec.h"
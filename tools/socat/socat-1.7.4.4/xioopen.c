@@ -14,7 +14,6 @@ static xiofile_t *xioallocfd(void);
 
 xiosingle_t hugo;
 static xiosingle_t *xioparse_single(const char **addr);
-static xiofile_t *xioparse_dual(const char **addr);
 static int xioopen_dual(xiofile_t *xfd, int xioflags);
 
 const struct addrname addressnames[] = {
@@ -325,6 +324,12 @@ const struct addrname addressnames[] = {
    { NULL }	/* end marker */
 } ;
 
+#ifndef XIO_KEYWHASH_GEN
+/* the perfect hash for addressnames, generated at build time from the
+   preprocessed table above */
+#include "xioaddrhash.h"
+#endif
+
 int xioopen_single(xiofile_t *xfd, int xioflags);
 
 
@@ -386,15 +391,113 @@ xiofile_t *xioopen(const char *addr,	/* address specification */
 		   int xioflags) {
    xiofile_t *xfd;
 
+   Debug1("xioopen(\"%s\")", addr);
+
+   if ((xfd = xioparse(addr)) == NULL) {
+      return NULL;
+   }
+   return xioopen_parsed(xfd, xioflags);
+}
+
+/* parse the argument that specifies a two-directional data stream without
+   opening it. the result can be opened with xioopen_parsed(), or kept as
+   template for xioclone() when the address is opened more than once.
+   returns NULL on error */
+xiofile_t *xioparse(const char *addr) {
+
    if (xioinitialize() < 0) {
       return NULL;
    }
+   return xioparse_dual(&addr);
+}
 
-   Debug1("xioopen(\"%s\")", addr);
+/* returns a copy of the parsed but not opened address tmpl with its own
+   option array, so opening the copy does not consume the options of the
+   template. argument strings and option values are shared.
+   returns NULL on error */
+xiofile_t *xioclone(const xiofile_t *tmpl) {
+   xiofile_t *xfd;
+
+   if ((xfd = Malloc(sizeof(xiofile_t))) == NULL) {
+      return NULL;
+   }
+   memcpy(xfd, tmpl, sizeof(xiofile_t));
+   if (tmpl->tag == XIO_TAG_DUAL) {
+      if ((xfd->dual.stream[0] =
+	   (xiosingle_t *)xioclone((xiofile_t *)tmpl->dual.stream[0]))
+	  == NULL) {
+	 free(xfd);
+	 return NULL;
+      }
+      if ((xfd->dual.stream[1] =
+	   (xiosingle_t *)xioclone((xiofile_t *)tmpl->dual.stream[1]))
+	  == NULL) {
+	 free(xfd->dual.stream[0]->opts);  free(xfd->dual.stream[0]);
+	 free(xfd);
+	 return NULL;
+      }
+      return xfd;
+   }
+   if (tmpl->stream.opts != NULL &&
+       (xfd->stream.opts = copyopts(tmpl->stream.opts, GROUP_ALL)) == NULL) {
+      free(xfd);
+      return NULL;
+   }
+   return xfd;
+}
+
+/* returns true if the parsed address tmpl does not create FDs of its own but
+   uses ones that already exist (STDIO, FD, ...), so all instances opened
+   with xioclone() would share them */
+bool xioshared(const xiofile_t *tmpl) {
+   const struct addrdesc *addr;
+
+   if (tmpl->tag == XIO_TAG_DUAL) {
+      return xioshared((xiofile_t *)tmpl->dual.stream[0]) ||
+	 xioshared((xiofile_t *)tmpl->dual.stream[1]);
+   }
+   addr = tmpl->stream.addr;
+   return
+#if WITH_STDIO
+      addr == &addr_stdio || addr == &addr_stdin ||
+      addr == &addr_stdout || addr == &addr_stderr ||
+#endif
+#if WITH_FDNUM
+      addr == &addr_fd ||
+#endif
+      false;
+}
+
+/* returns true if the parsed address tmpl has option retry or forever, so
+   opening it might wait between the attempts */
+bool xioretrying(const xiofile_t *tmpl) {
+   const struct opt *opt;
+
+   if (tmpl->tag == XIO_TAG_DUAL) {
+      return xioretrying((xiofile_t *)tmpl->dual.stream[0]) ||
+	 xioretrying((xiofile_t *)tmpl->dual.stream[1]);
+   }
+   if (tmpl->stream.opts == NULL) {
+      return false;
+   }
+   for (opt = tmpl->stream.opts; opt->desc != ODESC_END; ++opt) {
+      if (opt->desc == ODESC_DONE)  continue;
+      if (opt->desc->optcode == OPT_RETRY ||
+	  opt->desc->optcode == OPT_FOREVER) {
+	 return true;
+      }
+   }
+   return false;
+}
+
+/* opens the address xfd from xioparse() or xioclone().
+   returns xfd, or NULL on error */
+xiofile_t *xioopen_parsed(xiofile_t *xfd, int xioflags) {
 
-   if ((xfd = xioparse_dual(&addr)) == NULL) {
+   if (xfd == NULL) {
       return NULL;
    }
+   xiochildunknown_clear();
    /*!! support n socks */
    if (!sock[0]) {
       sock[0] = xfd;
@@ -411,7 +514,7 @@ xiofile_t *xioopen(const char *addr,	/* address specification */
 
 /* parse an address string that might contain !!
    return NULL on error */
-static xiofile_t *xioparse_dual(const char **addr) {
+xiofile_t *xioparse_dual(const char **addr) {
    xiofile_t *xfd;
    xiosingle_t *sfd1;
 
@@ -522,8 +625,7 @@ static xiosingle_t *xioparse_single(const char **addr) {
    }
    *tokp = '\0';  /*! len? */
    ae = (struct addrname *)
-      keyw((struct wordent *)&addressnames, token,
-	   sizeof(addressnames)/sizeof(struct addrname)-1);
+      keyw_hash((struct wordent *)&addressnames, &xioaddr_hash, token);
 
    if (ae) {
       addrdesc = ae->desc;
@@ -591,6 +693,9 @@ static xiosingle_t *xioparse_single(const char **addr) {
    return sfd;
 }
 
+/* opens the parsed address xfd. The address function works on the options in
+   xfd->stream.opts but does not free the array: it belongs to xfd, and whoever
+   created xfd frees it, e.g. the event loop for each of its connections */
 int xioopen_single(xiofile_t *xfd, int xioflags) {
    const struct addrdesc *addrdesc;
    int result;
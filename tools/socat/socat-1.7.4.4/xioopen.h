@@ -44,6 +44,7 @@ extern const struct addrname addressnames[];
 extern const struct optname optionnames[];
 
 extern int xioopen_makedual(xiofile_t *file);
+extern xiofile_t *xioparse_dual(const char **addr);
 
 #define retropt_2bytes(o,c,r) retropt_ushort(o,c,r)
 
@@ -168,6 +168,7 @@ const struct optname optionnames[] = {
 	IF_IP     ("add-source-membership",	&opt_ip_add_source_membership)
 #endif
 	IF_TUN    ("allmulti",	&opt_iff_allmulti)
+	IF_SOCKET ("allow-file",	&opt_allow_file)
 #if WITH_LIBWRAP && defined(HAVE_HOSTS_ALLOW_TABLE)
 	IF_IPAPP  ("allow-table",	&opt_tcpwrap_hosts_allow_table)
 #endif
@@ -259,6 +260,9 @@ const struct optname optionnames[] = {
 	IF_TERMIOS("b9600",	&opt_b9600)
 #endif /* defined(CBAUD) */
 	IF_LISTEN ("backlog",	&opt_backlog)
+#if HAVE_RECVMMSG
+	IF_SOCKET ("batch",	&opt_batch)
+#endif
 #ifdef O_BINARY
 	IF_OPEN   ("bin",		&opt_o_binary)
 	IF_OPEN   ("binary",		&opt_o_binary)
@@ -373,6 +377,7 @@ const struct optname optionnames[] = {
 	IF_OPEN   ("delay",	&opt_o_delay)
 #endif
 	IF_NAMED  ("delete",	&opt_unlink)
+	IF_SOCKET ("deny-file",	&opt_deny_file)
 #if WITH_LIBWRAP && defined(HAVE_HOSTS_DENY_TABLE)
 	IF_IPAPP  ("deny-table",	&opt_tcpwrap_hosts_deny_table)
 #endif
@@ -432,6 +437,9 @@ const struct optname optionnames[] = {
 	IF_TERMIOS("erase",	&opt_verase)
 	IF_SOCKET ("error",	&opt_so_error)
 	IF_ANY    ("escape",	&opt_escape)
+#if HAVE_SYS_EPOLL_H
+	IF_LISTEN ("event-loop",	&opt_event_loop)
+#endif
 	IF_OPEN   ("excl",	&opt_o_excl)
 #if WITH_FS && defined(FS_APPEND_FL)
 	IF_ANY    ("ext2-append",	&opt_fs_append)
@@ -596,6 +604,10 @@ const struct optname optionnames[] = {
 	IF_ANY    ("group",	&opt_group)
 	IF_NAMED  ("group-early",	&opt_group_early)
 	IF_ANY    ("group-late",	&opt_group_late)
+	IF_IP     ("happy",	&opt_happy_eyeballs)
+	IF_IP     ("happy-delay",	&opt_happy_eyeballs_delay)
+	IF_IP     ("happy-eyeballs",	&opt_happy_eyeballs)
+	IF_IP     ("happy-eyeballs-delay",	&opt_happy_eyeballs_delay)
 #ifdef IP_HDRINCL
 	IF_IP     ("hdrincl",	&opt_ip_hdrincl)
 #endif
@@ -878,6 +890,7 @@ const struct optname optionnames[] = {
 #endif /* SO_KERNACCEPT */
 	IF_OPENSSL("key",	&opt_openssl_key)
 	IF_TERMIOS("kill",	&opt_vkill)
+	IF_OPENSSL("ktls",	&opt_openssl_ktls)
 #ifdef O_LARGEFILE
 	IF_OPEN   ("largefile",	&opt_o_largefile)
 #endif
@@ -1177,6 +1190,7 @@ const struct optname optionnames[] = {
 	IF_OPENSSL("openssl-fips",	&opt_openssl_fips)
 #endif
 	IF_OPENSSL("openssl-key",	&opt_openssl_key)
+	IF_OPENSSL("openssl-ktls",	&opt_openssl_ktls)
 #if HAVE_SSL_set_max_proto_version || defined(SSL_set_max_proto_version)
 	IF_OPENSSL("openssl-max-proto-version",	&opt_openssl_max_proto_version)
 #endif
@@ -1190,6 +1204,7 @@ const struct optname optionnames[] = {
 	IF_OPENSSL("openssl-no-sni",	&opt_openssl_no_sni)
 #endif
 	IF_OPENSSL("openssl-pseudo",	&opt_openssl_pseudo)
+	IF_OPENSSL("openssl-session-cache",	&opt_openssl_session_cache)
 #if defined(HAVE_SSL_set_tlsext_host_name) || defined(SSL_set_tlsext_host_name)
 	IF_OPENSSL("openssl-snihost",   &opt_openssl_snihost)
 #endif
@@ -1234,6 +1249,9 @@ const struct optname optionnames[] = {
 #endif
 	/*IF_IPAPP("port",	&opt_port)*/
 	IF_TUN    ("portsel",	&opt_iff_portsel)
+	IF_SOCKET ("preconnect",	&opt_preconnect)
+	IF_LISTEN ("prefork",	&opt_prefork)
+	IF_LISTEN ("prefork-max",	&opt_prefork_max)
 #if HAVE_RESOLV_H && WITH_RES_PRIMARY
 	IF_IP     ("primary",	&opt_res_primary)
 #endif
@@ -1349,6 +1367,9 @@ const struct optname optionnames[] = {
 #endif /* HAVE_RESOLV_H */
 	IF_PROXY  ("resolv",	&opt_proxy_resolve)
 	IF_PROXY  ("resolve",	&opt_proxy_resolve)
+	IF_IP     ("resolve-async",	&opt_resolve_async)
+	IF_IP     ("resolve-neg-ttl",	&opt_resolve_neg_ttl)
+	IF_IP     ("resolve-ttl",	&opt_resolve_ttl)
 #ifdef IP_RETOPTS
 	IF_IP     ("retopts",	&opt_ip_retopts)
 #endif
@@ -1422,6 +1443,7 @@ const struct optname optionnames[] = {
 	IF_ANY    ("seek-end",		&opt_lseek32_end)
 	IF_ANY    ("seek-set",		&opt_lseek32_set)
 #endif
+	IF_OPENSSL("session-cache",	&opt_openssl_session_cache)
 	IF_ANY    ("setgid",	&opt_setgid)
 	IF_ANY    ("setgid-early",	&opt_setgid_early)
 	IF_ANY 	  ("setlk",	&opt_f_setlk_wr)
@@ -1796,6 +1818,11 @@ const struct optname optionnames[] = {
 	IF_TERMIOS("vquit",	&opt_vquit)
 #ifdef VREPRINT
 	IF_TERMIOS("vreprint",	&opt_vreprint)
+#endif
+#if WITH_VSOCK && defined(SO_VM_SOCKETS_BUFFER_SIZE)
+	IF_SOCKET ("vsock-buffer-max",	&opt_vsock_buffer_max)
+	IF_SOCKET ("vsock-buffer-min",	&opt_vsock_buffer_min)
+	IF_SOCKET ("vsock-buffer-size",	&opt_vsock_buffer_size)
 #endif
 	IF_TERMIOS("vstart",	&opt_vstart)
 	IF_TERMIOS("vstop",	&opt_vstop)
@@ -1829,6 +1856,9 @@ const struct optname optionnames[] = {
 #ifdef TCP_WINDOW_CLAMP	/* Linux 2.4.0 */
 	IF_TCP    ("window-clamp",	&opt_tcp_window_clamp)
 #endif
+#ifdef SO_REUSEPORT
+	IF_LISTEN ("workers",	&opt_workers)
+#endif
 #if WITH_LIBWRAP
 	IF_IPAPP  ("wrap",		&opt_tcpwrappers)
 #endif
@@ -1842,6 +1872,15 @@ const struct optname optionnames[] = {
 	{ NULL }
 } ;
 
+#ifndef XIO_KEYWHASH_GEN
+/* the perfect hash for optionnames, generated at build time from the
+   preprocessed table above */
+#include "xioopthash.h"
+#endif
+
+/* parseopts_table() takes the table as parameter that hides optionnames */
+static const struct optname *const xioopt_table = optionnames;
+
 
 /* walks the text argument a and writes its options that conform to groups 
    to the array opts. Uses the option table 'optionnames'.
@@ -1938,8 +1977,13 @@ int parseopts_table(const char **a, unsigned int groups, struct opt **opts,
       }
       *tokp = '\0';
 
-      ent = (struct optname *)
-	 keyw((struct wordent *)optionnames, token, optionnum);
+      if (optionnames == xioopt_table && optionnum == xioopt_hash.num) {
+	 ent = (struct optname *)
+	    keyw_hash((struct wordent *)optionnames, &xioopt_hash, token);
+      } else {
+	 ent = (struct optname *)
+	    keyw((struct wordent *)optionnames, token, optionnum);
+      }
       if (ent == NULL) {
 	 Error1("parseopts_table(): unknown option \"%s\"", token);
 	 continue;
@@ -3389,6 +3433,18 @@ int applyopts(int fd, struct opt *opts, enum e_phase phase) {
 	       }
 	       break;
 #endif /* HAVE_STRUCT_LINGER */
+#if HAVE_TYPE_LONGLONG
+	    case TYPE_LONGLONG:
+	       if (Setsockopt(fd, opt->desc->major, opt->desc->minor,
+			      &opt->value.u_longlong, sizeof(opt->value.u_longlong)) < 0) {
+		  Error6("setsockopt(%d, %d, %d, {%Ld}, "F_Zu"): %s",
+			 fd, opt->desc->major, opt->desc->minor,
+			 opt->value.u_longlong, sizeof(opt->value.u_longlong),
+			 strerror(errno));
+		  opt->desc = ODESC_ERROR; ++opt; continue;
+	       }
+	       break;
+#endif /* HAVE_TYPE_LONGLONG */
 #if defined(HAVE_STRUCT_IP_MREQ) || defined (HAVE_STRUCT_IP_MREQN)
 	    case TYPE_IP_MREQN:
 	       /* handled in applyopts_single */
@@ -3869,6 +3925,8 @@ static int applyopt_offset(struct single *xfd, struct opt *opt) {
       *(bool *)ptr = opt->value.u_bool;  break;
    case TYPE_INT:
       *(int *)ptr = opt->value.u_int;  break;
+   case TYPE_UINT:
+      *(unsigned int *)ptr = opt->value.u_uint;  break;
    case TYPE_DOUBLE:
       *(double *)ptr = opt->value.u_double;  break;
    case TYPE_TIMEVAL:
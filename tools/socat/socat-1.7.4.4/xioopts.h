@@ -145,6 +145,7 @@ enum e_func {
 #define GROUP_FILE GROUP_REG
 #define GROUP_SOCKET	0x00000020
 #define GROUP_READLINE	0x00000040
+#define GROUP_SOCK_VSOCK	0x00000080
 
 #define GROUP_NAMED	0x00000100	/* file system entry */
 #define GROUP_OPEN	0x00000200	/* flags for open() */
@@ -224,6 +225,7 @@ enum e_optcode {
    OPT_B3500000,	/* termios.c_cflag */
    OPT_B4000000,	/* termios.c_cflag */
    OPT_BACKLOG,
+   OPT_BATCH,		/* recvmmsg(), sendmmsg() */
    OPT_BIND,	/* a socket address as character string */
    OPT_BRKINT,		/* termios.c_iflag */
 #ifdef BSDLY
@@ -281,6 +283,7 @@ enum e_optcode {
 #endif
    OPT_END_CLOSE,	/* xfd.stream.howtoend = END_CLOSE */
    OPT_ESCAPE,
+   OPT_EVENT_LOOP,
    OPT_FDIN,
    OPT_FDOUT,
 #ifdef FFDLY
@@ -324,6 +327,8 @@ enum e_optcode {
    OPT_GROUP,
    OPT_GROUP_EARLY,
    OPT_GROUP_LATE,
+   OPT_HAPPY_EYEBALLS,
+   OPT_HAPPY_EYEBALLS_DELAY,
    OPT_HISTORY_FILE,	/* readline history file */
    OPT_HUPCL,		/* termios.c_cflag */
    OPT_ICANON,		/* termios.c_lflag */
@@ -492,11 +497,13 @@ enum e_optcode {
    OPT_OPENSSL_EGD,
    OPT_OPENSSL_FIPS,
    OPT_OPENSSL_KEY,
+   OPT_OPENSSL_KTLS,
    OPT_OPENSSL_MAX_PROTO_VERSION,
    OPT_OPENSSL_METHOD,
    OPT_OPENSSL_MIN_PROTO_VERSION,
    OPT_OPENSSL_NO_SNI,
    OPT_OPENSSL_PSEUDO,
+   OPT_OPENSSL_SESSION_CACHE,
    OPT_OPENSSL_SNIHOST,
    OPT_OPENSSL_VERIFY,
    OPT_OPOST,		/* termios.c_oflag */
@@ -568,6 +575,9 @@ enum e_optcode {
    OPT_PERM_LATE,
    OPT_PIPES,
    /*OPT_PORT,*/
+   OPT_PRECONNECT,
+   OPT_PREFORK,
+   OPT_PREFORK_MAX,
    OPT_PROMPT,		/* readline */
    OPT_PROTOCOL,	/* 6=TCP, 17=UDP */
    OPT_PROTOCOL_FAMILY,	/* 1=PF_UNIX, 2=PF_INET, 10=PF_INET6 */
@@ -582,8 +592,13 @@ enum e_optcode {
    OPT_PTY_INTERVALL,
    OPT_PTY_WAIT_SLAVE,
    OPT_RANGE,		/* restrict client socket address */
+   OPT_ALLOW_FILE,	/* restrict client socket address, list of networks */
+   OPT_DENY_FILE,	/* restrict client socket address, list of networks */
    OPT_RAW,		/* termios */
    OPT_READBYTES,
+   OPT_RESOLVE_ASYNC,
+   OPT_RESOLVE_NEG_TTL,
+   OPT_RESOLVE_TTL,
    OPT_RES_AAONLY,	/* resolver(3) */
    OPT_RES_DEBUG,	/* resolver(3) */
    OPT_RES_DEFNAMES,	/* resolver(3) */
@@ -826,6 +841,9 @@ enum e_optcode {
    OPT_VMIN, 		/* termios.c_cc */
    OPT_VQUIT,		/* termios.c_cc */
    OPT_VREPRINT,	/* termios.c_cc */
+   OPT_VSOCK_BUFFER_MAX,
+   OPT_VSOCK_BUFFER_MIN,
+   OPT_VSOCK_BUFFER_SIZE,
    OPT_VSTART,		/* termios.c_cc */
    OPT_VSTOP,		/* termios.c_cc */
    OPT_VSUSP,		/* termios.c_cc */
@@ -844,6 +862,7 @@ enum e_optcode {
    OPT_VWERASE,		/* termios.c_cc */
 #endif
    OPT_WAITLOCK,
+   OPT_WORKERS,
 #ifdef XCASE
    OPT_XCASE,		/* termios.c_lflag */
 #endif
@@ -0,0 +1,136 @@
+/* source: xioparse-bench.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* microbenchmark of the address parser: looks up every option and address
+   keyword with the binary search keyw() and with the perfect hash
+   keyw_hash(), checks that both find the same entries, and compares parsing
+   an address with many options to copying the parsed template with
+   xioclone().
+   build with "make xioparse-bench"; usage: ./xioparse-bench [rounds] */
+
+#include "config.h"
+#include "xioconfig.h"	/* what features are enabled */
+
+#include "sysincludes.h"
+
+#include "mytypes.h"
+#include "compat.h"
+#include "error.h"
+
+#include "sycls.h"
+#include "sysutils.h"
+#include "utils.h"
+#include "xio.h"
+#include "xioopts.h"
+#include "xioopen.h"
+
+#include "xioopthash.h"
+#include "xioaddrhash.h"
+
+/* libxio refers to the sockets of socat.c */
+xiofile_t *sock1, *sock2;
+
+#define BENCH_ADDRESS "TCP4:localhost:80,connect-timeout=5,keepalive,nodelay,sndbuf=65536,rcvbuf=65536,retry=3,interval=1,reuseaddr,bind=127.0.0.1,linger=2,tos=16,ttl=32,cloexec,nonblock,setsockopt-int=6:1:1,shut-down"
+
+static double now(void) {
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* looks up each keyword of table rounds times with both functions; returns
+   the ns per lookup of each in nskeyw, nshash, or -1 when they disagree */
+static int bench_keyw(const struct wordent *table, size_t entsize,
+		      const struct wordhash *hash, int rounds,
+		      double *nskeyw, double *nshash) {
+   const struct wordent *e, *h;
+   const char *name;
+   char upper[64];
+   double t0, t1, t2;
+   unsigned int i, j;
+   int r;
+
+   /* entries are larger than struct wordent in the option table */
+#define ENT(i) ((const struct wordent *)((const char *)table + (i)*entsize))
+   if (ENT(hash->num)->name != NULL) {
+      fputs("hash does not cover the whole table\n", stderr);
+      return -1;
+   }
+   for (i = 0; i < hash->num; ++i) {
+      name = ENT(i)->name;
+      for (j = 0; name[j] && j < sizeof(upper)-1; ++j)
+	 upper[j] = toupper((unsigned char)name[j]);
+      upper[j] = '\0';
+      e = keyw(table, upper, hash->num);
+      h = keyw_hash(table, hash, upper);
+      if (e == NULL || e != h) {
+	 fprintf(stderr, "keyword \"%s\": keyw() %p, keyw_hash() %p\n",
+		 name, (void *)e, (void *)h);
+	 return -1;
+      }
+   }
+   if (keyw_hash(table, hash, "no-such-keyword") != NULL) {
+      fputs("keyw_hash() found \"no-such-keyword\"\n", stderr);
+      return -1;
+   }
+
+   t0 = now();
+   for (r = 0; r < rounds; ++r)
+      for (i = 0; i < hash->num; ++i)
+	 if (keyw(table, ENT(i)->name, hash->num) == NULL)  return -1;
+   t1 = now();
+   for (r = 0; r < rounds; ++r)
+      for (i = 0; i < hash->num; ++i)
+	 if (keyw_hash(table, hash, ENT(i)->name) == NULL)  return -1;
+   t2 = now();
+#undef ENT
+   *nskeyw = (t1 - t0) * 1e9 / rounds / hash->num;
+   *nshash = (t2 - t1) * 1e9 / rounds / hash->num;
+   return 0;
+}
+
+int main(int argc, const char *argv[]) {
+   xiofile_t *tmpl, *xfd;
+   double t0, t1, t2, nskeyw, nshash;
+   int rounds = 1000;
+   int r, i;
+
+   if (argc > 1)  rounds = atoi(argv[1]);
+   if (rounds <= 0)  rounds = 1;
+   diag_set('p', "xioparse-bench");
+
+   if (bench_keyw((const struct wordent *)optionnames,
+		  sizeof(struct optname), &xioopt_hash, rounds,
+		  &nskeyw, &nshash) < 0) {
+      return 1;
+   }
+   printf("%-9s %4u keywords  keyw() %6.1f ns  keyw_hash() %6.1f ns\n",
+	  "options", xioopt_hash.num, nskeyw, nshash);
+   if (bench_keyw((const struct wordent *)addressnames,
+		  sizeof(struct addrname), &xioaddr_hash, rounds,
+		  &nskeyw, &nshash) < 0) {
+      return 1;
+   }
+   printf("%-9s %4u keywords  keyw() %6.1f ns  keyw_hash() %6.1f ns\n",
+	  "addresses", xioaddr_hash.num, nskeyw, nshash);
+
+   if ((tmpl = xioparse(BENCH_ADDRESS)) == NULL) {
+      return 1;
+   }
+   t0 = now();
+   for (r = 0; r < rounds; ++r) {
+      if ((xfd = xioparse(BENCH_ADDRESS)) == NULL)  return 1;
+      for (i = 0; i < xfd->stream.argc; ++i)  free((char *)xfd->stream.argv[i]);
+      free(xfd->stream.opts);  free(xfd);
+   }
+   t1 = now();
+   for (r = 0; r < rounds; ++r) {
+      if ((xfd = xioclone(tmpl)) == NULL)  return 1;
+      free(xfd->stream.opts);  free(xfd);
+   }
+   t2 = now();
+   printf("address with 16 options  xioparse() %6.2f us  xioclone() %6.2f us\n",
+	  (t1 - t0) * 1e6 / rounds, (t2 - t1) * 1e6 / rounds);
+   return 0;
+}
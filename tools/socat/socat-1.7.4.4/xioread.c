@@ -13,6 +13,217 @@
 #include "xio-openssl.h"
 
  
+#if _WITH_SOCKET
+/* on packet type we also receive outgoing packets, this is not desired.
+   returns true when the packet from this sender is to be skipped */
+static bool xioread_skippacket(union sockaddr_union *from) {
+#if defined(PF_PACKET) && defined(PACKET_OUTGOING)
+   if (from->soa.sa_family == PF_PACKET) {
+      if ((from->ll.sll_pkttype & PACKET_OUTGOING)
+	  == 0) {
+	 return true;
+      }
+   }
+#endif /* defined(PF_PACKET) && defined(PACKET_OUTGOING) */
+   return false;
+}
+
+/* a peer address is registered, so we need to check if the sender of a
+   packet matches.
+   returns 0 if so, or -1 when the packet is to be ignored */
+static int xioread_checkpeersa(struct single *pipe,
+			       union sockaddr_union *from, socklen_t fromlen) {
+#if 0 /* with UNIX sockets we find inconsistent lengths */
+   if (fromlen != pipe->salen) {
+      Info("recvfrom(): wrong peer address length, ignoring packet");
+      return -1;
+   }
+#endif
+   if (pipe->dtype & XIOREAD_RECV_SKIPIP) {
+      if (pipe->peersa.soa.sa_family != from->soa.sa_family) {
+	 Info("recvfrom(): wrong peer protocol, ignoring packet");
+	 return -1;
+      }
+#if WITH_IP4
+      switch (pipe->peersa.soa.sa_family) {
+      case PF_INET:
+	 if (pipe->peersa.ip4.sin_addr.s_addr !=
+	     from->ip4.sin_addr.s_addr) {
+	    Info("recvfrom(): wrong peer address, ignoring packet");
+	    return -1;
+	 }
+	 break;
+      }
+#endif /* WITH_IP4 */
+   } else {
+      switch (pipe->peersa.soa.sa_family) {
+#if 0
+      case PF_UNIX:
+	 if (strncmp(pipe->peersa.un.sun_path, from->un.sun_path,
+		     sizeof(from->un.sun_path))) {
+	    Info("recvfrom(): wrong peer address, ignoring packet");
+	    return -1;
+	 }
+	 break;
+#endif
+#if WITH_IP6
+      case PF_INET6:
+	 /* e.g. Solaris recvfrom sets a __sin6_src_id component */
+	 if (memcmp(&from->ip6.sin6_addr, &pipe->peersa.ip6.sin6_addr,
+		    sizeof(from->ip6.sin6_addr)) ||
+	     from->ip6.sin6_port != pipe->peersa.ip6.sin6_port) {
+	    Info("recvfrom(): wrong peer address, ignoring packet");
+	    return -1;
+	 }
+	 break;
+#endif /* WITH_IP6 */
+      default:
+	 if (memcmp(from, &pipe->peersa, fromlen)) {
+	    Info("recvfrom(): wrong peer address, ignoring packet");
+	    return -1;
+	 }
+      }
+   }
+   return 0;
+}
+
+#if HAVE_RECVMMSG
+/* allocates the buffers for pipe->batch.num datagrams of up to bufsiz bytes.
+   returns 0 on success, or -1 on error */
+static int xioread_batchinit(struct single *pipe, size_t bufsiz) {
+   struct xiobatch *b = &pipe->batch;
+
+   if (b->num > XIO_BATCHMAX) {
+      Warn2("batch=%u: using %u", b->num, XIO_BATCHMAX);
+      b->num = XIO_BATCHMAX;
+   }
+   if ((b->buff = Malloc(b->num*bufsiz)) == NULL ||
+       (b->msgs = Calloc(b->num, sizeof(struct mmsghdr))) == NULL ||
+       (b->iov  = Calloc(b->num, sizeof(struct iovec))) == NULL ||
+       (b->from = Calloc(b->num, sizeof(union sockaddr_union))) == NULL ||
+       (b->ctrl = Malloc(b->num*XIO_BATCHCTRL)) == NULL ||
+       (b->accepted = Calloc(b->num, sizeof(unsigned int))) == NULL) {
+      xioread_batchfree(pipe);
+      return -1;
+   }
+   b->bufsiz = bufsiz;
+   Info3("fd %d: receiving up to %u datagrams of "F_Zu" bytes per call",
+	 pipe->fd, b->num, bufsiz);
+   return 0;
+}
+
+void xioread_batchfree(struct single *pipe) {
+   struct xiobatch *b = &pipe->batch;
+
+   free(b->buff);  free(b->msgs);  free(b->iov);  free(b->from);
+   free(b->ctrl);  free(b->accepted);
+   b->buff = NULL;  b->msgs = NULL;  b->iov = NULL;  b->from = NULL;
+   b->ctrl = NULL;  b->accepted = NULL;
+   b->bufsiz = 0;  b->len = b->next = 0;
+}
+
+/* receives up to pipe->batch.num datagrams with one recvmmsg() call and
+   applies the peer checks to all of them; the accepted ones are queued.
+   returns the number of accepted datagrams, or -1 on error */
+static int xioread_batchfill(struct single *pipe) {
+   struct xiobatch *b = &pipe->batch;
+   union sockaddr_union *from;
+   socklen_t fromlen;
+   char infobuff[256];
+   unsigned int i;
+   int n;
+
+   for (i = 0; i < b->num; ++i) {
+      struct msghdr *msgh = &b->msgs[i].msg_hdr;
+      b->iov[i].iov_base = b->buff + i*b->bufsiz;
+      b->iov[i].iov_len  = b->bufsiz;
+      socket_init(pipe->para.socket.la.soa.sa_family, &b->from[i]);
+      msgh->msg_name = &b->from[i];
+      msgh->msg_namelen = sizeof(b->from[i]);
+      msgh->msg_iov = &b->iov[i];
+      msgh->msg_iovlen = 1;
+#if HAVE_STRUCT_MSGHDR_MSGCONTROL
+      msgh->msg_control = b->ctrl + i*XIO_BATCHCTRL;
+#endif
+#if HAVE_STRUCT_MSGHDR_MSGCONTROLLEN
+      msgh->msg_controllen = XIO_BATCHCTRL;
+#endif
+#if HAVE_STRUCT_MSGHDR_MSGFLAGS
+      msgh->msg_flags = 0;
+#endif
+   }
+   b->len = b->next = 0;
+   /* poll() reported the first datagram, do not wait for more */
+   do {
+      n = Recvmmsg(pipe->fd, b->msgs, b->num, MSG_DONTWAIT, NULL);
+   } while (n < 0 && errno == EINTR);
+   if (n < 0) {
+      int _errno = errno;
+      if (_errno != EAGAIN) {
+	 Error4("recvmmsg(%d, %p, %u, MSG_DONTWAIT, NULL): %s",
+		pipe->fd, b->msgs, b->num, strerror(_errno));
+      }
+      errno = _errno;
+      return -1;
+   }
+   Debug2("fd %d: received %d datagrams", pipe->fd, n);
+
+   for (i = 0; i < (unsigned int)n; ++i) {
+      from = &b->from[i];
+      fromlen = b->msgs[i].msg_hdr.msg_namelen;
+      if (pipe->dtype & XIOREAD_RECV_FROM) {
+	 if (xioread_skippacket(from)) {
+	    continue;
+	 }
+	 if (pipe->peersa.soa.sa_family != PF_UNSPEC &&
+	     xioread_checkpeersa(pipe, from, fromlen) < 0) {
+	    continue;
+	 }
+      } else {
+	 xiodopacketinfo(&b->msgs[i].msg_hdr, true, false);
+	 if (xiocheckpeer(pipe, from, &pipe->para.socket.la) < 0) {
+	    continue;
+	 }
+	 Info1("permitting packet from %s",
+	       sockaddr_info(&from->soa, fromlen, infobuff, sizeof(infobuff)));
+      }
+      b->accepted[b->len++] = i;
+   }
+   return b->len;
+}
+
+/* passes the next queued datagram of pipe in buff and its sender in from,
+   receiving a new batch when the queue is empty.
+   returns the number of bytes, or -1 (EAGAIN when no datagram passed the
+   peer checks) */
+static ssize_t xioread_batch(struct single *pipe, void *buff, size_t bufsiz,
+			     union sockaddr_union *from, socklen_t *fromlen) {
+   struct xiobatch *b = &pipe->batch;
+   unsigned int i;
+   size_t bytes;
+
+   if (b->buff == NULL && xioread_batchinit(pipe, bufsiz) < 0) {
+      return -1;
+   }
+   if (b->next >= b->len) {
+      if (xioread_batchfill(pipe) < 0) {
+	 return -1;
+      }
+      if (b->len == 0) {
+	 errno = EAGAIN;  return -1;
+      }
+   }
+   i = b->accepted[b->next++];
+   bytes = Min(b->msgs[i].msg_len, bufsiz);
+   memcpy(buff, b->iov[i].iov_base, bytes);
+   memcpy(from, &b->from[i], sizeof(*from));
+   *fromlen = b->msgs[i].msg_hdr.msg_namelen;
+   return bytes;
+}
+#endif /* HAVE_RECVMMSG */
+#endif /* _WITH_SOCKET */
+
+
 /* xioread() performs read() or recvfrom()
    If result is < 0, errno is valid */
 ssize_t xioread(xiofile_t *file, void *buff, size_t bufsiz) {
@@ -119,50 +330,57 @@ ssize_t xioread(xiofile_t *file, void *buff, size_t bufsiz) {
       socklen_t fromlen = sizeof(from);
       char infobuff[256];
       char ctrlbuff[1024];	/* ancillary messages */
+      bool batched = false;
       int rc;
 
-      msgh.msg_name = &from;
-      msgh.msg_namelen = fromlen;
+#if HAVE_RECVMMSG
+      if (pipe->batch.num > 0 && !(pipe->dtype & XIOREAD_RECV_ONESHOT)) {
+	 /* the peer checks were applied to the whole batch */
+	 batched = true;
+	 if ((bytes = xioread_batch(pipe, buff, bufsiz, &from, &fromlen)) < 0) {
+	    return -1;
+	 }
+      } else
+#endif /* HAVE_RECVMMSG */
+      {
+	 msgh.msg_name = &from;
+	 msgh.msg_namelen = fromlen;
 #if HAVE_STRUCT_MSGHDR_MSGCONTROL
-      msgh.msg_control = ctrlbuff;
+	 msgh.msg_control = ctrlbuff;
 #endif
 #if HAVE_STRUCT_MSGHDR_MSGCONTROLLEN
-      msgh.msg_controllen = sizeof(ctrlbuff);
+	 msgh.msg_controllen = sizeof(ctrlbuff);
 #endif
 
-      while ((rc = xiogetpacketsrc(pipe->fd, &msgh,
-			  MSG_PEEK
+	 while ((rc = xiogetpacketsrc(pipe->fd, &msgh,
+			     MSG_PEEK
 #ifdef MSG_TRUNC
-			  |MSG_TRUNC
+			     |MSG_TRUNC
 #endif
-				   )) < 0 &&
-	     errno == EINTR) ;
-      if (rc < 0)  return -1;
-
-      do {
-	 bytes =
-	    Recvfrom(pipe->fd, buff, bufsiz, 0, &from.soa, &fromlen);
-      } while (bytes < 0 && errno == EINTR);
-      if (bytes < 0) {
-	 char infobuff[256];
-	 _errno = errno;
-	 Error6("recvfrom(%d, %p, "F_Zu", 0, %s, {"F_socklen"}): %s",
-		pipe->fd, buff, bufsiz,
-		sockaddr_info(&from.soa, fromlen, infobuff, sizeof(infobuff)),
-		fromlen, strerror(errno));
-	 errno = _errno;
-	 return -1;
-      }
-      /* on packet type we also receive outgoing packets, this is not desired
-       */
-#if defined(PF_PACKET) && defined(PACKET_OUTGOING)
-      if (from.soa.sa_family == PF_PACKET) {
-	 if ((from.ll.sll_pkttype & PACKET_OUTGOING)
-	    == 0) {
+				      )) < 0 &&
+		errno == EINTR) ;
+	 if (rc < 0)  return -1;
+
+	 do {
+	    bytes =
+	       Recvfrom(pipe->fd, buff, bufsiz, 0, &from.soa, &fromlen);
+	 } while (bytes < 0 && errno == EINTR);
+	 if (bytes < 0) {
+	    char infobuff[256];
+	    _errno = errno;
+	    Error6("recvfrom(%d, %p, "F_Zu", 0, %s, {"F_socklen"}): %s",
+		   pipe->fd, buff, bufsiz,
+		   sockaddr_info(&from.soa, fromlen, infobuff, sizeof(infobuff)),
+		   fromlen, strerror(errno));
+	    errno = _errno;
+	    return -1;
+	 }
+	 /* on packet type we also receive outgoing packets, this is not desired
+	  */
+	 if (xioread_skippacket(&from)) {
 	    errno = EAGAIN;  return -1;
 	 }
       }
-#endif /* defined(PF_PACKET) && defined(PACKET_OUTGOING) */
 	    
       Notice2("received packet with "F_Zu" bytes from %s",
 	      bytes,
@@ -174,59 +392,9 @@ ssize_t xioread(xiofile_t *file, void *buff, size_t bufsiz) {
 	 return bytes;
       }
 
-      if (pipe->peersa.soa.sa_family != PF_UNSPEC) {
-	 /* a peer address is registered, so we need to check if it matches */
-#if 0 /* with UNIX sockets we find inconsistent lengths */
-	 if (fromlen != pipe->salen) {
-	    Info("recvfrom(): wrong peer address length, ignoring packet");
-	    errno = EAGAIN; return -1;
-	 }
-#endif
-	 if (pipe->dtype & XIOREAD_RECV_SKIPIP) {
-	    if (pipe->peersa.soa.sa_family != from.soa.sa_family) {
-	       Info("recvfrom(): wrong peer protocol, ignoring packet");
-	       errno = EAGAIN; return -1;
-	    }
-#if WITH_IP4
-	    switch (pipe->peersa.soa.sa_family) {
-	    case PF_INET:
-	       if (pipe->peersa.ip4.sin_addr.s_addr !=
-		   from.ip4.sin_addr.s_addr) {
-		  Info("recvfrom(): wrong peer address, ignoring packet");
-		  errno = EAGAIN; return -1;
-	       }
-	       break;
-	    }
-#endif /* WITH_IP4 */
-	 } else {
-	    switch (pipe->peersa.soa.sa_family) {
-#if 0
-	    case PF_UNIX:
-	       if (strncmp(pipe->peersa.un.sun_path, from.un.sun_path,
-			   sizeof(from.un.sun_path))) {
-		  Info("recvfrom(): wrong peer address, ignoring packet");
-		  errno = EAGAIN; return -1;
-	       }
-	       break;
-#endif
-#if WITH_IP6
-	    case PF_INET6:
-	       /* e.g. Solaris recvfrom sets a __sin6_src_id component */
-	       if (memcmp(&from.ip6.sin6_addr, &pipe->peersa.ip6.sin6_addr,
-			  sizeof(from.ip6.sin6_addr)) ||
-		   from.ip6.sin6_port != pipe->peersa.ip6.sin6_port) {
-		  Info("recvfrom(): wrong peer address, ignoring packet");
-		  errno = EAGAIN; return -1;
-	       }
-	       break;
-#endif /* WITH_IP6 */
-	    default:
-	       if (memcmp(&from, &pipe->peersa, fromlen)) {
-		  Info("recvfrom(): wrong peer address, ignoring packet");
-		  errno = EAGAIN; return -1;
-	       }
-	    }
-	 }
+      if (!batched && pipe->peersa.soa.sa_family != PF_UNSPEC &&
+	  xioread_checkpeersa(pipe, &from, fromlen) < 0) {
+	 errno = EAGAIN; return -1;
       }
 
       switch(from.soa.sa_family) {
@@ -325,46 +493,56 @@ ssize_t xioread(xiofile_t *file, void *buff, size_t bufsiz) {
       int rc;
 
       socket_init(pipe->para.socket.la.soa.sa_family, &from);
-      /* get source address */
-      msgh.msg_name = &from;
-      msgh.msg_namelen = fromlen;
+#if HAVE_RECVMMSG
+      if (pipe->batch.num > 0 && !(pipe->dtype & XIOREAD_RECV_ONESHOT)) {
+	 /* the peer checks were applied to the whole batch */
+	 if ((bytes = xioread_batch(pipe, buff, bufsiz, &from, &fromlen)) < 0) {
+	    return -1;
+	 }
+      } else
+#endif /* HAVE_RECVMMSG */
+      {
+	 /* get source address */
+	 msgh.msg_name = &from;
+	 msgh.msg_namelen = fromlen;
 #if HAVE_STRUCT_MSGHDR_MSGCONTROL
-      msgh.msg_control = ctrlbuff;
+	 msgh.msg_control = ctrlbuff;
 #endif
 #if HAVE_STRUCT_MSGHDR_MSGCONTROLLEN
-      msgh.msg_controllen = sizeof(ctrlbuff);
+	 msgh.msg_controllen = sizeof(ctrlbuff);
 #endif
-      while ((rc = xiogetpacketsrc(pipe->fd, &msgh,
-			  MSG_PEEK
+	 while ((rc = xiogetpacketsrc(pipe->fd, &msgh,
+			     MSG_PEEK
 #ifdef MSG_TRUNC
-			  |MSG_TRUNC
+			     |MSG_TRUNC
 #endif
-				   )) < 0 &&
-	     errno == EINTR) ;
-      if (rc < 0)  return -1;
-
-      xiodopacketinfo(&msgh, true, false);
-      if (xiocheckpeer(pipe, &from, &pipe->para.socket.la) < 0) {
-	 Recvfrom(pipe->fd, buff, bufsiz, 0, &from.soa, &fromlen);  /* drop */
-	 errno = EAGAIN;  return -1;
-      }
-      Info1("permitting packet from %s",
-	    sockaddr_info((struct sockaddr *)&from, fromlen,
-			  infobuff, sizeof(infobuff)));
+				      )) < 0 &&
+		errno == EINTR) ;
+	 if (rc < 0)  return -1;
 
-      do {
-	 bytes =
-	    Recvfrom(pipe->fd, buff, bufsiz, 0, &from.soa, &fromlen);
-      } while (bytes < 0 && errno == EINTR);
-      if (bytes < 0) {
-	 char infobuff[256];
-	 _errno = errno;
-	 Error6("recvfrom(%d, %p, "F_Zu", 0, %s, "F_socklen"): %s",
-		pipe->fd, buff, bufsiz,
-		sockaddr_info(&from.soa, fromlen, infobuff, sizeof(infobuff)),
-		fromlen, strerror(errno));
-	 errno = _errno;
-	 return -1;
+	 xiodopacketinfo(&msgh, true, false);
+	 if (xiocheckpeer(pipe, &from, &pipe->para.socket.la) < 0) {
+	    Recvfrom(pipe->fd, buff, bufsiz, 0, &from.soa, &fromlen);  /* drop */
+	    errno = EAGAIN;  return -1;
+	 }
+	 Info1("permitting packet from %s",
+	       sockaddr_info((struct sockaddr *)&from, fromlen,
+			     infobuff, sizeof(infobuff)));
+
+	 do {
+	    bytes =
+	       Recvfrom(pipe->fd, buff, bufsiz, 0, &from.soa, &fromlen);
+	 } while (bytes < 0 && errno == EINTR);
+	 if (bytes < 0) {
+	    char infobuff[256];
+	    _errno = errno;
+	    Error6("recvfrom(%d, %p, "F_Zu", 0, %s, "F_socklen"): %s",
+		   pipe->fd, buff, bufsiz,
+		   sockaddr_info(&from.soa, fromlen, infobuff, sizeof(infobuff)),
+		   fromlen, strerror(errno));
+	    errno = _errno;
+	    return -1;
+	 }
       }
       Notice2("received packet with "F_Zu" bytes from %s",
 	      bytes,
@@ -448,6 +626,11 @@ ssize_t xiopending(xiofile_t *file) {
       pipe = &file->stream;
    }
 
+#if _WITH_SOCKET && HAVE_RECVMMSG
+   if (pipe->batch.next < pipe->batch.len) {
+      return pipe->batch.len - pipe->batch.next;	/* datagrams */
+   }
+#endif /* _WITH_SOCKET && HAVE_RECVMMSG */
    switch (pipe->dtype & XIODATA_READMASK) {
 #if WITH_OPENSSL
    case XIOREAD_OPENSSL:
@@ -85,6 +85,7 @@ int xioshutdown(xiofile_t *sock, int how) {
 	    Info2("close(%d): %s",
 		  sock->stream.para.bipipe.fdout, strerror(errno));
 	 } 
+	 sock->stream.para.bipipe.fdout = -1;	/* xioclose() must not close it again */
       }
       
    } else if ((sock->stream.dtype & XIODATA_MASK) == XIODATA_2PIPE) {
@@ -99,6 +100,7 @@ int xioshutdown(xiofile_t *sock, int how) {
 	    Info2("close(%d): %s",
 		  sock->stream.para.exec.fdout, strerror(errno));
 	 } 
+	 sock->stream.para.exec.fdout = -1;	/* xioclose() must not close it again */
       }
 #if _WITH_SOCKET
    } else if (sock->stream.howtoend == END_SHUTDOWN) {
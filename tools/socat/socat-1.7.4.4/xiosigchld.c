@@ -9,10 +9,24 @@
 #include "xioopen.h"
 
 
-/*!! with socat, at most 4 exec children exist */
-pid_t diedunknown[NUMUNKNOWN];	/* children that died before they were registered */
-int   statunknown[NUMUNKNOWN]; 	/* exit state of unknown dead child */
-size_t nextunknown;
+/* the SIGCHLD handler only writes a byte to this pipe and sets
+   xiochild_pending; xiochildreap() waits for the terminated children in normal
+   program flow, where it may log and call back. the transfer loops have the
+   read end in their poll set */
+static int xiochild_pipe[2] = { -1, -1 };
+static volatile sig_atomic_t xiochild_pending;
+
+/* children that died before they were registered, see xiochildunknown() */
+static struct xiodiedunknown {
+   pid_t pid;
+   int   status;	/* exit state */
+} *diedunknown;
+static size_t numunknown, maxunknown;
+
+/* when set, xiochildreap() calls it with the pid of each terminated child
+   that is not registered with an xio descriptor, e.g. the children of a
+   listener with option prefork */
+void (*xiochilddied_hook)(pid_t pid);
 
 
 /* register for a xio filedescriptor a callback (handler).
@@ -28,7 +42,6 @@ int xiosetsigchild(xiofile_t *xfd, int (*callback)(struct single *)) {
 }
 
 /* exec'd child has died, perform appropriate changes to descriptor */
-/* is async-signal-safe */
 static int sigchld_stream(struct single *file) {
    /*!! call back to application */
    file->para.exec.pid = 0;
@@ -49,7 +62,7 @@ static int xio_checkchild(xiofile_t *socket, int socknum, pid_t deadchild) {
 	     socket->stream.para.exec.pid == deadchild) {
 	    Info2("exec'd process %d on socket %d terminated",
 		  socket->stream.para.exec.pid, socknum);
-	    sigchld_stream(&socket->stream);	/* is async-signal-safe */
+	    sigchld_stream(&socket->stream);
 	    return 1;
 	 }
       } else {
@@ -62,52 +75,106 @@ static int xio_checkchild(xiofile_t *socket, int socknum, pid_t deadchild) {
    return 0;
 }
 
-/* this is the "physical" signal handler for SIGCHLD */
+/* remembers a child that is not registered with an xio descriptor, so that
+   xiochildunknown() finds it when the descriptor is not yet complete */
+static void xiochildunknown_add(pid_t pid, int status) {
+   struct xiodiedunknown *p;
+
+   if (numunknown == maxunknown) {
+      size_t n = maxunknown ? 2*maxunknown : 4;
+      if ((p = Realloc(diedunknown, n*sizeof(*diedunknown))) == NULL) {
+	 return;
+      }
+      diedunknown = p;
+      maxunknown = n;
+   }
+   diedunknown[numunknown].pid = pid;
+   diedunknown[numunknown++].status = status;
+   Debug1("saving pid in diedunknown"F_Zu, numunknown);
+}
+
+/* looks for pid in the children that died before they were registered and
+   removes it. returns 1 and its exit status when found, else 0 */
+int xiochildunknown(pid_t pid, int *status) {
+   size_t i;
+
+   for (i = 0; i < numunknown; ++i) {
+      if (diedunknown[i].pid == pid) {
+	 if (status)  *status = diedunknown[i].status;
+	 diedunknown[i] = diedunknown[--numunknown];
+	 return 1;
+      }
+   }
+   return 0;
+}
+
+/* forgets the unregistered dead children; a pid is only looked up right
+   after the open that started it, so xioopen() and xio_fork() call it to keep
+   the list short with many anonymous children */
+void xiochildunknown_clear(void) {
+   numunknown = 0;
+}
+
+/* this is the "physical" signal handler for SIGCHLD; it only notes the signal
+   and wakes up the poll() of the transfer loop. is async-signal-safe */
+void childdied(int signum) {
+   int _errno = errno;
+
+   xiochild_pending = 1;
+   if (xiochild_pipe[1] >= 0) {
+      if (write(xiochild_pipe[1], "", 1) < 0) {
+	 ;	/* pipe full: it is readable anyway */
+      }
+   }
+#if !HAVE_SIGACTION
+   /* we might need to re-register our handler */
+   signal(SIGCHLD, childdied);
+#endif /* !HAVE_SIGACTION */
+   errno = _errno;
+}
+
+/* returns the fd that becomes readable when a child terminated, for the
+   poll set of a transfer loop, or -1 */
+int xiochildfd(void) {
+   return xiochild_pipe[0];
+}
+
+/* waits for the terminated children after a SIGCHLD, in normal program flow */
 /* the current socat/xio implementation knows two kinds of children:
    exec/system addresses perform a fork: these children are registered and
    there death influences the parents flow;
    listen-socket with fork children: these children are "anonymous" and their
    death does not affect the parent process (now; maybe we have a child
-   process counter later) */
-void childdied(int signum) {
+   process counter later)
+   returns the number of children that terminated */
+int xiochildreap(void) {
+   char drain[64];
    pid_t pid;
-   int _errno;
    int status = 0;
-   bool wassig = false;
+   int reaped = 0;
    int i;
 
-   _errno = errno;	/* save current value; e.g., select() on Cygwin seems
-			   to set it to EINTR _before_ handling the signal, and
-			   then passes the value left by the signal handler to
-			   the caller of select(), accept() etc. */
-   diag_in_handler = 1;
-   Notice1("childdied(): handling signal %d", signum);
-   Info1("childdied(signum=%d)", signum);
+   if (!xiochild_pending) {
+      return 0;	/* no SIGCHLD, avoid the system calls */
+   }
+   /* _before_ waitpid(), so a child that terminates meanwhile is not missed */
+   xiochild_pending = 0;
+   if (xiochild_pipe[0] >= 0) {
+      while (Read(xiochild_pipe[0], drain, sizeof(drain)) > 0)  ;
+   }
+   Info("childdied(): handling signal SIGCHLD");
    do {
       pid = Waitpid(-1, &status, WNOHANG);
       if (pid == 0) {
-	 Msg(wassig?E_INFO:E_WARN,
-	     "waitpid(-1, {}, WNOHANG): no child has exited");
-	 Info("childdied() finished");
-	 diag_in_handler = 0;
-	 errno = _errno;
-	 return;
-      } else if (pid < 0 && errno == ECHILD) {
-	 Msg(wassig?E_INFO:E_WARN,
-	      "waitpid(-1, {}, WNOHANG): "F_strerror);
-	 Info("childdied() finished");
-	 diag_in_handler = 0;
-	 errno = _errno;
-	 return;
-      }
-      wassig = true;
-      if (pid < 0) {
-	 Warn1("waitpid(-1, {%d}, WNOHANG): "F_strerror, status);
-	 Info("childdied() finished");
-	 diag_in_handler = 0;
-	 errno = _errno;
-	 return;
+	 Info("waitpid(-1, {}, WNOHANG): no child has exited");
+	 break;
+      } else if (pid < 0) {
+	 /* ECHILD: another waitpid() took the child */
+	 Msg1(errno==ECHILD?E_INFO:E_WARN,
+	      "waitpid(-1, {}, WNOHANG): %s", strerror(errno));
+	 break;
       }
+      ++reaped;
    /*! indent */
    if (num_child) num_child--;
    /* check if it was a registered child process */
@@ -117,14 +184,11 @@ void childdied(int signum) {
       ++i;
    }
    if (i == XIO_MAXSOCK) {
-	 Info2("childdied(%d): cannot identify child %d", signum, pid);
-	 if (nextunknown == NUMUNKNOWN) {
-	    nextunknown = 0;
+	 Info1("childdied(): cannot identify child %d", pid);
+	 xiochildunknown_add(pid, WEXITSTATUS(status));
+	 if (xiochilddied_hook != NULL) {
+	    xiochilddied_hook(pid);
 	 }
-	 diedunknown[nextunknown] = pid;
-	 statunknown[nextunknown++] = WEXITSTATUS(status);
-	 Debug1("saving pid in diedunknown"F_Zu,
-		nextunknown/*sic, for compatibility*/);
       }
 
    if (WIFEXITED(status)) {
@@ -154,23 +218,71 @@ void childdied(int signum) {
    } else {
       Warn1("waitpid(): cannot determine status of child %d", pid);
    }
-
-#if !HAVE_SIGACTION
-   /* we might need to re-register our handler */
-   if (Signal(SIGCHLD, childdied) == SIG_ERR) {
-      Warn("signal(SIGCHLD, childdied): "F_strerror);
-   }
-#endif /* !HAVE_SIGACTION */
   } while (1);
    Info("childdied() finished");
-   diag_in_handler = 0;
-   errno = _errno;
+   return reaped;
+}
+
+/* blocks until at least one child terminated, and waits for it.
+   returns the number of children that terminated */
+int xiochildwait(void) {
+   struct pollfd pfd;
+
+   while (!xiochild_pending) {
+      if (xiochild_pipe[0] < 0) {
+	 Sleep(INT_MAX);	/* any signal lets us continue */
+	 continue;
+      }
+      pfd.fd = xiochild_pipe[0];
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (Poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+	 Warn2("poll({%d,POLLIN}, 1, -1): %s", pfd.fd, strerror(errno));
+	 Sleep(1);
+      }
+   }
+   return xiochildreap();
+}
+
+static int xiochild_openpipe(void) {
+   int i;
+
+   if (xiochild_pipe[0] >= 0) {
+      return 0;
+   }
+   if (Pipe(xiochild_pipe) < 0) {
+      Warn2("pipe(%p): %s", xiochild_pipe, strerror(errno));
+      xiochild_pipe[0] = xiochild_pipe[1] = -1;
+      return -1;
+   }
+   for (i = 0; i < 2; ++i) {
+      /* the handler must never block on it, and programs must not get it */
+      Fcntl_l(xiochild_pipe[i], F_SETFL,
+	      Fcntl(xiochild_pipe[i], F_GETFL)|O_NONBLOCK);
+      Fcntl_l(xiochild_pipe[i], F_SETFD, FD_CLOEXEC);
+   }
+   return 0;
+}
+
+/* in a new child process: the pipe belongs to the parent, a SIGCHLD of the
+   child must not wake it up; the child gets its own */
+void xiochild_forked(void) {
+   if (xiochild_pipe[0] >= 0) {
+      Close(xiochild_pipe[0]);
+      Close(xiochild_pipe[1]);
+      xiochild_pipe[0] = xiochild_pipe[1] = -1;
+      xiochild_openpipe();
+   }
+   xiochild_pending = 0;
+   numunknown = 0;
 }
 
 
 int xiosetchilddied(void) {
 #if HAVE_SIGACTION
    struct sigaction act;
+
+   xiochild_openpipe();
    memset(&act, 0, sizeof(struct sigaction));
    act.sa_flags   = SA_NOCLDSTOP/*|SA_RESTART*/
 #ifdef SA_NOMASK
@@ -184,6 +296,7 @@ int xiosetchilddied(void) {
       Warn2("sigaction(SIGCHLD, %p, NULL): %s", childdied, strerror(errno));
    }
 #else /* HAVE_SIGACTION */
+   xiochild_openpipe();
    if (Signal(SIGCHLD, childdied) == SIG_ERR) {
       Warn2("signal(SIGCHLD, %p): %s", childdied, strerror(errno));
    }
@@ -114,3 +114,82 @@ int xio_opt_signal(pid_t pid, int signum) {
    return 0;
 }
 
+
+
+/* a listening process that reads files again on SIGHUP (the context of
+   OPENSSL-LISTEN, options allow-file and deny-file) installs this handler; it
+   only counts the signals, and each user reloads when the count differs from
+   the one of its last load. it also writes a byte to a pipe, so the accept
+   loop wakes up from poll() even when the signal arrived just before */
+volatile sig_atomic_t xio_sighup_count;
+static bool xio_sighup_armed;
+static struct sigaction xio_sighup_oldact;
+static int xio_sighup_pipe[2] = { -1, -1 };
+
+/* is async-signal-safe */
+static void xio_sighup_signal(int signum) {
+   int _errno = errno;
+
+   ++xio_sighup_count;
+   if (xio_sighup_pipe[1] >= 0) {
+      if (write(xio_sighup_pipe[1], "", 1) < 0) {
+	 ;	/* pipe full: it is readable anyway */
+      }
+   }
+   errno = _errno;
+}
+
+/* installs the handler, without SA_RESTART so the signal interrupts
+   accept() */
+void xio_sighup_arm(void) {
+   struct sigaction act;
+   int i;
+
+   if (xio_sighup_armed) {
+      return;
+   }
+   if (Pipe(xio_sighup_pipe) < 0) {
+      Warn2("pipe(%p): %s", xio_sighup_pipe, strerror(errno));
+      xio_sighup_pipe[0] = xio_sighup_pipe[1] = -1;
+   } else {
+      for (i = 0; i < 2; ++i) {
+	 Fcntl_l(xio_sighup_pipe[i], F_SETFL,
+		 Fcntl(xio_sighup_pipe[i], F_GETFL)|O_NONBLOCK);
+	 Fcntl_l(xio_sighup_pipe[i], F_SETFD, FD_CLOEXEC);
+      }
+   }
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = xio_sighup_signal;
+   sigfillset(&act.sa_mask);
+   Sigaction(SIGHUP, &act, &xio_sighup_oldact);
+   xio_sighup_armed = true;
+}
+
+/* in a child process, or when listening is done: restore the SIGHUP
+   handling of socat */
+void xio_sighup_reset(void) {
+   if (xio_sighup_armed) {
+      Sigaction(SIGHUP, &xio_sighup_oldact, NULL);
+      xio_sighup_armed = false;
+      if (xio_sighup_pipe[0] >= 0) {
+	 Close(xio_sighup_pipe[0]);
+	 Close(xio_sighup_pipe[1]);
+	 xio_sighup_pipe[0] = xio_sighup_pipe[1] = -1;
+      }
+   }
+}
+
+/* returns the fd that becomes readable on SIGHUP, for the poll set of the
+   accept loop, or -1 */
+int xio_sighup_fd(void) {
+   return xio_sighup_pipe[0];
+}
+
+/* empties the pipe; call it before checking xio_sighup_count */
+void xio_sighup_drain(void) {
+   char drain[64];
+
+   if (xio_sighup_pipe[0] >= 0) {
+      while (Read(xio_sighup_pipe[0], drain, sizeof(drain)) > 0)  ;
+   }
+}
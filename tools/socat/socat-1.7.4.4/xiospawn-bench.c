@@ -0,0 +1,89 @@
+/* source: xiospawn-bench.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* benchmark of starting EXEC and SYSTEM children: opens an address like
+   EXEC:true repeatedly, reads to EOF and closes it, once with fork() only
+   (xioopts.nospawn) and once with posix_spawnp(), and prints the children
+   per second of each. The resident size of the process is raised by <mb>
+   megabytes first, because the cost of fork() grows with it.
+   build with "make xiospawn-bench";
+   usage: ./xiospawn-bench [count [mb [address]]] */
+
+#include "config.h"
+#include "xioconfig.h"	/* what features are enabled */
+
+#include "sysincludes.h"
+
+#include "mytypes.h"
+#include "compat.h"
+#include "error.h"
+
+#include "sycls.h"
+#include "sysutils.h"
+#include "utils.h"
+#include "xio.h"
+
+/* libxio refers to the sockets of socat.c */
+xiofile_t *sock1, *sock2;
+
+static double now(void) {
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* opens and closes address count times; returns the children per second, or
+   -1 on error */
+static double bench_spawn(const char *address, int count) {
+   xiofile_t *xfd;
+   char buff[256];
+   double t0, t1;
+   int i;
+
+   t0 = now();
+   for (i = 0; i < count; ++i) {
+      if ((xfd = xioopen(address, XIO_RDWR|XIO_MAYCHILD)) == NULL) {
+	 return -1;
+      }
+      while (xioread(xfd, buff, sizeof(buff)) > 0)  ;
+      xioclose(xfd);
+      free(xfd);
+   }
+   t1 = now();
+   return count / (t1 - t0);
+}
+
+int main(int argc, const char *argv[]) {
+   const char *address = "EXEC:true";
+   int count = 200, mb = 256;
+   double forks, spawns;
+   char *ballast = NULL;
+
+   if (argc > 1)  count = atoi(argv[1]);
+   if (argc > 2)  mb = atoi(argv[2]);
+   if (argc > 3)  address = argv[3];
+   if (count <= 0)  count = 1;
+   diag_set('p', "xiospawn-bench");
+   xioinitialize();
+
+   if (mb > 0) {
+      if ((ballast = malloc((size_t)mb << 20)) == NULL) {
+	 fprintf(stderr, "cannot allocate %d MB\n", mb);
+	 return 1;
+      }
+      memset(ballast, 1, (size_t)mb << 20);	/* make it resident */
+   }
+
+   xioopts.nospawn = true;
+   if ((forks = bench_spawn(address, count)) < 0)  return 1;
+   xioopts.nospawn = false;
+   if ((spawns = bench_spawn(address, count)) < 0)  return 1;
+#if !HAVE_POSIX_SPAWNP
+   fputs("posix_spawnp() is not available, both runs used fork()\n", stderr);
+#endif
+   printf("%s with %d MB resident  fork() %7.1f/s  posix_spawnp() %7.1f/s\n",
+	  address, mb, forks, spawns);
+   free(ballast);
+   return 0;
+}
@@ -148,3 +148,280 @@ ssize_t xiowrite(xiofile_t *file, const void *buff, size_t bytes) {
    }
    return writt;
 }
+
+
+/* returns the FD that xiowritepart() writes to with a single write() call,
+   or -1 when the descriptor type requires xiowrite() */
+static int xiowritepartfd(struct single *pipe) {
+   if ((pipe->dtype & XIODATA_READMASK) == XIOREAD_READLINE) {
+      return -1;
+   }
+   switch (pipe->dtype & XIODATA_WRITEMASK) {
+   case XIOWRITE_STREAM: return pipe->fd;
+   case XIOWRITE_PIPE:   return pipe->para.bipipe.fdout;
+   case XIOWRITE_2PIPE:  return pipe->para.exec.fdout;
+   default:              return -1;
+   }
+}
+
+/* like xiowrite(), but for stream, pipe, and 2pipe type descriptors performs
+   only one write() call, so fewer bytes than requested might be written.
+   When the FD is nonblocking (or a socket with write buffer, see
+   xiowrbuf_init()) and cannot take data, it returns -1 with errno EAGAIN
+   without printing a message. sendto type descriptors with wrbuf.dontwait
+   (the peers of a datagram listener with option event-loop) send the
+   datagram with MSG_DONTWAIT. Other descriptor types are handled by
+   xiowrite().
+   on return value < 0: errno reflects the value from write() */
+ssize_t xiowritepart(xiofile_t *file, const void *buff, size_t bytes) {
+   ssize_t writt;
+   struct single *pipe;
+   int fd;
+   int _errno;
+
+   if (file->tag == XIO_TAG_INVALID) {
+      Error1("xiowritepart(): invalid xiofile descriptor %p", file);
+      errno = EINVAL;
+      return -1;
+   }
+
+   if (file->tag == XIO_TAG_DUAL) {
+      pipe = file->dual.stream[1];
+      if (pipe->tag == XIO_TAG_INVALID) {
+	 Error1("xiowritepart(): invalid xiofile sub descriptor %p[1]", file);
+	 errno = EINVAL;
+	 return -1;
+      }
+   } else {
+      pipe = &file->stream;
+   }
+
+#if _WITH_SOCKET && defined(MSG_DONTWAIT)
+   if ((pipe->dtype & XIODATA_WRITEMASK) == XIOWRITE_SENDTO &&
+       pipe->wrbuf.dontwait) {
+      /* a datagram is sent completely or not at all */
+      do {
+	 writt = Sendto(pipe->fd, buff, bytes, MSG_DONTWAIT,
+			&pipe->peersa.soa, pipe->salen);
+      } while (writt < 0 && errno == EINTR);
+      if (writt < 0) {
+	 _errno = errno;
+	 if (_errno != EAGAIN
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+	     && _errno != EWOULDBLOCK
+#endif
+	     ) {
+	    char infobuff[256];
+	    Error6("sendto(%d, %p, "F_Zu", MSG_DONTWAIT, %s, "F_socklen"): %s",
+		   pipe->fd, buff, bytes,
+		   sockaddr_info(&pipe->peersa.soa, pipe->salen,
+				 infobuff, sizeof(infobuff)),
+		   pipe->salen, strerror(_errno));
+	 } else {
+	    _errno = EAGAIN;
+	 }
+	 errno = _errno;
+	 return -1;
+      }
+      return writt;
+   }
+#endif /* _WITH_SOCKET && defined(MSG_DONTWAIT) */
+
+   if ((fd = xiowritepartfd(pipe)) < 0) {
+      return xiowrite(file, buff, bytes);
+   }
+
+   do {
+#ifdef MSG_DONTWAIT
+      if (pipe->wrbuf.dontwait) {
+	 writt = Send(fd, buff, bytes, MSG_DONTWAIT);
+      } else
+#endif
+	 writt = Write(fd, buff, bytes);
+   } while (writt < 0 && errno == EINTR);
+   if (writt < 0) {
+      _errno = errno;
+      switch (_errno) {
+      case EAGAIN:
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+      case EWOULDBLOCK:
+#endif
+	 errno = EAGAIN;
+	 return -1;
+      case EPIPE:
+      case ECONNRESET:
+	 if (pipe->cool_write) {
+	    Notice4("write(%d, %p, "F_Zu"): %s",
+		    fd, buff, bytes, strerror(_errno));
+	    break;
+	 }
+	 /*PASSTRHOUGH*/
+      default:
+	 Error4("write(%d, %p, "F_Zu"): %s",
+		fd, buff, bytes, strerror(_errno));
+      }
+      errno = _errno;
+      return -1;
+   }
+   return writt;
+}
+
+
+/* provides the write side of file with a ring buffer of bufsiz bytes that
+   takes the data xiowritebuffered() cannot write immediately. Only stream,
+   pipe, and 2pipe type descriptors get a buffer; with the other types
+   xiowritebuffered() behaves like xiowrite().
+   returns 0 on success, or -1 when no buffer is used */
+int xiowrbuf_init(xiofile_t *file, size_t bufsiz) {
+   struct single *pipe = XIO_WRSTREAM(file);
+   struct stat buf;
+   int fd;
+
+   if ((fd = xiowritepartfd(pipe)) < 0 || bufsiz == 0) {
+      return -1;
+   }
+   if ((pipe->wrbuf.buff = Malloc(bufsiz)) == NULL) {
+      return -1;
+   }
+   pipe->wrbuf.size = bufsiz;
+   pipe->wrbuf.head = 0;
+   pipe->wrbuf.len  = 0;
+   /* a socket can be written without blocking even when its FD is blocking */
+   if (Fstat(fd, &buf) == 0 && S_ISSOCK(buf.st_mode)) {
+      pipe->wrbuf.dontwait = true;
+   }
+   Debug3("fd %d: write buffer of "F_Zu" bytes%s", fd, bufsiz,
+	  pipe->wrbuf.dontwait ? ", nonblocking writes" : "");
+   return 0;
+}
+
+
+/* writes the data to file as far as possible without waiting and appends the
+   rest to its write buffer; when maywrite is false or older data is still
+   waiting in the buffer, all data is appended. The caller must make sure that
+   bytes does not exceed XIO_WRROOM(file).
+   Without write buffer, it behaves like xiowrite().
+   returns bytes on success, or -1 on error (errno is set) */
+ssize_t xiowritebuffered(xiofile_t *file, const void *buff, size_t bytes,
+			 bool maywrite) {
+   struct xioring *ring = &XIO_WRSTREAM(file)->wrbuf;
+   size_t done = 0, tail, n;
+   ssize_t writt;
+
+   if (ring->size == 0) {
+      return xiowrite(file, buff, bytes);
+   }
+   if (maywrite && ring->len == 0) {
+      if ((writt = xiowritepart(file, buff, bytes)) < 0) {
+	 if (errno != EAGAIN) {
+	    return -1;
+	 }
+      } else {
+	 done = writt;
+      }
+   }
+   if (bytes - done > ring->size - ring->len) {
+      Error3("xiowritebuffered(): "F_Zu" bytes do not fit into write buffer with "F_Zu" free bytes of "F_Zu,
+	     bytes - done, ring->size - ring->len, ring->size);
+      errno = ENOBUFS;
+      return -1;
+   }
+   if (done < bytes) {
+      Debug2("buffering "F_Zu" bytes for fd %d",
+	     bytes - done, XIO_GETWRFD(file));
+   }
+   while (done < bytes) {
+      tail = (ring->head + ring->len) % ring->size;
+      n = Min(bytes - done, ring->size - tail);
+      memcpy(ring->buff + tail, (const unsigned char *)buff + done, n);
+      ring->len += n;
+      done += n;
+   }
+   return bytes;
+}
+
+
+/* writes data waiting in the write buffer of file, until the buffer is empty
+   or the FD does not take more data.
+   returns the number of bytes written; -1 with errno EAGAIN when the FD did
+   not take any data; -1 with other errno on error, the waiting data is then
+   discarded */
+ssize_t xioflush(xiofile_t *file) {
+   struct xioring *ring = &XIO_WRSTREAM(file)->wrbuf;
+   ssize_t writt, total = 0;
+   size_t n;
+
+   while (ring->len > 0) {
+      n = Min(ring->len, ring->size - ring->head);
+      if ((writt = xiowritepart(file, ring->buff + ring->head, n)) < 0) {
+	 if (errno == EAGAIN) {
+	    if (total > 0)  break;
+	    return -1;
+	 }
+	 ring->head = ring->len = 0;
+	 return -1;
+      }
+      ring->head = (ring->head + writt) % ring->size;
+      ring->len -= writt;
+      total += writt;
+      if ((size_t)writt < n) {
+	 break;		/* FD does not take more data now */
+      }
+   }
+   if (ring->len == 0) {
+      ring->head = 0;
+   }
+   return total;
+}
+
+#if _WITH_SOCKET && HAVE_SENDMMSG
+/* writes the n datagrams described by iov with one sendmmsg() call (option
+   batch). file must be a datagram socket, either connected or writing with
+   XIOWRITE_SENDTO to the registered peer.
+   returns the number of bytes written, or -1 if an error occurred */
+ssize_t xiowritebatch(xiofile_t *file, struct iovec *iov, unsigned int n) {
+   static struct mmsghdr msgs[XIO_BATCHMAX];
+   struct single *pipe = XIO_WRSTREAM(file);
+   bool sendto = ((pipe->dtype & XIODATA_WRITEMASK) == XIOWRITE_SENDTO);
+   ssize_t writt = 0;
+   unsigned int done = 0, i;
+   int rc;
+
+   if (n > XIO_BATCHMAX)  n = XIO_BATCHMAX;
+   memset(msgs, 0, n*sizeof(struct mmsghdr));
+   for (i = 0; i < n; ++i) {
+      if (sendto) {
+	 msgs[i].msg_hdr.msg_name    = &pipe->peersa;
+	 msgs[i].msg_hdr.msg_namelen = pipe->salen;
+      }
+      msgs[i].msg_hdr.msg_iov    = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   while (done < n) {
+      rc = Sendmmsg(pipe->fd, msgs+done, n-done, 0);
+      if (rc < 0) {
+	 int _errno = errno;
+	 if (_errno == EINTR)  continue;
+	 Error4("sendmmsg(%d, %p, %u, 0): %s",
+		pipe->fd, msgs+done, n-done, strerror(_errno));
+	 errno = _errno;
+	 return -1;
+      }
+      for (i = done; i < done+rc; ++i) {
+	 writt += msgs[i].msg_len;
+      }
+      done += rc;
+   }
+   if (sendto) {
+      char infobuff[256];
+      union sockaddr_union us;
+      socklen_t uslen = sizeof(us);
+      Getsockname(pipe->fd, &us.soa, &uslen);
+      Notice1("local address: %s",
+	      sockaddr_info(&us.soa, uslen, infobuff, sizeof(infobuff)));
+   }
+   Debug3("fd %d: sent %u datagrams with "F_Zd" bytes", pipe->fd, n, writt);
+   return writt;
+}
+#endif /* _WITH_SOCKET && HAVE_SENDMMSG */